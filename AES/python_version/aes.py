@@ -10,6 +10,98 @@ import random
 from sbox import SBOX, REVERSE_SBOX
 
 
+# Lookup tables for the batch implementation below, indexed with numpy arrays of bytes
+SBOX_TABLE = SBOX.reshape(256).astype(np.uint8)
+REVERSE_SBOX_TABLE = REVERSE_SBOX.reshape(256).astype(np.uint8)
+RCON = np.array([0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36], dtype=np.uint8)
+
+# Byte i of a block is row i % 4 of column i // 4, SHIFT_ROWS[i] is the byte that moves to i
+SHIFT_ROWS = np.array([(i % 4) + 4 * ((i // 4 + i % 4) % 4) for i in range(16)])
+REVERSE_SHIFT_ROWS = np.argsort(SHIFT_ROWS)
+
+
+def gf_mult_table(factor):
+    # Product of every byte with factor in GF(2^8)
+    table = np.zeros(256, dtype=np.uint8)
+    for num in range(256):
+        product, a, b = 0, num, factor
+        while b:
+            if b & 1:
+                product ^= a
+            a = ((a << 1) ^ 0x11b) if a & 0x80 else a << 1
+            b >>= 1
+        table[num] = product
+    return table
+
+
+MULT = {factor: gf_mult_table(factor) for factor in (2, 3, 9, 11, 13, 14)}
+
+
+def expand_keys(keys):
+    """
+    Key expansion of N keys at once, keys is an N x 16 array of bytes.
+    Returns the N x 11 x 16 round keys.
+    """
+    keys = np.atleast_2d(np.asarray(keys, dtype=np.uint8))
+
+    # word-major (44 x 4 x N) so every step works on contiguous rows of N bytes
+    words = np.zeros((44, 4, len(keys)), dtype=np.uint8)
+    words[:4] = keys.T.reshape(4, 4, -1)
+
+    for i in range(4, 44):
+        temp = words[i-1]
+        if i % 4 == 0:
+            temp = SBOX_TABLE[np.roll(temp, -1, axis=0)]
+            temp[0] ^= RCON[i // 4 - 1]
+        np.bitwise_xor(words[i-4], temp, out=words[i])
+
+    return np.ascontiguousarray(words.reshape(176, -1).T).reshape(-1, 11, 16)
+
+
+def mix_columns_blocks(state, factors):
+    # factors are the multipliers of the byte itself and the three rows below it in the column
+    columns = state.reshape(-1, 4, 4)
+    mixed = MULT[factors[0]][columns] if factors[0] != 1 else columns.copy()
+    for shift, factor in enumerate(factors[1:], 1):
+        rows = np.roll(columns, -shift, axis=2)
+        mixed ^= MULT[factor][rows] if factor != 1 else rows
+    return mixed.reshape(-1, 16)
+
+
+def encrypt_blocks(keys, blocks):
+    """
+    Encrypts N blocks at once with gather tables instead of one block at a time.
+    keys is one key (16 bytes) or N keys (N x 16), blocks is N x 16, in the byte order of the hex strings.
+    Returns the N x 16 ciphertext blocks.
+    """
+    round_keys = expand_keys(keys)
+    state = np.atleast_2d(np.asarray(blocks, dtype=np.uint8)) ^ round_keys[:, 0]
+
+    for round_num in range(1, 11):
+        state = SBOX_TABLE[state][:, SHIFT_ROWS]
+        if round_num < 10:
+            state = mix_columns_blocks(state, (2, 3, 1, 1))
+        state ^= round_keys[:, round_num]
+
+    return state
+
+
+def decrypt_blocks(keys, blocks):
+    """
+    Decrypts N blocks at once, the inverse of encrypt_blocks.
+    """
+    round_keys = expand_keys(keys)
+    state = np.atleast_2d(np.asarray(blocks, dtype=np.uint8)) ^ round_keys[:, 10]
+
+    for round_num in range(9, -1, -1):
+        state = REVERSE_SBOX_TABLE[state[:, REVERSE_SHIFT_ROWS]]
+        state ^= round_keys[:, round_num]
+        if round_num > 0:
+            state = mix_columns_blocks(state, (14, 11, 13, 9))
+
+    return state
+
+
 # The AES class only accepts bytes as the secret input key and encryption/decryption data
 class AES:
     def __init__(self, key):
@@ -37,10 +129,11 @@ class AES:
             for j in range(1, 4):
                 self.key[i].T[j] = prev_key.T[j] ^ self.key[i].T[j-1]
 
+            # int() so the doubling does not overflow the uint8 before the reduction
             if rcon[0] < 80:
-                rcon[0] = rcon[0] * 2
+                rcon[0] = int(rcon[0]) * 2
             else:
-                rcon[0] = (rcon[0] * 2) ^ 0x11b
+                rcon[0] = (int(rcon[0]) * 2) ^ 0x11b
 
     @staticmethod
     def add_padding(text):
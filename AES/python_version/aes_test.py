@@ -5,7 +5,8 @@ the test is passed
 """
 
 import random
-from aes import AES
+import numpy as np
+from aes import AES, encrypt_blocks, decrypt_blocks
 
 
 try:
@@ -51,4 +52,18 @@ except Exception:
     print(decrypted_text)
     exit()
 
+# The batch implementation has to give the same blocks as the AES class
+keys = np.random.randint(0, 256, (1000, 16), dtype=np.uint8)
+blocks = np.random.randint(0, 256, (1000, 16), dtype=np.uint8)
+cipher_blocks = encrypt_blocks(keys, blocks)
+for key, block, cipher_block in zip(keys, blocks, cipher_blocks):
+    if AES(key.tobytes().hex()).encrypt(block.tobytes().hex()) != cipher_block.tobytes().hex():
+        print("BATCH NOT MATCHING")
+        print("Key: ", key.tobytes().hex())
+        print("Plaintext: ", block.tobytes().hex())
+        exit()
+if not (decrypt_blocks(keys, cipher_blocks) == blocks).all():
+    print("BATCH DECRYPTION NOT MATCHING")
+    exit()
+
 print("PASSED")
@@ -0,0 +1,125 @@
+"""
+This module generates AES test vectors (key, plaintext, ciphertext) with the batch implementation
+in aes.py, for the RTL testbenches and the firmware tests.
+
+Formats:
+    memh    three lines of 32 hex digits per vector (key, plaintext, ciphertext), first byte first,
+            read by tb_aes_regression.sv with $readmemh
+    c       a header with AES_NUM_VECTORS and aes_vectors[][3][16] for tests.c (CPEN391FW/include/aesVectors.h),
+            the bytes of each block are reversed to the order encrypt() and decrypt() in aesHwacc.c use
+    hex     one vector per line, key plaintext ciphertext separated by spaces
+
+Usage: python3 gen_vectors.py [--count N] [--seed S] [--format memh|c|hex] [--no-kat] [-o FILE]
+"""
+
+import argparse
+import sys
+import numpy as np
+from aes import encrypt_blocks
+
+# (key, plaintext, ciphertext) from FIPS-197 appendices B and C.1, SP 800-38A F.1.1 and the AESAVS
+# GFSbox, KeySbox and VarKey tables
+KNOWN_ANSWERS = [
+    ("000102030405060708090a0b0c0d0e0f", "00112233445566778899aabbccddeeff", "69c4e0d86a7b0430d8cdb78070b4c55a"),
+    ("2b7e151628aed2a6abf7158809cf4f3c", "3243f6a8885a308d313198a2e0370734", "3925841d02dc09fbdc118597196a0b32"),
+    ("2b7e151628aed2a6abf7158809cf4f3c", "6bc1bee22e409f96e93d7e117393172a", "3ad77bb40d7a3660a89ecaf32466ef97"),
+    ("2b7e151628aed2a6abf7158809cf4f3c", "ae2d8a571e03ac9c9eb76fac45af8e51", "f5d3d58503b9699de785895a96fdbaaf"),
+    ("2b7e151628aed2a6abf7158809cf4f3c", "30c81c46a35ce411e5fbc1191a0a52ef", "43b1cd7f598ece23881b00e3ed030688"),
+    ("2b7e151628aed2a6abf7158809cf4f3c", "f69f2445df4f9b17ad2b417be66c3710", "7b0c785e27e8ad3f8223207104725dd4"),
+    ("00000000000000000000000000000000", "f34481ec3cc627bacd5dc3fb08f273e6", "0336763e966d92595a567cc9ce537f5e"),
+    ("00000000000000000000000000000000", "9798c4640bad75c7c3227db910174e72", "a9a1631bf4996954ebc093957b234589"),
+    ("10a58869d74be5a374cf867cfb473859", "00000000000000000000000000000000", "6d251e6944b051e04eaa6fb4dbf78465"),
+    ("80000000000000000000000000000000", "00000000000000000000000000000000", "0edd33d3c621e546455bd8ba1418bec8"),
+]
+
+HEX_DIGITS = np.frombuffer(b"0123456789abcdef", dtype=np.uint8)
+
+
+def known_answers():
+    # N x 3 x 16 array of the known answer vectors, checked against the batch implementation
+    vectors = np.array([[np.frombuffer(bytes.fromhex(value), dtype=np.uint8) for value in vector]
+                        for vector in KNOWN_ANSWERS])
+    if not (encrypt_blocks(vectors[:, 0], vectors[:, 1]) == vectors[:, 2]).all():
+        sys.exit("aes.py does not match the known answer vectors")
+    return vectors
+
+
+def generate(count, seed, kat=True):
+    """
+    Returns an N x 3 x 16 array of (key, plaintext, ciphertext), the known answers followed by
+    count random vectors.
+    """
+    rng = np.random.default_rng(seed)
+    vectors = np.zeros((count, 3, 16), dtype=np.uint8)
+    vectors[:, :2] = rng.integers(0, 256, (count, 2, 16), dtype=np.uint8)
+    vectors[:, 2] = encrypt_blocks(vectors[:, 0], vectors[:, 1])
+
+    if kat:
+        vectors = np.concatenate((known_answers(), vectors))
+    return vectors
+
+
+def hex_lines(blocks, separator):
+    # 32 hex digits per block followed by separator, built with a table instead of formatting every block
+    blocks = blocks.reshape(-1, 16)
+    chars = np.empty((len(blocks), 33), dtype=np.uint8)
+    chars[:, 0:32:2] = HEX_DIGITS[blocks >> 4]
+    chars[:, 1:32:2] = HEX_DIGITS[blocks & 0xf]
+    chars[:, 32] = ord(separator)
+    return chars
+
+
+def write_memh(vectors, f):
+    f.write(hex_lines(vectors, "\n").tobytes())
+
+
+def write_hex(vectors, f):
+    chars = hex_lines(vectors, " ").reshape(len(vectors), 99)
+    chars[:, 98] = ord("\n")
+    f.write(chars.tobytes())
+
+
+def write_c(vectors, f):
+    lines = [
+        "/**",
+        " * AES test vectors (key, plaintext, ciphertext) generated by AES/python_version/gen_vectors.py.",
+        " * The bytes of each block are in the order encrypt() and decrypt() take them.",
+        " */",
+        "",
+        "#ifndef AESVECTORS_H_",
+        "#define AESVECTORS_H_",
+        "",
+        f"#define AES_NUM_VECTORS {len(vectors)}",
+        "",
+        "static const unsigned char aes_vectors[AES_NUM_VECTORS][3][16] = {",
+    ]
+    for vector in vectors:
+        blocks = [", ".join(f"0x{byte:02x}" for byte in block[::-1]) for block in vector]
+        lines.append("    {{" + "}, {".join(blocks) + "}},")
+    lines += ["};", "", "#endif /* AESVECTORS_H_ */", ""]
+    f.write("\n".join(lines).encode("ascii"))
+
+
+WRITERS = {"memh": write_memh, "c": write_c, "hex": write_hex}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--count", type=int, default=1000, help="number of random vectors")
+    parser.add_argument("--seed", type=int, default=391, help="seed for the random vectors")
+    parser.add_argument("--format", choices=WRITERS, default="memh")
+    parser.add_argument("--no-kat", action="store_true", help="leave out the known answer vectors")
+    parser.add_argument("-o", "--output", help="output file, stdout by default")
+    args = parser.parse_args()
+
+    vectors = generate(args.count, args.seed, not args.no_kat)
+
+    if args.output:
+        with open(args.output, "wb") as f:
+            WRITERS[args.format](vectors, f)
+    else:
+        WRITERS[args.format](vectors, sys.stdout.buffer)
+
+
+if __name__ == "__main__":
+    main()
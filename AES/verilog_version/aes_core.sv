@@ -0,0 +1,470 @@
+/**
+ * This module implements AES-128 encryption and decryption with a shared round key RAM.
+ * Expanded round keys are kept for KEY_SLOTS keys, so once a key has been expanded into a slot,
+ * blocks can be encrypted or decrypted with it at any time without another key expansion.
+ * The address details are as follows:
+ *    word 0: Write: first 32 bits of key, [7:0] is the lowest 8 bits, [15:8] is the second lowest 8 bits, etc.
+ *            Read: first 32 bits of the result block
+ *    word 1: Second 32 bits of key / result
+ *    word 2: Third 32 bits of key / result
+ *    word 3: Fourth 32 bits of key / result
+ *
+ *    word 4: First 32 bits of input block (plaintext or ciphertext)
+ *    word 5: Second 32 bits of input block
+ *    word 6: Third 32 bits of input block
+ *    word 7: Fourth 32 bits of input block
+ *
+ *    word 8: Expand the key in words 0-3 into the slot given by the written value
+ *    word 9: Encrypt the input block with the key in the slot given by the written value
+ *    word 10: Decrypt the input block with the key in the slot given by the written value
+ *    word 11: Read: [KEY_SLOTS-1:0] slots holding an expanded key. Write: forget the key in the given slot
+ *
+ *    word 12: DMA source address, must be 4 byte aligned
+ *    word 13: DMA destination address, must be 4 byte aligned
+ *    word 14: Start a DMA transfer, [15:0] number of blocks, [23:16] key slot, [24] decrypt, [25] raise irq when done,
+ *             [26] CTR mode, the number of blocks comes from word 20 and [15:0] and [24] are ignored
+ *    word 15: Read: DMA status, [0] busy, [1] done, [31:16] blocks left. Write: clear done and the irq
+ *
+ *    word 16: CTR counter, low 32 bits. Read: the counter for the next block
+ *    word 17: CTR counter, high 32 bits. Read: the counter for the next block
+ *    word 18: CTR nonce, low 32 bits
+ *    word 19: CTR nonce, high 32 bits
+ *    word 20: CTR length in bytes
+ *
+ * Like aes_encrypt.sv and aes_decrypt.sv, slave_waitrequest is held while a key expansion, encryption or
+ * decryption is running, so reading the result waits for it to finish. Key expansion takes 11 cycles and
+ * a block takes 12 cycles, one round per cycle.
+ *
+ * A DMA transfer reads each block from memory through the master port, encrypts or decrypts it and writes
+ * it back, without the CPU. Blocks in memory are in the byte order used by aesHwacc.c, so the results match
+ * encrypting each block through words 0-10. slave_waitrequest is not held during a DMA transfer so the
+ * status can be polled, other words must not be written until it is done.
+ *
+ * In CTR mode the DMA encrypts counter blocks instead of the blocks in memory and XORs the result with the
+ * data read from memory, so the same transfer encrypts and decrypts. Words 16-19 hold the first counter block
+ * in the same layout as the key words: written with aesHwacc.c it is the 8 byte nonce followed by a 64 bit big
+ * endian counter, which is incremented for every block. The length does not have to be a multiple of 16, the
+ * words after the last byte of the final block are neither read nor written and master_byteenable masks the
+ * bytes after it, so data after the end of the destination is left alone.
+ */
+
+module aes_core #(parameter KEY_SLOTS = 4, parameter SLOT_BITS = 2)
+               (input logic clk, input logic rst_n,
+               // outputs and inputs to and from master (most likely the HPS ARM processor)
+               output logic slave_waitrequest,
+               input logic [4:0] slave_address,
+               input logic slave_read, output logic [31:0] slave_readdata,
+               input logic slave_write, input logic [31:0] slave_writedata,
+               // DMA master to the memory holding the blocks
+               output logic [31:0] master_address,
+               output logic master_read, input logic [31:0] master_readdata,
+               output logic master_write, output logic [31:0] master_writedata,
+               output logic [3:0] master_byteenable,
+               input logic master_waitrequest,
+               output logic irq);
+
+    // Blocks and keys are packed, byte i is [8*i +: 8] with i = row * 4 + column
+
+    logic [127:0] key_in, block, result;
+
+    // round key RAM, the round keys of slot s are at s * 11 to s * 11 + 10
+    logic [127:0] round_keys [0:KEY_SLOTS*11-1];
+    logic [127:0] round_key;
+    logic [KEY_SLOTS-1:0] slot_valid;
+    logic [SLOT_BITS-1:0] slot;
+
+    // r_i is the round being computed, k_i is the index of the round key read for the next cycle
+    logic [3:0] r_i, k_i;
+    logic decrypting;
+
+    // key expansion
+    logic [127:0] kexp_key, kexp_next;
+    logic [31:0] kexp_subbed;
+    logic [7:0] rcon;
+
+    // round datapath
+    logic [127:0] subbed, inv_shifted, inv_subbed;
+    logic [127:0] enc_next, dec_next;
+
+    // DMA transfer, w_i is the word of the block being read or written
+    logic [31:0] dma_src, dma_dst;
+    logic [15:0] dma_blocks;
+    logic dma_busy, dma_done, dma_irq_en;
+    logic [1:0] w_i;
+
+    // CTR mode, data is the block read from memory and dma_left the bytes not written yet,
+    // last_w is the last word of the current block that is moved
+    logic [63:0] ctr_count, ctr_nonce;
+    logic [127:0] ctr_block, data;
+    logic [19:0] ctr_len, dma_left;
+    logic [15:0] start_blocks;
+    logic ctr_mode;
+    logic [1:0] last_w;
+
+    enum {START, KEXP, LOAD, FIRST, ROUND, DMA_READ, DMA_WRITE} state;
+
+    // xtime, multiply by 2 in GF(2^8)
+    function automatic logic [7:0] mult2(input logic [7:0] b);
+        mult2 = b[7] ? ((b << 1) ^ 8'h1b) : (b << 1);
+    endfunction
+
+    function automatic logic [127:0] shift_rows(input logic [127:0] s);
+        for (int row = 0; row < 4; row++) begin
+            for (int col = 0; col < 4; col++) begin
+                shift_rows[8*(row*4+col) +: 8] = s[8*(row*4+(col+row)%4) +: 8];
+            end
+        end
+    endfunction
+
+    function automatic logic [127:0] inv_shift_rows(input logic [127:0] s);
+        for (int row = 0; row < 4; row++) begin
+            for (int col = 0; col < 4; col++) begin
+                inv_shift_rows[8*(row*4+(col+row)%4) +: 8] = s[8*(row*4+col) +: 8];
+            end
+        end
+    endfunction
+
+    function automatic logic [127:0] mix_columns(input logic [127:0] s);
+        logic [7:0] a [0:3];
+        for (int col = 0; col < 4; col++) begin
+            for (int row = 0; row < 4; row++) begin
+                a[row] = s[8*(row*4+col) +: 8];
+            end
+            mix_columns[8*(0+col) +: 8]  = mult2(a[0]) ^ mult2(a[1]) ^ a[1] ^ a[2] ^ a[3];
+            mix_columns[8*(4+col) +: 8]  = mult2(a[1]) ^ mult2(a[2]) ^ a[2] ^ a[3] ^ a[0];
+            mix_columns[8*(8+col) +: 8]  = mult2(a[2]) ^ mult2(a[3]) ^ a[3] ^ a[0] ^ a[1];
+            mix_columns[8*(12+col) +: 8] = mult2(a[3]) ^ mult2(a[0]) ^ a[0] ^ a[1] ^ a[2];
+        end
+    endfunction
+
+    // Inverse column mixing, pre-multiplying each column by 4 * (a0 + a2) and 4 * (a1 + a3)
+    // turns it into mix_columns
+    function automatic logic [127:0] inv_mix_columns(input logic [127:0] s);
+        logic [127:0] t;
+        logic [7:0] u, v;
+        t = s;
+        for (int col = 0; col < 4; col++) begin
+            u = mult2(mult2(s[8*(0+col) +: 8] ^ s[8*(8+col) +: 8]));
+            v = mult2(mult2(s[8*(4+col) +: 8] ^ s[8*(12+col) +: 8]));
+            t[8*(0+col) +: 8]  = s[8*(0+col) +: 8] ^ u;
+            t[8*(4+col) +: 8]  = s[8*(4+col) +: 8] ^ v;
+            t[8*(8+col) +: 8]  = s[8*(8+col) +: 8] ^ u;
+            t[8*(12+col) +: 8] = s[8*(12+col) +: 8] ^ v;
+        end
+        inv_mix_columns = mix_columns(t);
+    endfunction
+
+    // 16 copies of each sbox so a whole round is done in one cycle
+    assign inv_shifted = inv_shift_rows(block);
+
+    genvar i;
+    generate
+        for (i = 0; i < 16; i++) begin : sboxes
+            aes_sbox sbox(.in(block[8*i +: 8]), .out(subbed[8*i +: 8]));
+            aes_inv_sbox inv_sbox(.in(inv_shifted[8*i +: 8]), .out(inv_subbed[8*i +: 8]));
+        end
+    endgenerate
+
+    // Encryption round r_i: SubBytes, ShiftRows, MixColumns (not in round 10), AddRoundKey
+    assign enc_next = (r_i === 4'd10 ? shift_rows(subbed) : mix_columns(shift_rows(subbed))) ^ round_key;
+    // Decryption round r_i: InvShiftRows, InvSubBytes, AddRoundKey, InvMixColumns (not in round 10)
+    assign dec_next = r_i === 4'd10 ? (inv_subbed ^ round_key) : inv_mix_columns(inv_subbed ^ round_key);
+
+    // Key expansion datapath, sboxes on the rotated last column of the previous round key
+    aes_sbox kexp_sbox0(.in(kexp_key[8*7 +: 8]),  .out(kexp_subbed[7:0]));
+    aes_sbox kexp_sbox1(.in(kexp_key[8*11 +: 8]), .out(kexp_subbed[15:8]));
+    aes_sbox kexp_sbox2(.in(kexp_key[8*15 +: 8]), .out(kexp_subbed[23:16]));
+    aes_sbox kexp_sbox3(.in(kexp_key[8*3 +: 8]),  .out(kexp_subbed[31:24]));
+
+    always @(*) begin
+        case (r_i)
+            4'd1: rcon = 8'h01;
+            4'd2: rcon = 8'h02;
+            4'd3: rcon = 8'h04;
+            4'd4: rcon = 8'h08;
+            4'd5: rcon = 8'h10;
+            4'd6: rcon = 8'h20;
+            4'd7: rcon = 8'h40;
+            4'd8: rcon = 8'h80;
+            4'd9: rcon = 8'h1b;
+            default: rcon = 8'h36;
+        endcase
+
+        for (int row = 0; row < 4; row++) begin
+            kexp_next[8*(row*4) +: 8] = kexp_key[8*(row*4) +: 8] ^ kexp_subbed[8*row +: 8] ^ (row == 0 ? rcon : 8'h00);
+            for (int col = 1; col < 4; col++) begin
+                kexp_next[8*(row*4+col) +: 8] = kexp_key[8*(row*4+col) +: 8] ^ kexp_next[8*(row*4+col-1) +: 8];
+            end
+        end
+    end
+
+    // Counter block, columns 0 and 1 hold the counter and columns 2 and 3 the nonce, like words 16-19
+    always @(*) begin
+        for (int row = 0; row < 4; row++) begin
+            ctr_block[8*(row*4+0) +: 8] = ctr_count[8*row +: 8];
+            ctr_block[8*(row*4+1) +: 8] = ctr_count[32+8*row +: 8];
+            ctr_block[8*(row*4+2) +: 8] = ctr_nonce[8*row +: 8];
+            ctr_block[8*(row*4+3) +: 8] = ctr_nonce[32+8*row +: 8];
+        end
+    end
+
+    // A CTR transfer covers the blocks holding the length, a partial last block stops after its last word
+    assign start_blocks = slave_writedata[26] ? ctr_len[19:4] + (ctr_len[3:0] !== 4'd0) : slave_writedata[15:0];
+    assign last_w = (!ctr_mode || dma_left >= 20'd16) ? 2'd3 : (dma_left[3:0] - 4'd1) >> 2;
+
+    always @(posedge clk) begin
+        // Synchronous read of the round key RAM, k_i is set up one cycle ahead
+        round_key <= round_keys[slot * 11 + k_i];
+
+        // Wait for reset
+        if (~rst_n) begin
+            state <= START;
+            slave_waitrequest <= 1'b1;
+            slot_valid <= 0;
+            r_i <= 4'd0;
+            k_i <= 4'd0;
+            dma_busy <= 1'b0;
+            dma_done <= 1'b0;
+            dma_irq_en <= 1'b0;
+            ctr_mode <= 1'b0;
+        end
+        else begin
+            case (state)
+                START: begin
+                    slave_waitrequest <= 1'b0;
+
+                    // a write held while an operation ran is taken once waitrequest is low, in the
+                    // first cycle back here it is still high and the master keeps the write up
+                    if (slave_write && !slave_waitrequest) begin
+                        case (slave_address)
+                            5'd0, 5'd1, 5'd2, 5'd3: begin
+                                key_in[8*(0+slave_address[1:0]) +: 8]  <= slave_writedata[7:0];
+                                key_in[8*(4+slave_address[1:0]) +: 8]  <= slave_writedata[15:8];
+                                key_in[8*(8+slave_address[1:0]) +: 8]  <= slave_writedata[23:16];
+                                key_in[8*(12+slave_address[1:0]) +: 8] <= slave_writedata[31:24];
+                            end
+                            5'd4, 5'd5, 5'd6, 5'd7: begin
+                                block[8*(0+slave_address[1:0]) +: 8]  <= slave_writedata[7:0];
+                                block[8*(4+slave_address[1:0]) +: 8]  <= slave_writedata[15:8];
+                                block[8*(8+slave_address[1:0]) +: 8]  <= slave_writedata[23:16];
+                                block[8*(12+slave_address[1:0]) +: 8] <= slave_writedata[31:24];
+                            end
+                            5'd8: begin
+                                // key expansion into the slot
+                                state <= KEXP;
+                                slave_waitrequest <= 1'b1;
+                                slot <= slave_writedata[SLOT_BITS-1:0];
+                                slot_valid[slave_writedata[SLOT_BITS-1:0]] <= 1'b0;
+                                kexp_key <= key_in;
+                                r_i <= 4'd0;
+                            end
+                            5'd9, 5'd10: begin
+                                // encryption uses round keys 0 to 10, decryption 10 down to 0
+                                state <= LOAD;
+                                slave_waitrequest <= 1'b1;
+                                slot <= slave_writedata[SLOT_BITS-1:0];
+                                decrypting <= slave_address === 5'd10;
+                                ctr_mode <= 1'b0;
+                                k_i <= slave_address === 5'd10 ? 4'd10 : 4'd0;
+                            end
+                            5'd11: begin
+                                slot_valid[slave_writedata[SLOT_BITS-1:0]] <= 1'b0;
+                            end
+                            5'd12: begin
+                                dma_src <= slave_writedata;
+                            end
+                            5'd13: begin
+                                dma_dst <= slave_writedata;
+                            end
+                            5'd14: begin
+                                // start a DMA transfer, waitrequest stays low so the status can be read,
+                                // CTR mode only ever encrypts
+                                slot <= slave_writedata[16 +: SLOT_BITS];
+                                decrypting <= slave_writedata[24] && !slave_writedata[26];
+                                ctr_mode <= slave_writedata[26];
+                                dma_irq_en <= slave_writedata[25];
+                                dma_blocks <= start_blocks;
+                                dma_left <= ctr_len;
+                                dma_done <= start_blocks === 16'd0;
+                                dma_busy <= start_blocks !== 16'd0;
+                                w_i <= 2'd0;
+                                if (start_blocks !== 16'd0) begin
+                                    state <= DMA_READ;
+                                end
+                            end
+                            5'd15: begin
+                                dma_done <= 1'b0;
+                            end
+                            5'd16: begin
+                                ctr_count[31:0] <= slave_writedata;
+                            end
+                            5'd17: begin
+                                ctr_count[63:32] <= slave_writedata;
+                            end
+                            5'd18: begin
+                                ctr_nonce[31:0] <= slave_writedata;
+                            end
+                            5'd19: begin
+                                ctr_nonce[63:32] <= slave_writedata;
+                            end
+                            5'd20: begin
+                                ctr_len <= slave_writedata[19:0];
+                            end
+                            default: begin
+                            end
+                        endcase
+                    end
+                end
+
+                // state to perform key expansion, one round key per cycle, round key 0 is the key itself
+                KEXP: begin
+                    if (r_i === 4'd0) begin
+                        round_keys[slot * 11] <= kexp_key;
+                    end
+                    else begin
+                        round_keys[slot * 11 + r_i] <= kexp_next;
+                        kexp_key <= kexp_next;
+                    end
+
+                    if (r_i === 4'd10) begin
+                        state <= START;
+                        slot_valid[slot] <= 1'b1;
+                        r_i <= 4'd0;
+                    end
+                    else begin
+                        r_i <= r_i + 4'd1;
+                    end
+                end
+
+                // state to wait for the first round key to be read
+                LOAD: begin
+                    state <= FIRST;
+                    k_i <= decrypting ? k_i - 4'd1 : k_i + 4'd1;
+                end
+
+                // state for the initial AddRoundKey
+                FIRST: begin
+                    state <= ROUND;
+                    block <= block ^ round_key;
+                    r_i <= 4'd1;
+                    k_i <= decrypting ? k_i - 4'd1 : k_i + 4'd1;
+                end
+
+                // state for round function, the round key for r_i was read in the previous cycle
+                ROUND: begin
+                    block <= decrypting ? dec_next : enc_next;
+
+                    if (r_i === 4'd10) begin
+                        state <= dma_busy ? DMA_WRITE : START;
+                        // in CTR mode the encrypted counter is the keystream for the data
+                        result <= ctr_mode ? enc_next ^ data : (decrypting ? dec_next : enc_next);
+                        r_i <= 4'd0;
+                        k_i <= 4'd0;
+                        w_i <= 2'd0;
+                    end
+                    else begin
+                        r_i <= r_i + 4'd1;
+                        // stay inside the slot after the last round key
+                        if (k_i !== 4'd0 && k_i !== 4'd10) begin
+                            k_i <= decrypting ? k_i - 4'd1 : k_i + 4'd1;
+                        end
+                    end
+                end
+
+                // state to read the next block from memory, one word per transfer
+                DMA_READ: begin
+                    if (!master_waitrequest) begin
+                        // memory word w_i holds column 3 - w_i, most significant byte first
+                        for (int row = 0; row < 4; row++) begin
+                            if (ctr_mode) begin
+                                data[8*(row*4+3-w_i) +: 8] <= master_readdata[8*(3-row) +: 8];
+                            end
+                            else begin
+                                block[8*(row*4+3-w_i) +: 8] <= master_readdata[8*(3-row) +: 8];
+                            end
+                        end
+
+                        w_i <= w_i + 2'd1;
+                        if (w_i === last_w) begin
+                            state <= LOAD;
+                            k_i <= decrypting ? 4'd10 : 4'd0;
+
+                            // the block to encrypt is the next counter block
+                            if (ctr_mode) begin
+                                block <= ctr_block;
+                                ctr_count <= ctr_count + 64'd1;
+                            end
+                        end
+                    end
+                end
+
+                // state to write the result block to memory
+                DMA_WRITE: begin
+                    if (!master_waitrequest) begin
+                        w_i <= w_i + 2'd1;
+                        if (w_i === last_w) begin
+                            dma_src <= dma_src + 32'd16;
+                            dma_dst <= dma_dst + 32'd16;
+                            dma_blocks <= dma_blocks - 16'd1;
+                            dma_left <= dma_left >= 20'd16 ? dma_left - 20'd16 : 20'd0;
+
+                            if (dma_blocks === 16'd1) begin
+                                state <= START;
+                                dma_busy <= 1'b0;
+                                dma_done <= 1'b1;
+                            end
+                            else begin
+                                state <= DMA_READ;
+                            end
+                        end
+                    end
+                end
+
+                default: begin
+                    state <= START;
+                    slave_waitrequest <= 1'b1;
+                end
+            endcase
+        end
+    end
+
+    // DMA master, one 32 bit word per transfer
+    always @(*) begin
+        master_read = state == DMA_READ;
+        master_write = state == DMA_WRITE;
+        master_address = (state == DMA_WRITE ? dma_dst : dma_src) + {w_i, 2'b00};
+        for (int row = 0; row < 4; row++) begin
+            master_writedata[8*(3-row) +: 8] = result[8*(row*4+3-w_i) +: 8];
+        end
+        // byte b of a memory word is byte 4 * w_i + b of the block
+        for (int b = 0; b < 4; b++) begin
+            master_byteenable[b] = !ctr_mode || dma_left >= 20'd16 || ({w_i, 2'b00} + b) < dma_left;
+        end
+    end
+
+    assign irq = dma_done && dma_irq_en;
+
+    // Outputting data when CPU reads
+    always @(*) begin
+        slave_readdata <= 0;
+        if (slave_read) begin
+            if (slave_address <= 5'd3) begin
+                slave_readdata <= {result[8*(12+slave_address[1:0]) +: 8], result[8*(8+slave_address[1:0]) +: 8],
+                                   result[8*(4+slave_address[1:0]) +: 8], result[8*(0+slave_address[1:0]) +: 8]};
+            end
+            else if (slave_address === 5'd11) begin
+                slave_readdata <= slot_valid;
+            end
+            else if (slave_address === 5'd15) begin
+                slave_readdata <= {dma_blocks, 14'b0, dma_done, dma_busy};
+            end
+            else if (slave_address === 5'd16) begin
+                slave_readdata <= ctr_count[31:0];
+            end
+            else if (slave_address === 5'd17) begin
+                slave_readdata <= ctr_count[63:32];
+            end
+        end
+    end
+
+endmodule: aes_core
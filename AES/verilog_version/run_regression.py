@@ -0,0 +1,130 @@
+"""
+This module runs the AES regression and latency benchmark (tb_aes_regression.sv) on the host.
+It generates the test vectors with gen_vectors.py (NIST known answer vectors plus random keys and
+blocks), builds aes_encrypt, aes_decrypt and aes_core with Icarus Verilog or Verilator,
+and fails if any block is wrong or if a core takes more cycles than latency_baseline.txt allows.
+
+Usage: python3 run_regression.py [--vectors N] [--seed S] [--sim icarus|verilator] [--update-baseline]
+"""
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.join(HERE, "..", "python_version"))
+import gen_vectors
+
+BUILD_DIR = os.path.join(HERE, "regression_build")
+BASELINE = os.path.join(HERE, "latency_baseline.txt")
+MAX_VECTORS = 10000  # MAX_VECTORS in tb_aes_regression.sv
+SOURCES = ["tb_aes_regression.sv", "aes_encrypt.sv", "aes_decrypt.sv", "aes_core.sv", "aes_sbox.sv", "aes_inv_sbox.sv"]
+
+# Plusarg of each latency reported by the testbench
+LIMIT_ARGS = {
+    "aes_encrypt_kexp": "MAX_ENC_KEXP",
+    "aes_encrypt_block": "MAX_ENC_BLOCK",
+    "aes_decrypt_kexp": "MAX_DEC_KEXP",
+    "aes_decrypt_block": "MAX_DEC_BLOCK",
+    "aes_core_kexp": "MAX_CORE_KEXP",
+    "aes_core_encrypt": "MAX_CORE_ENC",
+    "aes_core_decrypt": "MAX_CORE_DEC",
+}
+
+
+def generate_vectors(num_random, seed):
+    vectors = gen_vectors.generate(num_random, seed)
+    with open(os.path.join(BUILD_DIR, "regression_vectors.memh"), "wb") as f:
+        gen_vectors.write_memh(vectors, f)
+    return len(vectors)
+
+
+def read_baseline():
+    baseline = {}
+    with open(BASELINE) as f:
+        for line in f:
+            line = line.split("#")[0].split()
+            if len(line) == 2:
+                baseline[line[0]] = int(line[1])
+    return baseline
+
+
+def write_baseline(cycles):
+    with open(BASELINE, "w") as f:
+        f.write("# Cycles from the start write to done (aes_core: to waitrequest low) for one block, run_regression.py\n")
+        f.write("# fails if a core takes longer. kexp includes the key expansion, block uses the already expanded key.\n")
+        for name in LIMIT_ARGS:
+            f.write(f"{name} {cycles[name]}\n")
+
+
+def build(sim):
+    sources = [os.path.join(HERE, source) for source in SOURCES]
+
+    if sim == "icarus":
+        binary = os.path.join(BUILD_DIR, "tb_aes_regression.vvp")
+        subprocess.run(["iverilog", "-g2012", "-o", binary] + sources, check=True)
+        return ["vvp", "-n", binary]
+
+    subprocess.run(["verilator", "--binary", "--timing", "-Wno-fatal", "-Wno-BLKANDNBLK",
+                    "--top-module", "tb_aes_regression", "-Mdir", os.path.join(BUILD_DIR, "obj_dir")] + sources,
+                   check=True, stdout=subprocess.DEVNULL)
+    return [os.path.join(BUILD_DIR, "obj_dir", "Vtb_aes_regression")]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--vectors", type=int, default=2000, help="number of random vectors")
+    parser.add_argument("--seed", type=int, default=391, help="seed for the random vectors")
+    parser.add_argument("--sim", choices=["icarus", "verilator"], help="simulator, the first one found by default")
+    parser.add_argument("--update-baseline", action="store_true", help="save the measured latencies as the baseline")
+    args = parser.parse_args()
+
+    sim = args.sim
+    if sim is None:
+        sim = "icarus" if shutil.which("iverilog") else "verilator" if shutil.which("verilator") else None
+    if sim is None:
+        sys.exit("Neither Icarus Verilog (iverilog) nor Verilator was found")
+
+    if args.vectors + len(gen_vectors.KNOWN_ANSWERS) > MAX_VECTORS:
+        sys.exit(f"At most {MAX_VECTORS - len(gen_vectors.KNOWN_ANSWERS)} random vectors fit in the testbench")
+
+    os.makedirs(BUILD_DIR, exist_ok=True)
+    num_vectors = generate_vectors(args.vectors, args.seed)
+
+    command = build(sim) + [f"+VECTORS={num_vectors}"]
+    if not args.update_baseline:
+        baseline = read_baseline()
+        command += [f"+{LIMIT_ARGS[name]}={baseline[name]}" for name in LIMIT_ARGS]
+
+    # The testbench reads the vectors from its working directory
+    result = subprocess.run(command, cwd=BUILD_DIR, stdout=subprocess.PIPE, universal_newlines=True)
+    print(result.stdout, end="")
+
+    cycles = {}
+    passed = False
+    for line in result.stdout.splitlines():
+        words = line.split()
+        if len(words) == 4 and words[0] == "CYCLES":
+            cycles[words[1]] = int(words[2])
+        elif line.startswith("PASSED"):
+            passed = True
+
+    if len(cycles) != len(LIMIT_ARGS):
+        sys.exit("The simulation did not report the latencies")
+
+    print()
+    for name in LIMIT_ARGS:
+        print(f"{name}: {cycles[name]} cycles per block")
+
+    if args.update_baseline and passed:
+        write_baseline(cycles)
+        print("Baseline updated")
+
+    if not passed:
+        sys.exit("FAILED")
+
+
+if __name__ == "__main__":
+    main()
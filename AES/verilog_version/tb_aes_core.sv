@@ -0,0 +1,158 @@
+`timescale 1 ps / 1 ps
+
+module tb_aes_core();
+    logic clk, rst_n;
+    logic slave_waitrequest, slave_read, slave_write;
+    logic [4:0] slave_address;
+    logic [31:0] slave_readdata, slave_writedata;
+
+    // the DMA master is not used here, see tb_aes_core_dma.sv
+    logic [31:0] master_address, master_readdata, master_writedata;
+    logic [3:0] master_byteenable;
+    logic master_read, master_write, master_waitrequest, irq;
+    assign master_readdata = 32'b0;
+    assign master_waitrequest = 1'b1;
+
+    logic [7:0] mem_content [0:527];
+    logic [7:0] ref_content [0:255];
+
+    int errors;
+
+    aes_core dut(.*);
+
+    initial begin
+        clk = 1'b0;
+        forever #10 clk = ~clk;
+    end
+
+    // Avalon write, held until the dut releases waitrequest
+    task write_word(input logic [4:0] address, input logic [31:0] data);
+        @(posedge clk);
+        #2;
+        slave_write = 1'b1;
+        slave_read = 1'b0;
+        slave_address = address;
+        slave_writedata = data;
+        while (slave_waitrequest) begin
+            @(posedge clk);
+            #2;
+        end
+        @(posedge clk);
+        #2;
+        slave_write = 1'b0;
+    endtask
+
+    // Avalon read, waits for the running operation to finish
+    task read_word(input logic [4:0] address, output logic [31:0] data);
+        @(posedge clk);
+        #2;
+        slave_read = 1'b1;
+        slave_address = address;
+        #1;
+        while (slave_waitrequest) begin
+            @(posedge clk);
+            #1;
+        end
+        data = slave_readdata;
+        @(posedge clk);
+        #2;
+        slave_read = 1'b0;
+    endtask
+
+    // Words of the key and plaintext loaded from mem_content0.memh
+    function logic [31:0] mem_word(input int base);
+        mem_word = (mem_content[base + 3] << 24) + (mem_content[base + 2] << 16) + (mem_content[base + 1] << 8) + mem_content[base];
+    endfunction
+
+    // Read the result block and compare it with 16 bytes of mem_content/ref_content starting at base
+    task check_result(input logic use_ref, input int base);
+        logic [31:0] data;
+        logic [7:0] expected;
+        for (int w = 0; w < 4; w++) begin
+            read_word(w, data);
+            for (int b = 0; b < 4; b++) begin
+                expected = use_ref ? ref_content[base + 4 * w + b] : mem_content[base + 4 * w + b];
+                if (data[8*b +: 8] !== expected) begin
+                    errors++;
+                end
+            end
+        end
+    endtask
+
+    // A start write acted on more than once never completes
+    initial begin
+        #100000;
+        $display("FAILED: timeout");
+        $stop;
+    end
+
+    initial begin
+        logic [31:0] status;
+        int start;
+
+        slave_address = 5'b0;
+        slave_read = 1'b0;
+        slave_write = 1'b0;
+        errors = 0;
+
+        rst_n = 1'b0;
+        @(posedge clk);
+        @(posedge clk);
+        rst_n = 1'b1;
+
+        // RUN aes.py BEFORE RUNNING THE TESTBENCH
+        $readmemh("./mem_content0.memh", mem_content);
+        $readmemh("./ref_content0.memh", ref_content);
+
+        // Expand the key into slot 2
+        for (int w = 0; w < 4; w++) begin
+            write_word(w, mem_word(256 + 4 * w));
+        end
+        start = $time;
+        write_word(4'd8, 32'd2);
+        read_word(4'd11, status);
+        $display("Key expansion: %0d cycles", ($time - start) / 20);
+        assert(status[3:0] === 4'b0100);
+
+        // Encrypt the plaintext with slot 2
+        for (int w = 0; w < 4; w++) begin
+            write_word(4'd4 + w, mem_word(272 + 4 * w));
+        end
+        write_word(4'd9, 32'd2);
+        check_result(1'b1, 0);
+
+        // Decrypt the ciphertext with the same slot, no key expansion in between
+        for (int w = 0; w < 4; w++) begin
+            write_word(4'd4 + w, (ref_content[4 * w + 3] << 24) + (ref_content[4 * w + 2] << 16) +
+                                 (ref_content[4 * w + 1] << 8) + ref_content[4 * w]);
+        end
+        start = $time;
+        write_word(4'd10, 32'd2);
+        check_result(1'b0, 272);
+        $display("Decryption: %0d cycles including the result read", ($time - start) / 20);
+
+        // Expand the key again and encrypt right away, the encryption write is held until the expansion
+        // is done and must start exactly one encryption
+        for (int w = 0; w < 4; w++) begin
+            write_word(4'd4 + w, mem_word(272 + 4 * w));
+        end
+        write_word(4'd8, 32'd2);
+        write_word(4'd9, 32'd2);
+        check_result(1'b1, 0);
+
+        // Forget the slot
+        write_word(4'd11, 32'd2);
+        read_word(4'd11, status);
+        assert(status[3:0] === 4'b0000);
+
+        if (errors == 0) begin
+            $display("PASSED");
+        end
+        else begin
+            $display("FAILED: %0d wrong bytes", errors);
+        end
+
+        #400;
+        $stop;
+    end
+endmodule: tb_aes_core
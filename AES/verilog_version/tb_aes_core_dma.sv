@@ -0,0 +1,268 @@
+`timescale 1 ps / 1 ps
+
+module tb_aes_core_dma();
+    logic clk, rst_n;
+    logic slave_waitrequest, slave_read, slave_write;
+    logic [4:0] slave_address;
+    logic [31:0] slave_readdata, slave_writedata;
+    logic [31:0] master_address, master_readdata, master_writedata;
+    logic [3:0] master_byteenable;
+    logic master_read, master_write, master_waitrequest;
+    logic irq;
+
+    logic [7:0] mem_content [0:527];
+    logic [7:0] ref_content [0:255];
+
+    // Avalon memory model, 4 KB of 32 bit words
+    logic [31:0] memory [0:1023];
+
+    localparam NUM_BLOCKS = 8;
+    localparam SRC = 32'h100;
+    localparam DST = 32'h400;
+    localparam DST2 = 32'h800;
+
+    // CTR test, a length that ends in the middle of a word of the last block
+    localparam CTR_LEN = 16 * NUM_BLOCKS - 6;
+    localparam CTR_NONCE = 64'h0123456789abcdef;
+    localparam CTR_START = 64'h00000000fffffffe;
+    localparam SENTINEL = 32'hdeadbeef;
+
+    int errors;
+
+    aes_core dut(.*);
+
+    initial begin
+        clk = 1'b0;
+        forever #10 clk = ~clk;
+    end
+
+    // The memory stalls transfers at random, reads return data in the cycle waitrequest is low
+    always @(posedge clk) begin
+        if (master_write && !master_waitrequest) begin
+            for (int b = 0; b < 4; b++) begin
+                if (master_byteenable[b]) begin
+                    memory[master_address[11:2]][8*b +: 8] <= master_writedata[8*b +: 8];
+                end
+            end
+        end
+        master_waitrequest <= ($urandom % 3) == 0;
+    end
+
+    assign master_readdata = memory[master_address[11:2]];
+
+    task write_word(input logic [4:0] address, input logic [31:0] data);
+        @(posedge clk);
+        #2;
+        slave_write = 1'b1;
+        slave_read = 1'b0;
+        slave_address = address;
+        slave_writedata = data;
+        while (slave_waitrequest) begin
+            @(posedge clk);
+            #2;
+        end
+        @(posedge clk);
+        #2;
+        slave_write = 1'b0;
+    endtask
+
+    task read_word(input logic [4:0] address, output logic [31:0] data);
+        @(posedge clk);
+        #2;
+        slave_read = 1'b1;
+        slave_address = address;
+        #1;
+        while (slave_waitrequest) begin
+            @(posedge clk);
+            #1;
+        end
+        data = slave_readdata;
+        @(posedge clk);
+        #2;
+        slave_read = 1'b0;
+    endtask
+
+    function logic [31:0] mem_word(input int base);
+        mem_word = (mem_content[base + 3] << 24) + (mem_content[base + 2] << 16) + (mem_content[base + 1] << 8) + mem_content[base];
+    endfunction
+
+    // aesHwacc.c reverses the 16 bytes of a block, memory word i holds column 3 - i most significant byte first
+    function logic [31:0] block_word(input logic use_ref, input int base, input int i);
+        int b;
+        b = base + 4 * (3 - i);
+        if (use_ref) begin
+            block_word = (ref_content[b] << 24) + (ref_content[b + 1] << 16) + (ref_content[b + 2] << 8) + ref_content[b + 3];
+        end
+        else begin
+            block_word = (mem_content[b] << 24) + (mem_content[b + 1] << 16) + (mem_content[b + 2] << 8) + mem_content[b + 3];
+        end
+    endfunction
+
+    // Start a transfer with the key in slot 1 and wait for the irq
+    task run_dma(input logic [31:0] src, input logic [31:0] dst, input logic decrypting);
+        logic [31:0] status;
+        int start;
+
+        write_word(4'd12, src);
+        write_word(4'd13, dst);
+        start = $time;
+        write_word(4'd14, NUM_BLOCKS | (32'd1 << 16) | (decrypting << 24) | (32'd1 << 25));
+
+        // The status can be read while the transfer is running
+        read_word(4'd15, status);
+        assert(status[0] === 1'b1);
+
+        @(posedge irq);
+        $display("%s: %0d blocks in %0d cycles", decrypting ? "Decrypt" : "Encrypt", NUM_BLOCKS, ($time - start) / 20);
+
+        read_word(4'd15, status);
+        assert(status[1:0] === 2'b10);
+        assert(status[31:16] === 16'd0);
+        write_word(4'd15, 32'd0);
+        #1;
+        assert(irq === 1'b0);
+    endtask
+
+    // Keystream block n of the CTR test, encrypting the counter block through words 4-9
+    task keystream(input int n, output logic [31:0] ks [0:3]);
+        logic [63:0] count;
+        logic [31:0] data;
+        count = CTR_START + n;
+        write_word(5'd4, count[31:0]);
+        write_word(5'd5, count[63:32]);
+        write_word(5'd6, CTR_NONCE[31:0]);
+        write_word(5'd7, CTR_NONCE[63:32]);
+        write_word(5'd9, 32'd1);
+
+        // result word i is memory word 3 - i, most significant byte first
+        for (int i = 0; i < 4; i++) begin
+            read_word(i, data);
+            ks[3 - i] = {data[7:0], data[15:8], data[23:16], data[31:24]};
+        end
+    endtask
+
+    task run_ctr(input logic [31:0] src, input logic [31:0] dst);
+        logic [31:0] status;
+        int start;
+
+        write_word(5'd12, src);
+        write_word(5'd13, dst);
+        write_word(5'd16, CTR_START[31:0]);
+        write_word(5'd17, CTR_START[63:32]);
+        write_word(5'd18, CTR_NONCE[31:0]);
+        write_word(5'd19, CTR_NONCE[63:32]);
+        write_word(5'd20, CTR_LEN);
+        start = $time;
+        write_word(5'd14, (32'd1 << 16) | (32'd1 << 25) | (32'd1 << 26));
+
+        @(posedge irq);
+        $display("CTR: %0d bytes in %0d cycles", CTR_LEN, ($time - start) / 20);
+
+        // The counter carried into the high word and points after the last block
+        read_word(5'd16, status);
+        assert(status === CTR_START[31:0] + NUM_BLOCKS);
+        read_word(5'd17, status);
+        assert(status === 32'd1);
+        write_word(5'd15, 32'd0);
+    endtask
+
+    initial begin
+        logic [31:0] ks [0:3];
+        logic [31:0] expected;
+
+        slave_address = 5'b0;
+        slave_read = 1'b0;
+        slave_write = 1'b0;
+        master_waitrequest = 1'b1;
+        errors = 0;
+
+        rst_n = 1'b0;
+        @(posedge clk);
+        @(posedge clk);
+        rst_n = 1'b1;
+
+        // RUN aes.py BEFORE RUNNING THE TESTBENCH
+        $readmemh("./mem_content0.memh", mem_content);
+        $readmemh("./ref_content0.memh", ref_content);
+
+        // Expand the key into slot 1
+        for (int w = 0; w < 4; w++) begin
+            write_word(w, mem_word(256 + 4 * w));
+        end
+        write_word(4'd8, 32'd1);
+
+        // Copies of the plaintext block in memory
+        for (int n = 0; n < NUM_BLOCKS; n++) begin
+            for (int i = 0; i < 4; i++) begin
+                memory[SRC / 4 + 4 * n + i] = block_word(1'b0, 272, i);
+            end
+        end
+
+        run_dma(SRC, DST, 1'b0);
+        for (int n = 0; n < NUM_BLOCKS; n++) begin
+            for (int i = 0; i < 4; i++) begin
+                if (memory[DST / 4 + 4 * n + i] !== block_word(1'b1, 0, i)) begin
+                    errors++;
+                end
+            end
+        end
+
+        // Decrypt the ciphertext back
+        run_dma(DST, DST2, 1'b1);
+        for (int n = 0; n < NUM_BLOCKS; n++) begin
+            for (int i = 0; i < 4; i++) begin
+                if (memory[DST2 / 4 + 4 * n + i] !== block_word(1'b0, 272, i)) begin
+                    errors++;
+                end
+            end
+        end
+
+        // CTR: the plaintext blocks XOR the encrypted counter blocks, the bytes after the length are not written
+        for (int n = 0; n < 4 * NUM_BLOCKS + 1; n++) begin
+            memory[DST / 4 + n] = SENTINEL;
+            memory[DST2 / 4 + n] = SENTINEL;
+        end
+        run_ctr(SRC, DST);
+        for (int n = 0; n < NUM_BLOCKS; n++) begin
+            keystream(n, ks);
+            for (int i = 0; i < 4; i++) begin
+                expected = memory[SRC / 4 + 4 * n + i] ^ ks[i];
+                for (int b = 0; b < 4; b++) begin
+                    if (16 * n + 4 * i + b >= CTR_LEN) begin
+                        expected[8*b +: 8] = SENTINEL[8*b +: 8];
+                    end
+                end
+                if (memory[DST / 4 + 4 * n + i] !== expected) begin
+                    errors++;
+                end
+            end
+        end
+        if (memory[DST / 4 + 4 * NUM_BLOCKS] !== SENTINEL) begin
+            errors++;
+        end
+
+        // Running CTR again on the ciphertext gives the plaintext back
+        run_ctr(DST, DST2);
+        for (int n = 0; n < 4 * NUM_BLOCKS; n++) begin
+            expected = memory[SRC / 4 + n];
+            for (int b = 0; b < 4; b++) begin
+                if (4 * n + b >= CTR_LEN) begin
+                    expected[8*b +: 8] = SENTINEL[8*b +: 8];
+                end
+            end
+            if (memory[DST2 / 4 + n] !== expected) begin
+                errors++;
+            end
+        end
+
+        if (errors == 0) begin
+            $display("PASSED");
+        end
+        else begin
+            $display("FAILED: %0d wrong words", errors);
+        end
+
+        #400;
+        $stop;
+    end
+endmodule: tb_aes_core_dma
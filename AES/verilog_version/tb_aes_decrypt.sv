@@ -2,13 +2,18 @@
 
 module tb_aes_decrypt();
     logic clk, rst_n;
-    logic slave_waitrequest, slave_read, slave_write;
+    logic slave_read, slave_write, irq;
     logic [3:0] slave_address;
     logic [31:0] slave_readdata, slave_writedata;
 
     logic [7:0] mem_content [0:783];
     logic [7:0] ref_content [0:255];
 
+    // standalone copies of the sbox ROMs used by the dut, checked against aes.py
+    logic [7:0] rom_in, sbox_out, r_sbox_out;
+    aes_sbox sbox_check(.in(rom_in), .out(sbox_out));
+    aes_inv_sbox r_sbox_check(.in(rom_in), .out(r_sbox_out));
+
     aes_decrypt dut(.*);
 
     initial begin
@@ -16,10 +21,36 @@ module tb_aes_decrypt();
         forever #10 clk = ~clk;
     end
 
+    // Avalon write, the module never stalls the bus
+    task write_word(input logic [3:0] address, input logic [31:0] data);
+        @(posedge clk);
+        #2;
+        slave_write = 1'b1;
+        slave_address = address;
+        slave_writedata = data;
+        @(posedge clk);
+        #2;
+        slave_write = 1'b0;
+    endtask
+
+    // Status in word 10, [0] busy and [1] done
+    task check_status(input logic [1:0] expected);
+        slave_read = 1'b1;
+        slave_address = 4'd10;
+        #2;
+        assert(slave_readdata[1:0] === expected);
+        slave_read = 1'b0;
+    endtask
+
+    function logic [31:0] mem_word(input int base);
+        mem_word = (mem_content[base + 3] << 24) + (mem_content[base + 2] << 16) + (mem_content[base + 1] << 8) + mem_content[base];
+    endfunction
+
     initial begin
         slave_address = 4'b0;
         slave_read = 1'b0;
         slave_write = 1'b0;
+        rst_n = 1'b0;
 
         // RUN aes.py BEFORE RUNNING THE TESTBENCH
         @(posedge clk);
@@ -27,6 +58,7 @@ module tb_aes_decrypt();
         $readmemh("./ref_content1.memh", ref_content);
 
         @(posedge clk);
+        rst_n = 1'b1;
         #2;
         slave_write = 1'b1;
         slave_address = 4'd4;
@@ -67,6 +99,11 @@ module tb_aes_decrypt();
         slave_address = 4'd3;
         slave_writedata = (mem_content[527] << 24) + (mem_content[526] << 16) + (mem_content[525] << 8) + (mem_content[524]);
 
+        @(posedge clk);
+        #2;
+        slave_address = 4'd11;
+        slave_writedata = 32'h01;
+
         @(posedge clk);
         #2;
         slave_address = 4'd8;
@@ -81,14 +118,27 @@ module tb_aes_decrypt();
         @(posedge clk);
         @(posedge clk);
         for (int i = 9'd0; i < 9'd256; i++) begin
-            assert(dut.sbox[i] === mem_content[i]);
+            rom_in = i;
+            #1;
+            assert(sbox_out === mem_content[i]);
+            assert(r_sbox_out === mem_content[i + 10'd256]);
         end
 
-        for (int i = 9'd0; i < 9'd256; i++) begin
-            assert(dut.r_sbox[i] === mem_content[i + 10'd256]);
-        end
+        // the bus is not stalled, the status shows the module is busy until the irq
+        slave_read = 1'b1;
+        slave_address = 4'd10;
+        #2;
+        assert(slave_readdata[1:0] === 2'b01);
+        slave_read = 1'b0;
+
+        @(posedge irq);
+        #2;
+        slave_read = 1'b1;
+        slave_address = 4'd10;
+        #2;
+        assert(slave_readdata[1:0] === 2'b10);
+        slave_read = 1'b0;
 
-        @(posedge dut.done);
         @(posedge clk);
         @(posedge clk);
         @(posedge clk);
@@ -132,6 +182,50 @@ module tb_aes_decrypt();
         assert(slave_readdata[23:16] === ref_content[14]);
         assert(slave_readdata[31:24] === ref_content[15]);
 
+        // clearing done drops the irq
+        @(posedge clk);
+        #2;
+        slave_read = 1'b0;
+        slave_write = 1'b1;
+        slave_address = 4'd10;
+        @(posedge clk);
+        #2;
+        slave_write = 1'b0;
+        assert(irq === 1'b0);
+
+        // writing word 4 while the module is busy abandons the block, it never gets done or raises the irq
+        write_word(4'd9, 32'h01);
+        repeat (8) @(posedge clk);
+        #2;
+        check_status(2'b01);
+        write_word(4'd4, mem_word(528));
+        check_status(2'b00);
+        repeat (120) @(posedge clk);
+        check_status(2'b00);
+        assert(irq === 1'b0);
+
+        // the expanded key is kept, the block written again gives the same result
+        for (int w = 1; w < 4; w++) begin
+            write_word(w + 4, mem_word(528 + 4 * w));
+        end
+        write_word(4'd9, 32'h01);
+        @(posedge irq);
+        #2;
+        slave_read = 1'b1;
+        for (int w = 0; w < 4; w++) begin
+            slave_address = w;
+            #2;
+            assert(slave_readdata === {ref_content[4 * w + 3], ref_content[4 * w + 2], ref_content[4 * w + 1], ref_content[4 * w]});
+        end
+        slave_read = 1'b0;
+
+        // with the irq disabled only the status shows the block is done
+        write_word(4'd11, 32'h00);
+        write_word(4'd9, 32'h01);
+        repeat (120) @(posedge clk);
+        check_status(2'b10);
+        assert(irq === 1'b0);
+
         #400;
         $stop;
     end
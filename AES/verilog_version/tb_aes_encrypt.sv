@@ -2,13 +2,17 @@
 
 module tb_aes_encrypt();
     logic clk, rst_n;
-    logic slave_waitrequest, slave_read, slave_write;
+    logic slave_read, slave_write, irq;
     logic [3:0] slave_address;
     logic [31:0] slave_readdata, slave_writedata;
 
     logic [7:0] mem_content [0:527];
     logic [7:0] ref_content [0:255];
 
+    // standalone copies of the sbox ROMs used by the dut, checked against aes.py
+    logic [7:0] rom_in, sbox_out;
+    aes_sbox sbox_check(.in(rom_in), .out(sbox_out));
+
     aes_encrypt dut(.*);
 
     initial begin
@@ -16,10 +20,36 @@ module tb_aes_encrypt();
         forever #10 clk = ~clk;
     end
 
+    // Avalon write, the module never stalls the bus
+    task write_word(input logic [3:0] address, input logic [31:0] data);
+        @(posedge clk);
+        #2;
+        slave_write = 1'b1;
+        slave_address = address;
+        slave_writedata = data;
+        @(posedge clk);
+        #2;
+        slave_write = 1'b0;
+    endtask
+
+    // Status in word 10, [0] busy and [1] done
+    task check_status(input logic [1:0] expected);
+        slave_read = 1'b1;
+        slave_address = 4'd10;
+        #2;
+        assert(slave_readdata[1:0] === expected);
+        slave_read = 1'b0;
+    endtask
+
+    function logic [31:0] mem_word(input int base);
+        mem_word = (mem_content[base + 3] << 24) + (mem_content[base + 2] << 16) + (mem_content[base + 1] << 8) + mem_content[base];
+    endfunction
+
     initial begin
         slave_address = 4'b0;
         slave_read = 1'b0;
         slave_write = 1'b0;
+        rst_n = 1'b0;
 
         // RUN aes.py BEFORE RUNNING THE TESTBENCH
         @(posedge clk);
@@ -27,6 +57,7 @@ module tb_aes_encrypt();
         $readmemh("./ref_content0.memh", ref_content);
 
         @(posedge clk);
+        rst_n = 1'b1;
         #2;
         slave_write = 1'b1;
         slave_address = 4'd4;
@@ -67,6 +98,11 @@ module tb_aes_encrypt();
         slave_address = 4'd3;
         slave_writedata = (mem_content[271] << 24) + (mem_content[270] << 16) + (mem_content[269] << 8) + (mem_content[268]);
 
+        @(posedge clk);
+        #2;
+        slave_address = 4'd11;
+        slave_writedata = 32'h01;
+
         @(posedge clk);
         #2;
         slave_address = 4'd8;
@@ -81,10 +117,26 @@ module tb_aes_encrypt();
         @(posedge clk);
         @(posedge clk);
         for (int i = 9'd0; i < 9'd256; i++) begin
-            assert(dut.sbox[i] === mem_content[i]);
+            rom_in = i;
+            #1;
+            assert(sbox_out === mem_content[i]);
         end
 
-        @(posedge dut.done);
+        // the bus is not stalled, the status shows the module is busy until the irq
+        slave_read = 1'b1;
+        slave_address = 4'd10;
+        #2;
+        assert(slave_readdata[1:0] === 2'b01);
+        slave_read = 1'b0;
+
+        @(posedge irq);
+        #2;
+        slave_read = 1'b1;
+        slave_address = 4'd10;
+        #2;
+        assert(slave_readdata[1:0] === 2'b10);
+        slave_read = 1'b0;
+
         @(posedge clk);
         @(posedge clk);
         @(posedge clk);
@@ -128,6 +180,50 @@ module tb_aes_encrypt();
         assert(slave_readdata[23:16] === ref_content[14]);
         assert(slave_readdata[31:24] === ref_content[15]);
 
+        // clearing done drops the irq
+        @(posedge clk);
+        #2;
+        slave_read = 1'b0;
+        slave_write = 1'b1;
+        slave_address = 4'd10;
+        @(posedge clk);
+        #2;
+        slave_write = 1'b0;
+        assert(irq === 1'b0);
+
+        // writing word 4 while the module is busy abandons the block, it never gets done or raises the irq
+        write_word(4'd9, 32'h01);
+        repeat (8) @(posedge clk);
+        #2;
+        check_status(2'b01);
+        write_word(4'd4, mem_word(272));
+        check_status(2'b00);
+        repeat (120) @(posedge clk);
+        check_status(2'b00);
+        assert(irq === 1'b0);
+
+        // the expanded key is kept, the block written again gives the same result
+        for (int w = 1; w < 4; w++) begin
+            write_word(w + 4, mem_word(272 + 4 * w));
+        end
+        write_word(4'd9, 32'h01);
+        @(posedge irq);
+        #2;
+        slave_read = 1'b1;
+        for (int w = 0; w < 4; w++) begin
+            slave_address = w;
+            #2;
+            assert(slave_readdata === {ref_content[4 * w + 3], ref_content[4 * w + 2], ref_content[4 * w + 1], ref_content[4 * w]});
+        end
+        slave_read = 1'b0;
+
+        // with the irq disabled only the status shows the block is done
+        write_word(4'd11, 32'h00);
+        write_word(4'd9, 32'h01);
+        repeat (120) @(posedge clk);
+        check_status(2'b10);
+        assert(irq === 1'b0);
+
         #400;
         $stop;
     end
@@ -0,0 +1,324 @@
+`timescale 1 ps / 1 ps
+
+/**
+ * Regression and latency benchmark for aes_encrypt, aes_decrypt and aes_core, run by run_regression.py.
+ * Every vector in regression_vectors.memh (key, plaintext, ciphertext, generated with aes.py) is
+ * encrypted and decrypted twice, first with key expansion (word 8) and then with the expanded key
+ * (word 9). aes_core expands the key into slot 0 and then encrypts and decrypts with it. The cycles
+ * from the start write to done, or for aes_core until it releases waitrequest, are reported per core,
+ * and a core fails if it is slower than the MAX_* plusargs given by the runner from latency_baseline.txt.
+ *
+ * Plusargs: +VECTORS=<number of vectors> +MAX_ENC_KEXP=<cycles> +MAX_ENC_BLOCK=<cycles>
+ *           +MAX_DEC_KEXP=<cycles> +MAX_DEC_BLOCK=<cycles>
+ *           +MAX_CORE_KEXP=<cycles> +MAX_CORE_ENC=<cycles> +MAX_CORE_DEC=<cycles>
+ */
+
+module tb_aes_regression();
+    localparam MAX_VECTORS = 10000;
+    localparam ENC = 0;
+    localparam DEC = 1;
+    localparam LATENCIES = 7;
+
+    logic clk, rst_n;
+
+    logic enc_read, enc_write, enc_irq;
+    logic [3:0] enc_address;
+    logic [31:0] enc_readdata, enc_writedata;
+
+    logic dec_read, dec_write, dec_irq;
+    logic [3:0] dec_address;
+    logic [31:0] dec_readdata, dec_writedata;
+
+    logic core_waitrequest, core_read, core_write, core_irq;
+    logic [4:0] core_address;
+    logic [31:0] core_readdata, core_writedata;
+    logic [31:0] master_address, master_writedata;
+    logic master_read, master_write;
+    logic [3:0] master_byteenable;
+
+    // key, plaintext and ciphertext of each vector, first byte in [127:120]
+    logic [127:0] vectors [0:3*MAX_VECTORS-1];
+
+    // latency of each core and start word, index is core * 2 + (1 for word 9), then aes_core key
+    // expansion, encryption and decryption
+    int max_cycles [0:LATENCIES-1];
+    int total_cycles [0:LATENCIES-1];
+    int limit [0:LATENCIES-1];
+
+    int cycle;
+    int num_vectors;
+    int errors;
+
+    aes_encrypt enc(.clk(clk), .rst_n(rst_n),
+                    .slave_address(enc_address), .slave_read(enc_read), .slave_readdata(enc_readdata),
+                    .slave_write(enc_write), .slave_writedata(enc_writedata), .irq(enc_irq));
+
+    aes_decrypt dec(.clk(clk), .rst_n(rst_n),
+                    .slave_address(dec_address), .slave_read(dec_read), .slave_readdata(dec_readdata),
+                    .slave_write(dec_write), .slave_writedata(dec_writedata), .irq(dec_irq));
+
+    // the DMA master is not used, its memory never accepts a transfer
+    aes_core core(.clk(clk), .rst_n(rst_n), .slave_waitrequest(core_waitrequest),
+                  .slave_address(core_address), .slave_read(core_read), .slave_readdata(core_readdata),
+                  .slave_write(core_write), .slave_writedata(core_writedata),
+                  .master_address(master_address), .master_read(master_read), .master_readdata(32'd0),
+                  .master_write(master_write), .master_writedata(master_writedata),
+                  .master_byteenable(master_byteenable), .master_waitrequest(1'b1), .irq(core_irq));
+
+    initial begin
+        clk = 1'b0;
+        forever #10 clk = ~clk;
+    end
+
+    always @(posedge clk) begin
+        cycle <= cycle + 1;
+    end
+
+    // Avalon write, neither core holds waitrequest so it is accepted at the next clock edge
+    task write_word(input int core, input logic [3:0] address, input logic [31:0] data);
+        @(posedge clk);
+        #2;
+        if (core == ENC) begin
+            enc_write = 1'b1;
+            enc_address = address;
+            enc_writedata = data;
+        end
+        else begin
+            dec_write = 1'b1;
+            dec_address = address;
+            dec_writedata = data;
+        end
+        @(posedge clk);
+        #2;
+        enc_write = 1'b0;
+        dec_write = 1'b0;
+    endtask
+
+    task read_word(input int core, input logic [3:0] address, output logic [31:0] data);
+        @(posedge clk);
+        #2;
+        if (core == ENC) begin
+            enc_read = 1'b1;
+            enc_address = address;
+            #2;
+            data = enc_readdata;
+        end
+        else begin
+            dec_read = 1'b1;
+            dec_address = address;
+            #2;
+            data = dec_readdata;
+        end
+        enc_read = 1'b0;
+        dec_read = 1'b0;
+    endtask
+
+    // Avalon write to aes_core, held until it releases waitrequest
+    task core_write_word(input logic [4:0] address, input logic [31:0] data);
+        @(posedge clk);
+        #2;
+        core_write = 1'b1;
+        core_address = address;
+        core_writedata = data;
+        while (core_waitrequest) begin
+            @(posedge clk);
+            #2;
+        end
+        @(posedge clk);
+        #2;
+        core_write = 1'b0;
+    endtask
+
+    task core_read_word(input logic [4:0] address, output logic [31:0] data);
+        @(posedge clk);
+        #2;
+        core_read = 1'b1;
+        core_address = address;
+        #1;
+        while (core_waitrequest) begin
+            @(posedge clk);
+            #1;
+        end
+        data = core_readdata;
+        core_read = 1'b0;
+    endtask
+
+    // Bus word w of a vector, byte 4 * w is in [7:0] like mem_content in tb_aes_encrypt.sv
+    function logic [31:0] vector_word(input logic [127:0] v, input int w);
+        for (int b = 0; b < 4; b++) begin
+            vector_word[8*b +: 8] = v[127 - 8 * (4 * w + b) -: 8];
+        end
+    endfunction
+
+    // Run one block through a core, with key expansion and then with the expanded key
+    task run_vector(input int core, input logic [127:0] key, input logic [127:0] in, input logic [127:0] expected);
+        logic [31:0] data;
+        int start, cycles, index;
+
+        for (int pass = 0; pass < 2; pass++) begin
+            for (int w = 0; w < 4; w++) begin
+                write_word(core, 4'd4 + w, vector_word(in, w));
+            end
+            if (pass == 0) begin
+                for (int w = 0; w < 4; w++) begin
+                    write_word(core, w, vector_word(key, w));
+                end
+            end
+
+            write_word(core, pass == 0 ? 4'd8 : 4'd9, 32'd0);
+            start = cycle;
+            if (core == ENC) begin
+                @(posedge enc_irq);
+            end
+            else begin
+                @(posedge dec_irq);
+            end
+            #1;
+            cycles = cycle - start;
+
+            index = core * 2 + pass;
+            add_cycles(index, cycles);
+
+            for (int w = 0; w < 4; w++) begin
+                read_word(core, w, data);
+                if (data !== vector_word(expected, w)) begin
+                    errors++;
+                end
+            end
+
+            // clear done and the irq
+            write_word(core, 4'd10, 32'd0);
+        end
+    endtask
+
+    task add_cycles(input int index, input int cycles);
+        total_cycles[index] += cycles;
+        if (cycles > max_cycles[index]) begin
+            max_cycles[index] = cycles;
+        end
+    endtask
+
+    // Start an aes_core operation and count the cycles until it releases waitrequest
+    task core_run(input int index, input logic [4:0] address);
+        int start;
+
+        core_write_word(address, 32'd0);
+        start = cycle;
+        while (core_waitrequest) begin
+            @(posedge clk);
+            #1;
+        end
+        add_cycles(index, cycle - start);
+    endtask
+
+    // Expand the key into slot 0, then encrypt and decrypt one block with it
+    task run_core_vector(input logic [127:0] key, input logic [127:0] plain, input logic [127:0] cipher);
+        logic [31:0] data;
+
+        for (int w = 0; w < 4; w++) begin
+            core_write_word(w, vector_word(key, w));
+        end
+        core_run(4, 5'd8);
+
+        for (int w = 0; w < 4; w++) begin
+            core_write_word(5'd4 + w, vector_word(plain, w));
+        end
+        core_run(5, 5'd9);
+        for (int w = 0; w < 4; w++) begin
+            core_read_word(w, data);
+            if (data !== vector_word(cipher, w)) begin
+                errors++;
+            end
+        end
+
+        for (int w = 0; w < 4; w++) begin
+            core_write_word(5'd4 + w, vector_word(cipher, w));
+        end
+        core_run(6, 5'd10);
+        for (int w = 0; w < 4; w++) begin
+            core_read_word(w, data);
+            if (data !== vector_word(plain, w)) begin
+                errors++;
+            end
+        end
+    endtask
+
+    task report(input int index, input string name);
+        $display("CYCLES %0s %0d %0d", name, max_cycles[index], total_cycles[index] / num_vectors);
+        if (max_cycles[index] > limit[index]) begin
+            $display("LATENCY REGRESSION: %0s takes %0d cycles, the baseline is %0d", name, max_cycles[index], limit[index]);
+            errors++;
+        end
+    endtask
+
+    initial begin
+        enc_address = 4'b0;
+        enc_read = 1'b0;
+        enc_write = 1'b0;
+        dec_address = 4'b0;
+        dec_read = 1'b0;
+        dec_write = 1'b0;
+        core_address = 5'b0;
+        core_read = 1'b0;
+        core_write = 1'b0;
+        cycle = 0;
+        errors = 0;
+
+        for (int i = 0; i < LATENCIES; i++) begin
+            max_cycles[i] = 0;
+            total_cycles[i] = 0;
+        end
+
+        if (!$value$plusargs("VECTORS=%d", num_vectors) || num_vectors > MAX_VECTORS) begin
+            num_vectors = 1;
+        end
+
+        // no limit unless the runner gives the baseline
+        for (int i = 0; i < LATENCIES; i++) begin
+            limit[i] = 32'h7fffffff;
+        end
+        void'($value$plusargs("MAX_ENC_KEXP=%d", limit[0]));
+        void'($value$plusargs("MAX_ENC_BLOCK=%d", limit[1]));
+        void'($value$plusargs("MAX_DEC_KEXP=%d", limit[2]));
+        void'($value$plusargs("MAX_DEC_BLOCK=%d", limit[3]));
+        void'($value$plusargs("MAX_CORE_KEXP=%d", limit[4]));
+        void'($value$plusargs("MAX_CORE_ENC=%d", limit[5]));
+        void'($value$plusargs("MAX_CORE_DEC=%d", limit[6]));
+
+        // RUN run_regression.py, IT GENERATES THE VECTORS AND STARTS THE SIMULATION
+        $readmemh("regression_vectors.memh", vectors);
+
+        rst_n = 1'b0;
+        @(posedge clk);
+        @(posedge clk);
+        #2;
+        rst_n = 1'b1;
+
+        // raise the irqs when done
+        write_word(ENC, 4'd11, 32'd1);
+        write_word(DEC, 4'd11, 32'd1);
+
+        for (int n = 0; n < num_vectors; n++) begin
+            run_vector(ENC, vectors[3 * n], vectors[3 * n + 1], vectors[3 * n + 2]);
+            run_vector(DEC, vectors[3 * n], vectors[3 * n + 2], vectors[3 * n + 1]);
+            run_core_vector(vectors[3 * n], vectors[3 * n + 1], vectors[3 * n + 2]);
+        end
+
+        report(0, "aes_encrypt_kexp");
+        report(1, "aes_encrypt_block");
+        report(2, "aes_decrypt_kexp");
+        report(3, "aes_decrypt_block");
+        report(4, "aes_core_kexp");
+        report(5, "aes_core_encrypt");
+        report(6, "aes_core_decrypt");
+
+        if (errors == 0) begin
+            $display("PASSED: %0d vectors", num_vectors);
+        end
+        else begin
+            $display("FAILED: %0d errors", errors);
+        end
+
+        $finish;
+    end
+endmodule: tb_aes_regression
@@ -8,49 +8,85 @@ C_SRCS += \
 ../source/aesHwacc.c \
 ../source/altera_avalon_spi.c \
 ../source/bluetoothService.c \
+../source/cacheService.c \
 ../source/cloudlockrMain.c \
 ../source/hexService.c \
 ../source/hpsService.c \
+../source/initService.c \
+../source/jsonStream.c \
+../source/jsonWriter.c \
+../source/memService.c \
 ../source/mpu9250.c \
 ../source/processingService.c \
+../source/profileService.c \
+../source/scheduler.c \
+../source/smpService.c \
+../source/spiService.c \
+../source/statsService.c \
 ../source/tests.c \
+../source/timerService.c \
 ../source/verificationService.c \
-../source/wifiService.c 
+../source/wifiService.c \
+../source/workQueue.c 
 
 OBJS += \
 ./source/UART.o \
 ./source/aesHwacc.o \
 ./source/altera_avalon_spi.o \
 ./source/bluetoothService.o \
+./source/cacheService.o \
 ./source/cloudlockrMain.o \
 ./source/hexService.o \
 ./source/hpsService.o \
+./source/initService.o \
+./source/jsonStream.o \
+./source/jsonWriter.o \
+./source/memService.o \
 ./source/mpu9250.o \
 ./source/processingService.o \
+./source/profileService.o \
+./source/scheduler.o \
+./source/smpService.o \
+./source/spiService.o \
+./source/statsService.o \
 ./source/tests.o \
+./source/timerService.o \
 ./source/verificationService.o \
-./source/wifiService.o 
+./source/wifiService.o \
+./source/workQueue.o 
 
 C_DEPS += \
 ./source/UART.d \
 ./source/aesHwacc.d \
 ./source/altera_avalon_spi.d \
 ./source/bluetoothService.d \
+./source/cacheService.d \
 ./source/cloudlockrMain.d \
 ./source/hexService.d \
 ./source/hpsService.d \
+./source/initService.d \
+./source/jsonStream.d \
+./source/jsonWriter.d \
+./source/memService.d \
 ./source/mpu9250.d \
 ./source/processingService.d \
+./source/profileService.d \
+./source/scheduler.d \
+./source/smpService.d \
+./source/spiService.d \
+./source/statsService.d \
 ./source/tests.d \
+./source/timerService.d \
 ./source/verificationService.d \
-./source/wifiService.d 
+./source/wifiService.d \
+./source/workQueue.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
 source/%.o: ../source/%.c
 	@echo 'Building file: $<'
 	@echo 'Invoking: ARM C Compiler 5'
-	armcc -I"C:\Users\danie\Documents\school\cpen391\AES\CPEN391FW\include" --c99 -O0 -g --md --depend_format=unix_escaped -c -o "$@" "$<"
+	armcc -I"C:\Users\danie\Documents\school\cpen391\AES\CPEN391FW\include" --cpu=Cortex-A9 --fpu=SoftVFP --c99 -O0 -g --md --depend_format=unix_escaped -c -o "$@" "$<"
 	@echo 'Finished building: $<'
 	@echo ' '
 
@@ -0,0 +1,76 @@
+/**
+ * This module runs the board tests of source/tests.c on the host, against the peripheral models of
+ * host/sim. It is the main() commented out at the end of tests.c, less smp_test1(), as the host has no
+ * second core to start, and sensor_test1(), as the MPU9250 model only has the samples a test gives it
+ * (see spiModelTest.c). The timers are started first, as cloudlockrMain.c does, since the drivers
+ * time their waits with them.
+ *
+ * Build and run from CPEN391FW, or with the CMake build:
+ *  gcc -std=gnu99 -O2 -Iinclude -Ihost/sim host/boardTests.c source/tests.c host/sim/*.c $(ls source/*.c |
+ *      grep -v 'cloudlockrMain\|tests') -lpthread -o boardTests && ./boardTests
+ */
+
+#include <stdio.h>
+#include "cacheService.h"
+#include "hpsService.h"
+#include "sim.h"
+
+void aes_test0();
+void aes_test1();
+void aes_test3();
+void aes_test4();
+void aes_test5();
+void aes_test6();
+void aes_test7();
+void delay_test1();
+void password_test();
+void message1_test1();
+void message2_test1();
+void message2_test2();
+void message2_test3();
+void message2_test4();
+void message2_test5();
+void message2_test6();
+void message2_test7();
+void message2_test8();
+void message2_test9();
+void message7_test1();
+void json_extract_test1();
+void json_stream_test1();
+void json_writer_test1();
+
+int main(void)
+{
+    sim_reset();
+
+    cache_init();
+    hps_init();
+    aes_test0();
+    aes_test1();
+    aes_test3();
+    aes_test4();
+    aes_test5();
+    aes_test6();
+    aes_test7();
+    delay_test1();
+    password_test();
+    message1_test1();
+
+    message2_test1();
+    message2_test2();
+    message2_test3();
+    message2_test4();
+    message2_test5();
+    message2_test6();
+    message2_test7();
+    message2_test8();
+    message2_test9();
+
+    message7_test1();
+
+    json_extract_test1();
+    json_stream_test1();
+    json_writer_test1();
+
+    return 0;
+}
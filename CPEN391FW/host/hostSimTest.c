@@ -0,0 +1,314 @@
+/**
+ * This module tests the firmware drivers against the peripheral models of host/sim: the UARTs at their
+ * baud rate, the AES modules and the AES core's DMA against a software AES, the password and HEX code
+ * check, the switches, the sleep of hps_usleep() on the virtual clock, the request arena and pool and
+ * the runtime statistics.
+ *
+ * Build and run from CPEN391FW, or with the CMake build:
+ *  gcc -std=gnu99 -O2 -Iinclude -Ihost/sim host/hostSimTest.c host/sim/*.c $(ls source/*.c | grep -v
+ *      'cloudlockrMain\|tests') -lpthread -o hostSimTest && ./hostSimTest
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <typeDef.h>
+#include "aesHwacc.h"
+#include "hexService.h"
+#include "hpsService.h"
+#include "memAddress.h"
+#include "memService.h"
+#include "sim.h"
+#include "statsService.h"
+#include "UART.h"
+#include "verificationService.h"
+
+#define NUM_BLOCKS 40
+#define CTR_LENGTH 100
+
+static int failures = 0;
+
+static void check(int condition, const char *what)
+{
+    if (!condition)
+    {
+        printf("Failed %s\n", what);
+        failures++;
+    }
+    else
+    {
+        printf("Passed %s\n", what);
+    }
+}
+
+// FIPS-197 appendix C.1, in the byte order encrypt() and decrypt() take
+static unsigned char fips_key[16] = {0x0f, 0x0e, 0x0d, 0x0c, 0x0b, 0x0a, 0x09, 0x08,
+                                     0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01, 0x00};
+static unsigned char fips_plaintext[16] = {0xff, 0xee, 0xdd, 0xcc, 0xbb, 0xaa, 0x99, 0x88,
+                                           0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11, 0x00};
+static const unsigned char fips_ciphertext[16] = {0x5a, 0xc5, 0xb4, 0x70, 0x80, 0xb7, 0xcd, 0xd8,
+                                                  0x30, 0x04, 0x7b, 0x6a, 0xd8, 0xe0, 0xc4, 0x69};
+
+static void test_uart(void)
+{
+    char buffer[64];
+    uint64 start;
+    UART_tSTATS wifi_before = *UART_GetStats(UART_ePORT_WIFI);
+    UART_tSTATS bt_before = *UART_GetStats(UART_ePORT_BLUETOOTH);
+
+    // UART_puts() paces the bytes with hps_usleep()
+    sim_reset();
+    hps_init();
+    UART_Init(UART_ePORT_WIFI);
+    UART_Init(UART_ePORT_BLUETOOTH);
+
+    start = sim_ticks;
+    UART_puts(UART_ePORT_WIFI, "AT+RST\r\n");
+    check(sim_uart_take_tx(SIM_UART_WIFI, buffer, sizeof(buffer)) == 8 && strcmp(buffer, "AT+RST\r\n") == 0,
+          "UART_puts() sends the string");
+    // The first two bytes fill the shift and holding registers, each one after waits a byte time
+    check(sim_ticks - start >= 6 * sim_uart_byte_ticks(SIM_UART_WIFI), "UART_puts() waits for the transmitter");
+    check(sim_uart_take_tx(SIM_UART_BLUETOOTH, buffer, sizeof(buffer)) == 0, "nothing sent on the other port");
+
+    sim_uart_feed(SIM_UART_BLUETOOTH, "OK\n", 3);
+    check(UART_getchar(UART_ePORT_BLUETOOTH) == 'O' && UART_getchar(UART_ePORT_BLUETOOTH) == 'K' &&
+              UART_getchar(UART_ePORT_BLUETOOTH) == '\n',
+          "UART_getchar() receives the bytes in order");
+    check(sim_uart_rx_pending(SIM_UART_BLUETOOTH) == 0, "all fed bytes received");
+
+    // The receive FIFO holds 16 bytes, the rest are lost if nobody reads
+    sim_uart_feed(SIM_UART_BLUETOOTH, "abcdefghijklmnopqrst", 20);
+    sim_advance(21 * sim_uart_byte_ticks(SIM_UART_BLUETOOTH));
+    check(UART_TestForReceivedData(UART_ePORT_BLUETOOTH) && UART_getchar(UART_ePORT_BLUETOOTH) == 'a' &&
+              sim_uart_overruns(SIM_UART_BLUETOOTH) == 4,
+          "bytes arriving at a full receive FIFO overrun");
+    UART_Flush(UART_ePORT_BLUETOOTH);
+
+    sim_uart_feed(SIM_UART_WIFI, "xyz", 3);
+    sim_advance(4 * sim_uart_byte_ticks(SIM_UART_WIFI));
+    UART_Flush(UART_ePORT_WIFI);
+    check(!UART_TestForReceivedData(UART_ePORT_WIFI) && sim_uart_take_tx(SIM_UART_WIFI, buffer, sizeof(buffer)) == 0,
+          "UART_Flush() empties the receiver without transmitting");
+
+    // 3 + 16 bytes received on bluetooth, the rest overran, and 8 sent and 3 flushed on WiFi
+    check(UART_GetStats(UART_ePORT_BLUETOOTH)->rx_bytes - bt_before.rx_bytes == 19 &&
+              UART_GetStats(UART_ePORT_BLUETOOTH)->overruns - bt_before.overruns == 1 &&
+              UART_GetStats(UART_ePORT_WIFI)->tx_bytes - wifi_before.tx_bytes == 8 &&
+              UART_GetStats(UART_ePORT_WIFI)->rx_bytes - wifi_before.rx_bytes == 3,
+          "UART counters count the bytes and the overrun");
+}
+
+static void test_aes_modules(void)
+{
+    unsigned char result[16];
+    init_job_t job;
+
+    sim_reset();
+    encrypt(fips_key, fips_plaintext, result, 1);
+    check(memcmp(result, fips_ciphertext, 16) == 0, "encrypt() gives the FIPS-197 ciphertext");
+    decrypt(fips_key, result, result, 1);
+    check(memcmp(result, fips_plaintext, 16) == 0, "decrypt() gives the FIPS-197 plaintext");
+
+    // Same key again without the key expansion
+    encrypt(fips_key, fips_plaintext, result, 0);
+    check(memcmp(result, fips_ciphertext, 16) == 0, "encrypt() reuses the expanded key");
+
+    memset(&job, 0, sizeof(job));
+    for (int i = 0; i < 1000 && job.status == INIT_PENDING; i++)
+    {
+        job.status = aes_self_test_step(&job);
+    }
+    check(job.status == INIT_DONE, "aes_self_test_step() passes");
+}
+
+static void test_aes_core(void)
+{
+    static unsigned char plaintext[16 * NUM_BLOCKS];
+    static unsigned char ciphertext[16 * NUM_BLOCKS];
+    static unsigned char decrypted[16 * NUM_BLOCKS];
+    unsigned char counter_block[16];
+    unsigned char keystream[16];
+    unsigned char result[16];
+    uint64 start;
+    int slot;
+    int same = 1;
+    int polls = 0;
+
+    sim_reset();
+    slot = aes_key_slot(fips_key);
+    check(slot >= 0 && slot < AES_KEY_SLOTS, "aes_key_slot() gives a slot");
+    check(aes_key_slot(fips_key) == slot, "aes_key_slot() finds a loaded key");
+
+    encrypt_slot(slot, fips_plaintext, result);
+    check(memcmp(result, fips_ciphertext, 16) == 0, "encrypt_slot() gives the FIPS-197 ciphertext");
+    decrypt_slot(slot, result, result);
+    check(memcmp(result, fips_plaintext, 16) == 0, "decrypt_slot() gives the FIPS-197 plaintext");
+
+    for (int i = 0; i < (int)sizeof(plaintext); i++)
+    {
+        plaintext[i] = (unsigned char)(i * 13 + 5);
+    }
+    start = sim_ticks;
+    aes_dma_start(slot, plaintext, ciphertext, NUM_BLOCKS, 0);
+    while (!aes_dma_done())
+    {
+        polls++;
+    }
+    for (int i = 0; i < NUM_BLOCKS; i++)
+    {
+        encrypt_slot(slot, plaintext + 16 * i, result);
+        same &= memcmp(result, ciphertext + 16 * i, 16) == 0;
+    }
+    check(same, "DMA encryption matches encrypt_slot() on each block");
+    check(polls > 0 && sim_ticks - start >= (uint64)NUM_BLOCKS * 61 * SIM_FPGA_CYCLE_TICKS,
+          "DMA takes the time of the blocks");
+
+    aes_dma_start(slot, ciphertext, decrypted, NUM_BLOCKS, 1);
+    while (!aes_dma_done())
+    {
+        // wait
+    }
+    check(memcmp(decrypted, plaintext, sizeof(plaintext)) == 0, "DMA decryption gives the plaintext");
+
+    for (int i = 0; i < 16; i++)
+    {
+        counter_block[i] = (unsigned char)(0xA0 + i);
+    }
+    memset(ciphertext, 0xEE, sizeof(ciphertext));
+    aes_ctr_start(slot, counter_block, plaintext, ciphertext, CTR_LENGTH);
+    while (!aes_dma_done())
+    {
+        // wait
+    }
+    encrypt_slot(slot, counter_block, keystream);
+    same = 1;
+    for (int i = 0; i < 16; i++)
+    {
+        same &= ciphertext[i] == (plaintext[i] ^ keystream[i]);
+    }
+    check(same, "CTR block 0 is the plaintext XOR the encrypted counter block");
+    check(ciphertext[CTR_LENGTH] == 0xEE, "CTR writes nothing after the last byte");
+
+    memset(decrypted, 0, sizeof(decrypted));
+    aes_ctr_start(slot, counter_block, ciphertext, decrypted, CTR_LENGTH);
+    while (!aes_dma_done())
+    {
+        // wait
+    }
+    check(memcmp(decrypted, plaintext, CTR_LENGTH) == 0, "CTR twice gives the plaintext");
+}
+
+static void test_verification(void)
+{
+    char password[] = "hunter22";
+    char wrong[] = "hunter23";
+    char hex[16];
+
+    sim_reset();
+    set_password(password);
+    generate_display_hex_code();
+    sprintf(hex, "%x", (unsigned)sim_peek(SIM_ADDR(HEX_ADDR)));
+
+    check(verify(password, hex) == 1, "verify() accepts the password and the displayed code");
+    check(verify(wrong, hex) == 0, "verify() rejects a wrong password");
+    sprintf(hex, "%x", (unsigned)sim_peek(SIM_ADDR(HEX_ADDR)) ^ 1);
+    check(verify(password, hex) == 0, "verify() rejects a wrong code");
+}
+
+static void test_hps(void)
+{
+    uint64 start_us;
+    uint64 slept_us;
+
+    sim_reset();
+    hps_init();
+
+    sim_poke(SIM_ADDR(SWITCHES), 0x2A5);
+    hps_process();
+    check(sim_peek(SIM_ADDR(LEDS)) == 0x2A5 && sim_peek(SIM_ADDR(HEX0_1)) == 0x2A5, "switches show on the LEDs");
+
+    start_us = hps_time_us();
+    hps_usleep(1500000);
+    slept_us = hps_time_us() - start_us;
+    check(slept_us >= 1500000 && slept_us < 1501000, "hps_usleep() sleeps for the time given");
+
+    start_us = hps_time_us();
+    hps_ms_delay(20);
+    check(hps_time_us() - start_us >= 20000, "hps_ms_delay() waits for the time given");
+}
+
+static void test_memory(void)
+{
+    const mem_stats_t *mem = mem_stats();
+    mem_mark_t mark;
+    char *first;
+    char *second;
+    char *third;
+    void *blocks[MEM_POOL_BLOCKS];
+    int all = 1;
+
+    mem_reset();
+    first = mem_alloc(13);
+    mark = mem_mark();
+    second = mem_alloc(1000);
+    check(first != NULL && second == first + 16 && mem->arena_in_use == 1016 && mem->arena_peak >= 1016,
+          "mem_alloc() bumps the arena by 8 byte aligned sizes");
+
+    mem_release(mark);
+    third = mem_alloc(8);
+    check(third == second && mem->arena_in_use == 24, "mem_release() gives back what came after the mark");
+
+    check(mem_alloc(MEM_ARENA_SIZE) == NULL && mem->arena_failures > 0, "mem_alloc() fails when the arena is full");
+    mem_reset();
+    check(mem->arena_in_use == 0 && mem_alloc(MEM_ARENA_SIZE) != NULL, "mem_reset() empties the arena");
+    mem_reset();
+
+    for (int i = 0; i < MEM_POOL_BLOCKS; i++)
+    {
+        blocks[i] = mem_pool_alloc();
+        all &= blocks[i] != NULL;
+    }
+    check(all && mem_pool_alloc() == NULL && mem->pool_in_use == MEM_POOL_BLOCKS, "the pool hands out each block once");
+    mem_pool_free(blocks[0]);
+    check(mem_pool_alloc() == blocks[0], "mem_pool_free() returns a block to the pool");
+    for (int i = 0; i < MEM_POOL_BLOCKS; i++)
+    {
+        mem_pool_free(blocks[i]);
+    }
+    check(mem->pool_in_use == 0 && mem->pool_peak == MEM_POOL_BLOCKS, "the pool is empty again");
+}
+
+static void test_stats(void)
+{
+    static char snapshot[1024];
+
+    sim_reset();
+    hps_init();
+    UART_Init(UART_ePORT_BLUETOOTH);
+    stats_count_request();
+    stats_send();
+    sim_uart_take_tx(SIM_UART_BLUETOOTH, snapshot, sizeof(snapshot));
+    check(strncmp(snapshot, "{\"uptime\":", 10) == 0 && strstr(snapshot, "\"requests\":") != NULL &&
+              strstr(snapshot, "\"btOverruns\":1,") != NULL && strstr(snapshot, "\"aesBlocks\":") != NULL &&
+              strstr(snapshot, "\"arenaPeak\":") != NULL && strcmp(snapshot + strlen(snapshot) - 3, "}\v\n") == 0,
+          "stats_send() sends the counters as one message");
+}
+
+int main(void)
+{
+    test_uart();
+    test_aes_modules();
+    test_aes_core();
+    test_verification();
+    test_hps();
+    test_memory();
+    test_stats();
+
+    if (failures)
+    {
+        printf("%d tests failed\n", failures);
+        return 1;
+    }
+
+    printf("All tests passed\n");
+    return 0;
+}
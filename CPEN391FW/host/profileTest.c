@@ -0,0 +1,89 @@
+/**
+ * This module tests the profiling probes of profileService.c on the host, where they time with
+ * clock_gettime(): histogram buckets, min/max and a probe around a known sleep.
+ *
+ * Build and run from CPEN391FW:
+ *  gcc -std=gnu99 -O2 -Iinclude host/profileTest.c -o profileTest && ./profileTest
+ */
+
+#include <stdio.h>
+#include <typeDef.h>
+
+/*------------------- Firmware under test ------------------------------------*/
+
+#include "../source/profileService.c"
+
+/*------------------- Tests --------------------------------------------------*/
+
+static int failures = 0;
+
+static void check(int condition, const char *what)
+{
+    if (!condition)
+    {
+        printf("Failed %s\n", what);
+        failures++;
+    }
+    else
+    {
+        printf("Passed %s\n", what);
+    }
+}
+
+static void test_buckets(void)
+{
+    const prof_stats_t *stats = prof_stats(PROF_REQUEST);
+
+    prof_init();
+    prof_record(PROF_REQUEST, 0);
+    prof_record(PROF_REQUEST, 1);
+    prof_record(PROF_REQUEST, 3);
+    prof_record(PROF_REQUEST, 1024);
+    prof_record(PROF_REQUEST, 2047);
+    prof_record(PROF_REQUEST, 0xFFFFFFFF);
+
+    check(stats->buckets[0] == 2 && stats->buckets[1] == 1 && stats->buckets[10] == 2 && stats->buckets[31] == 1,
+          "durations land in their power of 2 bucket");
+    check(stats->count == 6 && stats->min == 0 && stats->max == 0xFFFFFFFF &&
+              stats->total == 0 + 1 + 3 + 1024 + 2047 + 0xFFFFFFFFULL,
+          "count, total, min and max");
+
+    prof_reset();
+    check(stats->count == 0 && stats->buckets[10] == 0, "reset clears the probes");
+}
+
+static void test_probe(void)
+{
+    const prof_stats_t *stats = prof_stats(PROF_GET_BLOB);
+    struct timespec sleep = {0, 2000000};
+
+    prof_init();
+
+    for (int i = 0; i < 3; i++)
+    {
+        PROF_BEGIN(PROF_GET_BLOB);
+        nanosleep(&sleep, NULL);
+        PROF_END(PROF_GET_BLOB);
+    }
+
+    prof_print_report();
+
+    // 2 ms is in [2^20, 2^21) ns, the sleep may run long but not 2 buckets long
+    check(stats->count == 3 && stats->min >= 2000000 && stats->max < (1UL << 23), "probe around a 2 ms sleep");
+    check(prof_stats(PROF_GET_JSON_VALUES)->count == 0, "other probes untouched");
+}
+
+int main(void)
+{
+    test_buckets();
+    test_probe();
+
+    if (failures)
+    {
+        printf("%d tests failed\n", failures);
+        return 1;
+    }
+
+    printf("All tests passed\n");
+    return 0;
+}
@@ -0,0 +1,389 @@
+/**
+ * This module contains the accessors of mmio.h for the host build: the virtual clock, the bus routing
+ * each access to a peripheral model, the HPS timers and the register file for everything else.
+ *
+ * The private timer and the watchdog in timer mode count down from their load value, the global timer
+ * counts up, all at the clock rate. The firmware only starts the watchdog as an interrupting one shot
+ * right before WFI, see hps_wfi(), so the model sleeps there: the clock skips to the interrupt.
+ */
+
+#include <string.h>
+#include <typeDef.h>
+#include "memAddress.h"
+#include "mmio.h"
+#include "sim.h"
+
+// Register map of the models
+#define UART_SPAN 0x10
+#define AES_SPAN 0x1000
+#define AES_MODULES 4
+#define SPI_SPAN 0x20
+#define TIMER_SPAN 0x10
+#define GTIMER_SPAN 0x10
+#define L2_SPAN 0x1000
+#define L2_MAINTENANCE 0x700
+
+// Private timer and watchdog words
+#define TIMER_LOAD 0
+#define TIMER_COUNTER 1
+#define TIMER_CONTROL 2
+#define TIMER_INTSTATUS 3
+#define TIMER_ENABLE 0x1
+#define TIMER_AUTO_RELOAD 0x2
+#define TIMER_IRQ 0x4
+
+// Global timer words
+#define GTIMER_COUNTER_LOW 0
+#define GTIMER_COUNTER_HIGH 1
+#define GTIMER_CONTROL 2
+
+#define GIC_CPU_ACK 3
+#define GIC_SPURIOUS 1023
+
+#define REGFILE_SIZE 4096
+
+typedef struct
+{
+    uint32 load;
+    uint32 count; // at since
+    uint32 control;
+    uint32 event;
+    uint64 since;
+} sim_timer_t;
+
+uint64 sim_ticks = 0;
+
+static unsigned long accesses = 0;
+static sim_timer_t ptimer;
+static sim_timer_t pwdt;
+static struct
+{
+    uint64 count; // at since
+    uint64 since;
+    uint32 control;
+} gtimer;
+static struct
+{
+    uint32 addr;
+    uint32 value;
+    bool used;
+} regfile[REGFILE_SIZE];
+
+/**
+ * Reset the clock and all models to their state at power up
+ */
+void sim_reset(void)
+{
+    sim_ticks = 0;
+    accesses = 0;
+    memset(&ptimer, 0, sizeof(ptimer));
+    memset(&pwdt, 0, sizeof(pwdt));
+    memset(&gtimer, 0, sizeof(gtimer));
+    memset(regfile, 0, sizeof(regfile));
+
+    sim_uart_reset();
+    sim_aes_reset();
+    sim_spi_reset(SIM_SPI_BYTE_TICKS);
+}
+
+/**
+ * Let time pass without register accesses, e.g. for a device model to take its time
+ */
+void sim_advance(uint64 ticks)
+{
+    sim_ticks += ticks;
+}
+
+/**
+ * Returns the virtual time in us
+ */
+uint64 sim_time_us(void)
+{
+    return sim_ticks / SIM_TICKS_PER_US;
+}
+
+/**
+ * Returns the number of register accesses since the last reset
+ */
+unsigned long sim_accesses(void)
+{
+    return accesses;
+}
+
+/*------------------- Register file ------------------------------------------*/
+
+static int regfile_find(uint32 addr)
+{
+    int i = (int)((addr >> 2) * 2654435761u % REGFILE_SIZE);
+
+    while (regfile[i].used && regfile[i].addr != addr)
+    {
+        i = (i + 1) % REGFILE_SIZE;
+    }
+
+    return i;
+}
+
+/**
+ * Returns the value of a register without a bus access, 0 if it was never written
+ */
+uint32 sim_peek(uint32 addr)
+{
+    int i = regfile_find(addr);
+
+    return regfile[i].used ? regfile[i].value : 0;
+}
+
+/**
+ * Set a register without a bus access, e.g. the switches
+ */
+void sim_poke(uint32 addr, uint32 value)
+{
+    int i = regfile_find(addr);
+
+    regfile[i].used = true;
+    regfile[i].addr = addr;
+    regfile[i].value = value;
+}
+
+/*------------------- Timers -------------------------------------------------*/
+
+static uint32 timer_count(sim_timer_t *timer)
+{
+    uint64 elapsed = sim_ticks - timer->since;
+
+    if (!(timer->control & TIMER_ENABLE) || elapsed <= timer->count)
+    {
+        return timer->control & TIMER_ENABLE ? timer->count - (uint32)elapsed : timer->count;
+    }
+
+    timer->event = 1;
+    if (!(timer->control & TIMER_AUTO_RELOAD))
+    {
+        return 0;
+    }
+
+    // Reloaded at every zero, one period is load + 1 ticks
+    return timer->load - (uint32)((elapsed - timer->count - 1) % ((uint64)timer->load + 1));
+}
+
+static void timer_sync(sim_timer_t *timer)
+{
+    timer->count = timer_count(timer);
+    timer->since = sim_ticks;
+}
+
+static uint32 timer_read(sim_timer_t *timer, int word)
+{
+    switch (word)
+    {
+    case TIMER_LOAD:
+        return timer->load;
+    case TIMER_COUNTER:
+        return timer_count(timer);
+    case TIMER_CONTROL:
+        return timer->control;
+    default:
+        timer_count(timer);
+        return timer->event;
+    }
+}
+
+static void timer_write(sim_timer_t *timer, int word, uint32 value)
+{
+    timer_sync(timer);
+
+    switch (word)
+    {
+    case TIMER_LOAD:
+        // Writing the load value also loads the counter
+        timer->load = value;
+        timer->count = value;
+        break;
+    case TIMER_COUNTER:
+        timer->count = value;
+        break;
+    case TIMER_CONTROL:
+        timer->control = value;
+        if (timer == &pwdt && (value & (TIMER_ENABLE | TIMER_IRQ | TIMER_AUTO_RELOAD)) == (TIMER_ENABLE | TIMER_IRQ))
+        {
+            // WFI until the one shot fires
+            sim_ticks += (uint64)timer->count + 1;
+        }
+        break;
+    default:
+        if (value & 1)
+        {
+            timer->event = 0;
+        }
+        break;
+    }
+}
+
+static uint64 gtimer_count(void)
+{
+    return gtimer.count + (gtimer.control & TIMER_ENABLE ? sim_ticks - gtimer.since : 0);
+}
+
+static uint32 gtimer_read(int word)
+{
+    switch (word)
+    {
+    case GTIMER_COUNTER_LOW:
+        return (uint32)gtimer_count();
+    case GTIMER_COUNTER_HIGH:
+        return (uint32)(gtimer_count() >> 32);
+    case GTIMER_CONTROL:
+        return gtimer.control;
+    default:
+        return 0;
+    }
+}
+
+static void gtimer_write(int word, uint32 value)
+{
+    gtimer.count = gtimer_count();
+    gtimer.since = sim_ticks;
+
+    switch (word)
+    {
+    case GTIMER_COUNTER_LOW:
+        gtimer.count = (gtimer.count & 0xFFFFFFFF00000000ULL) | value;
+        break;
+    case GTIMER_COUNTER_HIGH:
+        gtimer.count = (gtimer.count & 0xFFFFFFFFULL) | ((uint64)value << 32);
+        break;
+    case GTIMER_CONTROL:
+        gtimer.control = value;
+        break;
+    }
+}
+
+/*------------------- Bus ----------------------------------------------------*/
+
+static bool in_range(uint32 addr, volatile void *base, uint32 span)
+{
+    return addr >= SIM_ADDR(base) && addr < SIM_ADDR(base) + span;
+}
+
+static uint32 bus_read(uint32 addr)
+{
+    accesses++;
+    sim_ticks += SIM_ACCESS_TICKS;
+
+    if (in_range(addr, Wifi_ReceiverFifo, UART_SPAN))
+    {
+        return sim_uart_read(SIM_UART_WIFI, (addr - SIM_ADDR(Wifi_ReceiverFifo)) / 2);
+    }
+    if (in_range(addr, Bluetooth_ReceiverFifo, UART_SPAN))
+    {
+        return sim_uart_read(SIM_UART_BLUETOOTH, (addr - SIM_ADDR(Bluetooth_ReceiverFifo)) / 2);
+    }
+    if (in_range(addr, AES_ENCRYPT_ADDR, AES_MODULES * AES_SPAN))
+    {
+        return sim_aes_read((addr - SIM_ADDR(AES_ENCRYPT_ADDR)) / AES_SPAN, (addr % AES_SPAN) / 4);
+    }
+    if (in_range(addr, (volatile void *)SPI0_BASE, SPI_SPAN))
+    {
+        return sim_spi_read((addr - SPI0_BASE) / 4);
+    }
+    if (in_range(addr, PTIMER_ADDR, TIMER_SPAN))
+    {
+        return timer_read(&ptimer, (addr - SIM_ADDR(PTIMER_ADDR)) / 4);
+    }
+    if (in_range(addr, PWDT_ADDR, TIMER_SPAN))
+    {
+        return timer_read(&pwdt, (addr - SIM_ADDR(PWDT_ADDR)) / 4);
+    }
+    if (in_range(addr, GTIMER_ADDR, GTIMER_SPAN))
+    {
+        return gtimer_read((addr - SIM_ADDR(GTIMER_ADDR)) / 4);
+    }
+    if (addr == SIM_ADDR(GIC_CPU_ADDR + GIC_CPU_ACK))
+    {
+        // Nothing is pending once the watchdog event is cleared
+        return GIC_SPURIOUS;
+    }
+
+    return sim_peek(addr);
+}
+
+static void bus_write(uint32 addr, uint32 value)
+{
+    accesses++;
+    sim_ticks += SIM_ACCESS_TICKS;
+
+    if (in_range(addr, Wifi_ReceiverFifo, UART_SPAN))
+    {
+        sim_uart_write(SIM_UART_WIFI, (addr - SIM_ADDR(Wifi_ReceiverFifo)) / 2, (uint8)value);
+    }
+    else if (in_range(addr, Bluetooth_ReceiverFifo, UART_SPAN))
+    {
+        sim_uart_write(SIM_UART_BLUETOOTH, (addr - SIM_ADDR(Bluetooth_ReceiverFifo)) / 2, (uint8)value);
+    }
+    else if (in_range(addr, AES_ENCRYPT_ADDR, AES_MODULES * AES_SPAN))
+    {
+        sim_aes_write((addr - SIM_ADDR(AES_ENCRYPT_ADDR)) / AES_SPAN, (addr % AES_SPAN) / 4, value);
+    }
+    else if (in_range(addr, (volatile void *)SPI0_BASE, SPI_SPAN))
+    {
+        sim_spi_write((addr - SPI0_BASE) / 4, value);
+    }
+    else if (in_range(addr, PTIMER_ADDR, TIMER_SPAN))
+    {
+        timer_write(&ptimer, (addr - SIM_ADDR(PTIMER_ADDR)) / 4, value);
+    }
+    else if (in_range(addr, PWDT_ADDR, TIMER_SPAN))
+    {
+        timer_write(&pwdt, (addr - SIM_ADDR(PWDT_ADDR)) / 4, value);
+    }
+    else if (in_range(addr, GTIMER_ADDR, GTIMER_SPAN))
+    {
+        gtimer_write((addr - SIM_ADDR(GTIMER_ADDR)) / 4, value);
+    }
+    else if (in_range(addr, L2_CACHE_ADDR + L2_MAINTENANCE / 4, L2_SPAN - L2_MAINTENANCE))
+    {
+        // Cache maintenance operations complete at once and read back as 0
+    }
+    else
+    {
+        sim_poke(addr, value);
+    }
+}
+
+/*------------------- mmio.h -------------------------------------------------*/
+
+unsigned mmio_read32(volatile unsigned *reg)
+{
+    return bus_read(SIM_ADDR(reg));
+}
+
+void mmio_write32(volatile unsigned *reg, unsigned value)
+{
+    bus_write(SIM_ADDR(reg), value);
+}
+
+unsigned char mmio_read8(volatile unsigned char *reg)
+{
+    return (unsigned char)bus_read(SIM_ADDR(reg));
+}
+
+void mmio_write8(volatile unsigned char *reg, unsigned char value)
+{
+    bus_write(SIM_ADDR(reg), value);
+}
+
+void mmio_write_addr(volatile unsigned *reg, const void *ptr)
+{
+    uint32 addr = SIM_ADDR(reg);
+
+    if (in_range(addr, AES_ENCRYPT_ADDR, AES_MODULES * AES_SPAN))
+    {
+        accesses++;
+        sim_ticks += SIM_ACCESS_TICKS;
+        sim_aes_write_addr((addr - SIM_ADDR(AES_ENCRYPT_ADDR)) / AES_SPAN, (addr % AES_SPAN) / 4, ptr);
+        return;
+    }
+
+    bus_write(addr, (uint32)(uintptr_t)ptr);
+}
@@ -0,0 +1,129 @@
+/**
+ * This module contains the types and functions of the peripheral models behind mmio.h in the host build
+ *
+ * The models run on a virtual clock of SIM_TICKS_PER_US ticks per us, the rate of the private and global
+ * timers. Every register access costs SIM_ACCESS_TICKS, roughly a read over the lightweight bridge, and
+ * the models derive all their timing from the clock: UART bytes arrive and leave at the programmed baud
+ * rate, AES blocks take the cycle counts of AES/verilog_version/latency_baseline.txt and a sleep in
+ * hps_usleep() skips to the watchdog interrupt. Virtual time is deterministic, so benchmarks give the
+ * same numbers on every run and on any machine.
+ *
+ * Addresses that no model claims (PIOs, HEX, the master password memory, GIC, ...) are a plain register
+ * file, which tests read and set with sim_peek() and sim_poke().
+ */
+
+#ifndef SIM_H_
+#define SIM_H_
+
+#include <stdint.h>
+#include <typeDef.h>
+
+#define SIM_TICKS_PER_US 200
+#define SIM_ACCESS_TICKS 20
+
+// FPGA clock of the AES modules, 50 MHz
+#define SIM_FPGA_CYCLE_TICKS 4
+
+// Bus address of a register of memAddress.h, for sim_peek() and sim_poke()
+#define SIM_ADDR(reg) ((uint32)(uintptr_t)(reg))
+
+/*------------------- Clock and register file -------------------------------*/
+
+extern uint64 sim_ticks;
+
+void sim_reset(void);
+void sim_advance(uint64 ticks);
+uint64 sim_time_us(void);
+uint32 sim_peek(uint32 addr);
+void sim_poke(uint32 addr, uint32 value);
+unsigned long sim_accesses(void);
+
+/*------------------- UART (16550) -------------------------------------------*/
+
+typedef enum
+{
+    SIM_UART_WIFI,
+    SIM_UART_BLUETOOTH,
+    SIM_UARTS
+} sim_uart_port;
+
+// Called with each byte the firmware transmits, e.g. by a model of the device on the other end
+typedef void (*sim_uart_tx_fn)(sim_uart_port port, uint8 data);
+
+uint64 sim_uart_feed(sim_uart_port port, const void *data, int length);
+uint64 sim_uart_feed_after(sim_uart_port port, uint64 delay, const void *data, int length);
+int sim_uart_rx_pending(sim_uart_port port);
+int sim_uart_take_tx(sim_uart_port port, char *buffer, int size);
+void sim_uart_set_tx_handler(sim_uart_port port, sim_uart_tx_fn handler);
+uint64 sim_uart_byte_ticks(sim_uart_port port);
+unsigned long sim_uart_overruns(sim_uart_port port);
+
+/*------------------- AES ----------------------------------------------------*/
+
+void sim_aes_block(const uint8 key[16], const uint8 input[16], uint8 output[16], int decrypting);
+unsigned long sim_aes_blocks(void);
+
+/*------------------- SPI master and MPU9250 ---------------------------------*/
+
+#define SIM_SPI_BYTE_TICKS 16
+#define SIM_MPU_FIFO_SIZE 512
+
+// The SPI master keeps its own clock of one tick per SPI register access, see simSpi.c
+typedef struct
+{
+    int byte_ticks;
+    bool hold_valid;
+    uint8 hold;
+    bool shift_active;
+    uint8 shift;
+    int shift_left;
+    bool rx_valid;
+    uint8 rx;
+    bool roe;
+    uint32 control;
+    uint32 slave_sel;
+
+    // Statistics
+    unsigned long ticks;
+    unsigned long transfers;
+    unsigned long bytes;
+    unsigned long overruns;
+    unsigned long cs_ticks; // ticks the chip select was held
+    unsigned long cs_start;
+    int errors;
+} sim_spi_t;
+
+typedef struct
+{
+    uint8 regs[128];
+    uint8 ak[32];
+    uint8 fifo[SIM_MPU_FIFO_SIZE];
+    int fifo_head;
+    int fifo_count;
+    int byte_index; // byte of the current transfer
+    uint8 addr;
+    bool read;
+    bool absent; // nothing drives MISO
+} sim_mpu_t;
+
+extern sim_spi_t sim_spi;
+extern sim_mpu_t sim_mpu;
+
+void sim_spi_reset(int byte_ticks);
+void sim_mpu_sample(const int16 accel[3], const int16 gyro[3], const int16 mag[3]);
+
+/*------------------- Models, called by the bus in sim.c ---------------------*/
+
+void sim_uart_reset(void);
+uint8 sim_uart_read(sim_uart_port port, int reg);
+void sim_uart_write(sim_uart_port port, int reg, uint8 value);
+
+void sim_aes_reset(void);
+uint32 sim_aes_read(int module, int word);
+void sim_aes_write(int module, int word, uint32 value);
+void sim_aes_write_addr(int module, int word, const void *ptr);
+
+uint32 sim_spi_read(int reg);
+void sim_spi_write(int reg, uint32 value);
+
+#endif /* SIM_H_ */
@@ -0,0 +1,589 @@
+/**
+ * This module contains the model of the AES modules in the FPGA for the host build: the encryption
+ * and decryption modules and the AES core with key slots, DMA and CTR mode, with the register layout
+ * of AES/verilog_version/docs.txt.
+ *
+ * Blocks are computed in software with FIPS-197 AES-128 when they are started and become visible after
+ * the cycle counts the RTL takes, so polling drivers see busy modules. The block and key words hold the
+ * FIPS-197 bytes in reverse order, word 0 bits [7:0] being the last byte. The DMA reads and writes host
+ * memory through the pointers passed with mmio_write_addr().
+ */
+
+#include <string.h>
+#include <typeDef.h>
+#include "sim.h"
+
+// Modules in address order from AES_ENCRYPT_ADDR
+#define AES_ENCRYPT 0
+#define AES_DECRYPT 1
+#define AES_CORE 3
+
+// Words of all modules
+#define AES_KEY 0
+#define AES_BLOCK 4
+#define AES_START_KEYEXP 8
+#define AES_START 9
+#define AES_STATUS 10
+
+// Words of the core
+#define CORE_KEYEXP 8
+#define CORE_ENCRYPT 9
+#define CORE_DECRYPT 10
+#define CORE_SLOTS 11
+#define CORE_DMA_SRC 12
+#define CORE_DMA_DST 13
+#define CORE_DMA_START 14
+#define CORE_DMA_STATUS 15
+#define CORE_CTR_COUNTER 16
+#define CORE_CTR_NONCE 18
+#define CORE_CTR_LENGTH 20
+
+#define STATUS_BUSY 0x1
+#define STATUS_DONE 0x2
+#define DMA_DECRYPT (1 << 24)
+#define DMA_CTR (1 << 26)
+
+#define CORE_KEY_SLOTS 4
+
+// Cycles of AES/verilog_version/latency_baseline.txt
+#define ENCRYPT_KEXP_CYCLES 72
+#define ENCRYPT_CYCLES 61
+#define DECRYPT_KEXP_CYCLES 108
+#define DECRYPT_CYCLES 97
+#define CORE_KEXP_CYCLES 12
+#define CORE_BLOCK_CYCLES 13
+// A DMA block reads 4 words, runs the rounds without the start cycle and writes 4 words, 20 cycles in
+// tb_aes_core_dma.sv when the memory does not stall
+#define DMA_BLOCK_CYCLES (CORE_BLOCK_CYCLES - 1 + 8)
+
+typedef struct
+{
+    uint32 key[4];
+    uint32 block[4];
+    uint32 result[4];
+    uint8 loaded_key[16];
+    uint64 done_ticks;
+    bool running;
+    bool done;
+} aes_module_t;
+
+static struct
+{
+    aes_module_t modules[2];
+
+    // Core with key slots
+    struct
+    {
+        uint32 key[4];
+        uint32 block[4];
+        uint32 result[4];
+        uint8 slots[CORE_KEY_SLOTS][16];
+        uint32 valid;
+        uint32 ctr[4];
+        uint32 ctr_length;
+        uint8 *dma_src;
+        uint8 *dma_dst;
+        uint32 dma_blocks;
+        uint64 dma_start_ticks;
+        uint64 dma_done_ticks;
+        bool dma_done;
+    } core;
+
+    unsigned long blocks;
+} aes;
+
+/*------------------- FIPS-197 AES-128 ---------------------------------------*/
+
+static const uint8 sbox[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16};
+
+static uint8 inv_sbox[256];
+
+static uint8 xtime(uint8 x)
+{
+    return (uint8)((x << 1) ^ (x & 0x80 ? 0x1b : 0));
+}
+
+static uint8 gmul(uint8 a, uint8 b)
+{
+    uint8 product = 0;
+
+    while (b)
+    {
+        if (b & 1)
+        {
+            product ^= a;
+        }
+        a = xtime(a);
+        b >>= 1;
+    }
+
+    return product;
+}
+
+static void expand_key(const uint8 key[16], uint8 round_keys[176])
+{
+    uint8 rcon = 1;
+
+    memcpy(round_keys, key, 16);
+    for (int i = 16; i < 176; i += 4)
+    {
+        uint8 t[4];
+
+        memcpy(t, &round_keys[i - 4], 4);
+        if (i % 16 == 0)
+        {
+            uint8 first = t[0];
+
+            t[0] = sbox[t[1]] ^ rcon;
+            t[1] = sbox[t[2]];
+            t[2] = sbox[t[3]];
+            t[3] = sbox[first];
+            rcon = xtime(rcon);
+        }
+        for (int j = 0; j < 4; j++)
+        {
+            round_keys[i + j] = round_keys[i - 16 + j] ^ t[j];
+        }
+    }
+}
+
+static void add_round_key(uint8 state[16], const uint8 *round_key)
+{
+    for (int i = 0; i < 16; i++)
+    {
+        state[i] ^= round_key[i];
+    }
+}
+
+static void encrypt_fips(const uint8 key[16], const uint8 input[16], uint8 output[16])
+{
+    uint8 round_keys[176];
+    uint8 state[16];
+    uint8 t[16];
+
+    expand_key(key, round_keys);
+    memcpy(state, input, 16);
+    add_round_key(state, round_keys);
+
+    for (int round = 1; round <= 10; round++)
+    {
+        // SubBytes and ShiftRows, the state is column major
+        for (int i = 0; i < 16; i++)
+        {
+            t[i] = sbox[state[(i + 4 * (i % 4)) % 16]];
+        }
+
+        if (round < 10)
+        {
+            // MixColumns
+            for (int c = 0; c < 4; c++)
+            {
+                uint8 *col = &t[4 * c];
+                uint8 a0 = col[0], a1 = col[1], a2 = col[2], a3 = col[3];
+
+                col[0] = xtime(a0) ^ (xtime(a1) ^ a1) ^ a2 ^ a3;
+                col[1] = a0 ^ xtime(a1) ^ (xtime(a2) ^ a2) ^ a3;
+                col[2] = a0 ^ a1 ^ xtime(a2) ^ (xtime(a3) ^ a3);
+                col[3] = (xtime(a0) ^ a0) ^ a1 ^ a2 ^ xtime(a3);
+            }
+        }
+
+        memcpy(state, t, 16);
+        add_round_key(state, &round_keys[16 * round]);
+    }
+
+    memcpy(output, state, 16);
+}
+
+static void decrypt_fips(const uint8 key[16], const uint8 input[16], uint8 output[16])
+{
+    uint8 round_keys[176];
+    uint8 state[16];
+    uint8 t[16];
+
+    if (inv_sbox[0] == 0)
+    {
+        for (int i = 0; i < 256; i++)
+        {
+            inv_sbox[sbox[i]] = (uint8)i;
+        }
+    }
+
+    expand_key(key, round_keys);
+    memcpy(state, input, 16);
+    add_round_key(state, &round_keys[160]);
+
+    for (int round = 9; round >= 0; round--)
+    {
+        // InvShiftRows and InvSubBytes
+        for (int i = 0; i < 16; i++)
+        {
+            t[(i + 4 * (i % 4)) % 16] = inv_sbox[state[i]];
+        }
+
+        add_round_key(t, &round_keys[16 * round]);
+
+        if (round > 0)
+        {
+            // InvMixColumns
+            for (int c = 0; c < 4; c++)
+            {
+                uint8 *col = &t[4 * c];
+                uint8 a0 = col[0], a1 = col[1], a2 = col[2], a3 = col[3];
+
+                col[0] = gmul(a0, 14) ^ gmul(a1, 11) ^ gmul(a2, 13) ^ gmul(a3, 9);
+                col[1] = gmul(a0, 9) ^ gmul(a1, 14) ^ gmul(a2, 11) ^ gmul(a3, 13);
+                col[2] = gmul(a0, 13) ^ gmul(a1, 9) ^ gmul(a2, 14) ^ gmul(a3, 11);
+                col[3] = gmul(a0, 11) ^ gmul(a1, 13) ^ gmul(a2, 9) ^ gmul(a3, 14);
+            }
+        }
+
+        memcpy(state, t, 16);
+    }
+
+    memcpy(output, state, 16);
+}
+
+/**
+ * Encrypt or decrypt a block in software with the byte order of encrypt() and decrypt()
+ *
+ * Params:
+ *  key         16 byte key
+ *  input       16 byte block
+ *  output      filled with the 16 byte result
+ *  decrypting  int/boolean to specify whether to decrypt instead of encrypt
+ */
+void sim_aes_block(const uint8 key[16], const uint8 input[16], uint8 output[16], int decrypting)
+{
+    uint8 fips_key[16], fips_input[16], fips_output[16];
+
+    for (int i = 0; i < 16; i++)
+    {
+        fips_key[i] = key[15 - i];
+        fips_input[i] = input[15 - i];
+    }
+
+    if (decrypting)
+    {
+        decrypt_fips(fips_key, fips_input, fips_output);
+    }
+    else
+    {
+        encrypt_fips(fips_key, fips_input, fips_output);
+    }
+
+    for (int i = 0; i < 16; i++)
+    {
+        output[i] = fips_output[15 - i];
+    }
+}
+
+/**
+ * Returns the number of blocks the modules have encrypted or decrypted since the last reset
+ */
+unsigned long sim_aes_blocks(void)
+{
+    return aes.blocks;
+}
+
+/*------------------- Register words -----------------------------------------*/
+
+// Words 0 to 3 to bytes in the order of encrypt(), word 0 holds the last 4 bytes
+static void words_to_bytes(const uint32 words[4], uint8 bytes[16])
+{
+    for (int i = 0; i < 4; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            bytes[12 - 4 * i + j] = (uint8)(words[i] >> (8 * (3 - j)));
+        }
+    }
+}
+
+static void bytes_to_words(const uint8 bytes[16], uint32 words[4])
+{
+    for (int i = 0; i < 4; i++)
+    {
+        words[i] = ((uint32)bytes[12 - 4 * i] << 24) | ((uint32)bytes[13 - 4 * i] << 16) |
+                   ((uint32)bytes[14 - 4 * i] << 8) | bytes[15 - 4 * i];
+    }
+}
+
+static void block_words(const uint8 key[16], const uint32 input[4], uint32 output[4], int decrypting)
+{
+    uint8 in[16], out[16];
+
+    words_to_bytes(input, in);
+    sim_aes_block(key, in, out, decrypting);
+    bytes_to_words(out, output);
+    aes.blocks++;
+}
+
+void sim_aes_reset(void)
+{
+    memset(&aes, 0, sizeof(aes));
+}
+
+/*------------------- Encryption and decryption modules ----------------------*/
+
+static uint32 module_read(aes_module_t *module, int word)
+{
+    if (module->running && sim_ticks >= module->done_ticks)
+    {
+        module->running = false;
+        module->done = true;
+    }
+
+    if (word < 4)
+    {
+        return module->result[word];
+    }
+    if (word == AES_STATUS)
+    {
+        return (module->running ? STATUS_BUSY : 0) | (module->done ? STATUS_DONE : 0);
+    }
+
+    return 0;
+}
+
+static void module_write(aes_module_t *module, int word, uint32 value, int decrypting)
+{
+    int cycles;
+
+    if (word < 4)
+    {
+        module->key[word] = value;
+        return;
+    }
+    if (word < 8)
+    {
+        // Writing word 4 abandons a block that is still running
+        module->block[word - 4] = value;
+        if (word == AES_BLOCK)
+        {
+            module->running = false;
+            module->done = false;
+        }
+        return;
+    }
+
+    switch (word)
+    {
+    case AES_START_KEYEXP:
+    case AES_START:
+        if (word == AES_START_KEYEXP)
+        {
+            words_to_bytes(module->key, module->loaded_key);
+            cycles = decrypting ? DECRYPT_KEXP_CYCLES : ENCRYPT_KEXP_CYCLES;
+        }
+        else
+        {
+            cycles = decrypting ? DECRYPT_CYCLES : ENCRYPT_CYCLES;
+        }
+        block_words(module->loaded_key, module->block, module->result, decrypting);
+        module->running = true;
+        module->done = false;
+        module->done_ticks = sim_ticks + (uint64)cycles * SIM_FPGA_CYCLE_TICKS;
+        break;
+    case AES_STATUS:
+        module->done = false;
+        break;
+    }
+}
+
+/*------------------- Core ---------------------------------------------------*/
+
+// Run a whole DMA transfer at once, the status word shows it running for the time it takes
+static void core_dma(uint32 start)
+{
+    int slot = (start >> 16) & 0xFF;
+    uint8 *key = aes.core.slots[slot % CORE_KEY_SLOTS];
+    uint32 blocks;
+    uint8 block[16];
+
+    if (start & DMA_CTR)
+    {
+        uint64 counter = ((uint64)aes.core.ctr[1] << 32) | aes.core.ctr[0];
+        uint32 length = aes.core.ctr_length;
+        uint32 ctr_words[4];
+        uint8 keystream[16];
+
+        blocks = (length + 15) / 16;
+        for (uint32 n = 0; n < blocks; n++, counter++)
+        {
+            ctr_words[0] = (uint32)counter;
+            ctr_words[1] = (uint32)(counter >> 32);
+            ctr_words[2] = aes.core.ctr[2];
+            ctr_words[3] = aes.core.ctr[3];
+            words_to_bytes(ctr_words, block);
+            sim_aes_block(key, block, keystream, 0);
+            aes.blocks++;
+
+            for (uint32 j = 0; j < 16 && 16 * n + j < length; j++)
+            {
+                aes.core.dma_dst[16 * n + j] = aes.core.dma_src[16 * n + j] ^ keystream[j];
+            }
+        }
+        aes.core.ctr[0] = (uint32)counter;
+        aes.core.ctr[1] = (uint32)(counter >> 32);
+    }
+    else
+    {
+        blocks = start & 0xFFFF;
+        for (uint32 n = 0; n < blocks; n++)
+        {
+            sim_aes_block(key, aes.core.dma_src + 16 * n, block, (start & DMA_DECRYPT) != 0);
+            memcpy(aes.core.dma_dst + 16 * n, block, 16);
+            aes.blocks++;
+        }
+    }
+
+    aes.core.dma_blocks = blocks;
+    aes.core.dma_start_ticks = sim_ticks;
+    aes.core.dma_done_ticks = sim_ticks + (uint64)blocks * DMA_BLOCK_CYCLES * SIM_FPGA_CYCLE_TICKS;
+    aes.core.dma_done = false;
+}
+
+static uint32 core_read(int word)
+{
+    if (word < 4)
+    {
+        return aes.core.result[word];
+    }
+
+    switch (word)
+    {
+    case CORE_SLOTS:
+        return aes.core.valid;
+    case CORE_DMA_STATUS:
+        if (aes.core.dma_blocks != 0 && sim_ticks >= aes.core.dma_done_ticks)
+        {
+            aes.core.dma_blocks = 0;
+            aes.core.dma_done = true;
+        }
+        if (aes.core.dma_blocks != 0)
+        {
+            uint64 left = (aes.core.dma_done_ticks - sim_ticks) / (DMA_BLOCK_CYCLES * SIM_FPGA_CYCLE_TICKS) + 1;
+
+            return STATUS_BUSY | (uint32)(left << 16);
+        }
+        return aes.core.dma_done ? STATUS_DONE : 0;
+    case CORE_CTR_COUNTER:
+    case CORE_CTR_COUNTER + 1:
+    case CORE_CTR_NONCE:
+    case CORE_CTR_NONCE + 1:
+        return aes.core.ctr[word - CORE_CTR_COUNTER];
+    case CORE_CTR_LENGTH:
+        return aes.core.ctr_length;
+    default:
+        return 0;
+    }
+}
+
+static void core_write(int word, uint32 value)
+{
+    int slot = (int)(value % CORE_KEY_SLOTS);
+
+    if (word < 4)
+    {
+        aes.core.key[word] = value;
+        return;
+    }
+    if (word < 8)
+    {
+        aes.core.block[word - 4] = value;
+        return;
+    }
+
+    switch (word)
+    {
+    case CORE_KEYEXP:
+        words_to_bytes(aes.core.key, aes.core.slots[slot]);
+        aes.core.valid |= 1u << slot;
+        sim_ticks += CORE_KEXP_CYCLES * SIM_FPGA_CYCLE_TICKS;
+        break;
+    case CORE_ENCRYPT:
+    case CORE_DECRYPT:
+        // Holds waitrequest until the block is done
+        block_words(aes.core.slots[slot], aes.core.block, aes.core.result, word == CORE_DECRYPT);
+        sim_ticks += CORE_BLOCK_CYCLES * SIM_FPGA_CYCLE_TICKS;
+        break;
+    case CORE_SLOTS:
+        aes.core.valid &= ~(1u << slot);
+        memset(aes.core.slots[slot], 0, 16);
+        break;
+    case CORE_DMA_START:
+        core_dma(value);
+        break;
+    case CORE_DMA_STATUS:
+        aes.core.dma_done = false;
+        break;
+    case CORE_CTR_COUNTER:
+    case CORE_CTR_COUNTER + 1:
+    case CORE_CTR_NONCE:
+    case CORE_CTR_NONCE + 1:
+        aes.core.ctr[word - CORE_CTR_COUNTER] = value;
+        break;
+    case CORE_CTR_LENGTH:
+        aes.core.ctr_length = value;
+        break;
+    }
+}
+
+/*------------------- Bus ----------------------------------------------------*/
+
+uint32 sim_aes_read(int module, int word)
+{
+    switch (module)
+    {
+    case AES_ENCRYPT:
+    case AES_DECRYPT:
+        return module_read(&aes.modules[module], word);
+    case AES_CORE:
+        return core_read(word);
+    default:
+        return 0;
+    }
+}
+
+void sim_aes_write(int module, int word, uint32 value)
+{
+    switch (module)
+    {
+    case AES_ENCRYPT:
+    case AES_DECRYPT:
+        module_write(&aes.modules[module], word, value, module == AES_DECRYPT);
+        break;
+    case AES_CORE:
+        core_write(word, value);
+        break;
+    }
+}
+
+void sim_aes_write_addr(int module, int word, const void *ptr)
+{
+    if (module == AES_CORE && word == CORE_DMA_SRC)
+    {
+        aes.core.dma_src = (uint8 *)ptr;
+    }
+    else if (module == AES_CORE && word == CORE_DMA_DST)
+    {
+        aes.core.dma_dst = (uint8 *)ptr;
+    }
+}
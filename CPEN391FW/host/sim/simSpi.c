@@ -0,0 +1,360 @@
+/**
+ * This module contains the model of the Avalon SPI master SPI0 and of the MPU9250 behind it for the
+ * host build.
+ *
+ * The SPI master is modelled at the register level. It has its own time, one tick per register access of
+ * the SPI master, and a byte takes byte_ticks to shift, so a driver that leaves a byte unread for too long
+ * overruns the receive register the way the hardware would. The MPU9250 runs its I2C master right away
+ * and only produces samples when a test calls sim_mpu_sample().
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <typeDef.h>
+#include "constants.h"
+#include "altera_avalon_spi_regs.h"
+#include "sim.h"
+
+#define FIFO_COUNTL_ 0x73
+#define ACCEL_OUT_ 0x3B
+#define GYRO_OUT_ 0x43
+#define AK8963_ST2_ 0x09
+
+sim_spi_t sim_spi = {.byte_ticks = SIM_SPI_BYTE_TICKS};
+sim_mpu_t sim_mpu = {.regs = {[PWR_MGMNT_1_] = 0x01, [WHOAMI_] = WHOAMI_MPU9250_},
+                     .ak = {[AK8963_WHOAMI_] = WHOAMI_AK8963_, [AK8963_ASA_] = 0x80, [AK8963_ASA_ + 1] = 0x80,
+                            [AK8963_ASA_ + 2] = 0x80}};
+
+static void mpu_cs_assert(void);
+static uint8 mpu_exchange(uint8 mosi);
+static void mpu_reset(void);
+
+/*------------------- SPI master model ---------------------------------------*/
+
+static bool spi_cs(void)
+{
+    return (sim_spi.control & ALTERA_AVALON_SPI_CONTROL_SSO_MSK) && (sim_spi.slave_sel & 1);
+}
+
+static void spi_tick(void)
+{
+    sim_spi.ticks++;
+
+    if (sim_spi.shift_active && --sim_spi.shift_left == 0)
+    {
+        if (sim_spi.rx_valid)
+        {
+            sim_spi.roe = true;
+            sim_spi.overruns++;
+        }
+        sim_spi.rx = spi_cs() ? mpu_exchange(sim_spi.shift) : 0xFF;
+        sim_spi.rx_valid = true;
+        sim_spi.shift_active = false;
+        sim_spi.bytes++;
+    }
+
+    if (!sim_spi.shift_active && sim_spi.hold_valid)
+    {
+        sim_spi.shift = sim_spi.hold;
+        sim_spi.hold_valid = false;
+        sim_spi.shift_active = true;
+        sim_spi.shift_left = sim_spi.byte_ticks;
+    }
+}
+
+uint32 sim_spi_read(int reg)
+{
+    uint32 status;
+
+    spi_tick();
+
+    switch (reg)
+    {
+    case ALTERA_AVALON_SPI_RXDATA_REG:
+        sim_spi.rx_valid = false;
+        return sim_spi.rx;
+    case ALTERA_AVALON_SPI_STATUS_REG:
+        status = 0;
+        if (!sim_spi.hold_valid)
+            status |= ALTERA_AVALON_SPI_STATUS_TRDY_MSK;
+        if (!sim_spi.hold_valid && !sim_spi.shift_active)
+            status |= ALTERA_AVALON_SPI_STATUS_TMT_MSK;
+        if (sim_spi.rx_valid)
+            status |= ALTERA_AVALON_SPI_STATUS_RRDY_MSK;
+        if (sim_spi.roe)
+            status |= ALTERA_AVALON_SPI_STATUS_ROE_MSK | ALTERA_AVALON_SPI_STATUS_E_MSK;
+        return status;
+    case ALTERA_AVALON_SPI_CONTROL_REG:
+        return sim_spi.control;
+    case ALTERA_AVALON_SPI_SLAVE_SEL_REG:
+        return sim_spi.slave_sel;
+    }
+
+    return 0;
+}
+
+void sim_spi_write(int reg, uint32 data)
+{
+    bool was_selected = spi_cs();
+
+    spi_tick();
+
+    switch (reg)
+    {
+    case ALTERA_AVALON_SPI_TXDATA_REG:
+        if (sim_spi.hold_valid)
+        {
+            printf("model: TXDATA written while not ready\n");
+            sim_spi.errors++;
+        }
+        sim_spi.hold = (uint8)data;
+        sim_spi.hold_valid = true;
+        break;
+    case ALTERA_AVALON_SPI_STATUS_REG:
+        sim_spi.roe = false;
+        break;
+    case ALTERA_AVALON_SPI_CONTROL_REG:
+        sim_spi.control = data;
+        break;
+    case ALTERA_AVALON_SPI_SLAVE_SEL_REG:
+        sim_spi.slave_sel = data;
+        break;
+    }
+
+    if (!was_selected && spi_cs())
+    {
+        sim_spi.transfers++;
+        sim_spi.cs_start = sim_spi.ticks;
+        mpu_cs_assert();
+    }
+    else if (was_selected && !spi_cs())
+    {
+        if (sim_spi.hold_valid || sim_spi.shift_active)
+        {
+            printf("model: chip select released during a byte\n");
+            sim_spi.errors++;
+        }
+        sim_spi.cs_ticks += sim_spi.ticks - sim_spi.cs_start;
+    }
+}
+
+/*------------------- MPU9250 model ------------------------------------------*/
+
+static void mpu_reset(void)
+{
+    memset(sim_mpu.regs, 0, sizeof(sim_mpu.regs));
+    sim_mpu.regs[PWR_MGMNT_1_] = 0x01;
+    sim_mpu.regs[WHOAMI_] = WHOAMI_MPU9250_;
+    sim_mpu.fifo_count = 0;
+}
+
+static void mpu_fifo_push(uint8 data)
+{
+    if (sim_mpu.fifo_count == SIM_MPU_FIFO_SIZE)
+    {
+        // The oldest byte is overwritten
+        sim_mpu.fifo_head = (sim_mpu.fifo_head + 1) % SIM_MPU_FIFO_SIZE;
+        sim_mpu.fifo_count--;
+        sim_mpu.regs[INT_STATUS_] |= FIFO_OFLOW_INT_;
+    }
+    sim_mpu.fifo[(sim_mpu.fifo_head + sim_mpu.fifo_count) % SIM_MPU_FIFO_SIZE] = data;
+    sim_mpu.fifo_count++;
+}
+
+static uint8 mpu_fifo_pop(void)
+{
+    uint8 data;
+
+    if (sim_mpu.fifo_count == 0)
+    {
+        return 0xFF;
+    }
+    data = sim_mpu.fifo[sim_mpu.fifo_head];
+    sim_mpu.fifo_head = (sim_mpu.fifo_head + 1) % SIM_MPU_FIFO_SIZE;
+    sim_mpu.fifo_count--;
+    return data;
+}
+
+// One I2C master transaction of slave 0, run right away when it is enabled
+static void mpu_i2c_slv0(void)
+{
+    uint8 addr = sim_mpu.regs[I2C_SLV0_ADDR_];
+    uint8 reg = sim_mpu.regs[I2C_SLV0_REG_];
+    int count = sim_mpu.regs[I2C_SLV0_CTRL_] & 0x0F;
+
+    if (!(sim_mpu.regs[USER_CTRL_] & I2C_MST_EN_) || !(sim_mpu.regs[I2C_SLV0_CTRL_] & I2C_SLV0_EN_) ||
+        (addr & 0x7F) != AK8963_I2C_ADDR_)
+    {
+        return;
+    }
+
+    if (addr & I2C_READ_FLAG_)
+    {
+        memcpy(&sim_mpu.regs[EXT_SENS_DATA_00_], &sim_mpu.ak[reg], count);
+    }
+    else if (reg == AK8963_CNTL2_ && (sim_mpu.regs[I2C_SLV0_DO_] & AK8963_RESET_))
+    {
+        // Soft reset, the bit clears itself
+        sim_mpu.ak[AK8963_CNTL1_] = 0;
+    }
+    else
+    {
+        sim_mpu.ak[reg] = sim_mpu.regs[I2C_SLV0_DO_];
+    }
+}
+
+static void mpu_write(uint8 reg, uint8 data)
+{
+    switch (reg)
+    {
+    case PWR_MGMNT_1_:
+        if (data & H_RESET_)
+        {
+            mpu_reset();
+            return;
+        }
+        break;
+    case USER_CTRL_:
+        if (data & USER_FIFO_RST_)
+        {
+            sim_mpu.fifo_count = 0;
+            data &= ~USER_FIFO_RST_;
+        }
+        break;
+    case WHOAMI_:
+        return;
+    }
+
+    sim_mpu.regs[reg] = data;
+
+    if (reg == I2C_SLV0_CTRL_)
+    {
+        mpu_i2c_slv0();
+    }
+}
+
+static uint8 mpu_read(uint8 reg)
+{
+    uint8 data;
+
+    switch (reg)
+    {
+    case FIFO_COUNTH_:
+        return (uint8)(sim_mpu.fifo_count >> 8);
+    case FIFO_COUNTL_:
+        return (uint8)sim_mpu.fifo_count;
+    case FIFO_R_W_:
+        return mpu_fifo_pop();
+    case INT_STATUS_:
+        // Cleared by reading
+        data = sim_mpu.regs[INT_STATUS_];
+        sim_mpu.regs[INT_STATUS_] = 0;
+        return data;
+    }
+
+    return sim_mpu.regs[reg];
+}
+
+static void mpu_cs_assert(void)
+{
+    sim_mpu.byte_index = 0;
+}
+
+static uint8 mpu_exchange(uint8 mosi)
+{
+    uint8 miso = 0;
+
+    if (sim_mpu.absent)
+    {
+        return 0xFF;
+    }
+
+    if (sim_mpu.byte_index++ == 0)
+    {
+        sim_mpu.addr = mosi & 0x7F;
+        sim_mpu.read = (mosi & 0x80) != 0;
+        return 0;
+    }
+
+    if (sim_mpu.read)
+    {
+        miso = mpu_read(sim_mpu.addr);
+    }
+    else
+    {
+        mpu_write(sim_mpu.addr, mosi);
+    }
+
+    // Bursts go on with the next register, except on the FIFO port
+    if (sim_mpu.addr != FIFO_R_W_)
+    {
+        sim_mpu.addr = (sim_mpu.addr + 1) & 0x7F;
+    }
+
+    return miso;
+}
+
+static void put_be(uint8 *p, int16 value)
+{
+    p[0] = (uint8)((uint16)value >> 8);
+    p[1] = (uint8)value;
+}
+
+/**
+ * One sample at the sample rate: data registers, AK8963 read of slave 0 and a FIFO frame
+ */
+void sim_mpu_sample(const int16 accel[3], const int16 gyro[3], const int16 mag[3])
+{
+    int i;
+    int count = sim_mpu.regs[I2C_SLV0_CTRL_] & 0x0F;
+
+    for (i = 0; i < 3; i++)
+    {
+        put_be(&sim_mpu.regs[ACCEL_OUT_ + 2 * i], accel[i]);
+        put_be(&sim_mpu.regs[GYRO_OUT_ + 2 * i], gyro[i]);
+        sim_mpu.ak[AK8963_HXL_ + 2 * i] = (uint8)mag[i];
+        sim_mpu.ak[AK8963_HXL_ + 2 * i + 1] = (uint8)((uint16)mag[i] >> 8);
+    }
+    sim_mpu.ak[AK8963_ST2_] = 0x10;
+
+    if ((sim_mpu.regs[I2C_SLV0_CTRL_] & I2C_SLV0_EN_) && (sim_mpu.regs[I2C_SLV0_ADDR_] & I2C_READ_FLAG_))
+    {
+        mpu_i2c_slv0();
+    }
+    sim_mpu.regs[INT_STATUS_] |= RAW_DATA_RDY_INT_;
+
+    if (sim_mpu.regs[USER_CTRL_] & USER_FIFO_EN_)
+    {
+        if (sim_mpu.regs[FIFO_EN_] & FIFO_ACCEL_)
+        {
+            for (i = 0; i < 6; i++)
+                mpu_fifo_push(sim_mpu.regs[ACCEL_OUT_ + i]);
+        }
+        if ((sim_mpu.regs[FIFO_EN_] & FIFO_GYRO_) == FIFO_GYRO_)
+        {
+            for (i = 0; i < 6; i++)
+                mpu_fifo_push(sim_mpu.regs[GYRO_OUT_ + i]);
+        }
+        if (sim_mpu.regs[FIFO_EN_] & FIFO_SLV0_)
+        {
+            for (i = 0; i < count; i++)
+                mpu_fifo_push(sim_mpu.regs[EXT_SENS_DATA_00_ + i]);
+        }
+    }
+}
+
+/**
+ * Reset the SPI master and the MPU9250, with the AK8963 behind it answering
+ *
+ * Params:
+ *  byte_ticks  SPI master ticks a byte takes to shift
+ */
+void sim_spi_reset(int byte_ticks)
+{
+    memset(&sim_spi, 0, sizeof(sim_spi));
+    sim_spi.byte_ticks = byte_ticks;
+    memset(&sim_mpu, 0, sizeof(sim_mpu));
+    mpu_reset();
+    sim_mpu.ak[AK8963_WHOAMI_] = WHOAMI_AK8963_;
+    sim_mpu.ak[AK8963_ASA_] = sim_mpu.ak[AK8963_ASA_ + 1] = sim_mpu.ak[AK8963_ASA_ + 2] = 0x80;
+}
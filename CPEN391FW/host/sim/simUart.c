@@ -0,0 +1,308 @@
+/**
+ * This module contains the model of the two 16550 UARTs, WiFi and Bluetooth, for the host build.
+ *
+ * A byte takes 10 bit times at the baud rate set by the divisor latch, with the 50 MHz UART clock of
+ * UART_Init(). Bytes fed with sim_uart_feed() go onto the line back to back from the time they are fed
+ * and reach the receiver one byte time apart. The receive FIFO holds 16 bytes, the FIFOs of the
+ * gh_uart_16550 core in Cloudlockr_Computer are always enabled whatever the FIFO control register
+ * says, and a byte arriving when it is full is lost and counted as an overrun, so a driver that polls
+ * too slowly loses data the way it would on the board. Transmitted bytes are
+ * captured for sim_uart_take_tx() and passed to the handler of the port, the holding register is free
+ * again once the byte before it has left the shift register.
+ */
+
+#include <string.h>
+#include <typeDef.h>
+#include "sim.h"
+
+// Register numbers, the registers are 2 bytes apart
+#define UART_RBR_THR_DLL 0
+#define UART_IER_DLM 1
+#define UART_IIR_FCR 2
+#define UART_LCR 3
+#define UART_MCR 4
+#define UART_LSR 5
+#define UART_MSR 6
+#define UART_SCR 7
+
+#define LCR_DLAB 0x80
+#define FCR_CLEAR_RX 0x02
+#define LSR_DATA_READY 0x01
+#define LSR_OVERRUN 0x02
+#define LSR_THR_EMPTY 0x20
+#define LSR_TX_EMPTY 0x40
+#define IIR_NO_INTERRUPT 0x01
+#define IIR_FIFOS 0xC0
+
+// 50 MHz UART clock, 16 clocks per bit and 10 bits per byte, in 200 MHz ticks
+#define UART_DIVISOR_TICKS (16 * 10 * 4)
+#define UART_FIFO_SIZE 16
+#define UART_LINE_SIZE 0x10000
+#define UART_TX_SIZE 0x10000
+
+typedef struct
+{
+    uint8 ier;
+    uint8 fcr;
+    uint8 lcr;
+    uint8 mcr;
+    uint8 scr;
+    uint16 divisor;
+    bool overrun;
+    unsigned long overruns;
+
+    // Bytes on their way to the receiver with their arrival times
+    uint8 line[UART_LINE_SIZE];
+    uint64 arrival[UART_LINE_SIZE];
+    int line_head;
+    int line_count;
+    uint64 line_busy;
+
+    uint8 fifo[UART_FIFO_SIZE];
+    int fifo_head;
+    int fifo_count;
+
+    // Time the last transmitted byte has left the shift register
+    uint64 tx_done;
+    char tx[UART_TX_SIZE];
+    int tx_length;
+    sim_uart_tx_fn handler;
+} sim_uart_t;
+
+static sim_uart_t uarts[SIM_UARTS];
+
+/**
+ * Returns the time one byte takes on the line of a port, in ticks
+ */
+uint64 sim_uart_byte_ticks(sim_uart_port port)
+{
+    uint16 divisor = uarts[port].divisor;
+
+    return (uint64)UART_DIVISOR_TICKS * (divisor != 0 ? divisor : 1);
+}
+
+// Move the bytes that have arrived by now into the receiver
+static void uart_receive(sim_uart_t *uart)
+{
+    while (uart->line_count > 0 && uart->arrival[uart->line_head] <= sim_ticks)
+    {
+        if (uart->fifo_count < UART_FIFO_SIZE)
+        {
+            uart->fifo[(uart->fifo_head + uart->fifo_count) % UART_FIFO_SIZE] = uart->line[uart->line_head];
+            uart->fifo_count++;
+        }
+        else
+        {
+            uart->overrun = true;
+            uart->overruns++;
+        }
+
+        uart->line_head = (uart->line_head + 1) % UART_LINE_SIZE;
+        uart->line_count--;
+    }
+}
+
+void sim_uart_reset(void)
+{
+    for (int i = 0; i < SIM_UARTS; i++)
+    {
+        sim_uart_tx_fn handler = uarts[i].handler;
+
+        memset(&uarts[i], 0, sizeof(uarts[i]));
+        uarts[i].handler = handler;
+    }
+}
+
+uint8 sim_uart_read(sim_uart_port port, int reg)
+{
+    sim_uart_t *uart = &uarts[port];
+    uint8 data;
+
+    uart_receive(uart);
+
+    switch (reg)
+    {
+    case UART_RBR_THR_DLL:
+        if (uart->lcr & LCR_DLAB)
+        {
+            return (uint8)uart->divisor;
+        }
+        if (uart->fifo_count == 0)
+        {
+            return 0;
+        }
+        data = uart->fifo[uart->fifo_head];
+        uart->fifo_head = (uart->fifo_head + 1) % UART_FIFO_SIZE;
+        uart->fifo_count--;
+        return data;
+    case UART_IER_DLM:
+        return uart->lcr & LCR_DLAB ? (uint8)(uart->divisor >> 8) : uart->ier;
+    case UART_IIR_FCR:
+        return IIR_NO_INTERRUPT | IIR_FIFOS;
+    case UART_LCR:
+        return uart->lcr;
+    case UART_MCR:
+        return uart->mcr;
+    case UART_LSR:
+        data = 0;
+        if (uart->fifo_count > 0)
+            data |= LSR_DATA_READY;
+        if (uart->overrun)
+            data |= LSR_OVERRUN;
+        if (uart->tx_done <= sim_ticks + sim_uart_byte_ticks(port))
+            data |= LSR_THR_EMPTY;
+        if (uart->tx_done <= sim_ticks)
+            data |= LSR_TX_EMPTY;
+        // Overrun is cleared by reading
+        uart->overrun = false;
+        return data;
+    case UART_SCR:
+        return uart->scr;
+    default:
+        return 0;
+    }
+}
+
+void sim_uart_write(sim_uart_port port, int reg, uint8 value)
+{
+    sim_uart_t *uart = &uarts[port];
+
+    uart_receive(uart);
+
+    switch (reg)
+    {
+    case UART_RBR_THR_DLL:
+        if (uart->lcr & LCR_DLAB)
+        {
+            uart->divisor = (uart->divisor & 0xFF00) | value;
+            break;
+        }
+        // Starts shifting when the byte before it is done
+        uart->tx_done = (uart->tx_done > sim_ticks ? uart->tx_done : sim_ticks) + sim_uart_byte_ticks(port);
+        if (uart->tx_length < UART_TX_SIZE)
+        {
+            uart->tx[uart->tx_length++] = (char)value;
+        }
+        if (uart->handler != NULL)
+        {
+            uart->handler(port, value);
+        }
+        break;
+    case UART_IER_DLM:
+        if (uart->lcr & LCR_DLAB)
+        {
+            uart->divisor = (uint16)((uart->divisor & 0x00FF) | (value << 8));
+        }
+        else
+        {
+            uart->ier = value;
+        }
+        break;
+    case UART_IIR_FCR:
+        uart->fcr = value;
+        if (value & FCR_CLEAR_RX)
+        {
+            uart->fifo_count = 0;
+        }
+        break;
+    case UART_LCR:
+        uart->lcr = value;
+        break;
+    case UART_MCR:
+        uart->mcr = value;
+        break;
+    case UART_SCR:
+        uart->scr = value;
+        break;
+    }
+}
+
+/**
+ * Put bytes on the receive line of a port, sent back to back after the bytes fed before
+ *
+ * Params:
+ *  port        port the bytes arrive on
+ *  data        the bytes
+ *  length      number of bytes, dropped if the line already holds UART_LINE_SIZE bytes
+ *
+ * Returns the time the last byte reaches the receiver, in ticks
+ */
+uint64 sim_uart_feed(sim_uart_port port, const void *data, int length)
+{
+    return sim_uart_feed_after(port, 0, data, length);
+}
+
+/**
+ * Put bytes on the receive line of a port once delay ticks have passed, e.g. the reply of a device
+ * that takes that long to answer. Like sim_uart_feed(), the bytes follow any bytes fed before.
+ *
+ * Returns the time the last byte reaches the receiver, in ticks
+ */
+uint64 sim_uart_feed_after(sim_uart_port port, uint64 delay, const void *data, int length)
+{
+    sim_uart_t *uart = &uarts[port];
+    const uint8 *bytes = data;
+
+    if (uart->line_busy < sim_ticks + delay)
+    {
+        uart->line_busy = sim_ticks + delay;
+    }
+
+    for (int i = 0; i < length && uart->line_count < UART_LINE_SIZE; i++)
+    {
+        int tail = (uart->line_head + uart->line_count) % UART_LINE_SIZE;
+
+        uart->line_busy += sim_uart_byte_ticks(port);
+        uart->line[tail] = bytes[i];
+        uart->arrival[tail] = uart->line_busy;
+        uart->line_count++;
+    }
+
+    return uart->line_busy;
+}
+
+/**
+ * Returns the number of fed bytes the firmware has not read yet
+ */
+int sim_uart_rx_pending(sim_uart_port port)
+{
+    uart_receive(&uarts[port]);
+    return uarts[port].line_count + uarts[port].fifo_count;
+}
+
+/**
+ * Copy out the bytes transmitted on a port since the last call
+ *
+ * Params:
+ *  port        port to read
+ *  buffer      filled with the bytes and a terminating 0
+ *  size        size of buffer, later bytes are dropped
+ *
+ * Returns the number of bytes copied
+ */
+int sim_uart_take_tx(sim_uart_port port, char *buffer, int size)
+{
+    sim_uart_t *uart = &uarts[port];
+    int length = uart->tx_length < size - 1 ? uart->tx_length : size - 1;
+
+    memcpy(buffer, uart->tx, length);
+    buffer[length] = '\0';
+    uart->tx_length = 0;
+    return length;
+}
+
+/**
+ * Pass the bytes transmitted on a port to a model of the device on the other end, NULL for none
+ */
+void sim_uart_set_tx_handler(sim_uart_port port, sim_uart_tx_fn handler)
+{
+    uarts[port].handler = handler;
+}
+
+/**
+ * Returns the number of bytes lost because the receiver of a port was full
+ */
+unsigned long sim_uart_overruns(sim_uart_port port)
+{
+    return uarts[port].overruns;
+}
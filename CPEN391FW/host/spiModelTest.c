@@ -0,0 +1,228 @@
+/**
+ * This module tests spiService.c and the MPU9250 driver on the host against the model of the Avalon SPI
+ * master and of the MPU9250 behind it in host/sim/simSpi.c: register bursts, the AK8963 accesses through
+ * the I2C master, the FIFO reader and its overflow recovery, the background initialization and the
+ * fallback to one byte in flight after an overrun.
+ *
+ * Build and run from CPEN391FW, or with the host build in CMakeLists.txt:
+ *  gcc -std=gnu99 -O2 -Iinclude -Ihost/sim host/spiModelTest.c host/sim/*.c -o spiModelTest && ./spiModelTest
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <typeDef.h>
+#include "constants.h"
+#include "sim.h"
+
+/*------------------- Firmware under test ------------------------------------*/
+
+uint64 hps_time_us(void)
+{
+    return 0;
+}
+
+// The model runs the I2C master right away, no need to wait for it
+void hps_ms_delay(unsigned int time_ms)
+{
+}
+
+void hps_us_delay(unsigned int time_us)
+{
+}
+
+#include "../source/initService.c"
+#include "../source/spiService.c"
+#include "../source/mpu9250.c"
+
+/*------------------- Tests --------------------------------------------------*/
+
+static int failures = 0;
+
+static void check(int condition, const char *what)
+{
+    if (!condition)
+    {
+        printf("Failed %s\n", what);
+        failures++;
+    }
+    else
+    {
+        printf("Passed %s\n", what);
+    }
+}
+
+static void reset_model(int byte_ticks)
+{
+    sim_spi_reset(byte_ticks);
+    credits_max = SPI_MAX_CREDITS;
+}
+
+static void test_begin(void)
+{
+    bool ok;
+
+    reset_model(SIM_SPI_BYTE_TICKS);
+    ok = MPU9250_Begin();
+    check(ok, "MPU9250_Begin against the model");
+    check(sim_mpu.ak[AK8963_CNTL1_] == AK8963_CNT_MEAS2_, "AK8963 in 100 Hz continuous mode");
+    check(sim_mpu.regs[ACCEL_CONFIG_] == ACCEL_RANGE_16G && sim_mpu.regs[CONFIG_] == DLPF_BANDWIDTH_20HZ,
+          "default ranges and filter");
+
+    ok = MPU9250_ConfigSrd(9) && MPU9250_EnableFifo();
+    check(ok && fifo_enabled, "MPU9250_EnableFifo");
+    check(sim_mpu.regs[SMPLRT_DIV_] == 9 && sim_mpu.regs[FIFO_EN_] == (FIFO_ACCEL_ | FIFO_GYRO_ | FIFO_SLV0_),
+          "FIFO and sample rate configuration");
+    check(sim_spi.overruns == 0 && sim_spi.errors == 0 && spi_credits() == SPI_MAX_CREDITS, "no SPI errors during setup");
+}
+
+static void test_init_step(void)
+{
+    init_job_t job;
+    init_status status;
+    int steps = 0;
+
+    reset_model(SIM_SPI_BYTE_TICKS);
+    mpu_ready = false;
+    memset(&job, 0, sizeof(job));
+
+    // Waits are not needed by the model, run the steps back to back
+    do
+    {
+        status = MPU9250_InitStep(&job);
+        steps++;
+    } while (status == INIT_PENDING && steps < 100);
+
+    printf("MPU9250_InitStep: %d steps\n", steps);
+    check(status == INIT_DONE && mpu_ready && fifo_enabled, "MPU9250_InitStep against the model");
+    check(sim_mpu.ak[AK8963_CNTL1_] == AK8963_CNT_MEAS2_ && sim_mpu.regs[SMPLRT_DIV_] == 9 &&
+          sim_mpu.regs[FIFO_EN_] == (FIFO_ACCEL_ | FIFO_GYRO_ | FIFO_SLV0_) && sim_mpu.regs[CONFIG_] == DLPF_BANDWIDTH_20HZ,
+          "same configuration as MPU9250_Begin and MPU9250_EnableFifo");
+
+    sim_mpu.absent = true;
+    memset(&job, 0, sizeof(job));
+    while ((status = MPU9250_InitStep(&job)) == INIT_PENDING)
+    {
+    }
+    check(status == INIT_FAILED, "MPU9250_InitStep fails without a sensor");
+}
+
+static void test_fifo(void)
+{
+    int16 accel[3] = {100, -200, 2048};
+    int16 gyro[3];
+    int16 mag[3];
+    unsigned long transfers, bytes;
+    int i;
+
+    check(!MPU9250_Sample(), "empty FIFO gives no sample");
+
+    for (i = 0; i < 5; i++)
+    {
+        gyro[0] = (int16)(10 * i);
+        gyro[1] = (int16)(-10 * i);
+        gyro[2] = 3;
+        mag[0] = (int16)(i - 2);
+        mag[1] = (int16)(50 + i);
+        mag[2] = (int16)(-100 - i);
+        sim_mpu_sample(accel, gyro, mag);
+    }
+
+    check(MPU9250_Sample() && MPU9250_SampleCount() == 5, "5 FIFO frames read in one run");
+    check(accel_counts[0] == 100 && accel_counts[1] == -200 && accel_counts[2] == 2048, "accel unpacked");
+    check(gyro_counts[0] == 40 && gyro_counts[1] == -40 && mag_counts[0] == 2 && mag_counts[1] == 54 &&
+          mag_counts[2] == -104, "gyro and mag of the last frame unpacked");
+    check(gyro_median[0] == 20 && gyro_median[1] == -20 && mag_median[2] == -102, "medians of the frames");
+    check(getSensorKey() == 0x0A0A0A0A, "sensor key of a stationary card facing north");
+    check(sim_mpu.fifo_count == 0, "FIFO drained");
+
+    // One frame per sampler run at 100 Hz
+    sim_mpu_sample(accel, gyro, mag);
+    transfers = sim_spi.transfers;
+    bytes = sim_spi.bytes;
+    MPU9250_Sample();
+    transfers = sim_spi.transfers - transfers;
+    bytes = sim_spi.bytes - bytes;
+    printf("One frame: %lu transfers, %lu bytes\n", transfers, bytes);
+    check(transfers == 3 && bytes == 2 + 3 + 1 + FIFO_FRAME, "one frame in 3 transfers");
+}
+
+static void test_overflow(void)
+{
+    int16 accel[3] = {0, 0, 0};
+    int16 gyro[3] = {0, 0, 0};
+    int16 mag[3] = {0, 0, 0};
+    int count;
+    int i;
+
+    // 30 frames do not fit in 512 bytes
+    for (i = 0; i < 30; i++)
+    {
+        sim_mpu_sample(accel, gyro, mag);
+    }
+    count = MPU9250_SampleCount();
+    check(!MPU9250_Sample() && sim_mpu.fifo_count == 0, "overflowed FIFO is reset");
+
+    gyro[0] = 7;
+    sim_mpu_sample(accel, gyro, mag);
+    sim_mpu_sample(accel, gyro, mag);
+    check(MPU9250_Sample() && gyro_counts[0] == 7, "frames after the reset are read");
+    check(MPU9250_SampleCount() == (count + 2 > MPU9250_SAMPLES ? MPU9250_SAMPLES : count + 2),
+          "only whole frames added");
+}
+
+static void test_burst_timing(void)
+{
+    uint8 data[FIFO_FRAMES_MAX * FIFO_FRAME];
+    unsigned long two, one;
+    uint32 length = sizeof(data);
+
+    // The clock should not idle between the bytes of a burst
+    sim_spi.cs_ticks = 0;
+    Mpu9250_ReadRegisters(FIFO_R_W_, length, data);
+    two = sim_spi.cs_ticks;
+
+    credits_max = 1;
+    sim_spi.cs_ticks = 0;
+    Mpu9250_ReadRegisters(FIFO_R_W_, length, data);
+    one = sim_spi.cs_ticks;
+    credits_max = SPI_MAX_CREDITS;
+
+    printf("%lu byte burst: %lu ticks with 2 bytes in flight, %lu with 1, %d per byte\n",
+           (unsigned long)length + 1, two, one, sim_spi.byte_ticks);
+    check(two < (length + 1) * sim_spi.byte_ticks + 2 * sim_spi.byte_ticks, "burst keeps the clock busy");
+    check(two < one, "two bytes in flight are faster than one");
+}
+
+static void test_overrun(void)
+{
+    uint8 who_am_i = 0;
+
+    // Bytes shorter than the polling loop, the receive register overruns with 2 bytes in flight
+    reset_model(1);
+    check(!Mpu9250_ReadRegisters(WHOAMI_, 4, &fifo_buff[0]) && sim_spi.overruns > 0, "overrun reported");
+    check(spi_credits() == 1, "falls back to one byte in flight");
+
+    sim_spi.overruns = 0;
+    sim_spi.byte_ticks = SIM_SPI_BYTE_TICKS;
+    check(Mpu9250_ReadRegisters(WHOAMI_, 1, &who_am_i) && who_am_i == WHOAMI_MPU9250_ && sim_spi.overruns == 0,
+          "reads work after the fallback");
+}
+
+int main(void)
+{
+    test_init_step();
+    test_begin();
+    test_fifo();
+    test_overflow();
+    test_burst_timing();
+    test_overrun();
+
+    if (sim_spi.errors != 0)
+    {
+        printf("Failed %d SPI protocol errors\n", sim_spi.errors);
+        failures++;
+    }
+
+    printf("%s\n", failures == 0 ? "All tests passed" : "Some tests failed");
+    return failures != 0;
+}
@@ -0,0 +1,666 @@
+/**
+ * This module benchmarks file upload and download end to end on the host build. The real controller of
+ * cloudlockrMain.c, run by the scheduler, handles the requests of a model of the app on the Bluetooth
+ * UART and stores and fetches the packets through a model of the ESP8266 and the server on the WiFi
+ * UART. Both models answer after a latency and the UARTs run at their baud rate, all on the virtual
+ * clock of host/sim, so the numbers are the same on every run and only change with the firmware.
+ *
+ * For each file size it reports the throughput in KB/s, from the first byte of the request to the end
+ * of the last reply, and the latency of the data messages: from the last byte of an upload packet, or
+ * of the app's status message during a download, to the end of the reply of the firmware. The file
+ * downloaded is checked against the file uploaded. The counters of the firmware (message type 8) are
+ * printed at the end.
+ *
+ * Build and run from CPEN391FW, or with the CMake build:
+ *  gcc -std=gnu99 -O2 -Iinclude -Ihost/sim host/throughputBench.c host/sim/*.c $(ls source/*.c | grep -v
+ *      'cloudlockrMain\|tests') -lpthread -o throughputBench && ./throughputBench [-v] [-n] [-s [messages] | bytes ...]
+ * The file sizes default to 1 KB to 1 MB. The firmware's own output is dropped unless -v is given.
+ * With -n the app never sends {"ready":1}, as the apps released before it, so every reply of the
+ * firmware waits READY_TIMEOUT_MS first.
+ *
+ * With -s [messages] it runs a soak test instead, 10000 messages by default: requests of every type in
+ * turn, checking that the request path gives back all the memory it takes, see soak().
+ */
+
+#include <stdio.h>
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <typeDef.h>
+#include "sim.h"
+
+/*------------------- Firmware under test ------------------------------------*/
+
+#define main cloudlockr_main
+#include "../source/cloudlockrMain.c"
+#undef main
+
+/*------------------- Models -------------------------------------------------*/
+
+// Latencies of the models, in us
+#define APP_LATENCY_US 15000    // Bluetooth link and app, from the end of a message to the start of the answer
+#define ESP_COMMAND_US 1000     // ESP8266 reply to an AT command
+#define ESP_CONNECT_US 40000    // TCP connection to the server
+#define SERVER_US 60000         // HTTP request to the start of the response
+
+#define US_TICKS(us) ((uint64)(us) * SIM_TICKS_PER_US)
+
+#define LOCATION "49.262|-123.250|70.000"
+#define ESP_REQUEST_SIZE 8192
+#define ESP_REPLY_SIZE 4096
+#define SOAK_FILE_SIZE (MAX_FILEDATA_SIZE + 100)
+#define SOAK_MESSAGES 10000
+
+typedef enum
+{
+    APP_REQUEST,
+    APP_UPLOAD,
+    APP_DOWNLOAD
+} app_mode;
+
+// The app: sends the messages of a request and answers the replies of the firmware
+static struct
+{
+    app_mode mode;
+    char line[BUFFER_SIZE];
+    int line_length;
+    char reply[BUFFER_SIZE];
+    int done;
+    int failed;
+    int no_ready;
+
+    // File being uploaded or downloaded
+    const char *file;
+    int size;
+    int packets;
+    int next_packet;
+    char file_id[40];
+    char component[9];
+    int received;
+
+    // Requests and data messages sent, the ready messages not counted
+    unsigned long messages;
+
+    // Time the last byte of the last message reaches the DE1, and the latencies of the replies
+    uint64 sent_ticks;
+    unsigned long replies;
+    uint64 latency_total;
+    uint64 latency_max;
+} app;
+
+// The ESP8266 in station mode with the server behind it
+static struct
+{
+    char line[256];
+    int line_length;
+    char request[ESP_REQUEST_SIZE];
+    int request_length;
+    int data_left; // bytes of an AT+CIPSEND still to come
+
+    // Blobs of the file on the server, as hex
+    char file_id[40];
+    char **blobs;
+    int num_blobs;
+} esp;
+
+static void esp_reply(uint64 delay_us, const char *reply)
+{
+    sim_uart_feed_after(SIM_UART_WIFI, US_TICKS(delay_us), reply, strlen(reply));
+}
+
+/*
+ * Returns the string value of a key of a JSON object in buffer, NULL if it is not there
+ */
+static char *json_string(const char *json, const char *key, char *buffer, int size)
+{
+    char pattern[64];
+    const char *start;
+    int length = 0;
+
+    snprintf(pattern, sizeof(pattern), "\"%s\":\"", key);
+    start = strstr(json, pattern);
+    if (start == NULL)
+    {
+        return NULL;
+    }
+
+    start += strlen(pattern);
+    while (start[length] != '"' && start[length] != '\0' && length < size - 1)
+    {
+        buffer[length] = start[length];
+        length++;
+    }
+    buffer[length] = '\0';
+
+    return buffer;
+}
+
+/*
+ * Returns the integer value of a key of a JSON object, -1 if it is not there
+ */
+static int json_int(const char *json, const char *key)
+{
+    char pattern[64];
+    const char *start;
+
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    start = strstr(json, pattern);
+
+    return start != NULL ? atoi(start + strlen(pattern)) : -1;
+}
+
+/*
+ * The server, answers a complete HTTP request sent through the ESP8266
+ */
+static void server_request(void)
+{
+    static char body[ESP_REPLY_SIZE];
+    static char reply[ESP_REPLY_SIZE + 256];
+    char header[64];
+    char file_id[40] = "";
+    int blob = -1;
+    char *data;
+    int response_length;
+
+    esp.request[esp.request_length] = '\0';
+    sscanf(esp.request, "%*s /file/%39[^/ ]/%d", file_id, &blob);
+    data = strstr(esp.request, "\r\n\r\n");
+
+    if (strcmp(file_id, esp.file_id) != 0)
+    {
+        // A new file, the benchmark keeps one at a time
+        for (int i = 0; i < esp.num_blobs; i++)
+        {
+            free(esp.blobs[i]);
+        }
+        free(esp.blobs);
+        esp.blobs = NULL;
+        esp.num_blobs = 0;
+        strcpy(esp.file_id, file_id);
+    }
+
+    if (strncmp(esp.request, "POST", 4) == 0 && blob >= 0 && data != NULL)
+    {
+        if (blob >= esp.num_blobs)
+        {
+            esp.blobs = realloc(esp.blobs, sizeof(char *) * (blob + 1));
+            memset(esp.blobs + esp.num_blobs, 0, sizeof(char *) * (blob + 1 - esp.num_blobs));
+            esp.num_blobs = blob + 1;
+        }
+        free(esp.blobs[blob]);
+        esp.blobs[blob] = strdup(json_string(data, "fileData", body, sizeof(body)) != NULL ? body : "");
+        snprintf(body, sizeof(body), "{\"status\":1}");
+    }
+    else if (blob >= 0)
+    {
+        snprintf(body, sizeof(body), "{\"fileData\":\"%s\"}",
+                 blob < esp.num_blobs && esp.blobs[blob] != NULL ? esp.blobs[blob] : "");
+    }
+    else
+    {
+        snprintf(body, sizeof(body), "{\"numBlobs\":%d}", esp.num_blobs);
+    }
+
+    response_length = snprintf(reply, sizeof(reply), "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                               "Content-Length: %d\r\n\r\n%s", (int)strlen(body), body);
+
+    snprintf(header, sizeof(header), "\r\nRecv %d bytes\r\n\r\nSEND OK\r\n", esp.request_length);
+    esp_reply(ESP_COMMAND_US, header);
+    snprintf(header, sizeof(header), "\r\n+IPD,%d:", response_length);
+    esp_reply(SERVER_US, header);
+    esp_reply(0, reply);
+}
+
+/*
+ * The ESP8266, answers the AT commands without echo
+ */
+static void esp_command(const char *line)
+{
+    if (line[0] == '\0')
+    {
+        // Line ending after the data of an AT+CIPSEND
+    }
+    else if (strcmp(line, "AT") == 0 || strncmp(line, "AT+CWMODE=", 10) == 0)
+    {
+        esp_reply(ESP_COMMAND_US, "\r\nOK\r\n");
+    }
+    else if (strncmp(line, "AT+CWJAP=", 9) == 0)
+    {
+        esp_reply(ESP_COMMAND_US, "WIFI CONNECTED\r\nWIFI GOT IP\r\n\r\nOK\r\n");
+    }
+    else if (strncmp(line, "AT+CIPSTART=", 12) == 0)
+    {
+        esp_reply(ESP_CONNECT_US, "CONNECT\r\n\r\nOK\r\n");
+    }
+    else if (strncmp(line, "AT+CIPSEND=", 11) == 0)
+    {
+        esp.data_left = atoi(line + 11);
+        esp.request_length = 0;
+        esp_reply(ESP_COMMAND_US, "\r\nOK\r\n> ");
+    }
+    else if (strcmp(line, "AT+CIPCLOSE") == 0)
+    {
+        esp_reply(ESP_COMMAND_US, "CLOSED\r\n\r\nOK\r\n");
+    }
+    else
+    {
+        esp_reply(ESP_COMMAND_US, "\r\nERROR\r\n");
+    }
+}
+
+static void esp_receive(sim_uart_port port, uint8 data)
+{
+    if (esp.data_left > 0)
+    {
+        if (esp.request_length < ESP_REQUEST_SIZE - 1)
+        {
+            esp.request[esp.request_length++] = (char)data;
+        }
+        if (--esp.data_left == 0)
+        {
+            server_request();
+        }
+        return;
+    }
+
+    if (data == '\n')
+    {
+        if (esp.line_length > 0 && esp.line[esp.line_length - 1] == '\r')
+        {
+            esp.line_length--;
+        }
+        esp.line[esp.line_length] = '\0';
+        esp.line_length = 0;
+        esp_command(esp.line);
+    }
+    else if (esp.line_length < (int)sizeof(esp.line) - 1)
+    {
+        esp.line[esp.line_length++] = (char)data;
+    }
+}
+
+/*
+ * Send a message to the DE1, after the app's latency
+ */
+static void app_send(const char *message)
+{
+    static char line[BUFFER_SIZE];
+    int length = snprintf(line, sizeof(line), "%s\r\n", message);
+
+    app.sent_ticks = sim_uart_feed_after(SIM_UART_BLUETOOTH, US_TICKS(APP_LATENCY_US), line, length);
+}
+
+static void app_send_packet(void)
+{
+    static char message[BUFFER_SIZE];
+    int offset = (app.next_packet - 1) * MAX_FILEDATA_SIZE;
+    int length = app.size - offset < MAX_FILEDATA_SIZE ? app.size - offset : MAX_FILEDATA_SIZE;
+
+    snprintf(message, sizeof(message), "{\"type\":3,\"fileId\":\"%s\",\"packetNumber\":%d,\"totalPackets\":%d,"
+             "\"location\":\"" LOCATION "\",\"fileData\":\"%.*s\"}",
+             app.file_id, app.next_packet, app.packets, length, app.file + offset);
+    app.next_packet++;
+    app.messages++;
+    app_send(message);
+}
+
+static void app_finish(const char *line, int failed)
+{
+    strcpy(app.reply, line);
+    app.failed |= failed;
+    app.done = 1;
+}
+
+/*
+ * Handles a line sent by the DE1
+ */
+static void app_line(const char *line)
+{
+    static char data[MAX_FILEDATA_SIZE + 1];
+    int packet;
+
+    // Every message is acked, the app then says it is listening for the reply
+    if (strcmp(line, "{\"status\":2}") == 0)
+    {
+        if (!app.no_ready)
+        {
+            app_send("{\"ready\":1}");
+        }
+        return;
+    }
+
+    if (app.mode != APP_REQUEST)
+    {
+        uint64 latency = sim_ticks - app.sent_ticks;
+
+        app.replies++;
+        app.latency_total += latency;
+        app.latency_max = latency > app.latency_max ? latency : app.latency_max;
+    }
+
+    switch (app.mode)
+    {
+    case APP_UPLOAD:
+        if (json_string(line, "localEncryptionComponent", app.component, sizeof(app.component)) != NULL)
+        {
+            app_finish(line, app.next_packet <= app.packets);
+        }
+        else if (strcmp(line, "{\"status\":1}") == 0 && app.next_packet <= app.packets)
+        {
+            app_send_packet();
+        }
+        else
+        {
+            app_finish(line, 1);
+        }
+        break;
+    case APP_DOWNLOAD:
+        packet = json_int(line, "packetNumber");
+        if (packet < 1 || json_string(line, "fileData", data, sizeof(data)) == NULL)
+        {
+            app_finish(line, 1);
+            break;
+        }
+
+        // The packets must arrive in order and match the file
+        if ((packet - 1) * MAX_FILEDATA_SIZE != app.received || app.received + (int)strlen(data) > app.size ||
+            memcmp(app.file + app.received, data, strlen(data)) != 0)
+        {
+            app.failed = 1;
+        }
+        app.received += strlen(data);
+
+        if (packet < json_int(line, "totalPackets"))
+        {
+            app.messages++;
+            app_send("{\"status\":1}");
+        }
+        else
+        {
+            app_finish(line, app.received != app.size);
+        }
+        break;
+    default:
+        app_finish(line, 0);
+        break;
+    }
+}
+
+static void app_receive(sim_uart_port port, uint8 data)
+{
+    if (data != '\n')
+    {
+        if (app.line_length < BUFFER_SIZE - 1)
+        {
+            app.line[app.line_length++] = (char)data;
+        }
+        return;
+    }
+
+    // Messages from the DE1 end with "\v\n"
+    while (app.line_length > 0 && (app.line[app.line_length - 1] == '\v' || app.line[app.line_length - 1] == '\r'))
+    {
+        app.line_length--;
+    }
+    app.line[app.line_length] = '\0';
+    app.line_length = 0;
+    app_line(app.line);
+}
+
+/*------------------- Benchmark ----------------------------------------------*/
+
+static FILE *report;
+
+/*
+ * Send the first message of a request and run the firmware until the app has the last reply
+ *
+ * Returns the time the request took in ticks
+ */
+static uint64 app_request(app_mode mode, const char *message)
+{
+    uint64 start = sim_ticks;
+
+    app.mode = mode;
+    app.done = 0;
+    app.failed = 0;
+    app.replies = 0;
+    app.latency_total = 0;
+    app.latency_max = 0;
+
+    app.messages++;
+    app.sent_ticks = sim_uart_feed(SIM_UART_BLUETOOTH, message, strlen(message));
+    sim_uart_feed(SIM_UART_BLUETOOTH, "\r\n", 2);
+    while (!app.done)
+    {
+        sched_run_once();
+    }
+
+    return sim_ticks - start;
+}
+
+static void app_setup(const char *message)
+{
+    app_request(APP_REQUEST, message);
+    if (strcmp(app.reply, "{\"status\":1}") != 0)
+    {
+        fprintf(report, "Failed %s, reply %s\n", message, app.reply);
+        exit(1);
+    }
+}
+
+static double kb_per_s(int size, uint64 ticks)
+{
+    return size / 1024.0 / ((double)ticks / US_TICKS(1000000));
+}
+
+static double latency_ms(uint64 ticks)
+{
+    return (double)ticks / US_TICKS(1000);
+}
+
+/*
+ * Set up the file the app uploads and downloads next
+ */
+static void app_file(const char *file, int size)
+{
+    app.file = file;
+    app.size = size;
+    app.packets = (size + MAX_FILEDATA_SIZE - 1) / MAX_FILEDATA_SIZE;
+    snprintf(app.file_id, sizeof(app.file_id), "5eb1c0de-0000-4000-8000-%012d", size);
+}
+
+/*
+ * Upload the file of app_file(), returns the time it took in ticks
+ */
+static uint64 app_upload(void)
+{
+    static char message[BUFFER_SIZE];
+
+    app.next_packet = 2;
+    snprintf(message, sizeof(message), "{\"type\":3,\"fileId\":\"%s\",\"packetNumber\":1,\"totalPackets\":%d,"
+             "\"location\":\"" LOCATION "\",\"fileData\":\"%.*s\"}",
+             app.file_id, app.packets, app.size < MAX_FILEDATA_SIZE ? app.size : MAX_FILEDATA_SIZE, app.file);
+    return app_request(APP_UPLOAD, message);
+}
+
+/*
+ * Download the file of app_file() after app_upload(), returns the time it took in ticks
+ */
+static uint64 app_download(void)
+{
+    static char message[BUFFER_SIZE];
+
+    app.received = 0;
+    snprintf(message, sizeof(message), "{\"type\":4,\"localEncryptionComponent\":\"%s\",\"fileId\":\"%s\","
+             "\"location\":\"" LOCATION "\"}", app.component, app.file_id);
+    return app_request(APP_DOWNLOAD, message);
+}
+
+/*
+ * Fill a file with printable characters that need no escaping in JSON
+ */
+static void fill_file(char *file, int size)
+{
+    for (int i = 0; i < size; i++)
+    {
+        file[i] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789 -"[(i * 2654435761u >> 7) % 64];
+    }
+    file[size] = '\0';
+}
+
+/*
+ * Upload and download a file of size bytes, returns 0 if the downloaded file differs
+ */
+static int benchmark_file(int size)
+{
+    char *file = malloc(size + 1);
+    uint64 ticks;
+    int ok;
+
+    fill_file(file, size);
+    app_file(file, size);
+
+    fprintf(report, "%8d  %7d", size, app.packets);
+
+    ticks = app_upload();
+    ok = !app.failed;
+    fprintf(report, "  %11.2f  %8.1f  %8.1f", kb_per_s(size, ticks),
+            latency_ms(app.latency_total / (app.replies ? app.replies : 1)), latency_ms(app.latency_max));
+
+    ticks = app_download();
+    ok &= !app.failed;
+    fprintf(report, "  %13.2f  %8.1f  %8.1f  %s\n", kb_per_s(size, ticks),
+            latency_ms(app.latency_total / (app.replies ? app.replies : 1)), latency_ms(app.latency_max),
+            ok ? "ok" : "FAILED");
+    fflush(report);
+
+    free(file);
+    return ok;
+}
+
+/*
+ * Send requests of every type in turn until messages have been sent: a HEX code, its check, an upload
+ * and a download of a 2 packet file and the counters. After each round the request arena and the pool
+ * must be empty and the heap must be as large as after the first round.
+ *
+ * Returns 0 if a request failed or memory was not given back
+ */
+static int soak(unsigned long messages)
+{
+    static char file[SOAK_FILE_SIZE + 1];
+    const mem_stats_t *mem = mem_stats();
+    char message[128];
+    size_t heap = 0;
+    size_t heap_end = 0;
+    unsigned long rounds = 0;
+    int ok = 1;
+
+    fill_file(file, SOAK_FILE_SIZE);
+    app_file(file, SOAK_FILE_SIZE);
+    app.messages = 0;
+
+    while (ok && app.messages < messages)
+    {
+        app_setup("{\"type\":1}");
+        snprintf(message, sizeof(message), "{\"type\":2,\"password\":\"benchmark\",\"hex\":\"%x\"}",
+                 (unsigned)sim_peek(SIM_ADDR(HEX_ADDR)));
+        app_setup(message);
+
+        app_upload();
+        ok &= !app.failed;
+        app_download();
+        ok &= !app.failed;
+        app_request(APP_REQUEST, "{\"type\":8}");
+
+        ok &= mem->arena_in_use == 0 && mem->pool_in_use == 0;
+
+        heap_end = mallinfo2().uordblks;
+        if (rounds++ == 0)
+        {
+            heap = heap_end;
+        }
+        ok &= heap_end == heap;
+    }
+
+    fprintf(report, "Soak: %lu messages in %lu rounds, heap %zu bytes after the first round and %zu after the last,"
+            " arena peak %lu bytes, pool peak %lu blocks, %s\n", app.messages, rounds, heap, heap_end,
+            mem->arena_peak, mem->pool_peak, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    static const int default_sizes[] = {1024, 4096, 16384, 65536, 262144, 1048576};
+    int verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+    int first_size = 1 + verbose;
+    int soak_mode;
+    int failures = 0;
+    char message[128];
+
+    app.no_ready = argc > first_size && strcmp(argv[first_size], "-n") == 0;
+    first_size += app.no_ready;
+    soak_mode = argc > first_size && strcmp(argv[first_size], "-s") == 0;
+
+    report = stdout;
+    if (!verbose)
+    {
+        // Keep stdout for the report, drop the firmware's printf()s
+        fflush(stdout);
+        report = fdopen(dup(fileno(stdout)), "w");
+        freopen("/dev/null", "w", stdout);
+    }
+
+    sim_reset();
+    sim_uart_set_tx_handler(SIM_UART_WIFI, esp_receive);
+    sim_uart_set_tx_handler(SIM_UART_BLUETOOTH, app_receive);
+
+    // Boot, then set up the DE1 as the app does
+    init();
+    while (!init_done())
+    {
+        sched_run_once();
+    }
+    app_setup("{\"type\":7,\"password\":\"benchmark\"}");
+    app_setup("{\"type\":6,\"networkName\":\"network\",\"networkPassword\":\"password\"}");
+    app_setup("{\"type\":1}");
+    snprintf(message, sizeof(message), "{\"type\":2,\"password\":\"benchmark\",\"hex\":\"%x\"}",
+             (unsigned)sim_peek(SIM_ADDR(HEX_ADDR)));
+    app_setup(message);
+
+    if (soak_mode)
+    {
+        return soak(argc > first_size + 1 ? strtoul(argv[first_size + 1], NULL, 10) : SOAK_MESSAGES) ? 0 : 1;
+    }
+
+    fprintf(report, "Virtual time, UARTs at 115200 baud, app %d ms%s, ESP8266 command %d ms, connect %d ms, server %d ms\n",
+            APP_LATENCY_US / 1000, app.no_ready ? " without ready" : "", ESP_COMMAND_US / 1000, ESP_CONNECT_US / 1000, SERVER_US / 1000);
+    fprintf(report, "                     upload      latency ms          download      latency ms\n");
+    fprintf(report, "   bytes  packets         KB/s      mean       max           KB/s      mean       max\n");
+
+    if (argc > first_size)
+    {
+        for (int i = first_size; i < argc; i++)
+        {
+            failures += !benchmark_file(atoi(argv[i]));
+        }
+    }
+    else
+    {
+        for (int i = 0; i < (int)(sizeof(default_sizes) / sizeof(default_sizes[0])); i++)
+        {
+            failures += !benchmark_file(default_sizes[i]);
+        }
+    }
+
+    app_request(APP_REQUEST, "{\"type\":8}");
+    fprintf(report, "Counters %s\n", app.reply);
+
+    if (failures)
+    {
+        fprintf(report, "%d files failed\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
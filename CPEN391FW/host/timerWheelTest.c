@@ -0,0 +1,261 @@
+/**
+ * This module tests the timer wheel of timerService.c on the host, with the clock of hpsService.c
+ * replaced by a counter the tests advance: timers of every level and beyond the wheel, cancelling,
+ * restarting from a callback, catching up after the task was held up, and random timers with random
+ * cancels.
+ *
+ * Build and run from CPEN391FW:
+ *  gcc -std=gnu99 -O2 -Iinclude host/timerWheelTest.c -o timerWheelTest && ./timerWheelTest
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <typeDef.h>
+
+/*------------------- Firmware under test ------------------------------------*/
+
+static uint64 now_ms = 0;
+
+uint64 hps_time_ms(void)
+{
+    return now_ms;
+}
+
+#include "../source/timerService.c"
+
+/*------------------- Tests --------------------------------------------------*/
+
+#define NUM_RANDOM 2000
+
+static int failures = 0;
+
+static void check(int condition, const char *what)
+{
+    if (!condition)
+    {
+        printf("Failed %s\n", what);
+        failures++;
+    }
+    else
+    {
+        printf("Passed %s\n", what);
+    }
+}
+
+// A timer and what happened to it
+typedef struct
+{
+    soft_timer_t timer;
+    uint64 started_ms;
+    uint64 expires_ms;
+    uint64 fired_ms;
+    int fired;
+    int period_ms;
+} test_timer_t;
+
+// Time of the previous timer_task() call, a timer must fire in the first call at or after its expiry
+static uint64 last_run_ms = 0;
+static int late = 0;
+
+static void on_expire(void *arg)
+{
+    test_timer_t *t = arg;
+
+    t->fired++;
+    t->fired_ms = now_ms;
+    // A timer started after the task ran at that time waits for the next run
+    if (now_ms < t->expires_ms || (last_run_ms >= t->expires_ms && last_run_ms > t->started_ms))
+    {
+        printf("timer due at %llu ran at %llu\n", t->expires_ms, now_ms);
+        late++;
+    }
+
+    if (t->period_ms > 0)
+    {
+        t->started_ms = now_ms;
+        t->expires_ms = now_ms + t->period_ms;
+        timer_start(&t->timer, t->period_ms);
+    }
+}
+
+static void run_until(uint64 time_ms, uint64 step_ms)
+{
+    while (now_ms < time_ms)
+    {
+        now_ms += step_ms;
+        if (now_ms > time_ms)
+        {
+            now_ms = time_ms;
+        }
+        timer_task();
+        last_run_ms = now_ms;
+    }
+}
+
+static void start(test_timer_t *t, uint32 timeout_ms)
+{
+    timer_init(&t->timer, on_expire, t);
+    t->started_ms = now_ms;
+    t->expires_ms = now_ms + timeout_ms;
+    t->fired = 0;
+    t->period_ms = 0;
+    timer_start(&t->timer, timeout_ms);
+}
+
+static void test_levels(void)
+{
+    static const uint32 timeouts[] = {0, 1, 2, 63, 64, 65, 127, 4095, 4096, 4097, 5000, 262143,
+                                      262144, 300000, 16777215, 16777216, 20000000};
+    test_timer_t timers[sizeof(timeouts) / sizeof(timeouts[0])];
+    int n = sizeof(timeouts) / sizeof(timeouts[0]);
+    int once = 1;
+
+    late = 0;
+    for (int i = 0; i < n; i++)
+    {
+        start(&timers[i], timeouts[i]);
+    }
+
+    run_until(now_ms + 20000001, 1);
+
+    for (int i = 0; i < n; i++)
+    {
+        if (timers[i].fired != 1)
+        {
+            once = 0;
+        }
+    }
+
+    check(once && late == 0, "timers on every level fire once, on time");
+    check(timer_count == 0, "no timers left in the wheel");
+}
+
+static void test_cancel(void)
+{
+    test_timer_t a, b, c;
+
+    start(&a, 10);
+    start(&b, 5000);
+    start(&c, 10);
+    timer_cancel(&a.timer);
+    run_until(now_ms + 3000, 1);
+    timer_cancel(&b.timer);
+    run_until(now_ms + 3000, 1);
+
+    check(a.fired == 0 && b.fired == 0 && c.fired == 1, "cancelled timers do not fire");
+    check(!timer_pending(&a.timer) && !timer_pending(&b.timer) && !timer_pending(&c.timer), "timers not pending after running");
+
+    // Restarting a pending timer moves it
+    start(&a, 100);
+    a.expires_ms = now_ms + 7000;
+    timer_start(&a.timer, 7000);
+    run_until(now_ms + 8000, 1);
+    check(a.fired == 1 && a.fired_ms == a.expires_ms, "restarted timer fires at its new time");
+}
+
+static void test_periodic(void)
+{
+    test_timer_t a, zero;
+    uint64 begin = now_ms;
+
+    late = 0;
+    start(&a, 100);
+    a.period_ms = 100;
+
+    // A zero timeout from the callback runs on the next tick, not in a loop
+    start(&zero, 0);
+    zero.period_ms = 0;
+    run_until(now_ms + 10000, 1);
+    timer_cancel(&a.timer);
+
+    check(a.fired == 100 && late == 0, "timer restarted from its callback fires every period");
+    check(zero.fired == 1 && zero.fired_ms == begin + 1, "zero timeout runs on the next tick");
+}
+
+static void test_catch_up(void)
+{
+    test_timer_t timers[5];
+    static const uint32 timeouts[] = {5, 70, 4100, 9000, 12000};
+
+    for (int i = 0; i < 5; i++)
+    {
+        start(&timers[i], timeouts[i]);
+    }
+
+    // The task is held up for 10 s, e.g. by a blocking request
+    now_ms += 10000;
+    timer_task();
+    last_run_ms = now_ms;
+
+    check(timers[0].fired && timers[1].fired && timers[2].fired && timers[3].fired && !timers[4].fired,
+          "timers due while the task was held up run on its next call");
+
+    run_until(now_ms + 3000, 1);
+    check(timers[4].fired == 1 && timers[4].fired_ms == timers[4].expires_ms, "later timers keep their time");
+}
+
+static void test_random(void)
+{
+    static test_timer_t timers[NUM_RANDOM];
+    int cancelled[NUM_RANDOM];
+    int wrong = 0;
+    uint64 end = 0;
+
+    srand(391);
+    late = 0;
+
+    for (int i = 0; i < NUM_RANDOM; i++)
+    {
+        uint32 timeout = (uint32)(rand() % 4 == 0 ? rand() % 100 : rand() % 2000000);
+
+        start(&timers[i], timeout);
+        cancelled[i] = rand() % 5 == 0;
+        if (timers[i].expires_ms > end)
+        {
+            end = timers[i].expires_ms;
+        }
+    }
+
+    for (int i = 0; i < NUM_RANDOM; i++)
+    {
+        if (cancelled[i])
+        {
+            timer_cancel(&timers[i].timer);
+        }
+    }
+
+    // Irregular task periods
+    while (now_ms <= end)
+    {
+        run_until(now_ms + 1 + rand() % 50, 1 + rand() % 50);
+    }
+
+    for (int i = 0; i < NUM_RANDOM; i++)
+    {
+        if (timers[i].fired != (cancelled[i] ? 0 : 1))
+        {
+            wrong++;
+        }
+    }
+
+    check(wrong == 0 && late == 0, "random timers fire once, in the first run after they expire");
+    check(timer_count == 0, "no random timers left in the wheel");
+}
+
+int main(void)
+{
+    test_levels();
+    test_cancel();
+    test_periodic();
+    test_catch_up();
+    test_random();
+
+    if (failures)
+    {
+        printf("%d tests failed\n", failures);
+        return 1;
+    }
+
+    printf("All tests passed\n");
+    return 0;
+}
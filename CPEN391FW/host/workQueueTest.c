@@ -0,0 +1,179 @@
+/**
+ * This module tests the work queue and spinlocks of workQueue.c on the host with pthreads,
+ * several producers and consumers racing on one queue the way the two cores do on the board.
+ *
+ * Build and run from CPEN391FW:
+ *  gcc -std=gnu99 -O2 -pthread -Iinclude host/workQueueTest.c source/workQueue.c -o workQueueTest && ./workQueueTest
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include "workQueue.h"
+
+#define NUM_PRODUCERS 4
+#define NUM_CONSUMERS 4
+#define ITEMS_PER_PRODUCER 200000
+#define NUM_ITEMS (NUM_PRODUCERS * ITEMS_PER_PRODUCER)
+
+static work_queue_t queue;
+static unsigned char popped[NUM_ITEMS];
+static volatile int num_popped = 0;
+
+static spinlock_t counter_lock = 0;
+static unsigned long counter = 0;
+
+static void *producer(void *arg)
+{
+    int first = (int)(intptr_t)arg * ITEMS_PER_PRODUCER;
+
+    for (int i = first; i < first + ITEMS_PER_PRODUCER; i++)
+    {
+        // Items are the numbers 1 to NUM_ITEMS, NULL means empty
+        while (!work_queue_push(&queue, (void *)(intptr_t)(i + 1)))
+        {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static void *consumer(void *arg)
+{
+    void *item;
+
+    while (__atomic_load_n(&num_popped, __ATOMIC_SEQ_CST) < NUM_ITEMS)
+    {
+        item = work_queue_pop(&queue);
+        if (item == NULL)
+        {
+            sched_yield();
+            continue;
+        }
+
+        popped[(intptr_t)item - 1]++;
+        __atomic_fetch_add(&num_popped, 1, __ATOMIC_SEQ_CST);
+    }
+
+    return NULL;
+}
+
+static void *incrementer(void *arg)
+{
+    for (int i = 0; i < ITEMS_PER_PRODUCER; i++)
+    {
+        spin_lock(&counter_lock);
+        counter++;
+        spin_unlock(&counter_lock);
+    }
+
+    return NULL;
+}
+
+static void work_queue_test1()
+{
+    pthread_t producers[NUM_PRODUCERS], consumers[NUM_CONSUMERS];
+    int correct = 1;
+
+    work_queue_init(&queue);
+
+    for (int i = 0; i < NUM_CONSUMERS; i++)
+    {
+        pthread_create(&consumers[i], NULL, consumer, NULL);
+    }
+    for (int i = 0; i < NUM_PRODUCERS; i++)
+    {
+        pthread_create(&producers[i], NULL, producer, (void *)(intptr_t)i);
+    }
+    for (int i = 0; i < NUM_PRODUCERS; i++)
+    {
+        pthread_join(producers[i], NULL);
+    }
+    for (int i = 0; i < NUM_CONSUMERS; i++)
+    {
+        pthread_join(consumers[i], NULL);
+    }
+
+    // Every item comes out exactly once and the queue is empty afterwards
+    for (int i = 0; i < NUM_ITEMS; i++)
+    {
+        if (popped[i] != 1)
+        {
+            correct = 0;
+        }
+    }
+    if (work_queue_pop(&queue) != NULL)
+    {
+        correct = 0;
+    }
+
+    if (correct)
+    {
+        printf("Passed work queue test 1\n");
+    }
+    else
+    {
+        printf("Failed work queue test 1\n");
+    }
+}
+
+static void work_queue_test2()
+{
+    int correct = 1;
+
+    // A full queue refuses items and gives them back in order
+    work_queue_init(&queue);
+    for (int i = 0; i < WORK_QUEUE_SIZE; i++)
+    {
+        correct &= work_queue_push(&queue, (void *)(intptr_t)(i + 1));
+    }
+    correct &= !work_queue_push(&queue, (void *)(intptr_t)1);
+    for (int i = 0; i < WORK_QUEUE_SIZE; i++)
+    {
+        correct &= work_queue_pop(&queue) == (void *)(intptr_t)(i + 1);
+    }
+    correct &= work_queue_pop(&queue) == NULL;
+
+    if (correct)
+    {
+        printf("Passed work queue test 2\n");
+    }
+    else
+    {
+        printf("Failed work queue test 2\n");
+    }
+}
+
+static void spinlock_test1()
+{
+    pthread_t threads[NUM_PRODUCERS];
+
+    for (int i = 0; i < NUM_PRODUCERS; i++)
+    {
+        pthread_create(&threads[i], NULL, incrementer, NULL);
+    }
+    for (int i = 0; i < NUM_PRODUCERS; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    if (counter == (unsigned long)NUM_PRODUCERS * ITEMS_PER_PRODUCER && spin_trylock(&counter_lock))
+    {
+        printf("Passed spinlock test 1\n");
+    }
+    else
+    {
+        printf("Failed spinlock test 1\n");
+    }
+    spin_unlock(&counter_lock);
+}
+
+int main()
+{
+    work_queue_test1();
+    work_queue_test2();
+    spinlock_test1();
+    return 0;
+}
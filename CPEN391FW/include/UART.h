@@ -19,6 +19,13 @@ typedef enum
     UART_ePORT_BLUETOOTH,
 } UART_ePORT;
 
+typedef struct
+{
+    unsigned long rx_bytes;
+    unsigned long tx_bytes;
+    unsigned long overruns;
+} UART_tSTATS;
+
 /*------------------- Function Prototype -------------------*/
 void UART_Init(UART_ePORT ePort);
 int UART_putchar(UART_ePORT ePort, int c);
@@ -27,4 +34,5 @@ int UART_TestForReceivedData(UART_ePORT ePort);
 void UART_Flush(UART_ePORT ePort);
 void UART_puts(UART_ePORT ePort, char *buffer);
 char *UART_gets(UART_ePORT ePort, char *buffer, int length, int mode);
+const UART_tSTATS *UART_GetStats(UART_ePORT ePort);
 #endif // UART_H_
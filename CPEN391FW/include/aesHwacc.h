@@ -5,7 +5,33 @@
 #ifndef AESHWACC_H_
 #define AESHWACC_H_
 
+#include "initService.h"
+
+// Number of expanded keys kept by the AES core, must match its KEY_SLOTS parameter
+#define AES_KEY_SLOTS 4
+
+// Work done by the AES modules, only updated from the main loop
+typedef struct
+{
+    unsigned blocks;
+    unsigned key_expansions;
+} aes_stats_t;
+
 void encrypt(unsigned char key[], unsigned char plaintext[], unsigned char ciphertext[], int keyexp);
 void decrypt(unsigned char key[], unsigned char ciphertext[], unsigned char plaintext[], int keyexp);
+void encrypt_start(unsigned char key[], unsigned char plaintext[], int keyexp);
+int encrypt_poll(unsigned char ciphertext[]);
+void decrypt_start(unsigned char key[], unsigned char ciphertext[], int keyexp);
+int decrypt_poll(unsigned char plaintext[]);
+int aes_key_slot(unsigned char key[]);
+void aes_load_key(int slot, unsigned char key[]);
+void aes_forget_key(int slot);
+void encrypt_slot(int slot, unsigned char plaintext[], unsigned char ciphertext[]);
+void decrypt_slot(int slot, unsigned char ciphertext[], unsigned char plaintext[]);
+void aes_dma_start(int slot, unsigned char src[], unsigned char dst[], int num_blocks, int decrypting);
+void aes_ctr_start(int slot, unsigned char counter_block[], unsigned char src[], unsigned char dst[], int length);
+int aes_dma_done(void);
+init_status aes_self_test_step(init_job_t *job);
+const aes_stats_t *aes_get_stats(void);
 
 #endif /* AESHWACC_H_ */
@@ -0,0 +1,78 @@
+/**
+ * AES test vectors (key, plaintext, ciphertext) generated by AES/python_version/gen_vectors.py.
+ * The bytes of each block are in the order encrypt() and decrypt() take them.
+ */
+
+#ifndef AESVECTORS_H_
+#define AESVECTORS_H_
+
+#define AES_NUM_VECTORS 64
+
+static const unsigned char aes_vectors[AES_NUM_VECTORS][3][16] = {
+    {{0x0f, 0x0e, 0x0d, 0x0c, 0x0b, 0x0a, 0x09, 0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01, 0x00}, {0xff, 0xee, 0xdd, 0xcc, 0xbb, 0xaa, 0x99, 0x88, 0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11, 0x00}, {0x5a, 0xc5, 0xb4, 0x70, 0x80, 0xb7, 0xcd, 0xd8, 0x30, 0x04, 0x7b, 0x6a, 0xd8, 0xe0, 0xc4, 0x69}},
+    {{0x3c, 0x4f, 0xcf, 0x09, 0x88, 0x15, 0xf7, 0xab, 0xa6, 0xd2, 0xae, 0x28, 0x16, 0x15, 0x7e, 0x2b}, {0x34, 0x07, 0x37, 0xe0, 0xa2, 0x98, 0x31, 0x31, 0x8d, 0x30, 0x5a, 0x88, 0xa8, 0xf6, 0x43, 0x32}, {0x32, 0x0b, 0x6a, 0x19, 0x97, 0x85, 0x11, 0xdc, 0xfb, 0x09, 0xdc, 0x02, 0x1d, 0x84, 0x25, 0x39}},
+    {{0x3c, 0x4f, 0xcf, 0x09, 0x88, 0x15, 0xf7, 0xab, 0xa6, 0xd2, 0xae, 0x28, 0x16, 0x15, 0x7e, 0x2b}, {0x2a, 0x17, 0x93, 0x73, 0x11, 0x7e, 0x3d, 0xe9, 0x96, 0x9f, 0x40, 0x2e, 0xe2, 0xbe, 0xc1, 0x6b}, {0x97, 0xef, 0x66, 0x24, 0xf3, 0xca, 0x9e, 0xa8, 0x60, 0x36, 0x7a, 0x0d, 0xb4, 0x7b, 0xd7, 0x3a}},
+    {{0x3c, 0x4f, 0xcf, 0x09, 0x88, 0x15, 0xf7, 0xab, 0xa6, 0xd2, 0xae, 0x28, 0x16, 0x15, 0x7e, 0x2b}, {0x51, 0x8e, 0xaf, 0x45, 0xac, 0x6f, 0xb7, 0x9e, 0x9c, 0xac, 0x03, 0x1e, 0x57, 0x8a, 0x2d, 0xae}, {0xaf, 0xba, 0xfd, 0x96, 0x5a, 0x89, 0x85, 0xe7, 0x9d, 0x69, 0xb9, 0x03, 0x85, 0xd5, 0xd3, 0xf5}},
+    {{0x3c, 0x4f, 0xcf, 0x09, 0x88, 0x15, 0xf7, 0xab, 0xa6, 0xd2, 0xae, 0x28, 0x16, 0x15, 0x7e, 0x2b}, {0xef, 0x52, 0x0a, 0x1a, 0x19, 0xc1, 0xfb, 0xe5, 0x11, 0xe4, 0x5c, 0xa3, 0x46, 0x1c, 0xc8, 0x30}, {0x88, 0x06, 0x03, 0xed, 0xe3, 0x00, 0x1b, 0x88, 0x23, 0xce, 0x8e, 0x59, 0x7f, 0xcd, 0xb1, 0x43}},
+    {{0x3c, 0x4f, 0xcf, 0x09, 0x88, 0x15, 0xf7, 0xab, 0xa6, 0xd2, 0xae, 0x28, 0x16, 0x15, 0x7e, 0x2b}, {0x10, 0x37, 0x6c, 0xe6, 0x7b, 0x41, 0x2b, 0xad, 0x17, 0x9b, 0x4f, 0xdf, 0x45, 0x24, 0x9f, 0xf6}, {0xd4, 0x5d, 0x72, 0x04, 0x71, 0x20, 0x23, 0x82, 0x3f, 0xad, 0xe8, 0x27, 0x5e, 0x78, 0x0c, 0x7b}},
+    {{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, {0xe6, 0x73, 0xf2, 0x08, 0xfb, 0xc3, 0x5d, 0xcd, 0xba, 0x27, 0xc6, 0x3c, 0xec, 0x81, 0x44, 0xf3}, {0x5e, 0x7f, 0x53, 0xce, 0xc9, 0x7c, 0x56, 0x5a, 0x59, 0x92, 0x6d, 0x96, 0x3e, 0x76, 0x36, 0x03}},
+    {{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, {0x72, 0x4e, 0x17, 0x10, 0xb9, 0x7d, 0x22, 0xc3, 0xc7, 0x75, 0xad, 0x0b, 0x64, 0xc4, 0x98, 0x97}, {0x89, 0x45, 0x23, 0x7b, 0x95, 0x93, 0xc0, 0xeb, 0x54, 0x69, 0x99, 0xf4, 0x1b, 0x63, 0xa1, 0xa9}},
+    {{0x59, 0x38, 0x47, 0xfb, 0x7c, 0x86, 0xcf, 0x74, 0xa3, 0xe5, 0x4b, 0xd7, 0x69, 0x88, 0xa5, 0x10}, {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, {0x65, 0x84, 0xf7, 0xdb, 0xb4, 0x6f, 0xaa, 0x4e, 0xe0, 0x51, 0xb0, 0x44, 0x69, 0x1e, 0x25, 0x6d}},
+    {{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80}, {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, {0xc8, 0xbe, 0x18, 0x14, 0xba, 0xd8, 0x5b, 0x45, 0x46, 0xe5, 0x21, 0xc6, 0xd3, 0x33, 0xdd, 0x0e}},
+    {{0xef, 0xc7, 0x80, 0xcb, 0x19, 0x96, 0x2c, 0x04, 0x01, 0x42, 0xb1, 0xd3, 0x2c, 0x6e, 0x60, 0x69}, {0xcc, 0xa1, 0x3b, 0x84, 0x0a, 0x77, 0x13, 0xbb, 0x8c, 0xac, 0xeb, 0x09, 0x71, 0xd6, 0x00, 0xfb}, {0x6d, 0xf8, 0xa8, 0xc8, 0xc1, 0x0a, 0x78, 0x26, 0xfd, 0x3e, 0x2d, 0xd8, 0x67, 0xab, 0x56, 0xca}},
+    {{0x8e, 0x87, 0x62, 0x69, 0xd5, 0xbc, 0xfd, 0x87, 0xc1, 0x70, 0xa0, 0x9d, 0xb1, 0xc6, 0x8f, 0xb2}, {0x82, 0x27, 0x79, 0xab, 0xe4, 0x89, 0x45, 0x5f, 0x95, 0xb8, 0xab, 0xab, 0xd3, 0x20, 0xc1, 0x5c}, {0xb4, 0x3f, 0x8c, 0x2c, 0x2f, 0x48, 0xbf, 0xc0, 0x77, 0x8a, 0x33, 0x75, 0xdf, 0x3a, 0xaa, 0xe8}},
+    {{0x9f, 0x3f, 0x33, 0xa7, 0x53, 0x92, 0xe0, 0xdb, 0x78, 0x97, 0x40, 0x71, 0xdc, 0xa1, 0x01, 0xba}, {0xea, 0x97, 0x02, 0xcb, 0x6c, 0x5f, 0x9a, 0x43, 0xf0, 0xcd, 0x64, 0x66, 0x58, 0x02, 0x6a, 0xe6}, {0xf2, 0x1b, 0xf7, 0x77, 0x72, 0xa8, 0x1f, 0x13, 0xab, 0x31, 0xa5, 0x59, 0x03, 0x84, 0xae, 0x80}},
+    {{0xe3, 0x71, 0xeb, 0x9e, 0x90, 0x34, 0x67, 0x13, 0xe9, 0x75, 0x06, 0x6d, 0xea, 0x1f, 0xaf, 0x3f}, {0x48, 0x4c, 0x07, 0x2d, 0xc3, 0xef, 0x01, 0xdd, 0x37, 0x73, 0xc5, 0xcb, 0x66, 0x98, 0xc5, 0x46}, {0xbf, 0xc6, 0xda, 0x52, 0x9c, 0x15, 0x3f, 0x01, 0xb4, 0xe7, 0x93, 0xf0, 0xca, 0x0f, 0xd1, 0x22}},
+    {{0x41, 0xc0, 0x04, 0x76, 0xff, 0x65, 0x21, 0xd3, 0xe6, 0x7a, 0xe1, 0xd1, 0xd4, 0xcf, 0x4e, 0xe4}, {0xe8, 0x25, 0xb3, 0xef, 0x01, 0x19, 0x68, 0x90, 0x3a, 0x5e, 0x40, 0xa0, 0x9b, 0xc6, 0xc1, 0xfa}, {0x2c, 0x25, 0x1d, 0xc5, 0x15, 0x44, 0xd1, 0xd0, 0x6b, 0xdb, 0x2f, 0x37, 0x0a, 0x2b, 0x06, 0x60}},
+    {{0x29, 0xdb, 0xe0, 0x32, 0x22, 0xa5, 0xdd, 0x4a, 0x32, 0xfb, 0x29, 0x2a, 0xc5, 0xd0, 0xb4, 0xdf}, {0xaf, 0xbd, 0x95, 0xa1, 0x03, 0x8d, 0xaf, 0x70, 0xc0, 0xe2, 0x1a, 0xdb, 0x87, 0x88, 0x81, 0xb8}, {0x9f, 0x0e, 0x94, 0xd2, 0x8b, 0x29, 0xe7, 0x23, 0x26, 0xd1, 0x88, 0x09, 0x90, 0x08, 0x02, 0x06}},
+    {{0xdf, 0x31, 0xe0, 0x85, 0xbb, 0xc6, 0xd1, 0xaf, 0xfc, 0x29, 0x6c, 0x50, 0xc1, 0xe6, 0x6a, 0x29}, {0xfe, 0x77, 0xd2, 0x61, 0x17, 0xc0, 0x70, 0xba, 0x03, 0x63, 0xc9, 0x62, 0xdf, 0xd5, 0x01, 0x3c}, {0x0b, 0x07, 0xd6, 0x74, 0xa8, 0xc7, 0x50, 0x96, 0xe7, 0x32, 0x5f, 0x31, 0x23, 0x41, 0xd5, 0x77}},
+    {{0x6c, 0x60, 0x1a, 0x8e, 0x6e, 0xff, 0x63, 0x9f, 0x0d, 0x46, 0x47, 0x83, 0x55, 0x62, 0xf6, 0xd9}, {0xc7, 0x10, 0x0f, 0xe9, 0x9b, 0x9c, 0x0d, 0x02, 0x5b, 0x73, 0x75, 0x11, 0x0d, 0xc6, 0x15, 0xa0}, {0x58, 0xdf, 0xa1, 0xf7, 0x22, 0xc1, 0x92, 0xec, 0x74, 0x02, 0x4b, 0xfd, 0x08, 0x2d, 0x59, 0x0e}},
+    {{0xa4, 0x8d, 0x02, 0xc8, 0x3d, 0x4a, 0xbd, 0x21, 0x36, 0xfd, 0xb0, 0xf7, 0x27, 0xea, 0xde, 0x4c}, {0x0a, 0x7b, 0x61, 0xf0, 0x3b, 0xb5, 0xbd, 0xd6, 0xeb, 0x05, 0x12, 0x4b, 0xba, 0xbb, 0x8c, 0xb3}, {0x77, 0x27, 0x6d, 0x43, 0x9f, 0x89, 0xa8, 0x1e, 0x4f, 0xf8, 0xe7, 0x02, 0x4e, 0xae, 0xf0, 0xf3}},
+    {{0x1b, 0xad, 0x82, 0x50, 0x09, 0x47, 0x91, 0xeb, 0x6f, 0xe2, 0x3c, 0xcc, 0x12, 0x97, 0x9e, 0x26}, {0x65, 0xfb, 0x31, 0x23, 0x31, 0x2f, 0xb1, 0x54, 0x84, 0xdf, 0xed, 0x4c, 0x91, 0xe1, 0x4a, 0xae}, {0x41, 0xbe, 0x57, 0x12, 0xfa, 0x78, 0x3a, 0x14, 0x83, 0x69, 0xb2, 0x6e, 0xf2, 0x0c, 0xcc, 0x66}},
+    {{0xff, 0x4f, 0xbf, 0x1b, 0x42, 0xf7, 0xc0, 0x8b, 0x31, 0x24, 0x15, 0xbe, 0xed, 0x03, 0xdb, 0x65}, {0xbf, 0x9f, 0x08, 0xe7, 0x1a, 0x7f, 0x02, 0xdb, 0x74, 0x54, 0xa0, 0xd3, 0xc8, 0x6c, 0x05, 0x1d}, {0x10, 0x73, 0x5d, 0xc4, 0xff, 0x73, 0xe6, 0xe3, 0x0c, 0x3c, 0xb9, 0x72, 0xc9, 0x54, 0x00, 0x04}},
+    {{0x41, 0x90, 0x5c, 0x53, 0x62, 0x12, 0x0b, 0x53, 0xa9, 0x0e, 0xd4, 0x1c, 0x34, 0x63, 0xad, 0x8f}, {0xfa, 0x8d, 0x43, 0x54, 0x43, 0xe5, 0x04, 0x80, 0x46, 0x73, 0xd6, 0x0d, 0xd1, 0x42, 0xd3, 0x87}, {0xc9, 0x9b, 0xb2, 0xa7, 0x80, 0x6d, 0x48, 0x9b, 0x54, 0xc4, 0x93, 0xc3, 0x57, 0x4d, 0x55, 0x5e}},
+    {{0xd6, 0x0f, 0x7a, 0xb2, 0xad, 0xad, 0x01, 0x91, 0xda, 0x9b, 0xfb, 0xf6, 0x40, 0xcc, 0x3a, 0x6c}, {0xe4, 0x31, 0xa9, 0x01, 0x5a, 0x6c, 0x3e, 0x80, 0x08, 0x46, 0x0b, 0xdf, 0x14, 0x4c, 0xa7, 0x76}, {0x97, 0x1b, 0x30, 0xa0, 0xb7, 0x50, 0x1f, 0x69, 0x61, 0x6d, 0xef, 0xf6, 0xdd, 0xe7, 0xc8, 0x9e}},
+    {{0xe6, 0x60, 0xcc, 0x27, 0x13, 0x25, 0x75, 0x12, 0x30, 0x0b, 0x87, 0x2f, 0xd9, 0x85, 0x82, 0x14}, {0xb7, 0x1d, 0xc7, 0xd9, 0x90, 0xe9, 0xc8, 0xf3, 0xca, 0x04, 0x59, 0xbf, 0x18, 0xe9, 0xc9, 0x3e}, {0x12, 0xc0, 0x91, 0xa8, 0x9a, 0x0f, 0x52, 0x9e, 0x25, 0x3b, 0x25, 0x61, 0xf2, 0xf8, 0x37, 0x65}},
+    {{0x06, 0xc5, 0xcb, 0x7b, 0x15, 0x0f, 0xfc, 0xc3, 0x60, 0x61, 0x51, 0xa7, 0x42, 0xfd, 0x40, 0xc8}, {0x0c, 0x79, 0xc2, 0x3f, 0x51, 0xfb, 0xb6, 0x48, 0x60, 0x37, 0xfc, 0x83, 0x98, 0xda, 0x1e, 0xed}, {0x65, 0xee, 0x7e, 0x2d, 0x0a, 0xb2, 0x05, 0x4a, 0x8b, 0x24, 0x0f, 0xc7, 0x13, 0x67, 0x7b, 0xc7}},
+    {{0xed, 0x86, 0x39, 0x22, 0x0c, 0xd4, 0x5c, 0x44, 0xc1, 0x5f, 0xc5, 0xbc, 0x98, 0xb7, 0x64, 0x03}, {0xa3, 0xb9, 0x5b, 0x6a, 0xdc, 0x52, 0x5f, 0x13, 0x14, 0x8b, 0x6e, 0x5d, 0x53, 0xed, 0x7b, 0x6c}, {0x45, 0x2e, 0x56, 0x7c, 0xc8, 0xcc, 0xe7, 0x84, 0x8a, 0xe4, 0x05, 0x47, 0x31, 0xc5, 0x66, 0xf8}},
+    {{0x6a, 0x45, 0xe4, 0xb8, 0x24, 0x37, 0xd3, 0x8c, 0x32, 0x5e, 0x17, 0xec, 0x03, 0xbe, 0xdb, 0x9a}, {0xa1, 0x1f, 0x6c, 0x7d, 0x95, 0x1a, 0x1a, 0x8e, 0xa5, 0xd2, 0x5e, 0x7d, 0xe7, 0xd1, 0xc7, 0x09}, {0x34, 0x9b, 0xca, 0xce, 0x8a, 0xb4, 0x6b, 0x6d, 0xa8, 0x06, 0x7a, 0x4c, 0x5c, 0x73, 0x62, 0x9d}},
+    {{0x4d, 0xbf, 0x51, 0x6d, 0x0c, 0xfd, 0x68, 0x34, 0xfc, 0xc3, 0x58, 0x8c, 0xd5, 0xee, 0xf8, 0x36}, {0xa6, 0x2e, 0x24, 0x3e, 0xe0, 0x17, 0x78, 0x86, 0xf0, 0x58, 0x9c, 0xfa, 0x25, 0xea, 0x2f, 0x94}, {0x80, 0xb9, 0x91, 0x9b, 0x41, 0xca, 0x88, 0xda, 0x0d, 0x2c, 0x71, 0xbd, 0xe7, 0x65, 0xaf, 0x91}},
+    {{0xd5, 0x15, 0xe1, 0x5a, 0xa4, 0xc6, 0xdd, 0x3c, 0x53, 0x9f, 0x2e, 0x0b, 0xbf, 0x45, 0x03, 0xf4}, {0x80, 0x3e, 0x61, 0xe3, 0xdf, 0x69, 0x98, 0xd4, 0xfd, 0xe6, 0x71, 0x20, 0x60, 0x9a, 0xf4, 0x6f}, {0xe4, 0x07, 0x91, 0xa2, 0x77, 0xfb, 0xe6, 0x91, 0x73, 0x05, 0xda, 0x78, 0x65, 0x26, 0x57, 0xe7}},
+    {{0xa6, 0x85, 0xa4, 0xd8, 0x13, 0x33, 0x7d, 0xce, 0x9d, 0x69, 0x66, 0x5b, 0x91, 0x29, 0xd0, 0x3b}, {0x67, 0x5b, 0x95, 0x9e, 0x63, 0x92, 0xb0, 0xf7, 0xb2, 0xf0, 0x39, 0xf6, 0xb6, 0x95, 0xef, 0xfe}, {0xd7, 0xed, 0xc8, 0x01, 0x90, 0x1a, 0x0c, 0x0f, 0x48, 0x53, 0x67, 0x7f, 0xb7, 0x0a, 0x7a, 0x20}},
+    {{0x7d, 0xb4, 0xf1, 0x8e, 0x29, 0x32, 0x99, 0xd3, 0x65, 0xde, 0xed, 0x51, 0x6c, 0xf0, 0xda, 0xcd}, {0x40, 0xb4, 0x40, 0xc5, 0x43, 0x9b, 0x2a, 0x54, 0x03, 0x5c, 0xee, 0x44, 0x0d, 0x07, 0xb6, 0x39}, {0xd0, 0x42, 0x5e, 0x46, 0x45, 0x3a, 0xd1, 0xdb, 0xc7, 0x1a, 0xdb, 0xc9, 0x9e, 0x3d, 0x66, 0xe2}},
+    {{0xde, 0x28, 0x63, 0xd3, 0x26, 0x8e, 0xac, 0x10, 0xdb, 0x53, 0x11, 0x70, 0x4c, 0x8a, 0x8c, 0x3a}, {0xdf, 0xc1, 0xed, 0xca, 0x46, 0x6c, 0x3a, 0x52, 0xbf, 0x1e, 0xc4, 0x71, 0xda, 0x70, 0x3e, 0xaf}, {0xa5, 0x5d, 0xd9, 0x73, 0x41, 0x94, 0xf7, 0x9a, 0xf2, 0xe4, 0xae, 0xd7, 0xb0, 0xdc, 0x0b, 0x31}},
+    {{0x21, 0xf9, 0xd8, 0xd7, 0x7a, 0x30, 0xdd, 0xb1, 0xed, 0xab, 0x87, 0xfd, 0x14, 0x9b, 0x83, 0xa3}, {0x8c, 0xce, 0xcf, 0xe5, 0x96, 0xed, 0xa7, 0x08, 0xe1, 0x00, 0xfa, 0xd9, 0xda, 0x41, 0x90, 0xa6}, {0x04, 0xbd, 0xd0, 0xaf, 0xbf, 0xe1, 0x5f, 0x99, 0xed, 0xcc, 0x67, 0xbc, 0xde, 0x0d, 0x94, 0x52}},
+    {{0x49, 0x7e, 0x0b, 0x84, 0x50, 0x34, 0x4c, 0xeb, 0xeb, 0x0c, 0xb1, 0xf7, 0xab, 0xd2, 0x04, 0x7d}, {0xa6, 0x89, 0x5c, 0xc7, 0x19, 0x83, 0x8e, 0x84, 0x89, 0x76, 0xa3, 0x71, 0x3f, 0xaa, 0x64, 0xfb}, {0x8b, 0x15, 0x6b, 0xa5, 0x48, 0x99, 0xd0, 0xa2, 0x0f, 0xfa, 0x3d, 0x0a, 0x62, 0x87, 0xc7, 0xb1}},
+    {{0x4e, 0xc5, 0x2f, 0x94, 0xef, 0x4e, 0x30, 0xa7, 0x20, 0xd6, 0x07, 0x5f, 0x6d, 0x2c, 0x22, 0x68}, {0x63, 0x8c, 0x2b, 0x19, 0xe7, 0x4f, 0xc2, 0x4d, 0x50, 0x11, 0x8d, 0x36, 0x4e, 0x9d, 0x57, 0x77}, {0xbe, 0x76, 0x43, 0x53, 0xaa, 0x74, 0x96, 0x44, 0x3d, 0xef, 0xc7, 0xb6, 0x56, 0xd0, 0xe3, 0x18}},
+    {{0x6e, 0x67, 0xa9, 0x9c, 0x94, 0x06, 0xf9, 0x61, 0xdb, 0x17, 0x74, 0x3f, 0xc4, 0x3a, 0xbf, 0xdd}, {0xb2, 0x70, 0x6b, 0x64, 0xe0, 0x44, 0x04, 0xa8, 0x53, 0xcb, 0x93, 0x49, 0x41, 0x6f, 0x3b, 0xd6}, {0x40, 0x86, 0x6c, 0xfa, 0xca, 0xa3, 0xea, 0x6c, 0x67, 0x15, 0xd7, 0x05, 0x0f, 0x72, 0x2c, 0x22}},
+    {{0x07, 0x16, 0x72, 0xd7, 0xf0, 0x9e, 0x0f, 0x1d, 0x9b, 0x78, 0x0b, 0x33, 0x8f, 0x85, 0x5e, 0x73}, {0xe4, 0x90, 0x10, 0x6e, 0x18, 0xcb, 0xa3, 0x0f, 0x24, 0x25, 0x7e, 0xcc, 0x63, 0x2a, 0x5b, 0xc7}, {0xd4, 0x0e, 0x61, 0xcd, 0xc5, 0x39, 0xad, 0x68, 0xe6, 0xf0, 0x24, 0x04, 0x56, 0x7b, 0xda, 0x23}},
+    {{0x74, 0x6a, 0xa1, 0x94, 0x33, 0xcd, 0x48, 0x63, 0xfa, 0x73, 0x9e, 0x83, 0x9f, 0x5f, 0x16, 0x87}, {0xab, 0x5e, 0xbf, 0x3d, 0x40, 0x7b, 0xb8, 0x8b, 0xff, 0x86, 0xed, 0x82, 0x2f, 0x9f, 0xb3, 0x21}, {0x27, 0xbd, 0xa8, 0x5a, 0xf3, 0xec, 0x49, 0x9e, 0x96, 0xc8, 0x25, 0xb2, 0xb7, 0x24, 0x1c, 0xa1}},
+    {{0xda, 0x0f, 0x74, 0x66, 0x9d, 0x2e, 0xc6, 0xa4, 0xbd, 0xc0, 0xa9, 0x0e, 0x6b, 0x7c, 0x46, 0x43}, {0x77, 0x9f, 0x6b, 0x6c, 0xc5, 0x3e, 0xb3, 0x70, 0xbf, 0xb3, 0x41, 0x19, 0x54, 0x9f, 0x6f, 0x07}, {0x84, 0x82, 0x38, 0x93, 0x62, 0xb2, 0xdd, 0x3d, 0xc9, 0x87, 0xba, 0xb2, 0x96, 0xa2, 0x5d, 0xe0}},
+    {{0x11, 0x02, 0xb7, 0x2e, 0x65, 0x6d, 0x33, 0x47, 0x80, 0x4f, 0x92, 0x23, 0xd3, 0x7f, 0xd7, 0xc8}, {0xc3, 0xda, 0xc2, 0xb5, 0xe1, 0xe5, 0xec, 0x8d, 0xa8, 0x0f, 0x77, 0x95, 0x10, 0xc4, 0xb6, 0xfa}, {0xfc, 0x1e, 0xd0, 0xfe, 0x4f, 0xff, 0xc3, 0xf8, 0x9b, 0x56, 0xb8, 0x77, 0x7b, 0x58, 0xeb, 0x4c}},
+    {{0x8b, 0x41, 0x96, 0x8f, 0xa9, 0x41, 0x30, 0x75, 0x46, 0x8f, 0xa4, 0xa4, 0xda, 0x9f, 0x69, 0x7e}, {0x3f, 0x31, 0x12, 0xe0, 0xa6, 0x50, 0x07, 0xd7, 0xfd, 0x9e, 0x6f, 0x59, 0x54, 0x74, 0x0f, 0xcf}, {0x30, 0xcd, 0x21, 0x8f, 0xc7, 0x80, 0x55, 0x96, 0x88, 0x58, 0x7a, 0x3e, 0x63, 0x10, 0x3b, 0x5d}},
+    {{0x67, 0xf9, 0x81, 0xd3, 0xb2, 0x3b, 0xd9, 0xa1, 0xdf, 0x84, 0x4e, 0x29, 0x32, 0x78, 0x54, 0xe0}, {0x12, 0xc3, 0xfe, 0xec, 0xf9, 0x99, 0xd9, 0xf2, 0x3a, 0xdf, 0x55, 0x65, 0x3a, 0xb7, 0x32, 0xa2}, {0x87, 0x1f, 0x82, 0x60, 0x1b, 0xa8, 0xdf, 0x30, 0xf0, 0x9b, 0x8e, 0x0a, 0x72, 0xb4, 0xd8, 0x9f}},
+    {{0xd8, 0x02, 0x13, 0xb8, 0x11, 0x1a, 0x97, 0x6b, 0xe0, 0x63, 0x9f, 0x3e, 0xda, 0x84, 0xae, 0x35}, {0x97, 0xbe, 0x54, 0x6f, 0x6c, 0x39, 0x4f, 0x3d, 0xbe, 0x44, 0x7f, 0x66, 0xa4, 0xf0, 0xab, 0xd7}, {0x10, 0x0c, 0x0d, 0xd3, 0x2c, 0x1a, 0x64, 0xae, 0x06, 0x9c, 0xda, 0xf7, 0xe4, 0xf8, 0x78, 0x49}},
+    {{0x85, 0xb6, 0x52, 0x92, 0xdd, 0x94, 0x25, 0x42, 0x97, 0xef, 0x60, 0x1a, 0x95, 0x10, 0x13, 0xf3}, {0x2f, 0xc3, 0xdf, 0x52, 0x2e, 0x27, 0x99, 0x46, 0x21, 0x17, 0x3a, 0x0e, 0x24, 0x1b, 0x83, 0x7a}, {0xbb, 0xe7, 0x17, 0x84, 0xed, 0x5b, 0xfe, 0xcb, 0x75, 0xf1, 0x97, 0xc7, 0x00, 0x4e, 0x93, 0xba}},
+    {{0x33, 0x11, 0xbb, 0xd3, 0xf5, 0x55, 0xf9, 0x89, 0xd1, 0xd2, 0x55, 0x97, 0x92, 0x95, 0x7a, 0xfb}, {0xe2, 0xec, 0xf7, 0x5a, 0x34, 0x15, 0x3a, 0xf0, 0xbc, 0xfd, 0x2d, 0xb5, 0xf8, 0xb3, 0x9f, 0xb3}, {0x6b, 0xcc, 0x9e, 0xc9, 0x84, 0xc1, 0x12, 0x8d, 0x49, 0x4f, 0x71, 0x46, 0xa4, 0xa6, 0x25, 0x46}},
+    {{0x21, 0xf4, 0xa4, 0x7f, 0x42, 0x1b, 0xc8, 0xf0, 0xf6, 0x57, 0xaf, 0xf0, 0x27, 0x0d, 0x11, 0x15}, {0x15, 0xac, 0x95, 0x9d, 0xc1, 0x42, 0xa7, 0xe3, 0xd6, 0x9d, 0xd2, 0x37, 0xc7, 0x11, 0x08, 0xde}, {0xa6, 0xaf, 0x6d, 0x7b, 0x50, 0xb8, 0xc5, 0xab, 0x28, 0x9c, 0x50, 0x02, 0xfa, 0x7c, 0xbd, 0xd3}},
+    {{0x7b, 0xdf, 0xaa, 0x0a, 0x11, 0x72, 0x67, 0x4b, 0xd7, 0x13, 0x89, 0x07, 0xab, 0xe1, 0x29, 0x61}, {0xf5, 0x76, 0xd3, 0x6a, 0x3a, 0x21, 0x74, 0xe1, 0xd4, 0xc9, 0x7f, 0xca, 0x20, 0x4d, 0xfa, 0x5f}, {0x51, 0x8b, 0x36, 0x55, 0x2e, 0xb0, 0x4b, 0xa3, 0x4f, 0x6a, 0x1e, 0xde, 0x98, 0xd1, 0x28, 0x85}},
+    {{0x1e, 0xbe, 0x95, 0xaa, 0xf2, 0xb8, 0x8d, 0xce, 0x31, 0x12, 0x62, 0xc8, 0x9e, 0x4e, 0xdb, 0xdb}, {0xd4, 0x01, 0xc7, 0x59, 0x6f, 0xea, 0x3e, 0x92, 0x67, 0x56, 0x32, 0x8c, 0x08, 0x7f, 0xb3, 0x3a}, {0xff, 0x63, 0xc7, 0x89, 0xf7, 0x6a, 0xf8, 0xc8, 0x55, 0xcc, 0xdb, 0x91, 0xdf, 0x07, 0x6b, 0xd1}},
+    {{0x29, 0x3e, 0x7d, 0x50, 0xec, 0x82, 0xcd, 0xdc, 0xd2, 0x3e, 0xf8, 0xfd, 0x9f, 0x8f, 0xf3, 0xde}, {0xff, 0x87, 0x24, 0x01, 0xc6, 0x43, 0x82, 0x34, 0xfa, 0x34, 0x76, 0x6d, 0xc2, 0x86, 0x8e, 0xc1}, {0x57, 0x7f, 0x06, 0xe5, 0x2e, 0xa1, 0x05, 0xd5, 0x1e, 0xec, 0x12, 0xbf, 0x76, 0xa0, 0x54, 0x23}},
+    {{0xdd, 0xcb, 0xa7, 0x2d, 0x2d, 0x12, 0x5b, 0x5b, 0x1c, 0xe6, 0x16, 0xd1, 0xe1, 0x06, 0x5a, 0xd2}, {0x29, 0x13, 0x08, 0x04, 0x83, 0xb6, 0x9d, 0xf9, 0xd6, 0x75, 0x17, 0x2f, 0x0b, 0x14, 0x14, 0x6c}, {0xc8, 0xf6, 0xf0, 0x3c, 0x57, 0xf0, 0x95, 0x54, 0xd0, 0xdb, 0x9f, 0x2b, 0xe6, 0x6d, 0x8e, 0x5e}},
+    {{0xfa, 0x4d, 0x99, 0xcd, 0x9a, 0x1e, 0xce, 0x1e, 0x04, 0x36, 0x72, 0xd2, 0x45, 0x92, 0xcd, 0x2c}, {0x6f, 0x99, 0xbb, 0xdd, 0x1e, 0x3e, 0xe2, 0x25, 0x76, 0x4e, 0x13, 0x60, 0xb1, 0x05, 0x77, 0x97}, {0x0a, 0x82, 0x20, 0x27, 0x97, 0x78, 0xc0, 0x78, 0x11, 0xb3, 0xb0, 0xb2, 0x0a, 0xac, 0x74, 0x40}},
+    {{0x73, 0x0c, 0x4c, 0x3a, 0xa8, 0xb8, 0xe4, 0x8a, 0x94, 0x67, 0xb0, 0x39, 0x18, 0xdc, 0x0e, 0x4d}, {0x74, 0x7c, 0xad, 0xc3, 0xcb, 0x80, 0xa4, 0x6f, 0x42, 0xb3, 0x4d, 0xa8, 0xef, 0x65, 0xcf, 0x9c}, {0xbe, 0x77, 0x63, 0x7d, 0xac, 0x4e, 0xe2, 0x05, 0xcf, 0x41, 0x43, 0x7c, 0xd2, 0x89, 0xd0, 0xa8}},
+    {{0x6f, 0x1e, 0x8c, 0x61, 0xf3, 0x05, 0xd1, 0x9b, 0x11, 0xbc, 0x5f, 0x3b, 0x76, 0x6c, 0xa0, 0xb1}, {0x8f, 0x93, 0x5e, 0x10, 0xd0, 0x59, 0xb3, 0x7d, 0x14, 0x99, 0xee, 0x2f, 0xe6, 0x92, 0xe4, 0xd2}, {0xc3, 0xeb, 0xbb, 0x44, 0x27, 0x51, 0x09, 0x26, 0x11, 0x10, 0xa2, 0xbf, 0x7b, 0x94, 0x45, 0x5f}},
+    {{0xaa, 0x58, 0xbc, 0x97, 0x0c, 0xce, 0x4d, 0x1b, 0x4e, 0x0e, 0xd1, 0x1e, 0x67, 0x50, 0x24, 0x68}, {0xf9, 0xdf, 0x31, 0xad, 0x36, 0x9f, 0xe2, 0x62, 0x37, 0x59, 0x52, 0xd3, 0x24, 0x98, 0x5e, 0xa9}, {0x6c, 0x59, 0x45, 0xb9, 0x74, 0x2d, 0xe9, 0x6d, 0x11, 0xc4, 0x73, 0x59, 0xa9, 0x0e, 0xce, 0x05}},
+    {{0xbf, 0xba, 0x3e, 0xcd, 0x11, 0x01, 0x3d, 0x0c, 0x3f, 0x1f, 0x0a, 0x96, 0xd8, 0x1b, 0x44, 0xa0}, {0x05, 0x62, 0x8f, 0xe4, 0xd3, 0x33, 0x9e, 0x07, 0x03, 0x07, 0xbe, 0x28, 0x24, 0xa9, 0x9a, 0xd1}, {0x3a, 0xfe, 0x82, 0x0c, 0xb4, 0xfa, 0x12, 0xdf, 0xbf, 0x42, 0x49, 0xbb, 0xee, 0xe7, 0x8d, 0xc1}},
+    {{0xb1, 0x6a, 0x08, 0x7c, 0x39, 0x08, 0xcf, 0xba, 0xe8, 0x53, 0xe6, 0x60, 0x14, 0x9c, 0x36, 0x65}, {0xe2, 0xb7, 0xcb, 0xf9, 0x3b, 0x82, 0x18, 0x47, 0x51, 0x4c, 0x4a, 0x66, 0x72, 0x07, 0x19, 0xbd}, {0x0c, 0x63, 0x70, 0x3f, 0x93, 0x6b, 0x2a, 0x3c, 0xdf, 0x39, 0xcc, 0x2c, 0x92, 0x2e, 0xa8, 0x7e}},
+    {{0x33, 0x52, 0xbb, 0xc8, 0xe0, 0x99, 0x26, 0xfa, 0xc2, 0xf7, 0xc0, 0x39, 0x0e, 0x5f, 0xcd, 0x87}, {0x89, 0xb4, 0x52, 0xf3, 0x5a, 0xec, 0x6d, 0x20, 0x14, 0x3e, 0x33, 0x6e, 0xfd, 0x98, 0x09, 0x45}, {0x33, 0x09, 0xa6, 0x99, 0x19, 0x0e, 0xef, 0x9d, 0x13, 0x7b, 0x27, 0xfb, 0x72, 0xfb, 0x6f, 0x27}},
+    {{0x4a, 0xae, 0x9d, 0x56, 0x28, 0x8d, 0xf3, 0x57, 0x37, 0xd7, 0x44, 0x94, 0x11, 0x88, 0xf6, 0xcf}, {0x69, 0xae, 0x39, 0xba, 0xca, 0x9e, 0x0d, 0x2f, 0x8f, 0xa2, 0xa1, 0x62, 0xd0, 0x35, 0xa1, 0x2c}, {0xf0, 0xdc, 0x99, 0x1a, 0x84, 0x18, 0x48, 0x4e, 0xfa, 0xeb, 0x5e, 0x45, 0x13, 0x46, 0x20, 0xbd}},
+    {{0xd0, 0x9c, 0xe2, 0x9d, 0xac, 0x17, 0xbf, 0xaa, 0xff, 0x8d, 0x13, 0x19, 0x5b, 0xcc, 0x32, 0x63}, {0x92, 0x68, 0xd0, 0xe2, 0xe3, 0x48, 0xfa, 0x06, 0xd0, 0xc7, 0x1d, 0xfc, 0x4a, 0xce, 0x95, 0x3f}, {0xa3, 0x91, 0xed, 0xa4, 0x41, 0xda, 0x7d, 0x0e, 0xb0, 0xab, 0x14, 0xa6, 0x62, 0xb7, 0x9c, 0x46}},
+    {{0x05, 0xec, 0x20, 0x40, 0x20, 0x0d, 0xdb, 0xb7, 0x52, 0x77, 0x17, 0x24, 0xaa, 0x83, 0xfa, 0x3b}, {0xfa, 0x60, 0x12, 0xbc, 0xeb, 0xc7, 0x0b, 0x61, 0xb6, 0x30, 0xde, 0x16, 0x1d, 0xab, 0x9d, 0x11}, {0x12, 0x9e, 0xc9, 0x0b, 0x8f, 0xf1, 0x80, 0x28, 0x61, 0xec, 0x43, 0x78, 0x51, 0x21, 0xa5, 0xf6}},
+    {{0x8a, 0xf3, 0xb9, 0x66, 0xb8, 0xd6, 0x81, 0x4e, 0x61, 0xfb, 0x6d, 0x1f, 0xc2, 0x27, 0x5d, 0x28}, {0x97, 0x4e, 0x3d, 0x3f, 0x08, 0x98, 0x1a, 0xa0, 0xfa, 0x66, 0xf6, 0x82, 0xc7, 0x5f, 0x1a, 0x4e}, {0xac, 0x5a, 0x34, 0x6e, 0xb3, 0x1a, 0xec, 0x8f, 0xb9, 0x08, 0xbd, 0xaf, 0xa9, 0xf0, 0xe1, 0x86}},
+    {{0x12, 0xf6, 0xc1, 0x77, 0xa0, 0xab, 0x69, 0xd3, 0x93, 0x64, 0xd4, 0x14, 0x4a, 0xf8, 0x1f, 0xf0}, {0xc3, 0x94, 0x1b, 0x5b, 0xc2, 0x4c, 0x5b, 0x3d, 0xb1, 0x3a, 0xa7, 0x99, 0xb1, 0xbd, 0x90, 0xb3}, {0x5c, 0x2d, 0xdc, 0x3b, 0x31, 0xa1, 0x6a, 0x31, 0xf9, 0x9f, 0x05, 0x09, 0x07, 0xf1, 0xd6, 0x6f}},
+    {{0x2e, 0xc6, 0x16, 0x42, 0x01, 0x2c, 0xca, 0xc0, 0x5c, 0x73, 0x99, 0x09, 0xc2, 0x27, 0x16, 0xeb}, {0x78, 0xb4, 0xc6, 0x98, 0x35, 0x37, 0xde, 0x2c, 0x35, 0xb0, 0xb5, 0x8e, 0xf6, 0x80, 0xc9, 0x11}, {0xf1, 0xde, 0xbe, 0xf9, 0x44, 0xdd, 0x28, 0x77, 0x92, 0x44, 0xd3, 0xb1, 0x41, 0x51, 0x33, 0x58}},
+    {{0xba, 0xab, 0x50, 0x05, 0x98, 0x07, 0xae, 0x03, 0xd1, 0x8c, 0xb5, 0x9b, 0x2a, 0x4a, 0x5c, 0x44}, {0xc9, 0x54, 0x10, 0x08, 0xce, 0xe3, 0x05, 0x8b, 0x2b, 0x2d, 0xa5, 0x36, 0x32, 0x90, 0x56, 0x38}, {0x2d, 0x3b, 0x23, 0x5c, 0xb7, 0xae, 0x66, 0xc8, 0x31, 0xbb, 0x2b, 0xc5, 0x85, 0x3c, 0x3c, 0x01}},
+};
+
+#endif /* AESVECTORS_H_ */
@@ -5,9 +5,16 @@
 #ifndef BLUETOOTHSERVICE_H_
 #define BLUETOOTHSERVICE_H_
 
+#include "jsonStream.h"
+
 char *bluetooth_wait_for_data(void);
 void bluetooth_send_message(char *data);
 void bluetooth_send_status(int status);
-char *bluetooth_wait_for_data(void);
+void bluetooth_init(void);
+void bluetooth_set_sink(const char *key, char *buffer, int size);
+json_stream_status bluetooth_poll(void);
+json_stream_t *bluetooth_message(void);
+json_stream_t *bluetooth_wait_for_message(void);
+int bluetooth_wait_for_ready(void);
 
 #endif /* BLUETOOTHSERVICE_H_ */
@@ -0,0 +1,17 @@
+/**
+ * This module contains function declarations for cacheService.c
+ */
+
+#ifndef CACHESERVICE_H_
+#define CACHESERVICE_H_
+
+// L1 and L2 line size, buffers shared with a DMA master should be aligned to it
+#define CACHE_LINE_SIZE 32
+
+void cache_init(void);
+void cache_init_secondary(void);
+void cache_clean_range(void *addr, unsigned int length);
+void cache_invalidate_range(void *addr, unsigned int length);
+void cache_flush_range(void *addr, unsigned int length);
+
+#endif /* CACHESERVICE_H_ */
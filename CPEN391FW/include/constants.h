@@ -8,17 +8,31 @@
 // Max character length for master password
 #define MAX_PASSWORD_LENGTH 32
 
+// Max character length for a file ID (UUID is 36 characters)
+#define MAX_FILE_ID_LENGTH 64
+
 // Max size for filedata sent from bluetooth
 
 #define MAX_FILEDATA_SIZE 0x200 // half kilobyte
 
 // Bluetooth constants
 #define BUFFER_SIZE 2048	  // 512 bytes of file data + 1536 bytes of extra data allowance
-#define TIMEOUT_ITER 10000000 // Large number to represent the max number of iterations with no data arriving (~50 sec)
+#define BLUETOOTH_TIMEOUT_MS 50000 // Max time with no data arriving inside a message
 #define MOCK_BLUETOOTH 0
+#define READY_TIMEOUT_MS 2000 // Max wait for the app's ready message before responding anyway
+#define READY_POLL_US 200 // Sleep between checks for the ready message, the UART FIFO holds 11 ms of data
+
+// Max number of JSON tokens in a single message (type 3 uses 13)
+#define JSON_MAX_TOKENS 32
 
 // Number of times to attempt connecting to router
 #define HANDSHAKE 5
+#define WIFI_KEEPALIVE_SEC 30 // Period of the WiFi module keepalive check
+#define WIFI_KEEPALIVE_TIMEOUT_MS 500 // Max wait for a keepalive reply before a request uses the module
+
+// Period of the scheduler statistics printout
+#define STATS_PERIOD_SEC 10
+#define PROFILING 1 // Time the request path with the probes of profileService.c
 
 // Timing constants
 #define TIME_FLAG_1MS 0x0001
@@ -30,9 +44,9 @@
 #define TIME_FLAG_20MS 0x0040
 #define TIME_FLAG_50MS 0x0080
 #define TIME_FLAG_100MS 0x0100
-#define TIME_FLAG_200MS 0x0210
-#define TIME_FLAG_300MS 0x0410
-#define TIME_FLAG_400MS 0x0810
+#define TIME_FLAG_200MS 0x0200
+#define TIME_FLAG_300MS 0x0400
+#define TIME_FLAG_400MS 0x0800
 #define TIME_FLAG_500MS 0x1000
 #define TIME_FLAG_1SEC 0x2000
 
@@ -65,6 +79,15 @@
 #define I2C_READ_FLAG_      0x80
 #define I2C_SLV0_EN_        0x80
 #define EXT_SENS_DATA_00_   0x49
+#define FIFO_EN_            0x23
+#define FIFO_ACCEL_         0x08
+#define FIFO_GYRO_          0x70
+#define FIFO_SLV0_          0x01
+#define USER_FIFO_EN_       0x40
+#define USER_FIFO_RST_      0x04
+#define FIFO_OFLOW_INT_     0x10
+#define FIFO_COUNTH_        0x72
+#define FIFO_R_W_           0x74
 
 /* AK8963 registers */
 #define AK8963_I2C_ADDR_  	0x0C
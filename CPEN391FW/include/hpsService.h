@@ -5,14 +5,20 @@
 #ifndef HPSSERVICE_H_
 #define HPSSERVICE_H_
 
-extern volatile uint32 *PtimerCount;
+#include "initService.h"
+
+extern volatile unsigned *PtimerCount;
 
 void hps_init(void);
 void hps_process(void);
 bool hps_elapsed_us(uint32 start, uint32 TimeUs);
+uint64 hps_time_ticks(void);
+uint64 hps_time_us(void);
+uint64 hps_time_ms(void);
 void hps_us_delay(unsigned int time_us);
 void hps_ms_delay(unsigned int time_ms);
 void hps_toggle_ledg(void);
 void hps_usleep(unsigned int time_us);
+init_status hps_delay_step(init_job_t *job);
 
 #endif /* HPSSERVICE_H_ */
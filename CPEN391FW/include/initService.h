@@ -0,0 +1,46 @@
+/**
+ * This module contains function declarations and types for initService.c
+ */
+
+#ifndef INITSERVICE_H_
+#define INITSERVICE_H_
+
+#include <typeDef.h>
+
+// Max number of drivers initialized at boot
+#define INIT_MAX_JOBS 6
+
+typedef enum
+{
+    INIT_PENDING,
+    INIT_DONE,
+    INIT_FAILED
+} init_status;
+
+typedef struct init_job init_job_t;
+
+// Runs the next step of a driver's initialization, must not block. Returns INIT_PENDING until done.
+typedef init_status (*init_step_fn)(init_job_t *job);
+
+// A driver initialized in the background, steps are run by init_task()
+struct init_job
+{
+    const char *name;
+    init_step_fn step;
+    int state;              // owned by the step function, starts at 0
+    uint32 wait_until_us;   // boot time before which step is not called, see init_wait_us()
+    uint32 deadline_us;     // boot time at which the job fails
+    init_status status;
+    uint32 done_us;         // boot time the job finished
+    uint32 steps;
+};
+
+int init_add(const char *name, init_step_fn step, uint32 timeout_ms);
+void init_wait_us(init_job_t *job, uint32 time_us);
+void init_start(void);
+void init_task(void);
+int init_done(void);
+uint32 init_boot_us(void);
+void init_print_report(void);
+
+#endif /* INITSERVICE_H_ */
@@ -77,10 +77,23 @@ extern "C"
 #define __IO_CALC_ADDRESS_NATIVE(BASE, REGNUM) \
   ((void*)(__KSEG0_TO_KSEG1((uint32)BASE) + ((REGNUM) * (SYSTEM_BUS_WIDTH/8))))
 
+#ifdef __ARMCC_VERSION
 #define IORD(BASE, REGNUM) \
   (*((volatile uint32*)(__IO_CALC_ADDRESS_NATIVE ((BASE), (REGNUM)))))
 #define IOWR(BASE, REGNUM, DATA) \
   (*((volatile uint32*)(__IO_CALC_ADDRESS_NATIVE ((BASE), (REGNUM)))) = (DATA))
+#else
+/* Host build, the registers are the peripheral models behind mmio.h */
+#include "mmio.h"
+
+#define __IO_CALC_ADDRESS_HOST(BASE, REGNUM) \
+  ((volatile unsigned *)(uintptr_t)((BASE) + ((REGNUM) * (SYSTEM_BUS_WIDTH/8))))
+
+#define IORD(BASE, REGNUM) \
+  mmio_read32(__IO_CALC_ADDRESS_HOST ((BASE), (REGNUM)))
+#define IOWR(BASE, REGNUM, DATA) \
+  mmio_write32(__IO_CALC_ADDRESS_HOST ((BASE), (REGNUM)), (DATA))
+#endif
 
 #ifdef __cplusplus
 }
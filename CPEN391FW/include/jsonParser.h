@@ -31,6 +31,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include "memService.h"
 
 #ifdef JSMN_STATIC
 #define JSMN_API static
@@ -454,7 +455,7 @@ static void jsmn_init(jsmn_parser *parser) {
 /**
  * str: the character string representing a JSON object
  *
- * Returns array of jsmntok_t objects if parsing succeeds
+ * Returns array of jsmntok_t objects if parsing succeeds, allocated from the request arena of memService.c
  * If parsing fails, an error message is printed to stderr and NULL is returned
  */
 static jsmntok_t *str_to_json(const char *str) {
@@ -484,7 +485,7 @@ static jsmntok_t *str_to_json(const char *str) {
     return NULL;
   }
 
-  tokens = (jsmntok_t *)malloc(num_tokens * sizeof(jsmntok_t));
+  tokens = (jsmntok_t *)mem_alloc(num_tokens * sizeof(jsmntok_t));
   if (!tokens) return NULL;
 
   jsmn_init(&p2);
@@ -504,14 +505,54 @@ static jsmntok_t *str_to_json(const char *str) {
         fprintf(stderr, "Something really bad happened\n");
         break;
     }
-    free(tokens);
-    tokens = NULL;
     return NULL;
   }
 
   return tokens;
 }
 
+/**
+ * str: the character string representing a JSON object
+ * tokens: caller provided array to fill with tokens
+ * max_tokens: number of entries available in tokens
+ *
+ * Single pass alternative to str_to_json that parses into a fixed size token
+ * array instead of counting and then allocating.
+ *
+ * Kept for the tests, bluetooth messages are parsed as they arrive by jsonStream.c.
+ *
+ * Returns the number of tokens used, or a negative jsmnerr value on failure
+ */
+static inline int json_tokenize(const char *str, jsmntok_t *tokens, int max_tokens) {
+  jsmn_parser p;
+  int num_tokens;
+
+  if (str == NULL) {
+    return JSMN_ERROR_INVAL;
+  }
+
+  jsmn_init(&p);
+  num_tokens = jsmn_parse(&p, str, strlen(str), tokens, max_tokens);
+  if (num_tokens < 0) {
+    switch (num_tokens) {
+      case JSMN_ERROR_NOMEM:
+        fprintf(stderr, "More than %i tokens\n", max_tokens);
+        break;
+      case JSMN_ERROR_INVAL:
+        fprintf(stderr, "JSON string contains invalid character\n");
+        break;
+      case JSMN_ERROR_PART:
+        fprintf(stderr, "JSON string incomplete\n");
+        break;
+      default:
+        fprintf(stderr, "Something really bad happened\n");
+        break;
+    }
+  }
+
+  return num_tokens;
+}
+
 /**
  * From the example code
  *
@@ -528,21 +569,25 @@ static int jsoneq(const char *json, jsmntok_t *tok, const char *s) {
 }
 
 /*
- * Returns an array of string values of the json values.
+ * Returns an array of string values of the json values, allocated from the request arena of memService.c
  * The max length of value is capped by the MAX_VALUE_SIZE
+ * NULL is returned if the arena is full
  */
 static char** get_json_values(const char *json, jsmntok_t *tok, int numTokens)
 {
-	char** ret = malloc(sizeof(char*) * numTokens);
+	char** ret = mem_alloc(sizeof(char*) * numTokens);
 	int valuesAdded = 0;
 
+	if (!ret) return NULL;
+
 	for (int i = 2; valuesAdded < numTokens; i += 2)
 	{
 		// Get the token and copy the data to the return buffer
 		jsmntok_t token = tok[i];
 		int length = token.end - token.start;
 
-		ret[valuesAdded] = malloc(length + 1);
+		ret[valuesAdded] = mem_alloc(length + 1);
+		if (!ret[valuesAdded]) return NULL;
 		memcpy(ret[valuesAdded], json + token.start, length);
     ret[valuesAdded][length] = '\0';
 
@@ -552,14 +597,104 @@ static char** get_json_values(const char *json, jsmntok_t *tok, int numTokens)
 	return ret;
 }
 
-static void free_json_values_array(char** array, int numTokens)
+/**
+ * View of a JSON value inside the original message buffer.
+ * ptr is NULL if the value was not present.
+ */
+typedef struct json_view {
+  char *ptr;
+  int len;
+} json_view_t;
+
+/**
+ * Schema entry mapping a key name to a value slot.
+ * Build entries with JSON_FIELD so the key length is known at compile time.
+ */
+typedef struct json_field {
+  const char *key;
+  int key_len;
+} json_field_t;
+
+#define JSON_FIELD(name) { (name), sizeof(name) - 1 }
+
+/*
+ * Looks up the values of a flat JSON object by key name in a single scan of
+ * the tokens. views[i] is set to the value of schema[i], regardless of the
+ * order the fields were sent in.
+ *
+ * No memory is allocated. Each value found is null terminated in place (over
+ * its closing quote or delimiter), so json must be writable and must not be
+ * parsed again afterwards. Kept for the tests, the firmware uses json_stream_extract.
+ *
+ * Returns the number of schema fields that were found
+ */
+static inline int json_extract(char *json, const jsmntok_t *tok, int num_tokens,
+                        const json_field_t *schema, int num_fields, json_view_t *views)
+{
+  int found = 0;
+  int i = 1;
+
+  memset(views, 0, sizeof(json_view_t) * num_fields);
+
+  if (num_tokens < 1 || tok[0].type != JSMN_OBJECT) {
+    return 0;
+  }
+
+  while (i + 1 < num_tokens && found < num_fields)
+  {
+    const jsmntok_t *key = &tok[i];
+    const jsmntok_t *value = &tok[i + 1];
+    int key_len = key->end - key->start;
+
+    for (int f = 0; f < num_fields; f++)
+    {
+      if (views[f].ptr == NULL && schema[f].key_len == key_len &&
+          memcmp(json + key->start, schema[f].key, key_len) == 0)
+      {
+        views[f].ptr = json + value->start;
+        views[f].len = value->end - value->start;
+        json[value->end] = '\0';
+        found++;
+        break;
+      }
+    }
+
+    // Skip the value, including anything nested inside of it
+    i += 2;
+    while (i < num_tokens && tok[i].start < value->end)
+    {
+      i++;
+    }
+  }
+
+  return found;
+}
+
+/*
+ * Parses an integer value in place, without copying it out of the buffer.
+ * Returns 0 if the view is empty or does not start with a number (like strtol)
+ */
+static inline int json_view_to_int(json_view_t view)
 {
-	for (int i = 0; i < numTokens; i++)
-	{
-		free(array[i]);
-	}
+  int value = 0;
+  int sign = 1;
+  int i = 0;
+
+  if (view.ptr == NULL) {
+    return 0;
+  }
+
+  if (view.len > 0 && view.ptr[0] == '-') {
+    sign = -1;
+    i++;
+  }
+
+  for (; i < view.len && view.ptr[i] >= '0' && view.ptr[i] <= '9'; i++)
+  {
+    value = value * 10 + (view.ptr[i] - '0');
+  }
 
-	free(array);
+  return sign * value;
 }
 
 #endif /* JSMN_HEADER */
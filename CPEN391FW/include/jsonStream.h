@@ -0,0 +1,62 @@
+/**
+ * This module contains function declarations and types for jsonStream.c
+ */
+
+#ifndef JSONSTREAM_H_
+#define JSONSTREAM_H_
+
+#include "jsonParser.h"
+
+// Max number of key/value pairs kept for one message
+#define JSON_STREAM_MAX_FIELDS 16
+// Storage for all keys and values, except the value diverted to the sink
+#define JSON_STREAM_POOL_SIZE 512
+
+typedef enum
+{
+    JSON_STREAM_BUSY = 0, // More bytes needed
+    JSON_STREAM_DONE,     // Closing brace of the object received
+    JSON_STREAM_ERROR     // Malformed message or out of storage
+} json_stream_status;
+
+typedef struct json_stream_field
+{
+    char *key;
+    int key_len;
+    json_view_t value;
+} json_stream_field_t;
+
+/**
+ * Resumable parser for a flat JSON object, fed one byte at a time.
+ */
+typedef struct json_stream
+{
+    int state;
+    int escape;
+
+    // Message type, set as soon as the "type" value is complete (-1 until then)
+    int type;
+
+    // Fields received so far
+    json_stream_field_t fields[JSON_STREAM_MAX_FIELDS];
+    int num_fields;
+
+    // Null terminated keys and values of the fields
+    char pool[JSON_STREAM_POOL_SIZE];
+    int pool_len;
+
+    // Value of sink_key is written straight to sink instead of the pool
+    const char *sink_key;
+    int sink_key_len;
+    char *sink;
+    int sink_size;
+    int sinking;
+} json_stream_t;
+
+void json_stream_init(json_stream_t *stream);
+void json_stream_set_sink(json_stream_t *stream, const char *key, char *buffer, int size);
+void json_stream_reset(json_stream_t *stream);
+json_stream_status json_stream_feed(json_stream_t *stream, char c);
+int json_stream_extract(json_stream_t *stream, const json_field_t *schema, int num_fields, json_view_t *views);
+
+#endif /* JSONSTREAM_H_ */
@@ -0,0 +1,31 @@
+/**
+ * This module contains function declarations and types for jsonWriter.c
+ */
+
+#ifndef JSONWRITER_H_
+#define JSONWRITER_H_
+
+// Size of the fragments handed to the output function
+#define JSON_WRITER_BUFFER_SIZE 64
+
+/**
+ * Writer for a flat JSON object, output is flushed in fragments as it is formed.
+ */
+typedef struct json_writer
+{
+    // Called with each null terminated fragment, e.g. bluetooth_send_message
+    void (*out)(char *fragment);
+
+    char buffer[JSON_WRITER_BUFFER_SIZE + 1];
+    int len;
+
+    // Set until the first field is written, no comma is needed before it
+    int first;
+} json_writer_t;
+
+void json_writer_begin(json_writer_t *writer, void (*out)(char *fragment));
+void json_write_int(json_writer_t *writer, const char *key, int value);
+void json_write_string(json_writer_t *writer, const char *key, const char *value);
+void json_writer_end(json_writer_t *writer);
+
+#endif /* JSONWRITER_H_ */
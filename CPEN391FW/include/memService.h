@@ -0,0 +1,40 @@
+/**
+ * This module contains function declarations and types for memService.c
+ */
+
+#ifndef MEMSERVICE_H_
+#define MEMSERVICE_H_
+
+#include <stddef.h>
+#include <typeDef.h>
+#include "constants.h"
+
+// Request arena, in bytes. A WiFi call takes about 1.1 KB, the tokens and values of the reply
+#define MEM_ARENA_SIZE 0x1000
+// Pool blocks, one holds a blob of hex encrypted file data with its terminator
+#define MEM_POOL_BLOCK_SIZE (2 * MAX_FILEDATA_SIZE + 8)
+#define MEM_POOL_BLOCKS 2
+
+// Position in the arena, everything allocated after it is released by mem_release()
+typedef uint32 mem_mark_t;
+
+// Use of the arena in bytes and of the pool in blocks, the peaks are since boot
+typedef struct
+{
+    uint32 arena_in_use;
+    uint32 arena_peak;
+    uint32 arena_failures;
+    uint32 pool_in_use;
+    uint32 pool_peak;
+    uint32 pool_failures;
+} mem_stats_t;
+
+void *mem_alloc(size_t size);
+mem_mark_t mem_mark(void);
+void mem_release(mem_mark_t mark);
+void mem_reset(void);
+void *mem_pool_alloc(void);
+void mem_pool_free(void *block);
+const mem_stats_t *mem_stats(void);
+
+#endif /* MEMSERVICE_H_ */
@@ -0,0 +1,93 @@
+/**
+ * This module contains the field schemas of the JSON messages received over bluetooth.
+ *
+ * Each schema lists the keys of one message type, and the matching enum gives the
+ * slot index of every field in the json_view_t array filled in by json_stream_extract.
+ */
+
+#ifndef MESSAGESCHEMA_H_
+#define MESSAGESCHEMA_H_
+
+#include "jsonParser.h"
+
+// Message type 2: verify master password and HEX code
+enum
+{
+    VERIFY_PASSWORD,
+    VERIFY_HEX,
+    VERIFY_NUM_FIELDS
+};
+static const json_field_t verify_schema[VERIFY_NUM_FIELDS] = {
+    JSON_FIELD("password"),
+    JSON_FIELD("hex")};
+
+// Message type 3: upload a packet of file data
+enum
+{
+    UPLOAD_FILE_ID,
+    UPLOAD_PACKET_NUMBER,
+    UPLOAD_TOTAL_PACKETS,
+    UPLOAD_LOCATION,
+    UPLOAD_FILE_DATA,
+    UPLOAD_NUM_FIELDS
+};
+static const json_field_t upload_schema[UPLOAD_NUM_FIELDS] = {
+    JSON_FIELD("fileId"),
+    JSON_FIELD("packetNumber"),
+    JSON_FIELD("totalPackets"),
+    JSON_FIELD("location"),
+    JSON_FIELD("fileData")};
+
+// Message type 4: download a file
+enum
+{
+    DOWNLOAD_ENCRYPTION_COMPONENT,
+    DOWNLOAD_FILE_ID,
+    DOWNLOAD_LOCATION,
+    DOWNLOAD_NUM_FIELDS
+};
+static const json_field_t download_schema[DOWNLOAD_NUM_FIELDS] = {
+    JSON_FIELD("localEncryptionComponent"),
+    JSON_FIELD("fileId"),
+    JSON_FIELD("location")};
+
+// Message type 6: WiFi configuration
+enum
+{
+    WIFI_NETWORK_NAME,
+    WIFI_NETWORK_PASSWORD,
+    WIFI_NUM_FIELDS
+};
+static const json_field_t wifi_schema[WIFI_NUM_FIELDS] = {
+    JSON_FIELD("networkName"),
+    JSON_FIELD("networkPassword")};
+
+// Message type 7: set master password
+enum
+{
+    PASSWORD_PASSWORD,
+    PASSWORD_NUM_FIELDS
+};
+static const json_field_t password_schema[PASSWORD_NUM_FIELDS] = {
+    JSON_FIELD("password")};
+
+// Status reply from the app (e.g. ready for the next download packet)
+enum
+{
+    STATUS_STATUS,
+    STATUS_NUM_FIELDS
+};
+static const json_field_t status_schema[STATUS_NUM_FIELDS] = {
+    JSON_FIELD("status")};
+
+// Readiness from the app, sent once it has the ack of its last message and is listening
+// for the response. Handled by bluetoothService, never acked or passed to the controller.
+enum
+{
+    READY_READY,
+    READY_NUM_FIELDS
+};
+static const json_field_t ready_schema[READY_NUM_FIELDS] = {
+    JSON_FIELD("ready")};
+
+#endif /* MESSAGESCHEMA_H_ */
@@ -0,0 +1,53 @@
+/**
+ * This module contains the accessors for memory mapped registers
+ *
+ * Drivers access peripherals only through these, with the register addresses of memAddress.h. With the
+ * ARM compiler they are inline volatile accesses, the same code a dereference gives. In the host build
+ * they are functions of the peripheral models in host/sim, so the firmware runs on Linux, see sim.h.
+ */
+
+#ifndef MMIO_H_
+#define MMIO_H_
+
+#ifdef __ARMCC_VERSION
+
+static __inline unsigned mmio_read32(volatile unsigned *reg)
+{
+    return *reg;
+}
+
+static __inline void mmio_write32(volatile unsigned *reg, unsigned value)
+{
+    *reg = value;
+}
+
+static __inline unsigned char mmio_read8(volatile unsigned char *reg)
+{
+    return *reg;
+}
+
+static __inline void mmio_write8(volatile unsigned char *reg, unsigned char value)
+{
+    *reg = value;
+}
+
+// Write the bus address of a buffer, e.g. for a DMA master
+static __inline void mmio_write_addr(volatile unsigned *reg, const void *ptr)
+{
+    *reg = (unsigned)ptr;
+}
+
+#else
+
+#include <stdint.h>
+
+unsigned mmio_read32(volatile unsigned *reg);
+void mmio_write32(volatile unsigned *reg, unsigned value);
+unsigned char mmio_read8(volatile unsigned char *reg);
+void mmio_write8(volatile unsigned char *reg, unsigned char value);
+// Host pointers do not fit in a register, the models keep the whole pointer
+void mmio_write_addr(volatile unsigned *reg, const void *ptr);
+
+#endif
+
+#endif /* MMIO_H_ */
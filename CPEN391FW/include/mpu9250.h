@@ -17,17 +17,25 @@
 #define MPU9250_H
 
 #include "constants.h"
+#include "initService.h"
+
+// Readings kept by the background sampler, the key uses their medians
+#define MPU9250_SAMPLES 15
 
 /*------------------- API Function -------------------------------------------*/
 
 bool MPU9250_Begin( void );
+init_status MPU9250_InitStep( init_job_t *job );
 bool MPU9250_EnableDrdyInt( void );
 bool MPU9250_DisableDrdyInt( void );
+bool MPU9250_EnableFifo( void );
 bool MPU9250_ConfigSrd( const uint8 srd );
 bool MPU9250_ConfigAccelRange( const uint8 range );
 bool MPU9250_ConfigGyroRange( const uint8 range );
 bool MPU9250_ConfigDlpf(const uint8 dlpf);
 bool MPU9250_Read( void );
+bool MPU9250_Sample( void );
+int MPU9250_SampleCount( void );
 
 //void  MPU9250_ApplyRotation( const Eigen::Matrix3f &c );
 uint8 MPU9250_accel_range( void );
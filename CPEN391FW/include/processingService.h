@@ -5,6 +5,8 @@
 #ifndef PROCESSINGSERVICE_H_
 #define PROCESSINGSERVICE_H_
 
+extern char upload_file_data[];
+
 void generate_key(char *location, unsigned char key[]);
 void regenerate_key(char *encryption_component, char *location, unsigned char key[]);
 char *upload(char *file_id, int packet_number, int total_packets, char *location, char *file_data);
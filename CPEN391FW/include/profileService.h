@@ -0,0 +1,59 @@
+/**
+ * This module contains function declarations, types and the probe macros for profileService.c
+ */
+
+#ifndef PROFILESERVICE_H_
+#define PROFILESERVICE_H_
+
+#include <typeDef.h>
+#include "constants.h"
+
+// log2 buckets, bucket n counts durations in [2^n, 2^(n+1))
+#define PROF_BUCKETS 32
+
+// Profiled code paths, names in profileService.c
+typedef enum
+{
+    PROF_REQUEST,
+    PROF_STR_TO_JSON,
+    PROF_GET_JSON_VALUES,
+    PROF_GENERATE_KEY,
+    PROF_ENCRYPT_HELPER,
+    PROF_UPLOAD_DATA,
+    PROF_GET_BLOB,
+    PROF_DECRYPT_HELPER,
+    PROF_BLUETOOTH_SEND,
+    PROF_READY_WAIT,
+    PROF_PROBES
+} prof_probe;
+
+// Durations recorded for a probe, in units of prof_now()
+typedef struct
+{
+    uint32 count;
+    uint64 total;
+    uint32 min;
+    uint32 max;
+    uint32 buckets[PROF_BUCKETS];
+} prof_stats_t;
+
+#if PROFILING
+// Time the code between PROF_BEGIN and PROF_END of the same probe, in the same block
+#define PROF_BEGIN(probe) uint32 prof_start_##probe = prof_now()
+#define PROF_END(probe) prof_record(probe, prof_now() - prof_start_##probe)
+#else
+#define PROF_BEGIN(probe)
+#define PROF_END(probe)
+#endif
+
+void prof_init(void);
+uint32 prof_now(void);
+void prof_record(prof_probe probe, uint32 duration);
+const prof_stats_t *prof_stats(prof_probe probe);
+const char *prof_name(prof_probe probe);
+const char *prof_unit(void);
+uint32 prof_to_us(uint64 duration);
+void prof_print_report(void);
+void prof_reset(void);
+
+#endif /* PROFILESERVICE_H_ */
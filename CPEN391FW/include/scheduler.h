@@ -0,0 +1,28 @@
+/**
+ * This module contains function declarations and types for scheduler.c
+ */
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include <typeDef.h>
+
+// Max number of registered periodic tasks and event sources
+#define SCHED_MAX_TASKS 8
+#define SCHED_MAX_EVENTS 4
+
+// Periodic task, must return quickly
+typedef void (*sched_task_fn)(void);
+// Event source, returns nonzero if the event happened. Must not block.
+typedef int (*sched_poll_fn)(void);
+// Handler for an event
+typedef void (*sched_handler_fn)(void);
+
+int sched_add_task(uint32 time_flag, sched_task_fn task, bool in_idle);
+int sched_add_event(sched_poll_fn poll, sched_handler_fn handler);
+void sched_idle(void);
+void sched_run_once(void);
+void sched_run(void);
+void sched_print_stats(void);
+
+#endif /* SCHEDULER_H_ */
@@ -0,0 +1,24 @@
+/**
+ * This module contains function declarations for smpService.c
+ */
+
+#ifndef SMPSERVICE_H_
+#define SMPSERVICE_H_
+
+typedef void (*smp_job_function)(void *arg);
+
+// A job for core 1, owned by the caller until smp_job_done() returns 1
+typedef struct
+{
+    smp_job_function function;
+    void *arg;
+    volatile int done;
+} smp_job_t;
+
+int smp_start_core1(void);
+int smp_core1_running(void);
+int smp_submit(smp_job_t *job, smp_job_function function, void *arg);
+int smp_job_done(smp_job_t *job);
+void smp_wait(smp_job_t *job);
+
+#endif /* SMPSERVICE_H_ */
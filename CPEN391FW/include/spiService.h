@@ -0,0 +1,22 @@
+/**
+ * This module contains function declarations for spiService.c
+ */
+
+#ifndef SPISERVICE_H_
+#define SPISERVICE_H_
+
+// One chip select assertion: write_length bytes of write_data, then read_length bytes into read_data
+typedef struct
+{
+    const uint8 *write_data;
+    uint32 write_length;
+    uint8 *read_data;
+    uint32 read_length;
+} spi_transfer_t;
+
+bool spi_transfer(uint32 base, uint32 slave, const uint8 *write_data, uint32 write_length,
+                  uint8 *read_data, uint32 read_length);
+bool spi_transfer_batch(uint32 base, uint32 slave, const spi_transfer_t *transfers, int count);
+int spi_credits(void);
+
+#endif /* SPISERVICE_H_ */
@@ -0,0 +1,12 @@
+/**
+ * This module contains function declarations for statsService.c
+ */
+
+#ifndef STATSSERVICE_H_
+#define STATSSERVICE_H_
+
+void stats_count_request(void);
+void stats_fold_profile(void);
+void stats_send(void);
+
+#endif /* STATSSERVICE_H_ */
@@ -0,0 +1,36 @@
+/**
+ * This module contains function declarations and types for timerService.c
+ */
+
+#ifndef TIMERSERVICE_H_
+#define TIMERSERVICE_H_
+
+#include <typeDef.h>
+
+// Wheel levels and slots per level, level n has slots of 64^n ms
+#define TIMER_LEVELS 4
+#define TIMER_LEVEL_BITS 6
+#define TIMER_SLOTS (1 << TIMER_LEVEL_BITS)
+
+typedef struct soft_timer soft_timer_t;
+
+// Called from timer_task() once the timer expired, may start timers again (including itself)
+typedef void (*timer_fn)(void *arg);
+
+// A timeout, owned by the caller and linked into the wheel while pending
+struct soft_timer
+{
+    soft_timer_t *next;
+    soft_timer_t **pprev;   // link pointing at this timer, null while not pending
+    uint64 expires_ms;
+    timer_fn fn;
+    void *arg;
+};
+
+void timer_init(soft_timer_t *timer, timer_fn fn, void *arg);
+void timer_start(soft_timer_t *timer, uint32 timeout_ms);
+void timer_cancel(soft_timer_t *timer);
+bool timer_pending(const soft_timer_t *timer);
+void timer_task(void);
+
+#endif /* TIMERSERVICE_H_ */
@@ -4,8 +4,27 @@
 
 #ifndef WIFI_H_
 #define WIFI_H_
+
+#include "initService.h"
+
+// Connection history of the WiFi module, only updated from the main loop.
+// A join after the first is a reconnect.
+typedef struct
+{
+    unsigned joins;
+    unsigned join_failures;
+    unsigned tcp_connects;
+    unsigned tcp_failures;
+    unsigned keepalive_failures;
+} wifi_stats_t;
+
 int set_wifi_config(char *network_name, char *network_password);
 int get_file_metadata(char *file_id);
 int upload_data(char *file_id, int blob_number, char *file_data);
 char *get_blob(char *file_id, int blob_number);
+void wifi_keepalive_start(void);
+int wifi_poll(void);
+void wifi_keepalive_done(void);
+init_status wifi_init_step(init_job_t *job);
+const wifi_stats_t *wifi_get_stats(void);
 #endif // WIFI_H_
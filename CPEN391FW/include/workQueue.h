@@ -0,0 +1,36 @@
+/**
+ * This module contains function declarations for workQueue.c
+ */
+
+#ifndef WORKQUEUE_H_
+#define WORKQUEUE_H_
+
+// Number of entries of a work queue, a power of two
+#define WORK_QUEUE_SIZE 32
+
+// 0 when free, 1 when held
+typedef volatile unsigned spinlock_t;
+
+typedef struct
+{
+    volatile unsigned sequence;
+    void *volatile item;
+} work_queue_cell_t;
+
+// Bounded multi-producer/multi-consumer queue, any core may push and pop without a lock
+typedef struct
+{
+    work_queue_cell_t cells[WORK_QUEUE_SIZE];
+    volatile unsigned head;
+    volatile unsigned tail;
+} work_queue_t;
+
+void spin_lock(spinlock_t *lock);
+int spin_trylock(spinlock_t *lock);
+void spin_unlock(spinlock_t *lock);
+
+void work_queue_init(work_queue_t *queue);
+int work_queue_push(work_queue_t *queue, void *item);
+void *work_queue_pop(work_queue_t *queue);
+
+#endif /* WORKQUEUE_H_ */
@@ -16,6 +16,7 @@
 #include <typeDef.h>
 
 #include "memAddress.h"
+#include "mmio.h"
 #include "UART.h"
 #include "hpsService.h"
 
@@ -28,7 +29,39 @@
 // HINT:
 // To write a byte to the FifoControlReg of the UART, we could write
 // something like this:
-// RS232_FifoControlReg = 0x55 ;
+// mmio_write8(RS232_FifoControlReg, 0x55);
+
+// Overrun Error bit (1) of the line status register
+#define UART_LSR_OVERRUN (1 << 1)
+
+// Traffic counters of each port, only updated from the main loop
+static UART_tSTATS UART_Stats[2];
+
+/**************************************************************************
+** Read the line status register of the given UART port.
+** An overrun is reported by one read only, so it is counted here.
+**
+***************************************************************************/
+static unsigned char UART_LineStatus(UART_ePORT ePort)
+{
+    unsigned char status;
+
+    if (ePort == UART_ePORT_WIFI)
+    {
+        status = mmio_read8(Wifi_LineStatusReg);
+    }
+    else
+    {
+        status = mmio_read8(Bluetooth_LineStatusReg);
+    }
+
+    if (status & UART_LSR_OVERRUN)
+    {
+        UART_Stats[ePort].overruns++;
+    }
+
+    return status;
+}
 
 /**************************************************************************
 ** Subroutine to initialize the UART Port by writing some data
@@ -43,7 +76,7 @@ void UART_Init(UART_ePORT ePort)
     if (ePort == UART_ePORT_WIFI)
     {
         // set bit 7 of Line Control Register to 1, to gain access to the baud rate registers
-        Wifi_LineControlReg = 0x80; // 0x80 = 1000 0000
+        mmio_write8(Wifi_LineControlReg, 0x80); // 0x80 = 1000 0000
 
         // set Divisor latch (LSB and MSB) with correct value for required baud rate
         /*
@@ -53,25 +86,25 @@ void UART_Init(UART_ePORT ePort)
         */
         // Baud rate divisor value = (frequency of BR_clk) / (desired baud rate x 16)
         // BR_clk = input clock to UART, 50 MHz?
-        Wifi_DivisorLatchLSB = (unsigned char)((50000000) / (115200 * 16));
-        Wifi_DivisorLatchMSB = (unsigned char)(((50000000) / (115200 * 16)) >> 8);
+        mmio_write8(Wifi_DivisorLatchLSB, (unsigned char)((50000000) / (115200 * 16)));
+        mmio_write8(Wifi_DivisorLatchMSB, (unsigned char)(((50000000) / (115200 * 16)) >> 8));
 
         // set bit 7 of Line control register back to 0 and
-        Wifi_LineControlReg = 0x00; // 0x80 = 1000 0000
+        mmio_write8(Wifi_LineControlReg, 0x00); // 0x80 = 1000 0000
 
         // program other bits in that reg for 8 bit data, 1 stop bit, no parity etc
-        Wifi_LineControlReg = 0x03; // 0x03 = 0000 0011
+        mmio_write8(Wifi_LineControlReg, 0x03); // 0x03 = 0000 0011
 
         // Reset the Fifo's in the FiFo Control Reg by setting bits 1 & 2
-        Wifi_FifoControlReg = 0x06; // 0x06 = 0000 0110
+        mmio_write8(Wifi_FifoControlReg, 0x06); // 0x06 = 0000 0110
 
         // Now Clear all bits in the FiFo control registers
-        Wifi_FifoControlReg = 0x00; // 0x00 = 0000 0000
+        mmio_write8(Wifi_FifoControlReg, 0x00); // 0x00 = 0000 0000
     }
     else if (ePort == UART_ePORT_BLUETOOTH)
     {
         // set bit 7 of Line Control Register to 1, to gain access to the baud rate registers
-        Bluetooth_LineControlReg = 0x80; // 0x80 = 1000 0000
+        mmio_write8(Bluetooth_LineControlReg, 0x80); // 0x80 = 1000 0000
 
         // set Divisor latch (LSB and MSB) with correct value for required baud rate
         /*
@@ -81,20 +114,20 @@ void UART_Init(UART_ePORT ePort)
         */
         // Baud rate divisor value = (frequency of BR_clk) / (desired baud rate x 16)
         // BR_clk = input clock to UART, 50 MHz?
-        Bluetooth_DivisorLatchLSB = (unsigned char)((50000000) / (115200 * 16));
-        Bluetooth_DivisorLatchMSB = (unsigned char)(((50000000) / (115200 * 16)) >> 8);
+        mmio_write8(Bluetooth_DivisorLatchLSB, (unsigned char)((50000000) / (115200 * 16)));
+        mmio_write8(Bluetooth_DivisorLatchMSB, (unsigned char)(((50000000) / (115200 * 16)) >> 8));
 
         // set bit 7 of Line control register back to 0 and
-        Bluetooth_LineControlReg = 0x00; // 0x80 = 1000 0000
+        mmio_write8(Bluetooth_LineControlReg, 0x00); // 0x80 = 1000 0000
 
         // program other bits in that reg for 8 bit data, 1 stop bit, no parity etc
-        Bluetooth_LineControlReg = 0x03; // 0x03 = 0000 0011
+        mmio_write8(Bluetooth_LineControlReg, 0x03); // 0x03 = 0000 0011
 
         // Reset the Fifo's in the FiFo Control Reg by setting bits 1 & 2
-        Bluetooth_FifoControlReg = 0x06; // 0x06 = 0000 0110
+        mmio_write8(Bluetooth_FifoControlReg, 0x06); // 0x06 = 0000 0110
 
         // Now Clear all bits in the FiFo control registers
-        Bluetooth_FifoControlReg = 0x00; // 0x00 = 0000 0000
+        mmio_write8(Bluetooth_FifoControlReg, 0x00); // 0x00 = 0000 0000
     }
 }
 
@@ -108,25 +141,27 @@ int UART_putchar(UART_ePORT ePort, int c)
     {
         // wait for Transmitter Holding Register bit (5) of line status register to be '1'
         // indicating we can write to the device
-        while (!(Wifi_LineStatusReg & (1 << 5)))
+        while (!(UART_LineStatus(UART_ePORT_WIFI) & (1 << 5)))
         {
             // wait
         }
 
         // write character to Transmitter fifo register
-        Wifi_TransmitterFifo = c;
+        mmio_write8(Wifi_TransmitterFifo, c);
+        UART_Stats[ePort].tx_bytes++;
     }
     else if (ePort == UART_ePORT_BLUETOOTH)
     {
         // wait for Transmitter Holding Register bit (5) of line status register to be '1'
         // indicating we can write to the device
-        while (!(Bluetooth_LineStatusReg & (1 << 5)))
+        while (!(UART_LineStatus(UART_ePORT_BLUETOOTH) & (1 << 5)))
         {
             // wait
         }
 
         // write character to Transmitter fifo register
-        Bluetooth_TransmitterFifo = c;
+        mmio_write8(Bluetooth_TransmitterFifo, c);
+        UART_Stats[ePort].tx_bytes++;
     }
 
     // return the character we printed
@@ -144,24 +179,26 @@ int UART_getchar(UART_ePORT ePort)
     if (ePort == UART_ePORT_WIFI)
     {
         // wait for Data Ready bit (0) of line status register to be '1'
-        while (!(Wifi_LineStatusReg & (1 << 0)))
+        while (!(UART_LineStatus(UART_ePORT_WIFI) & (1 << 0)))
         {
             // wait
         }
 
         // read new character from ReceiverFiFo register
-        newChar = Wifi_ReceiverFifo;
+        newChar = mmio_read8(Wifi_ReceiverFifo);
+        UART_Stats[ePort].rx_bytes++;
     }
     else if (ePort == UART_ePORT_BLUETOOTH)
     {
         // wait for Data Ready bit (0) of line status register to be '1'
-        while (!(Bluetooth_LineStatusReg & (1 << 0)))
+        while (!(UART_LineStatus(UART_ePORT_BLUETOOTH) & (1 << 0)))
         {
             // wait
         }
 
         // read new character from ReceiverFiFo register
-        newChar = Bluetooth_ReceiverFifo;
+        newChar = mmio_read8(Bluetooth_ReceiverFifo);
+        UART_Stats[ePort].rx_bytes++;
     }
 
     // return new character
@@ -180,13 +217,13 @@ int UART_TestForReceivedData(UART_ePORT ePort)
     {
         // if Wifi_LineStatusReg bit 0 is set to 1
         // return TRUE, otherwise return FALSE
-        return (Wifi_LineStatusReg & (1 << 0));
+        return (UART_LineStatus(UART_ePORT_WIFI) & (1 << 0));
     }
     else if (ePort == UART_ePORT_BLUETOOTH)
     {
         // if Wifi_LineStatusReg bit 0 is set to 1
         // return TRUE, otherwise return FALSE
-        return (Bluetooth_LineStatusReg & (1 << 0));
+        return (UART_LineStatus(UART_ePORT_BLUETOOTH) & (1 << 0));
     }
 
     return 0;
@@ -203,9 +240,10 @@ void UART_Flush(UART_ePORT ePort)
         // while bit 0 of Line Status Register == '1'
         // read unwanted char out of fifo receiver buffer
 
-        while ((Wifi_LineStatusReg & (1 << 0)))
+        while ((UART_LineStatus(UART_ePORT_WIFI) & (1 << 0)))
         {
-            Wifi_ReceiverFifo = 0x00;
+            mmio_read8(Wifi_ReceiverFifo);
+            UART_Stats[ePort].rx_bytes++;
         }
     }
     else if (ePort == UART_ePORT_BLUETOOTH)
@@ -213,13 +251,24 @@ void UART_Flush(UART_ePORT ePort)
         // while bit 0 of Line Status Register == �1�
         // read unwanted char out of fifo receiver buffer
 
-        while ((Bluetooth_LineStatusReg & (1 << 0)))
+        while ((UART_LineStatus(UART_ePORT_BLUETOOTH) & (1 << 0)))
         {
-            Bluetooth_ReceiverFifo = 0x00;
+            mmio_read8(Bluetooth_ReceiverFifo);
+            UART_Stats[ePort].rx_bytes++;
         }
     }
 }
 
+/**************************************************************************
+** Returns the bytes sent and received and the overruns of the given
+** UART port since boot.
+**
+***************************************************************************/
+const UART_tSTATS *UART_GetStats(UART_ePORT ePort)
+{
+    return &UART_Stats[ePort];
+}
+
 /*
  * Put multiple chars
  * */
@@ -3,67 +3,167 @@
  * hardware accelerated AES encryption/decryption modules.
  */
 
+#include <string.h>
 #include "memAddress.h"
+#include "mmio.h"
 #include "aesHwacc.h"
+#include "cacheService.h"
+
+// Word addresses of the AES encryption and decryption modules
+#define AES_KEY 0
+#define AES_RESULT 0
+#define AES_BLOCK 4
+#define AES_START_KEYEXP 8
+#define AES_START 9
+#define AES_STATUS 10
+
+// Done bit of their status word
+#define AES_STATUS_DONE 0x2
+
+// Word addresses of the AES core with key slots
+#define AES_CORE_KEY 0
+#define AES_CORE_RESULT 0
+#define AES_CORE_BLOCK 4
+#define AES_CORE_KEYEXP 8
+#define AES_CORE_ENCRYPT 9
+#define AES_CORE_DECRYPT 10
+#define AES_CORE_SLOTS 11
+#define AES_CORE_DMA_SRC 12
+#define AES_CORE_DMA_DST 13
+#define AES_CORE_DMA_START 14
+#define AES_CORE_DMA_STATUS 15
+#define AES_CORE_CTR_COUNTER 16
+#define AES_CORE_CTR_LENGTH 20
+
+// Bits of the DMA start and status words
+#define AES_DMA_DECRYPT (1 << 24)
+#define AES_DMA_IRQ (1 << 25)
+#define AES_DMA_CTR (1 << 26)
+#define AES_DMA_BUSY 0x1
+#define AES_DMA_DONE 0x2
+
+// Keys held in the AES core's slots, with the time they were last used for picking a slot to replace
+static unsigned char slot_keys[AES_KEY_SLOTS][16];
+static unsigned slot_last_used[AES_KEY_SLOTS];
+static unsigned slot_time = 0;
+
+// Destination of the running DMA transfer, its cache lines are dropped when it is done
+static unsigned char *dma_dst;
+static unsigned dma_length;
+
+static aes_stats_t aes_stats;
 
 /**
-  * Function to call Avalon memory mapped custom component AES encryption module.
-  *
-  * Params:
-  * 	key			unsigned char array of 16 elements, each element being 8 bits of the encryption key
-  * 	plaintext	unsigned char array of 16 elements, each element being 8 bits of the plaintext
-  * 	ciphertext 	unsigned char array of size 16, will be filled with ciphertext after function execution
-  * 	keyexp		int/boolean to specify whether to perform key expansion (only need to be true once for each encryption)
-  */
-void encrypt(unsigned char key[], unsigned char plaintext[], unsigned char ciphertext[], int keyexp)
+ * Write 16 bytes to 4 consecutive words of an AES module, in the same word and byte order as encrypt()
+ */
+static void write_words(volatile unsigned *addr, unsigned char bytes[])
+{
+    for (int i = 0; i < 4; i++)
+    {
+        mmio_write32(addr + i, (bytes[12 - 4 * i] << 24) + (bytes[13 - 4 * i] << 16) + (bytes[14 - 4 * i] << 8) + bytes[15 - 4 * i]);
+    }
+}
+
+/**
+ * Read 16 bytes from 4 consecutive words of an AES module, in the same word and byte order as encrypt()
+ */
+static void read_words(volatile unsigned *addr, unsigned char bytes[])
 {
-    unsigned word4 = (plaintext[12] << 24) + (plaintext[13] << 16) + (plaintext[14] << 8) + plaintext[15];
-    unsigned word5 = (plaintext[8] << 24) + (plaintext[9] << 16) + (plaintext[10] << 8) + plaintext[11];
-    unsigned word6 = (plaintext[4] << 24) + (plaintext[5] << 16) + (plaintext[6] << 8) + plaintext[7];
-    unsigned word7 = (plaintext[0] << 24) + (plaintext[1] << 16) + (plaintext[2] << 8) + plaintext[3];
+    for (int i = 0; i < 4; i++)
+    {
+        unsigned word = mmio_read32(addr + i);
 
-    // Write plaintext to AES encryption module
-    *(AES_ENCRYPT_ADDR + 4) = word4;
-    *(AES_ENCRYPT_ADDR + 5) = word5;
-    *(AES_ENCRYPT_ADDR + 6) = word6;
-    *(AES_ENCRYPT_ADDR + 7) = word7;
+        for (int j = 0; j < 4; j++)
+        {
+            bytes[12 - 4 * i + j] = word >> (8 * (3 - j));
+        }
+    }
+}
+
+/**
+ * Write the input block (and the key when keyexp is set) to the AES encryption or decryption module and start it.
+ * The module does not stall the bus while it runs.
+ */
+static void aes_start(volatile unsigned *aes, unsigned char key[], unsigned char input[], int keyexp)
+{
+    // Writing word 4 abandons a block that is still running
+    write_words(aes + AES_BLOCK, input);
 
     if (keyexp)
     {
         // Input key and perform key expansion
-        unsigned word0 = (key[12] << 24) + (key[13] << 16) + (key[14] << 8) + key[15];
-        unsigned word1 = (key[8] << 24) + (key[9] << 16) + (key[10] << 8) + key[11];
-        unsigned word2 = (key[4] << 24) + (key[5] << 16) + (key[6] << 8) + key[7];
-        unsigned word3 = (key[0] << 24) + (key[1] << 16) + (key[2] << 8) + key[3];
-
-        // Write key to AES encryption module
-        *(AES_ENCRYPT_ADDR + 0) = word0;
-        *(AES_ENCRYPT_ADDR + 1) = word1;
-        *(AES_ENCRYPT_ADDR + 2) = word2;
-        *(AES_ENCRYPT_ADDR + 3) = word3;
-
-        *(AES_ENCRYPT_ADDR + 8) = (unsigned)0;
+        write_words(aes + AES_KEY, key);
+        mmio_write32(aes + AES_START_KEYEXP, (unsigned)0);
+        aes_stats.key_expansions++;
     }
     else
     {
         // Don't perform key expansion
-        *(AES_ENCRYPT_ADDR + 9) = (unsigned)0;
+        mmio_write32(aes + AES_START, (unsigned)0);
     }
+}
 
-    unsigned cipher0 = *(AES_ENCRYPT_ADDR + 0);
-    unsigned cipher1 = *(AES_ENCRYPT_ADDR + 1);
-    unsigned cipher2 = *(AES_ENCRYPT_ADDR + 2);
-    unsigned cipher3 = *(AES_ENCRYPT_ADDR + 3);
+/**
+ * Read the result block of the AES encryption or decryption module if it is done, and clear done and the irq
+ */
+static int aes_poll(volatile unsigned *aes, unsigned char output[])
+{
+    if (!(mmio_read32(aes + AES_STATUS) & AES_STATUS_DONE))
+    {
+        return 0;
+    }
 
-    for (int i = 0; i < 4; i++)
+    read_words(aes + AES_RESULT, output);
+    mmio_write32(aes + AES_STATUS, (unsigned)0);
+    aes_stats.blocks++;
+    return 1;
+}
+
+/**
+  * Function to call Avalon memory mapped custom component AES encryption module.
+  *
+  * Params:
+  * 	key			unsigned char array of 16 elements, each element being 8 bits of the encryption key
+  * 	plaintext	unsigned char array of 16 elements, each element being 8 bits of the plaintext
+  * 	ciphertext 	unsigned char array of size 16, will be filled with ciphertext after function execution
+  * 	keyexp		int/boolean to specify whether to perform key expansion (only need to be true once for each encryption)
+  */
+void encrypt(unsigned char key[], unsigned char plaintext[], unsigned char ciphertext[], int keyexp)
+{
+    encrypt_start(key, plaintext, keyexp);
+    while (!encrypt_poll(ciphertext))
     {
-        ciphertext[i] = cipher3 >> (8 * (3 - i));
-        ciphertext[i + 4] = cipher2 >> (8 * (3 - i));
-        ciphertext[i + 8] = cipher1 >> (8 * (3 - i));
-        ciphertext[i + 12] = cipher0 >> (8 * (3 - i));
+        // wait
     }
 }
 
+/**
+ * Function to start the AES encryption module without waiting for it, so the CPU can do other work
+ * while the block is encrypted. Call encrypt_poll() to get the ciphertext.
+ *
+ * Params:
+ * 	key			unsigned char array of 16 elements, each element being 8 bits of the encryption key
+ * 	plaintext	unsigned char array of 16 elements, each element being 8 bits of the plaintext
+ * 	keyexp		int/boolean to specify whether to perform key expansion (only need to be true once for each encryption)
+ */
+void encrypt_start(unsigned char key[], unsigned char plaintext[], int keyexp)
+{
+    aes_start(AES_ENCRYPT_ADDR, key, plaintext, keyexp);
+}
+
+/**
+ * Function to check whether the block started by encrypt_start() is done.
+ *
+ * Params:
+ * 	ciphertext 	unsigned char array of size 16, filled with the ciphertext once the block is done
+ *
+ * Returns 1 once the ciphertext has been read, 0 while the module is still running
+ */
+int encrypt_poll(unsigned char ciphertext[])
+{
+    return aes_poll(AES_ENCRYPT_ADDR, ciphertext);
+}
+
 /**
  * Function to call Avalon memory mapped custom component AES decryption module.
  *
@@ -75,49 +175,278 @@ void encrypt(unsigned char key[], unsigned char plaintext[], unsigned char ciphe
  */
 void decrypt(unsigned char key[], unsigned char ciphertext[], unsigned char plaintext[], int keyexp)
 {
-    unsigned word4 = (ciphertext[12] << 24) + (ciphertext[13] << 16) + (ciphertext[14] << 8) + ciphertext[15];
-    unsigned word5 = (ciphertext[8] << 24) + (ciphertext[9] << 16) + (ciphertext[10] << 8) + ciphertext[11];
-    unsigned word6 = (ciphertext[4] << 24) + (ciphertext[5] << 16) + (ciphertext[6] << 8) + ciphertext[7];
-    unsigned word7 = (ciphertext[0] << 24) + (ciphertext[1] << 16) + (ciphertext[2] << 8) + ciphertext[3];
+    decrypt_start(key, ciphertext, keyexp);
+    while (!decrypt_poll(plaintext))
+    {
+        // wait
+    }
+}
 
-    // Write plaintext to AES decryption module
-    *(AES_DECRYPT_ADDR + 4) = word4;
-    *(AES_DECRYPT_ADDR + 5) = word5;
-    *(AES_DECRYPT_ADDR + 6) = word6;
-    *(AES_DECRYPT_ADDR + 7) = word7;
+/**
+ * Function to start the AES decryption module without waiting for it, so the CPU can do other work
+ * while the block is decrypted. Call decrypt_poll() to get the plaintext.
+ *
+ * Params:
+ * 	key			unsigned char array of 16 elements, each element being 8 bits of the encryption key
+ * 	ciphertext	unsigned char array of 16 elements, each element being 8 bits of the ciphertext
+ * 	keyexp		int/boolean to specify whether to perform key expansion (only need to be true once for each decryption)
+ */
+void decrypt_start(unsigned char key[], unsigned char ciphertext[], int keyexp)
+{
+    aes_start(AES_DECRYPT_ADDR, key, ciphertext, keyexp);
+}
 
-    if (keyexp)
+/**
+ * Function to check whether the block started by decrypt_start() is done.
+ *
+ * Params:
+ * 	plaintext 	unsigned char array of size 16, filled with the plaintext once the block is done
+ *
+ * Returns 1 once the plaintext has been read, 0 while the module is still running
+ */
+int decrypt_poll(unsigned char plaintext[])
+{
+    return aes_poll(AES_DECRYPT_ADDR, plaintext);
+}
+
+/**
+ * Function to find the AES core key slot holding the expanded key. If no slot holds it, the key
+ * is expanded into the least recently used slot. Switching between a few keys, or between encryption
+ * and decryption with the same key, then needs no key expansion.
+ *
+ * Params:
+ * 	key			unsigned char array of 16 elements, each element being 8 bits of the encryption key
+ *
+ * Returns the slot to pass to encrypt_slot() and decrypt_slot()
+ */
+int aes_key_slot(unsigned char key[])
+{
+    unsigned valid = mmio_read32(AES_CORE_ADDR + AES_CORE_SLOTS);
+    int slot = 0;
+
+    slot_time++;
+
+    for (int i = 0; i < AES_KEY_SLOTS; i++)
     {
-        // Input key and perform key expansion
-        unsigned word0 = (key[12] << 24) + (key[13] << 16) + (key[14] << 8) + key[15];
-        unsigned word1 = (key[8] << 24) + (key[9] << 16) + (key[10] << 8) + key[11];
-        unsigned word2 = (key[4] << 24) + (key[5] << 16) + (key[6] << 8) + key[7];
-        unsigned word3 = (key[0] << 24) + (key[1] << 16) + (key[2] << 8) + key[3];
-
-        // Write key to AES decryption module
-        *(AES_DECRYPT_ADDR + 0) = word0;
-        *(AES_DECRYPT_ADDR + 1) = word1;
-        *(AES_DECRYPT_ADDR + 2) = word2;
-        *(AES_DECRYPT_ADDR + 3) = word3;
-
-        *(AES_DECRYPT_ADDR + 8) = (unsigned)0;
+        // The core forgets its keys when the FPGA is reset, so only trust slots it reports as valid
+        if ((valid >> i) & 1)
+        {
+            if (memcmp(slot_keys[i], key, 16) == 0)
+            {
+                slot_last_used[i] = slot_time;
+                return i;
+            }
+        }
+        else
+        {
+            slot_last_used[i] = 0;
+        }
+
+        if (slot_last_used[i] < slot_last_used[slot])
+        {
+            slot = i;
+        }
     }
-    else
+
+    aes_load_key(slot, key);
+    return slot;
+}
+
+/**
+ * Function to expand a key into a slot of the AES core, replacing the key it held.
+ *
+ * Params:
+ * 	slot		slot number, 0 to AES_KEY_SLOTS - 1
+ * 	key			unsigned char array of 16 elements, each element being 8 bits of the encryption key
+ */
+void aes_load_key(int slot, unsigned char key[])
+{
+    write_words(AES_CORE_ADDR + AES_CORE_KEY, key);
+    mmio_write32(AES_CORE_ADDR + AES_CORE_KEYEXP, (unsigned)slot);
+    aes_stats.key_expansions++;
+
+    memcpy(slot_keys[slot], key, 16);
+    slot_last_used[slot] = ++slot_time;
+}
+
+/**
+ * Function to clear a slot of the AES core, so the key can not be used any more.
+ *
+ * Params:
+ * 	slot		slot number, 0 to AES_KEY_SLOTS - 1
+ */
+void aes_forget_key(int slot)
+{
+    mmio_write32(AES_CORE_ADDR + AES_CORE_SLOTS, (unsigned)slot);
+
+    memset(slot_keys[slot], 0, 16);
+    slot_last_used[slot] = 0;
+}
+
+/**
+ * Function to encrypt a block with the key in an AES core slot. Gives the same ciphertext as encrypt().
+ *
+ * Params:
+ * 	slot		slot returned by aes_key_slot()
+ * 	plaintext	unsigned char array of 16 elements, each element being 8 bits of the plaintext
+ * 	ciphertext 	unsigned char array of size 16, will be filled with ciphertext after function execution
+ */
+void encrypt_slot(int slot, unsigned char plaintext[], unsigned char ciphertext[])
+{
+    write_words(AES_CORE_ADDR + AES_CORE_BLOCK, plaintext);
+    mmio_write32(AES_CORE_ADDR + AES_CORE_ENCRYPT, (unsigned)slot);
+
+    // The core holds waitrequest until the block is done
+    read_words(AES_CORE_ADDR + AES_CORE_RESULT, ciphertext);
+    aes_stats.blocks++;
+}
+
+/**
+ * Function to decrypt a block with the key in an AES core slot. Gives the same plaintext as decrypt().
+ *
+ * Params:
+ * 	slot		slot returned by aes_key_slot()
+ * 	ciphertext	unsigned char array of 16 elements, each element being 8 bits of the ciphertext
+ * 	plaintext 	unsigned char array of size 16, will be filled with plaintext after function execution
+ */
+void decrypt_slot(int slot, unsigned char ciphertext[], unsigned char plaintext[])
+{
+    write_words(AES_CORE_ADDR + AES_CORE_BLOCK, ciphertext);
+    mmio_write32(AES_CORE_ADDR + AES_CORE_DECRYPT, (unsigned)slot);
+
+    // The core holds waitrequest until the block is done
+    read_words(AES_CORE_ADDR + AES_CORE_RESULT, plaintext);
+    aes_stats.blocks++;
+}
+
+/**
+ * Function to start encrypting or decrypting blocks in memory with the AES core's DMA.
+ * The core reads each block from src and writes the result to dst by itself, so the CPU is free
+ * until aes_dma_done() returns 1. The results are the same as encrypt_slot()/decrypt_slot() on each block.
+ * Both buffers must be 4 byte aligned and must not be used until the transfer is done, dst should
+ * not share cache lines with other data (see cache_invalidate_range()).
+ *
+ * Params:
+ * 	slot		slot returned by aes_key_slot()
+ * 	src			unsigned char array of 16 * num_blocks elements to encrypt or decrypt
+ * 	dst			unsigned char array of size 16 * num_blocks, filled with the results
+ * 	num_blocks	number of 16 byte blocks, at most 65535
+ * 	decrypting	int/boolean to specify whether to decrypt instead of encrypt
+ */
+void aes_dma_start(int slot, unsigned char src[], unsigned char dst[], int num_blocks, int decrypting)
+{
+    // The DMA does not snoop the CPU caches
+    cache_clean_range(src, 16 * num_blocks);
+    cache_flush_range(dst, 16 * num_blocks);
+    dma_dst = dst;
+    dma_length = 16 * num_blocks;
+
+    mmio_write_addr(AES_CORE_ADDR + AES_CORE_DMA_SRC, src);
+    mmio_write_addr(AES_CORE_ADDR + AES_CORE_DMA_DST, dst);
+
+    // The core raises its irq when the last block is written
+    mmio_write32(AES_CORE_ADDR + AES_CORE_DMA_START, (unsigned)num_blocks | ((unsigned)slot << 16) |
+                 (decrypting ? AES_DMA_DECRYPT : 0) | AES_DMA_IRQ);
+}
+
+/**
+ * Function to start encrypting or decrypting a buffer in AES-CTR mode with the AES core's DMA.
+ * The core encrypts the counter blocks itself and XORs them with the data, so encryption and
+ * decryption are the same operation and no padding is needed: only the blocks covering length bytes
+ * are processed and nothing after the last byte of dst is written. Block n is XORed with
+ * encrypt_slot(counter block + n), with the 8 byte counter at the end of the block counting up
+ * big endian. Like aes_dma_start(), wait for aes_dma_done() before using dst.
+ *
+ * Params:
+ * 	slot			slot returned by aes_key_slot()
+ * 	counter_block	unsigned char array of 16 elements, an 8 byte nonce followed by the 8 byte start counter
+ * 	src				unsigned char array of length elements to encrypt or decrypt, 4 byte aligned
+ * 	dst				unsigned char array of size length, filled with the results, 4 byte aligned
+ * 	length			number of bytes, at most 16 * 65535
+ */
+void aes_ctr_start(int slot, unsigned char counter_block[], unsigned char src[], unsigned char dst[], int length)
+{
+    cache_clean_range(src, length);
+    cache_flush_range(dst, length);
+    dma_dst = dst;
+    dma_length = length;
+
+    mmio_write_addr(AES_CORE_ADDR + AES_CORE_DMA_SRC, src);
+    mmio_write_addr(AES_CORE_ADDR + AES_CORE_DMA_DST, dst);
+
+    // The counter and nonce words use the same layout as the key words
+    write_words(AES_CORE_ADDR + AES_CORE_CTR_COUNTER, counter_block);
+    mmio_write32(AES_CORE_ADDR + AES_CORE_CTR_LENGTH, (unsigned)length);
+
+    mmio_write32(AES_CORE_ADDR + AES_CORE_DMA_START, ((unsigned)slot << 16) | AES_DMA_CTR | AES_DMA_IRQ);
+}
+
+/**
+ * Function to check whether the transfer started by aes_dma_start() or aes_ctr_start() is done.
+ * Clears the done flag and the irq, and drops the cached lines of dst so the CPU reads the results.
+ *
+ * Returns 1 once the transfer is done, 0 while it is still running
+ */
+int aes_dma_done(void)
+{
+    if (mmio_read32(AES_CORE_ADDR + AES_CORE_DMA_STATUS) & AES_DMA_DONE)
     {
-        // Don't perform key expansion
-        *(AES_DECRYPT_ADDR + 9) = (unsigned)0;
+        mmio_write32(AES_CORE_ADDR + AES_CORE_DMA_STATUS, (unsigned)0);
+        cache_invalidate_range(dma_dst, dma_length);
+        aes_stats.blocks += (dma_length + 15) / 16;
+        return 1;
     }
 
-    unsigned plain0 = *(AES_DECRYPT_ADDR + 0);
-    unsigned plain1 = *(AES_DECRYPT_ADDR + 1);
-    unsigned plain2 = *(AES_DECRYPT_ADDR + 2);
-    unsigned plain3 = *(AES_DECRYPT_ADDR + 3);
+    return 0;
+}
 
-    for (int i = 0; i < 4; i++)
+/**
+ * Step function of the background initialization, see initService.c. Encrypts and decrypts the
+ * FIPS-197 example block on the encryption and decryption modules without waiting for them.
+ */
+init_status aes_self_test_step(init_job_t *job)
+{
+    // FIPS-197 appendix C.1, in the byte order encrypt() and decrypt() take
+    static unsigned char key[16] = {0x0f, 0x0e, 0x0d, 0x0c, 0x0b, 0x0a, 0x09, 0x08,
+                                    0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01, 0x00};
+    static unsigned char plaintext[16] = {0xff, 0xee, 0xdd, 0xcc, 0xbb, 0xaa, 0x99, 0x88,
+                                          0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11, 0x00};
+    static const unsigned char expected[16] = {0x5a, 0xc5, 0xb4, 0x70, 0x80, 0xb7, 0xcd, 0xd8,
+                                               0x30, 0x04, 0x7b, 0x6a, 0xd8, 0xe0, 0xc4, 0x69};
+    static unsigned char result[16];
+
+    switch (job->state)
     {
-        plaintext[i] = plain3 >> (8 * (3 - i));
-        plaintext[i + 4] = plain2 >> (8 * (3 - i));
-        plaintext[i + 8] = plain1 >> (8 * (3 - i));
-        plaintext[i + 12] = plain0 >> (8 * (3 - i));
+    case 0:
+        encrypt_start(key, plaintext, 1);
+        job->state = 1;
+        return INIT_PENDING;
+    case 1:
+        if (!encrypt_poll(result))
+        {
+            return INIT_PENDING;
+        }
+        if (memcmp(result, expected, 16) != 0)
+        {
+            return INIT_FAILED;
+        }
+        decrypt_start(key, result, 1);
+        job->state = 2;
+        return INIT_PENDING;
+    default:
+        if (!decrypt_poll(result))
+        {
+            return INIT_PENDING;
+        }
+        return memcmp(result, plaintext, 16) == 0 ? INIT_DONE : INIT_FAILED;
     }
 }
+
+/**
+ * Returns the blocks processed and the key expansions of all AES modules since boot.
+ * Blocks of a DMA transfer are counted once aes_dma_done() has seen it finish.
+ */
+const aes_stats_t *aes_get_stats(void)
+{
+    return &aes_stats;
+}
@@ -21,10 +21,26 @@
 #include "hpsService.h"
 #include "UART.h"
 #include "jsonParser.h"
+#include "jsonStream.h"
+#include "messageSchema.h"
+#include "bluetoothService.h"
+#include "scheduler.h"
+#include "profileService.h"
 
 static int bluetooth_count = 0;
 static char bluetooth_data[BUFFER_SIZE];
 
+// Incremental parser for messages, fed as bytes arrive
+static json_stream_t bluetooth_stream;
+// Set once the current message is finished, the stream is reset on the next byte
+static int bluetooth_complete = 0;
+// Set while dropping the rest of a malformed message
+static int bluetooth_discard = 0;
+// Set when the app has said it is listening for the response to its last message
+static int bluetooth_ready = 0;
+// Set when a message completed while waiting for readiness, it is returned by the next wait
+static int bluetooth_pending = 0;
+
 // Mocking request index
 int mock_idx = 0;
 /*
@@ -120,7 +136,11 @@ char *mock_bluetooth_wait_for_data(void)
 		exit(0);
 	}
 
-	return json_str;
+	// Copy into the receive buffer, since message fields are parsed in place
+	strncpy(bluetooth_data, json_str, BUFFER_SIZE - 1);
+	bluetooth_data[BUFFER_SIZE - 1] = '\0';
+
+	return bluetooth_data;
 }
 
 /*
@@ -130,9 +150,11 @@ char *mock_bluetooth_wait_for_data(void)
  */
 void bluetooth_send_message(char *data)
 {
+	PROF_BEGIN(PROF_BLUETOOTH_SEND);
 #if !MOCK_BLUETOOTH
 	UART_puts(UART_ePORT_BLUETOOTH, data);
 #endif
+	PROF_END(PROF_BLUETOOTH_SEND);
 }
 
 /*
@@ -160,7 +182,7 @@ char *bluetooth_wait_for_data(void)
 
 	// Reset state
 	bluetooth_count = 0;
-	int i = 0;
+	uint64 deadline_us;
 	char c = ' ';
 
 	// Wait for initial data to arrive
@@ -176,7 +198,8 @@ char *bluetooth_wait_for_data(void)
 	}
 
 	// Process all subsequent data (timing out if too much waiting elapses)
-	while (i < TIMEOUT_ITER && c != '\n')
+	deadline_us = hps_time_us() + 1000ULL * BLUETOOTH_TIMEOUT_MS;
+	while (hps_time_us() < deadline_us && c != '\n')
 	{
 		if (UART_TestForReceivedData(UART_ePORT_BLUETOOTH))
 		{
@@ -184,12 +207,8 @@ char *bluetooth_wait_for_data(void)
 			bluetooth_data[bluetooth_count] = c;
 
 			bluetooth_count++;
-			i = 0;
-
-			continue;
+			deadline_us = hps_time_us() + 1000ULL * BLUETOOTH_TIMEOUT_MS;
 		}
-
-		i++;
 	}
 
 	// Return NULL if timeout occurs
@@ -205,3 +224,212 @@ char *bluetooth_wait_for_data(void)
 	return bluetooth_data;
 #endif
 }
+
+/*
+ * Initializes the incremental message parser
+ */
+void bluetooth_init(void)
+{
+	json_stream_init(&bluetooth_stream);
+	bluetooth_complete = 0;
+	bluetooth_discard = 0;
+	bluetooth_ready = 0;
+	bluetooth_pending = 0;
+}
+
+/*
+ * Writes the value of the given message field straight into buffer as it arrives,
+ * instead of keeping it with the rest of the message
+ */
+void bluetooth_set_sink(const char *key, char *buffer, int size)
+{
+	json_stream_set_sink(&bluetooth_stream, key, buffer, size);
+}
+
+/*
+ * Feeds one received byte to the message parser.
+ * A malformed message is dropped up to the end of its line before the error is reported.
+ */
+static json_stream_status bluetooth_feed(char c)
+{
+	json_stream_status status;
+
+	if (bluetooth_complete)
+	{
+		json_stream_reset(&bluetooth_stream);
+		bluetooth_complete = 0;
+	}
+
+	if (bluetooth_discard)
+	{
+		if (c != '\n')
+		{
+			return JSON_STREAM_BUSY;
+		}
+
+		bluetooth_discard = 0;
+		bluetooth_complete = 1;
+		return JSON_STREAM_ERROR;
+	}
+
+	status = json_stream_feed(&bluetooth_stream, c);
+	if (status == JSON_STREAM_DONE)
+	{
+		json_view_t ready[READY_NUM_FIELDS];
+
+		bluetooth_complete = 1;
+
+		// Readiness messages are consumed here, not acked or passed on
+		if (bluetooth_stream.type == -1 && json_stream_extract(&bluetooth_stream, ready_schema, READY_NUM_FIELDS, ready) == READY_NUM_FIELDS)
+		{
+			bluetooth_ready = 1;
+			return JSON_STREAM_BUSY;
+		}
+
+		// Acknowledge the message (trailing line endings are skipped by the next message),
+		// the app has to send a new ready message before its response is sent
+		bluetooth_ready = 0;
+		bluetooth_send_status(2);
+	}
+	else if (status == JSON_STREAM_ERROR)
+	{
+		bluetooth_discard = 1;
+		status = JSON_STREAM_BUSY;
+	}
+
+	return status;
+}
+
+/*
+ * Parses any bytes that have already been received, without waiting for more.
+ *
+ * Returns JSON_STREAM_DONE when a full message is available from bluetooth_message(),
+ * JSON_STREAM_ERROR when a malformed message was dropped, and JSON_STREAM_BUSY otherwise.
+ */
+json_stream_status bluetooth_poll(void)
+{
+	json_stream_status status;
+
+	// Message already received while waiting for readiness
+	if (bluetooth_pending)
+	{
+		bluetooth_pending = 0;
+		return JSON_STREAM_DONE;
+	}
+
+#if MOCK_BLUETOOTH
+	// Every poll delivers the next mock message
+	return bluetooth_wait_for_message() != NULL ? JSON_STREAM_DONE : JSON_STREAM_ERROR;
+#endif
+
+	while (UART_TestForReceivedData(UART_ePORT_BLUETOOTH))
+	{
+		status = bluetooth_feed((char)UART_getchar(UART_ePORT_BLUETOOTH));
+		if (status != JSON_STREAM_BUSY)
+		{
+			return status;
+		}
+	}
+
+	return JSON_STREAM_BUSY;
+}
+
+/*
+ * Returns the last message completed by bluetooth_poll or bluetooth_wait_for_message
+ */
+json_stream_t *bluetooth_message(void)
+{
+	return &bluetooth_stream;
+}
+
+/*
+ * Waits for an entire bluetooth message, parsing it while it arrives.
+ * Returns NULL if the message is malformed or times out.
+ */
+json_stream_t *bluetooth_wait_for_message(void)
+{
+	json_stream_status status = JSON_STREAM_BUSY;
+
+	// Message already received while waiting for readiness
+	if (bluetooth_pending)
+	{
+		bluetooth_pending = 0;
+		return &bluetooth_stream;
+	}
+
+#if MOCK_BLUETOOTH
+	char *json_str = mock_bluetooth_wait_for_data();
+
+	for (int j = 0; json_str[j] != '\0' && status == JSON_STREAM_BUSY; j++)
+	{
+		status = bluetooth_feed(json_str[j]);
+	}
+#else
+	int started = 0;
+	uint64 deadline_us = 0;
+
+	// Wait indefinitely for a message to start, then time out if too much waiting elapses
+	while (status == JSON_STREAM_BUSY && (!started || hps_time_us() < deadline_us))
+	{
+		if (UART_TestForReceivedData(UART_ePORT_BLUETOOTH))
+		{
+			status = bluetooth_feed((char)UART_getchar(UART_ePORT_BLUETOOTH));
+			started = 1;
+			deadline_us = hps_time_us() + 1000ULL * BLUETOOTH_TIMEOUT_MS;
+
+			continue;
+		}
+
+		sched_idle();
+	}
+#endif
+
+	if (status != JSON_STREAM_DONE)
+	{
+		// Drop any partial message
+		bluetooth_complete = 1;
+		bluetooth_discard = 0;
+		return NULL;
+	}
+
+	return &bluetooth_stream;
+}
+
+/*
+ * Waits for the app to say it is listening before a response is sent.
+ *
+ * The app sends {"ready":1} once it has the ack of its last message, usually while the
+ * request is still being processed, so there is normally no wait at all. Apps that do not
+ * send it are answered after READY_TIMEOUT_MS, the core sleeps between checks. If the app sends a new message instead, the
+ * wait ends and that message is returned by the next bluetooth_wait_for_message.
+ *
+ * Returns the number of ms waited, or -1 if the app did not say it was ready
+ */
+int bluetooth_wait_for_ready(void)
+{
+#if MOCK_BLUETOOTH
+	return 0;
+#else
+	uint64 start_ms = hps_time_ms();
+
+	while (!bluetooth_ready)
+	{
+		if (hps_time_ms() - start_ms >= READY_TIMEOUT_MS)
+		{
+			return -1;
+		}
+
+		if (bluetooth_poll() == JSON_STREAM_DONE)
+		{
+			bluetooth_pending = 1;
+			return -1;
+		}
+
+		sched_idle();
+		hps_usleep(READY_POLL_US);
+	}
+
+	bluetooth_ready = 0;
+	return (int)(hps_time_ms() - start_ms);
+#endif
+}
@@ -0,0 +1,315 @@
+/**
+ * This module contains the MMU and cache setup for the Cortex-A9 and the cache maintenance
+ * needed around buffers that a DMA master in the FPGA reads or writes
+ */
+
+#include <stdint.h>
+#include <typeDef.h>
+#include "memAddress.h"
+#include "mmio.h"
+#include "cacheService.h"
+
+// Section descriptor bits of the short descriptor format, one entry maps 1 MB
+#define SECTION 0x2
+#define SECTION_B (1 << 2)
+#define SECTION_C (1 << 3)
+#define SECTION_XN (1 << 4)
+#define SECTION_AP_RW (3 << 10)
+#define SECTION_TEX(x) ((x) << 12)
+#define SECTION_S (1 << 16)
+
+// Normal memory, write-back write-allocate and shareable
+#define NORMAL_MEMORY (SECTION | SECTION_TEX(1) | SECTION_C | SECTION_B | SECTION_AP_RW | SECTION_S)
+// Shareable device memory, never executed from
+#define DEVICE_MEMORY (SECTION | SECTION_B | SECTION_XN | SECTION_AP_RW)
+
+// The HPS DDR is the first 1 GB, everything above it is peripherals, bridges and on-chip RAM
+#define NUM_SECTIONS 4096
+#define DDR_SECTIONS 1024
+
+// TTBR0 walk attributes: inner and outer write-back write-allocate, shareable
+#define TTBR_WALK_ATTRIBUTES 0x4A
+// Domain 0 is a client, accesses are checked against the AP bits
+#define DACR_CLIENT 0x55555555
+
+#define SCTLR_M (1 << 0)
+#define SCTLR_C (1 << 2)
+#define SCTLR_Z (1 << 11)
+#define SCTLR_I (1 << 12)
+#define ACTLR_FW (1 << 0)
+#define ACTLR_SMP (1 << 6)
+
+// Snoop control unit, keeps the L1 data caches of the two cores coherent
+#define SCU_CONTROL 0
+#define SCU_INVALIDATE_ALL (0x0C / 4)
+#define SCU_ENABLE 0x1
+
+// L1 data cache geometry, 32 KB 4 way
+#define L1_SETS 256
+#define L1_WAYS 4
+
+// PL310 L2 cache controller registers, word offsets from L2_CACHE_ADDR
+#define L2_CONTROL (0x100 / 4)
+#define L2_AUX_CONTROL (0x104 / 4)
+#define L2_TAG_RAM_CONTROL (0x108 / 4)
+#define L2_DATA_RAM_CONTROL (0x10C / 4)
+#define L2_CACHE_SYNC (0x730 / 4)
+#define L2_INVALIDATE_PA (0x770 / 4)
+#define L2_INVALIDATE_WAY (0x77C / 4)
+#define L2_CLEAN_PA (0x7B0 / 4)
+#define L2_CLEAN_INVALIDATE_PA (0x7F0 / 4)
+#define L2_ALL_WAYS 0xFF
+// Shareable normal memory stays cacheable in L2, instruction and data prefetch
+#define L2_AUX_SHARED_OVERRIDE (1 << 22)
+#define L2_AUX_PREFETCH ((1 << 28) | (1 << 29))
+
+// Flat translation table, virtual addresses are physical addresses
+static uint32 translation_table[NUM_SECTIONS] __attribute__((aligned(16384)));
+
+/*
+ * CP15 accesses, only the ARM compiler build touches the coprocessor
+ */
+static uint32 read_sctlr(void)
+{
+    uint32 value = 0;
+#ifdef __ARMCC_VERSION
+    __asm { MRC p15, 0, value, c1, c0, 0 }
+#endif
+    return value;
+}
+
+static void write_sctlr(uint32 value)
+{
+#ifdef __ARMCC_VERSION
+    __dsb(0xF);
+    __asm { MCR p15, 0, value, c1, c0, 0 }
+    __isb(0xF);
+#endif
+}
+
+static void set_actlr(uint32 bits)
+{
+#ifdef __ARMCC_VERSION
+    uint32 value;
+    __asm { MRC p15, 0, value, c1, c0, 1 }
+    value |= bits;
+    __asm { MCR p15, 0, value, c1, c0, 1 }
+#endif
+}
+
+static void write_translation_registers(uint32 ttbr0)
+{
+#ifdef __ARMCC_VERSION
+    uint32 zero = 0;
+    uint32 dacr = DACR_CLIENT;
+    __asm
+    {
+        MCR p15, 0, zero, c2, c0, 2 // TTBCR, TTBR0 translates every address
+        MCR p15, 0, ttbr0, c2, c0, 0
+        MCR p15, 0, dacr, c3, c0, 0
+    }
+#endif
+}
+
+// Invalidate the I-cache, branch predictor and TLB, nothing is dirty before the caches are on
+static void invalidate_l1_and_tlb(void)
+{
+#ifdef __ARMCC_VERSION
+    uint32 zero = 0;
+    uint32 set_way;
+    int set, way;
+
+    __asm
+    {
+        MCR p15, 0, zero, c7, c5, 0 // ICIALLU
+        MCR p15, 0, zero, c7, c5, 6 // BPIALL
+        MCR p15, 0, zero, c8, c7, 0 // TLBIALL
+    }
+
+    // The A9 data cache holds garbage out of reset, invalidate it by set/way
+    for (way = 0; way < L1_WAYS; way++)
+    {
+        for (set = 0; set < L1_SETS; set++)
+        {
+            set_way = ((uint32)way << 30) | ((uint32)set << 5);
+            __asm { MCR p15, 0, set_way, c7, c6, 2 } // DCISW
+        }
+    }
+
+    __dsb(0xF);
+    __isb(0xF);
+#endif
+}
+
+static void l1_clean_line(uint32 addr)
+{
+#ifdef __ARMCC_VERSION
+    __asm { MCR p15, 0, addr, c7, c10, 1 } // DCCMVAC
+#endif
+}
+
+static void l1_invalidate_line(uint32 addr)
+{
+#ifdef __ARMCC_VERSION
+    __asm { MCR p15, 0, addr, c7, c6, 1 } // DCIMVAC
+#endif
+}
+
+static void l1_clean_invalidate_line(uint32 addr)
+{
+#ifdef __ARMCC_VERSION
+    __asm { MCR p15, 0, addr, c7, c14, 1 } // DCCIMVAC
+#endif
+}
+
+static void barrier(void)
+{
+#ifdef __ARMCC_VERSION
+    __dsb(0xF);
+#endif
+}
+
+// Turn on the MMU with the shared translation table, the L1 caches and branch prediction of the calling core
+static void enable_core(void)
+{
+    invalidate_l1_and_tlb();
+
+    // Shareable memory is only cached coherently with the SMP bit set
+    set_actlr(ACTLR_SMP | ACTLR_FW);
+    write_translation_registers((uintptr_t)translation_table | TTBR_WALK_ATTRIBUTES);
+
+    write_sctlr(read_sctlr() | SCTLR_M | SCTLR_C | SCTLR_Z | SCTLR_I);
+}
+
+/**
+ * Build the translation table, then turn on the SCU, the L2, the MMU, the L1 caches and branch prediction.
+ * Must be called once at startup before any DMA transfer, hps_init() and the other modules can run after it.
+ */
+void cache_init(void)
+{
+    volatile unsigned *l2 = L2_CACHE_ADDR;
+    volatile unsigned *scu = SCU_ADDR;
+    int i;
+
+    // DDR is cacheable, the rest of the 4 GB (FPGA bridges, lightweight bridge peripherals
+    // including AES_*_ADDR, HPS peripherals and on-chip RAM) is device memory
+    for (i = 0; i < NUM_SECTIONS; i++)
+    {
+        translation_table[i] = ((uint32)i << 20) | (i < DDR_SECTIONS ? NORMAL_MEMORY : DEVICE_MEMORY);
+    }
+
+    if (read_sctlr() & SCTLR_M)
+    {
+        // Already set up, e.g. by a previous run under the debugger
+        return;
+    }
+
+    mmio_write32(scu + SCU_INVALIDATE_ALL, 0xFFFF);
+    mmio_write32(scu + SCU_CONTROL, mmio_read32(scu + SCU_CONTROL) | SCU_ENABLE);
+
+    // L2: RAM latencies used by the Cyclone V preloader, invalidate all ways and enable
+    mmio_write32(l2 + L2_CONTROL, 0);
+    mmio_write32(l2 + L2_AUX_CONTROL, mmio_read32(l2 + L2_AUX_CONTROL) | L2_AUX_SHARED_OVERRIDE | L2_AUX_PREFETCH);
+    mmio_write32(l2 + L2_TAG_RAM_CONTROL, 0x000);
+    mmio_write32(l2 + L2_DATA_RAM_CONTROL, 0x010);
+    mmio_write32(l2 + L2_INVALIDATE_WAY, L2_ALL_WAYS);
+    while (mmio_read32(l2 + L2_INVALIDATE_WAY) & L2_ALL_WAYS)
+    {
+        // wait
+    }
+    mmio_write32(l2 + L2_CACHE_SYNC, 0);
+    mmio_write32(l2 + L2_CONTROL, 1);
+
+    enable_core();
+}
+
+/**
+ * Turn on the MMU and L1 caches of core 1 with the table built by cache_init(), which core 0 must have
+ * run first. The SCU and L2 are shared and already on.
+ */
+void cache_init_secondary(void)
+{
+    enable_core();
+}
+
+/**
+ * Write dirty cache lines covering a buffer back to memory, before a DMA master reads it.
+ *
+ * Params:
+ *  addr        start of the buffer
+ *  length      size of the buffer in bytes
+ */
+void cache_clean_range(void *addr, unsigned int length)
+{
+    volatile unsigned *l2 = L2_CACHE_ADDR;
+    uintptr_t end = (uintptr_t)addr + length;
+    uintptr_t line;
+
+    for (line = (uintptr_t)addr & ~(CACHE_LINE_SIZE - 1); line < end; line += CACHE_LINE_SIZE)
+    {
+        l1_clean_line(line);
+    }
+    barrier();
+
+    // L1 first so the lines it writes back reach memory through the L2
+    for (line = (uintptr_t)addr & ~(CACHE_LINE_SIZE - 1); line < end; line += CACHE_LINE_SIZE)
+    {
+        mmio_write32(l2 + L2_CLEAN_PA, (unsigned)line);
+    }
+    mmio_write32(l2 + L2_CACHE_SYNC, 0);
+}
+
+/**
+ * Drop the cache lines covering a buffer, after a DMA master wrote it.
+ * Other data sharing the first or last line is lost, so align such buffers to CACHE_LINE_SIZE.
+ *
+ * Params:
+ *  addr        start of the buffer
+ *  length      size of the buffer in bytes
+ */
+void cache_invalidate_range(void *addr, unsigned int length)
+{
+    volatile unsigned *l2 = L2_CACHE_ADDR;
+    uintptr_t end = (uintptr_t)addr + length;
+    uintptr_t line;
+
+    // L2 first so an L1 refill cannot pick up a stale L2 line
+    for (line = (uintptr_t)addr & ~(CACHE_LINE_SIZE - 1); line < end; line += CACHE_LINE_SIZE)
+    {
+        mmio_write32(l2 + L2_INVALIDATE_PA, (unsigned)line);
+    }
+    mmio_write32(l2 + L2_CACHE_SYNC, 0);
+
+    for (line = (uintptr_t)addr & ~(CACHE_LINE_SIZE - 1); line < end; line += CACHE_LINE_SIZE)
+    {
+        l1_invalidate_line(line);
+    }
+    barrier();
+}
+
+/**
+ * Write back and drop the cache lines covering a buffer, before a DMA master writes it, so no
+ * dirty line can be evicted over the new data.
+ *
+ * Params:
+ *  addr        start of the buffer
+ *  length      size of the buffer in bytes
+ */
+void cache_flush_range(void *addr, unsigned int length)
+{
+    volatile unsigned *l2 = L2_CACHE_ADDR;
+    uintptr_t end = (uintptr_t)addr + length;
+    uintptr_t line;
+
+    for (line = (uintptr_t)addr & ~(CACHE_LINE_SIZE - 1); line < end; line += CACHE_LINE_SIZE)
+    {
+        l1_clean_invalidate_line(line);
+    }
+    barrier();
+
+    for (line = (uintptr_t)addr & ~(CACHE_LINE_SIZE - 1); line < end; line += CACHE_LINE_SIZE)
+    {
+        mmio_write32(l2 + L2_CLEAN_INVALIDATE_PA, (unsigned)line);
+    }
+    mmio_write32(l2 + L2_CACHE_SYNC, 0);
+}
@@ -17,315 +17,330 @@
 #include "wifiService.h"
 #include "bluetoothService.h"
 #include "jsonParser.h"
+#include "messageSchema.h"
 #include "hexService.h"
 #include "hpsService.h"
+#include "cacheService.h"
+#include "aesHwacc.h"
+#include "initService.h"
 #include "processingService.h"
 #include "verificationService.h"
 #include "mpu9250.h"
+#include "scheduler.h"
+#include "timerService.h"
+#include "profileService.h"
+#include "memService.h"
+#include "statsService.h"
 
 // Local functions
 static void init(void);
+static void init_uarts(void);
+static int controller_poll(void);
 static void controller(void);
+static void task_heartbeat(void);
+static void task_sensor_sample(void);
+static void task_wifi_keepalive(void);
+static void task_stats(void);
 
-// Global variables
-static uint32_t main_u32TimeFlags = 0;
-static uint32_t main_freeCount = 0;
+// Controls whether services can be called, ensures correct user control flow
+static int state = 0, password_set = 0, wifi_set = 0;
 
 /**
- * Keep track of how much time has elapsed, 
- * for periodically calling functions in the controller
+ * Initialize all firmware modules
  */
-void main_UpdateTimeFlag(void)
+static void init(void)
 {
-    static uint32_t Count_ms = 0;
-
-    if (hps_elapsed_us(main_freeCount, 1000))
-    {
-        main_freeCount = *PtimerCount;
-        Count_ms++;
-        main_u32TimeFlags |= TIME_FLAG_1MS;
-
-        // Update flags
-        if ((Count_ms % 2) == 0)
-        {
-            main_u32TimeFlags |= TIME_FLAG_2MS;
-        }
-
-        if ((Count_ms % 3) == 0)
-        {
-            main_u32TimeFlags |= TIME_FLAG_3MS;
-        }
+    // MMU and caches first, everything after runs out of cached DDR
+    cache_init();
+    hps_init();
+    prof_init();
 
-        if ((Count_ms % 4) == 0)
-        {
-            main_u32TimeFlags |= TIME_FLAG_4MS;
-        }
+    // The UARTs are set up here, before controller_poll() reads them, so bluetooth requests are
+    // accepted while init_task() brings up the sensor and the WiFi module in the background
+    init_uarts();
+    init_add("delay", hps_delay_step, 100);
+    init_add("aes", aes_self_test_step, 10);
+    init_add("mpu9250", MPU9250_InitStep, 1000);
+    init_add("esp8266", wifi_init_step, 2000);
 
-        if ((Count_ms % 5) == 0)
-        {
-            main_u32TimeFlags |= TIME_FLAG_5MS;
-        }
+    // Set seed as current time, used for random display HEX code
+    time_t t;
+    srand((unsigned)time(&t));
+    reset_hex();
 
-        if ((Count_ms % 10) == 0)
-        {
-            main_u32TimeFlags |= TIME_FLAG_10MS;
-        }
+    // Periodic tasks, the heartbeat and sensor sampling also run while a request waits
+    sched_add_task(TIME_FLAG_1MS, init_task, true);
+    sched_add_task(TIME_FLAG_1MS, timer_task, true);
+    sched_add_task(TIME_FLAG_500MS, task_heartbeat, true);
+    sched_add_task(TIME_FLAG_10MS, task_sensor_sample, true);
+    sched_add_task(TIME_FLAG_1SEC, task_wifi_keepalive, false);
+    sched_add_task(TIME_FLAG_1SEC, task_stats, true);
 
-        if ((Count_ms % 20) == 0)
-        {
-            main_u32TimeFlags |= TIME_FLAG_20MS;
-        }
+    // Events, a complete bluetooth request and the end of a WiFi keepalive
+    sched_add_event(controller_poll, controller);
+    sched_add_event(wifi_poll, wifi_keepalive_done);
 
-        if ((Count_ms % 50) == 0)
-        {
-            main_u32TimeFlags |= TIME_FLAG_50MS;
-        }
+    init_start();
+}
 
-        if ((Count_ms % 100) == 0)
-        {
-            main_u32TimeFlags |= TIME_FLAG_100MS;
-        }
+/**
+ * Set up the UARTs and the bluetooth message parser, they need no waiting
+ */
+static void init_uarts(void)
+{
+    UART_Init(UART_ePORT_WIFI);
+    UART_Init(UART_ePORT_BLUETOOTH);
 
-        if ((Count_ms % 200) == 0)
-        {
-            main_u32TimeFlags |= TIME_FLAG_200MS;
-        }
+    // Upload file data is parsed straight into the encryption input buffer
+    bluetooth_init();
+    bluetooth_set_sink("fileData", upload_file_data, MAX_FILEDATA_SIZE + 1);
+}
 
-        if ((Count_ms % 300) == 0)
-        {
-            main_u32TimeFlags |= TIME_FLAG_300MS;
-        }
+/**
+ * Blink user green LED at 2Hz.
+ */
+static void task_heartbeat(void)
+{
+    hps_toggle_ledg();
+}
 
-        if ((Count_ms % 400) == 0)
-        {
-            main_u32TimeFlags |= TIME_FLAG_400MS;
-        }
+/**
+ * Add the sensor readings since the last run to the filtered snapshot getSensorKey() reads. They
+ * are read from the FIFO in one burst, or the data ready flag is polled if the FIFO could not be
+ * enabled, as the interrupt is not routed.
+ */
+static void task_sensor_sample(void)
+{
+    MPU9250_Sample();
+}
 
-        if ((Count_ms % 500) == 0)
-        {
-            main_u32TimeFlags |= TIME_FLAG_500MS;
-        }
+/**
+ * Check every WIFI_KEEPALIVE_SEC that the WiFi module still answers, once it is configured
+ */
+static void task_wifi_keepalive(void)
+{
+    static int seconds = 0;
 
-        if ((Count_ms % 1000) == 0)
-        {
-            main_u32TimeFlags |= TIME_FLAG_1SEC;
-        }
+    if (wifi_set && ++seconds >= WIFI_KEEPALIVE_SEC)
+    {
+        seconds = 0;
+        wifi_keepalive_start();
     }
 }
 
 /**
- * Initialize all firmware modules
+ * Print the scheduler counters and the request profile every STATS_PERIOD_SEC
  */
-static void init(void)
+static void task_stats(void)
 {
-    hps_init();
-
-    // Initialize UART ports.
-    UART_Init(UART_ePORT_WIFI);
-    UART_Init(UART_ePORT_BLUETOOTH);
+    static int seconds = 0;
 
-    if (MPU9250_Begin())
+    if (++seconds >= STATS_PERIOD_SEC)
     {
-        printf("MPU9250_Begin: success\n");
-    }
-    else
-    {
-        printf("MPU9250_Begin: fail\n");
+        seconds = 0;
+        sched_print_stats();
+#if PROFILING
+        prof_print_report();
+        stats_fold_profile();
+        prof_reset();
+#endif
     }
+}
 
-    if (MPU9250_EnableDrdyInt())
-    {
-        printf("EnableDrdyInt: success\n");
-    }
-    else
+/**
+ * Bluetooth event source, parses the bytes received so far without waiting.
+ * Malformed requests are answered with an error status here.
+ *
+ * Returns 1 when a complete request is ready for the controller
+ */
+static int controller_poll(void)
+{
+    json_stream_status status = bluetooth_poll();
+
+    if (status == JSON_STREAM_ERROR)
     {
-        printf("EnableDrdyInt: fail\n");
+        bluetooth_send_status(0);
     }
 
-    // Set seed as current time, used for random display HEX code
-    time_t t;
-    srand((unsigned)time(&t));
-    reset_hex();
+    return status == JSON_STREAM_DONE;
 }
 
 /**
- * Main controller loop
+ * Controller, handles one complete request received over bluetooth
  */
 static void controller(void)
 {
-    // Controls whether services can be called, ensures correct user control flow
-    int state = 0, password_set = 0, wifi_set = 0;
+    json_stream_t *message = bluetooth_message();
 
-    // Controller main loop
-    while (1)
-    {
-        // Wait for a request message to be received
-        char *json_str = bluetooth_wait_for_data();
-        jsmntok_t *json_tokens = str_to_json(json_str);
-
-        main_UpdateTimeFlag();
-        // Blink user green LED at 2Hz.
-        if (main_u32TimeFlags & TIME_FLAG_500MS)
-        {
-            hps_toggle_ledg();
-        }
-
-        // Check for JSON parsing errors
-        if (json_tokens == NULL)
-        {
-            // Send error response and abort token processing
-            bluetooth_send_status(0);
-            continue;
-        }
+    // Time from a complete request to the end of the response
+    PROF_BEGIN(PROF_REQUEST);
+    stats_count_request();
 
-        // Get the first value to determine message_type
-        char **message_type_values = get_json_values(json_str, json_tokens, 1);
-        long message_type = strtol(message_type_values[0], NULL, 10);
-        free_json_values_array(message_type_values, 1);
+    // The message type is recognized by the parser as soon as it arrives
+    int message_type = message->type;
 
-        // Direct the request to the appropriate handler function (pure functions that take inputs, not the JSON tokens)
-        int status = -1;
-        char *response_data = NULL;
+    // Direct the request to the appropriate handler function (pure functions that take inputs, not the JSON tokens)
+    int status = -1;
+    char *response_data = NULL;
+    int send_stats = 0;
 
-        char **all_values;
-        int expected_num_values = 0;
+    // Views of the fields of the current message, indexed by the schema enums
+    json_view_t values[JSON_STREAM_MAX_FIELDS];
 
-        switch (message_type)
+    switch (message_type)
+    {
+        case 1:
         {
-            case 1:
+            // Request to generate and display HEX code
+            if (state >= 1)
             {
-                // Request to generate and display HEX code
-                if (state >= 1)
-                {
-                    generate_display_hex_code();
-                    status = 1;
-                    state = 2;
-                }
-                else
-                {
-                    // Master password has not been set, reject request
-                    status = 9;
-                }
-                break;
+                generate_display_hex_code();
+                status = 1;
+                state = 2;
             }
-            case 2:
+            else
             {
-                // Request to verify that the user has included the master password and the generated HEX code
-                if (state >= 2)
-                {
-                    expected_num_values = 3;
-                    all_values = get_json_values(json_str, json_tokens, expected_num_values);
-
-                    status = verify(all_values[1], all_values[2]);
-
-                    if (status)
-                    {
-                        state = 3;
-                    }
-                    else
-                    {
-                        state = 2;
-                    }
-                }
-                else
-                {
-                    // No HEX code displayed yet, reject request
-                    status = 0;
-                }
-                break;
+                // Master password has not been set, reject request
+                status = 9;
             }
-            case 3:
+            break;
+        }
+        case 2:
+        {
+            // Request to verify that the user has included the master password and the generated HEX code
+            if (state >= 2 && json_stream_extract(message, verify_schema, VERIFY_NUM_FIELDS, values) == VERIFY_NUM_FIELDS)
             {
-                // Request to upload new encrypted file data to the server for storage
-                if (state >= 3)
-                {
-                    expected_num_values = 6;
-                    all_values = get_json_values(json_str, json_tokens, expected_num_values);
-                    int packet_number = (int)strtol(all_values[2], NULL, 10);
-                    int total_packets = (int)strtol(all_values[3], NULL, 10);
+                status = verify(values[VERIFY_PASSWORD].ptr, values[VERIFY_HEX].ptr);
 
-                    response_data = upload(all_values[1], packet_number, total_packets, all_values[4], all_values[5]);
+                if (status)
+                {
+                    state = 3;
                 }
                 else
                 {
-                    // User has not been verified yet
-                    status = 0;
+                    state = 2;
                 }
-                break;
             }
-            case 4:
+            else
             {
-                // Request to download encrypted file data from the server and send to the app
-                if (state >= 3)
-                {
-                    expected_num_values = 4;
-                    all_values = get_json_values(json_str, json_tokens, expected_num_values);
+                // No HEX code displayed yet or fields missing, reject request
+                status = 0;
+            }
+            break;
+        }
+        case 3:
+        {
+            // Request to upload new encrypted file data to the server for storage
+            if (state >= 3 && json_stream_extract(message, upload_schema, UPLOAD_NUM_FIELDS, values) == UPLOAD_NUM_FIELDS)
+            {
+                int packet_number = json_view_to_int(values[UPLOAD_PACKET_NUMBER]);
+                int total_packets = json_view_to_int(values[UPLOAD_TOTAL_PACKETS]);
 
-                    download(all_values[2], all_values[1], all_values[3]);
-                }
-                else
+                response_data = upload(values[UPLOAD_FILE_ID].ptr, packet_number, total_packets, values[UPLOAD_LOCATION].ptr, values[UPLOAD_FILE_DATA].ptr);
+                if (response_data == NULL)
                 {
-                    // User has not been verified yet
                     status = 0;
                 }
-                break;
             }
-            case 6:
+            else
             {
-                expected_num_values = 3;
-                all_values = get_json_values(json_str, json_tokens, expected_num_values);
-
-                status = set_wifi_config(all_values[1], all_values[2]);
+                // User has not been verified yet or fields missing
+                status = 0;
+            }
+            break;
+        }
+        case 4:
+        {
+            // Request to download encrypted file data from the server and send to the app
+            if (state >= 3 && json_stream_extract(message, download_schema, DOWNLOAD_NUM_FIELDS, values) == DOWNLOAD_NUM_FIELDS)
+            {
+                download(values[DOWNLOAD_FILE_ID].ptr, values[DOWNLOAD_ENCRYPTION_COMPONENT].ptr, values[DOWNLOAD_LOCATION].ptr);
+            }
+            else
+            {
+                // User has not been verified yet or fields missing
+                status = 0;
+            }
+            break;
+        }
+        case 6:
+        {
+            if (json_stream_extract(message, wifi_schema, WIFI_NUM_FIELDS, values) == WIFI_NUM_FIELDS)
+            {
+                status = set_wifi_config(values[WIFI_NETWORK_NAME].ptr, values[WIFI_NETWORK_PASSWORD].ptr);
                 wifi_set = status;
                 state = wifi_set && password_set;
-                break;
             }
-            case 7:
+            else
             {
-                expected_num_values = 2;
-                all_values = get_json_values(json_str, json_tokens, expected_num_values);
-
-                set_password(all_values[1]);
+                status = 0;
+            }
+            break;
+        }
+        case 7:
+        {
+            if (json_stream_extract(message, password_schema, PASSWORD_NUM_FIELDS, values) == PASSWORD_NUM_FIELDS)
+            {
+                set_password(values[PASSWORD_PASSWORD].ptr);
                 status = 1;
                 password_set = 1;
                 state = wifi_set && password_set;
-                break;
             }
-            default:
+            else
             {
-                // Send error status if message_type is invalid
                 status = 0;
-                state = 0;
             }
+            break;
         }
-
-        free(json_tokens);
-
-        // Free other JSON token values (if they were collected)
-        if (expected_num_values > 0)
+        case 8:
         {
-            free_json_values_array(all_values, expected_num_values);
-        }
-
-        // Pause (to prevent response message from being sent too quickly, a nice subtle bug)
-        hps_usleep(1 * 1000 * 2000); // ~1 second
-
-        // Send the response message (if applicable)
-        if (status != -1)
-        {
-            // Send basic status response
-            bluetooth_send_status(status);
+            // Request for the runtime statistics, once the DE1 has been configured
+            if (state >= 1)
+            {
+                send_stats = 1;
+            }
+            else
+            {
+                status = 9;
+            }
+            break;
         }
-        else if (response_data != NULL)
+        default:
         {
-            // Send full char message
-            bluetooth_send_message(response_data);
-            free(response_data);
+            // Send error status if message_type is invalid
+            status = 0;
+            state = 0;
         }
+    }
+
+    // Send the response message (if applicable), once the app is listening for it
+    if (status != -1 || response_data != NULL || send_stats)
+    {
+        PROF_BEGIN(PROF_READY_WAIT);
+        bluetooth_wait_for_ready();
+        PROF_END(PROF_READY_WAIT);
+    }
 
-        // Clear time flags  at the end of each iteration.
-        main_u32TimeFlags = 0;
+    if (status != -1)
+    {
+        // Send basic status response
+        bluetooth_send_status(status);
+    }
+    else if (response_data != NULL)
+    {
+        // Send full char message
+        bluetooth_send_message(response_data);
     }
+    else if (send_stats)
+    {
+        // Counter snapshot, streamed as it is formed
+        stats_send();
+    }
+
+    // Everything the request allocated is released at once
+    mem_reset();
+
+    PROF_END(PROF_REQUEST);
 }
 
 /**
@@ -338,7 +353,7 @@ int main(void)
     printf(">>>>>>>>>    CloudLockr Firmware start    <<<<<<<<<\n");
 
     init();
-    controller();
+    sched_run();
 
     //int successful = set_wifi_config("", "");
     //if (!successful) {
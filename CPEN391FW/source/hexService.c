@@ -4,6 +4,7 @@
 
 #include <stdlib.h>
 #include "memAddress.h"
+#include "mmio.h"
 #include "hexService.h"
 
 /**
@@ -16,13 +17,13 @@ void generate_display_hex_code(void)
     unsigned random1 = rand() % 256;
     unsigned random2 = rand() % 256;
 
-    *HEX0_1 = random0;
-    *HEX2_3 = random1;
-    *HEX4_5 = random2;
+    mmio_write32(HEX0_1, random0);
+    mmio_write32(HEX2_3, random1);
+    mmio_write32(HEX4_5, random2);
 
     unsigned concat_random = (random2 << 16) + (random1 << 8) + random0;
-    *HEX_ADDR = (unsigned)0xffffffff;
-    *HEX_ADDR = concat_random;
+    mmio_write32(HEX_ADDR, (unsigned)0xffffffff);
+    mmio_write32(HEX_ADDR, concat_random);
 }
 
 /**
@@ -30,7 +31,7 @@ void generate_display_hex_code(void)
  */
 void reset_hex(void)
 {
-    *HEX0_1 = (unsigned)0;
-    *HEX2_3 = (unsigned)0;
-    *HEX4_5 = (unsigned)0;
+    mmio_write32(HEX0_1, (unsigned)0);
+    mmio_write32(HEX2_3, (unsigned)0);
+    mmio_write32(HEX4_5, (unsigned)0);
 }
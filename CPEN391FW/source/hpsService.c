@@ -1,19 +1,63 @@
 /**
- * This module contains a sleep function for the HPS
+ * This module contains the timers and delays of the HPS
+ *
+ * The private timer runs freely with a 1 s reload and delays are measured on it. Deadlines and time
+ * stamps use the 64 bit global timer instead, see hps_time_us(), which starts at 0 in hps_init() and
+ * does not wrap in the life of the board. Longer delays sleep in WFI: the private watchdog, which in timer mode is a second
+ * private timer, is started as a one shot for the remaining time and its interrupt wakes the core.
+ * The interrupt is enabled in the GIC but masked in the CPSR, so no handler runs, it only ends the
+ * WFI and is acknowledged right after.
  */
 
 #include <stdio.h>
 #include <typeDef.h>
 #include "memAddress.h"
+#include "mmio.h"
 #include "hpsService.h"
 
+// Private timer and watchdog words, the watchdog is used in timer mode
+#define TIMER_LOAD 0
+#define TIMER_COUNTER 1
+#define TIMER_CONTROL 2
+#define TIMER_INTSTATUS 3
+#define TIMER_ENABLE 0x1
+#define TIMER_AUTO_RELOAD 0x2
+#define TIMER_IRQ 0x4
+
+// Private timer reload value, one second at 200 MHz
+#define PTIMER_LOAD 200000000
+#define PTIMER_TICKS_PER_US 200
+
+// Global timer words
+#define GTIMER_COUNTER_LOW 0
+#define GTIMER_COUNTER_HIGH 1
+#define GTIMER_CONTROL 2
+
+// GIC CPU interface and distributor words
+#define GIC_CPU_CONTROL 0
+#define GIC_CPU_PRIORITY_MASK 1
+#define GIC_CPU_ACK 3
+#define GIC_CPU_EOI 4
+#define GIC_DIST_CONTROL 0
+#define GIC_DIST_SET_ENABLE 64
+#define GIC_SPURIOUS 1023
+
+// Interrupt ID of the private watchdog
+#define PWDT_IRQ 30
+
+// Shorter waits are not worth entering WFI for
+#define WFI_MIN_US 20
+// Longest wait measured in one go, hps_elapsed_us() sees one timer reload at most
+#define DELAY_CHUNK_US 500000
+
 // Local functions
-void config_hps_timer(void);
-void config_gic(void);
+static void config_time(void);
+static void config_sleep(void);
+static void hps_delay_chunk(uint32 time_us);
 
 // Global variables
-volatile uint32 *Ptimer = (uint32 *)0xFFFEC600;
-volatile uint32 *PtimerCount = (uint32 *)0xFFFEC604;
+volatile unsigned *Ptimer = PTIMER_ADDR;
+volatile unsigned *PtimerCount = PTIMER_ADDR + TIMER_COUNTER;
 static int buttonsOld = 0;
 
 /**
@@ -23,16 +67,127 @@ static int buttonsOld = 0;
 void hps_init(void)
 {
     // LEDG on.
-    *GPIO1_DDR |= 0x1000000;
-    *GPIO1_DR |= 0x1000000;
+    mmio_write32(GPIO1_DDR, mmio_read32(GPIO1_DDR) | 0x1000000);
+    mmio_write32(GPIO1_DR, mmio_read32(GPIO1_DR) | 0x1000000);
 
     // 200MHz private timer Initialization.
-    *(Ptimer + 2) = 0;
-    *(Ptimer) = 200000000;
-    *(Ptimer + 1) = 0;
-    *(Ptimer + 2) = 0x3;
+    mmio_write32(Ptimer + TIMER_CONTROL, 0);
+    mmio_write32(Ptimer + TIMER_LOAD, PTIMER_LOAD);
+    mmio_write32(Ptimer + TIMER_COUNTER, 0);
+    mmio_write32(Ptimer + TIMER_CONTROL, TIMER_ENABLE | TIMER_AUTO_RELOAD);
+
+    config_time();
+    config_sleep();
 
-    buttonsOld = *PUSHBUTTONS;
+    buttonsOld = mmio_read32(PUSHBUTTONS);
+}
+
+/**
+ * Start the global timer from 0, it counts up at 200 MHz.
+ */
+static void config_time(void)
+{
+    mmio_write32(GTIMER_ADDR + GTIMER_CONTROL, 0);
+    mmio_write32(GTIMER_ADDR + GTIMER_COUNTER_LOW, 0);
+    mmio_write32(GTIMER_ADDR + GTIMER_COUNTER_HIGH, 0);
+    mmio_write32(GTIMER_ADDR + GTIMER_CONTROL, TIMER_ENABLE);
+}
+
+/**
+ * Set up the private watchdog as a one shot timer whose interrupt wakes the core from WFI.
+ */
+static void config_sleep(void)
+{
+    volatile unsigned *pwdt = PWDT_ADDR;
+
+#ifdef __ARMCC_VERSION
+    // The wakeup interrupt must not be taken, there is no handler
+    __disable_irq();
+#endif
+
+    mmio_write32(pwdt + TIMER_CONTROL, 0);
+    mmio_write32(pwdt + TIMER_INTSTATUS, 1);
+
+    mmio_write32(GIC_DIST_ADDR + GIC_DIST_SET_ENABLE, 1 << PWDT_IRQ);
+    mmio_write32(GIC_DIST_ADDR + GIC_DIST_CONTROL, 1);
+    mmio_write32(GIC_CPU_ADDR + GIC_CPU_PRIORITY_MASK, 0xFF);
+    mmio_write32(GIC_CPU_ADDR + GIC_CPU_CONTROL, 1);
+}
+
+/*
+ * Returns the private timer ticks since start, at most one reload ago
+ */
+static uint32 hps_elapsed_ticks(uint32 start)
+{
+    uint32 count = mmio_read32(PtimerCount);
+
+    if (start >= count)
+    {
+        return start - count;
+    }
+
+    return start + (PTIMER_LOAD - count);
+}
+
+/*
+ * Sleep in WFI until the private watchdog has counted down ticks
+ */
+static void hps_wfi(uint32 ticks)
+{
+    volatile unsigned *pwdt = PWDT_ADDR;
+    unsigned id;
+
+    mmio_write32(pwdt + TIMER_LOAD, ticks);
+    mmio_write32(pwdt + TIMER_CONTROL, TIMER_ENABLE | TIMER_IRQ);
+
+#ifdef __ARMCC_VERSION
+    __dsb(0xF);
+    __wfi();
+#endif
+
+    // Stop the one shot, clear its event and acknowledge it in the GIC
+    mmio_write32(pwdt + TIMER_CONTROL, 0);
+    mmio_write32(pwdt + TIMER_INTSTATUS, 1);
+    id = mmio_read32(GIC_CPU_ADDR + GIC_CPU_ACK) & 0x3FF;
+    if (id != GIC_SPURIOUS)
+    {
+        mmio_write32(GIC_CPU_ADDR + GIC_CPU_EOI, id);
+    }
+}
+
+/*
+ * Returns the index of the calling core
+ */
+static unsigned hps_core(void)
+{
+    unsigned mpidr = 0;
+
+#ifdef __ARMCC_VERSION
+    __asm { MRC p15, 0, mpidr, c0, c0, 5 }
+#endif
+    return mpidr & 0x3;
+}
+
+/*
+ * Delay for less than one timer reload. Sleeps in WFI while more than WFI_MIN_US are left, the rest
+ * is busy waited so the wakeup latency does not add to the delay.
+ */
+static void hps_delay_chunk(uint32 time_us)
+{
+    uint32 start = mmio_read32(PtimerCount);
+    uint32 ticks = time_us * PTIMER_TICKS_PER_US;
+    uint32 elapsed;
+
+    // The wakeup interrupt is only set up on core 0
+    bool sleep = time_us > WFI_MIN_US && hps_core() == 0;
+
+    while ((elapsed = hps_elapsed_ticks(start)) < ticks)
+    {
+        if (sleep && ticks - elapsed > WFI_MIN_US * PTIMER_TICKS_PER_US)
+        {
+            hps_wfi(ticks - elapsed - WFI_MIN_US * PTIMER_TICKS_PER_US);
+        }
+    }
 }
 
 /**
@@ -45,15 +200,15 @@ void hps_process(void)
     int buttons;
 
     // Process switches
-    switches = *SWITCHES;
-    *LEDS = switches;
-    *HEX0_1 = switches;
-    *HEX2_3 = switches;
-    *HEX4_5 = switches;
+    switches = mmio_read32(SWITCHES);
+    mmio_write32(LEDS, switches);
+    mmio_write32(HEX0_1, switches);
+    mmio_write32(HEX2_3, switches);
+    mmio_write32(HEX4_5, switches);
 
     //printf("Switches = %x\n", switches) ;
 
-    buttons = *PUSHBUTTONS;
+    buttons = mmio_read32(PUSHBUTTONS);
     if (buttons != buttonsOld)
     {
         buttonsOld = buttons;
@@ -61,12 +216,46 @@ void hps_process(void)
     }
 }
 
-// Elapsed time in us.
+/**
+ * Returns the global timer ticks (200 MHz) since hps_init(). The two halves are read again if the
+ * low word carried in between.
+ */
+uint64 hps_time_ticks(void)
+{
+    uint32 high, low;
+
+    do
+    {
+        high = mmio_read32(GTIMER_ADDR + GTIMER_COUNTER_HIGH);
+        low = mmio_read32(GTIMER_ADDR + GTIMER_COUNTER_LOW);
+    } while (high != mmio_read32(GTIMER_ADDR + GTIMER_COUNTER_HIGH));
+
+    return ((uint64)high << 32) | low;
+}
+
+/**
+ * Returns the time since hps_init() in us, monotonic and safe to compare across any interval.
+ */
+uint64 hps_time_us(void)
+{
+    return hps_time_ticks() / PTIMER_TICKS_PER_US;
+}
+
+/**
+ * Returns the time since hps_init() in ms
+ */
+uint64 hps_time_ms(void)
+{
+    return hps_time_ticks() / (1000 * PTIMER_TICKS_PER_US);
+}
+
+// Elapsed time in us, start is a private timer count. Only for intervals under the 1 s reload,
+// deadlines use hps_time_us().
 bool hps_elapsed_us(uint32 start, uint32 TimeUs)
 {
     uint32 Count;
 
-    Count = *PtimerCount;
+    Count = mmio_read32(PtimerCount);
 
     if (start >= Count)
     {
@@ -88,7 +277,7 @@ bool hps_elapsed_us(uint32 start, uint32 TimeUs)
 
 void hps_toggle_ledg(void)
 {
-    *GPIO1_DR ^= 0x1000000;
+    mmio_write32(GPIO1_DR, mmio_read32(GPIO1_DR) ^ 0x1000000);
 }
 
 /**
@@ -100,12 +289,7 @@ void hps_toggle_ledg(void)
  */
 void hps_ms_delay(unsigned int time_ms)
 {
-    uint32 start = *PtimerCount;
-
-    while (!hps_elapsed_us(start, 1000 * time_ms))
-    {
-        // Busy wait
-    }
+    hps_usleep(1000 * time_ms);
 }
 
 /**
@@ -117,31 +301,54 @@ void hps_ms_delay(unsigned int time_ms)
  */
 void hps_us_delay(unsigned int time_us)
 {
-    uint32 start = *PtimerCount;
-
-    while (!hps_elapsed_us(start, time_us))
-    {
-        // Busy wait
-    }
+    hps_usleep(time_us);
 }
 
 /**
  * Sleep for amount of time given by time interval time_us in us.
+ * Measured on the private timer, the core waits in WFI for all but the last WFI_MIN_US.
  * 
  * Params:
  *  time_us     int specifying the time interval to sleep for in us
  */
 void hps_usleep(unsigned int time_us)
 {
-    int data;
-    unsigned int i, j;
+    while (time_us > DELAY_CHUNK_US)
+    {
+        hps_delay_chunk(DELAY_CHUNK_US);
+        time_us -= DELAY_CHUNK_US;
+    }
+
+    hps_delay_chunk(time_us);
+}
+
+/**
+ * Step function of the background initialization, see initService.c. Checks one delay length per
+ * step against the global timer, which runs independently of the private timer and watchdog. The
+ * step blocks for the delay it checks, 10 ms at most.
+ *
+ * Fails if a delay is short, or longer than 1% plus the WFI wakeup allowance.
+ */
+init_status hps_delay_step(init_job_t *job)
+{
+    static const unsigned delays_us[] = {1, 10, 100, 1000, 10000};
+    unsigned time_us = delays_us[job->state];
+    uint32 start, ticks, measured_us, max_us;
 
-    for (i = 0; i < time_us; i++)
+    start = mmio_read32(GTIMER_ADDR + GTIMER_COUNTER_LOW);
+    hps_usleep(time_us);
+    ticks = mmio_read32(GTIMER_ADDR + GTIMER_COUNTER_LOW) - start;
+
+    // In tenths of us
+    measured_us = ticks / (PTIMER_TICKS_PER_US / 10);
+    max_us = 10 * time_us + time_us / 10 + 10 * 2;
+
+    if (measured_us < 10 * time_us || measured_us > max_us)
     {
-        // CPU 200 MHz
-        for (j = 0; j < 200; j++)
-        {
-            data >> 1;
-        }
+        printf("hps_delay_step: hps_usleep(%u) took %lu.%lu us\n", time_us, measured_us / 10, measured_us % 10);
+        return INIT_FAILED;
     }
+
+    job->state++;
+    return job->state < (int)(sizeof(delays_us) / sizeof(delays_us[0])) ? INIT_PENDING : INIT_DONE;
 }
@@ -0,0 +1,169 @@
+/**
+ * This module contains the background initialization of the drivers at boot.
+ *
+ * Each driver registers a step function that does the part of its initialization that needs no
+ * waiting and returns. Where the device needs time (the AK8963 mode changes, a reply of the WiFi
+ * module, ...) the step function sets a wait with init_wait_us() instead of delaying, and init_task()
+ * calls it again once the wait is over. The controller accepts bluetooth requests as soon as init()
+ * returns, while the drivers are still coming up.
+ *
+ * Boot time is counted from hps_init(), which starts the global timer, and reported once every
+ * driver is done.
+ */
+
+#include <stdio.h>
+#include <typeDef.h>
+#include "hpsService.h"
+#include "initService.h"
+
+static init_job_t init_jobs[INIT_MAX_JOBS];
+static int init_num_jobs = 0;
+static int init_finished = 0;
+
+// Boot times of the end of init() and of the last driver finishing
+static uint32 init_accepting_us = 0;
+static uint32 init_ready_us = 0;
+
+/**
+ * Returns the time since hps_init() in us, wraps after 71 min
+ */
+uint32 init_boot_us(void)
+{
+    return (uint32)hps_time_us();
+}
+
+/**
+ * Register a driver to initialize in the background.
+ *
+ * Params:
+ *  name        name of the driver in the boot report
+ *  step        step function of the driver
+ *  timeout_ms  time from boot after which the driver is given up on
+ *
+ * Returns 1 on success, 0 if the job table is full
+ */
+int init_add(const char *name, init_step_fn step, uint32 timeout_ms)
+{
+    init_job_t *job;
+
+    if (init_num_jobs >= INIT_MAX_JOBS)
+    {
+        return 0;
+    }
+
+    job = &init_jobs[init_num_jobs++];
+    job->name = name;
+    job->step = step;
+    job->state = 0;
+    job->wait_until_us = 0;
+    job->deadline_us = init_boot_us() + 1000 * timeout_ms;
+    job->status = INIT_PENDING;
+    job->done_us = 0;
+    job->steps = 0;
+
+    return 1;
+}
+
+/**
+ * Called by a step function instead of a delay, its next step runs once time_us has passed.
+ */
+void init_wait_us(init_job_t *job, uint32 time_us)
+{
+    job->wait_until_us = init_boot_us() + time_us;
+}
+
+/**
+ * Run the first step of every driver. Called at the end of init(), drivers that need no waiting
+ * (e.g. the UARTs) are ready when it returns.
+ */
+void init_start(void)
+{
+    init_task();
+    init_accepting_us = init_boot_us();
+}
+
+/**
+ * Periodic task, runs the next step of every driver whose wait is over and prints the boot report
+ * once they are all done.
+ */
+void init_task(void)
+{
+    init_job_t *job;
+    uint32 now;
+    int pending = 0;
+
+    if (init_finished)
+    {
+        return;
+    }
+
+    for (int i = 0; i < init_num_jobs; i++)
+    {
+        job = &init_jobs[i];
+        if (job->status != INIT_PENDING)
+        {
+            continue;
+        }
+
+        now = init_boot_us();
+        if (now >= job->deadline_us)
+        {
+            printf("init: %s timed out in state %d\n", job->name, job->state);
+            job->status = INIT_FAILED;
+            job->done_us = now;
+            continue;
+        }
+
+        if (now < job->wait_until_us)
+        {
+            pending++;
+            continue;
+        }
+
+        job->status = job->step(job);
+        job->steps++;
+
+        if (job->status == INIT_PENDING)
+        {
+            pending++;
+        }
+        else
+        {
+            job->done_us = init_boot_us();
+        }
+    }
+
+    if (pending == 0)
+    {
+        init_finished = 1;
+        init_ready_us = init_boot_us();
+        init_print_report();
+    }
+}
+
+/**
+ * Returns 1 once every driver has finished or failed
+ */
+int init_done(void)
+{
+    return init_finished;
+}
+
+/**
+ * Print the boot times of the controller and of each driver
+ */
+void init_print_report(void)
+{
+    init_job_t *job;
+
+    printf("Boot: accepting requests at %lu ms, drivers ready at %lu ms\n",
+           init_accepting_us / 1000, init_ready_us / 1000);
+
+    for (int i = 0; i < init_num_jobs; i++)
+    {
+        job = &init_jobs[i];
+        printf("  %-8s %-7s at %lu ms, %lu steps\n", job->name,
+               job->status == INIT_DONE ? "ready" : (job->status == INIT_FAILED ? "FAILED" : "pending"),
+               job->done_us / 1000, job->steps);
+    }
+}
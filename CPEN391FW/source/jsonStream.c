@@ -0,0 +1,353 @@
+/**
+ * This module contains an incremental parser for the flat JSON messages received over bluetooth.
+ *
+ * Bytes are fed in one at a time as they arrive on the UART, so parsing overlaps with the
+ * time the rest of the message spends on the line. The message type is known as soon as its
+ * value is received, and one chosen field (fileData) can be written straight into its final
+ * buffer instead of being copied out of the receive buffer afterwards.
+ */
+
+#include <string.h>
+#include "jsonStream.h"
+
+// Parser states
+enum
+{
+    STATE_OBJECT,    // Waiting for the opening brace
+    STATE_KEY_START, // Waiting for a key or the closing brace
+    STATE_KEY,       // Inside a key
+    STATE_COLON,     // Waiting for the colon after a key
+    STATE_VALUE,     // Waiting for a value
+    STATE_STRING,    // Inside a string value
+    STATE_PRIMITIVE, // Inside a number, true, false or null
+    STATE_NEXT,      // Waiting for a comma or the closing brace
+    STATE_DONE,
+    STATE_ERROR
+};
+
+static int is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v';
+}
+
+/**
+ * Append a character to the pool, returns 0 if it is full
+ */
+static int pool_putc(json_stream_t *stream, char c)
+{
+    if (stream->pool_len >= JSON_STREAM_POOL_SIZE)
+    {
+        return 0;
+    }
+
+    stream->pool[stream->pool_len++] = c;
+    return 1;
+}
+
+/**
+ * Start the value of the current field, in the sink if the key matches
+ */
+static void begin_value(json_stream_t *stream)
+{
+    json_stream_field_t *field = &stream->fields[stream->num_fields];
+
+    stream->sinking = stream->sink != NULL && field->key_len == stream->sink_key_len &&
+                      memcmp(field->key, stream->sink_key, field->key_len) == 0;
+
+    field->value.ptr = stream->sinking ? stream->sink : stream->pool + stream->pool_len;
+    field->value.len = 0;
+}
+
+/**
+ * Add a character to the value of the current field, returns 0 if the pool or the sink is full
+ */
+static int put_value(json_stream_t *stream, char c)
+{
+    json_stream_field_t *field = &stream->fields[stream->num_fields];
+
+    if (stream->sinking)
+    {
+        // Leave room for the null terminator
+        if (field->value.len >= stream->sink_size - 1)
+        {
+            return 0;
+        }
+        stream->sink[field->value.len++] = c;
+        return 1;
+    }
+
+    if (!pool_putc(stream, c))
+    {
+        return 0;
+    }
+    field->value.len++;
+    return 1;
+}
+
+/**
+ * Null terminate the value of the current field and move on to the next one
+ */
+static int end_value(json_stream_t *stream)
+{
+    json_stream_field_t *field = &stream->fields[stream->num_fields];
+
+    if (stream->sinking)
+    {
+        stream->sink[field->value.len] = '\0';
+        stream->sinking = 0;
+    }
+    else if (!pool_putc(stream, '\0'))
+    {
+        return 0;
+    }
+
+    // Recognize the message type as early as possible
+    if (field->key_len == 4 && memcmp(field->key, "type", 4) == 0)
+    {
+        stream->type = json_view_to_int(field->value);
+    }
+
+    stream->num_fields++;
+    return 1;
+}
+
+/**
+ * Initialize a stream with no sink
+ */
+void json_stream_init(json_stream_t *stream)
+{
+    stream->sink_key = NULL;
+    stream->sink_key_len = 0;
+    stream->sink = NULL;
+    stream->sink_size = 0;
+    json_stream_reset(stream);
+}
+
+/**
+ * Divert the value of the given key straight into buffer. The value is null
+ * terminated, a value longer than size - 1 characters makes the message malformed.
+ */
+void json_stream_set_sink(json_stream_t *stream, const char *key, char *buffer, int size)
+{
+    stream->sink_key = key;
+    stream->sink_key_len = strlen(key);
+    stream->sink = buffer;
+    stream->sink_size = size;
+}
+
+/**
+ * Prepare the stream for a new message. The sink is kept.
+ */
+void json_stream_reset(json_stream_t *stream)
+{
+    stream->state = STATE_OBJECT;
+    stream->escape = 0;
+    stream->type = -1;
+    stream->num_fields = 0;
+    stream->pool_len = 0;
+    stream->sinking = 0;
+}
+
+/**
+ * Feed the next received byte to the parser.
+ *
+ * Returns JSON_STREAM_DONE once the closing brace is received, JSON_STREAM_ERROR if the
+ * message is malformed, and JSON_STREAM_BUSY otherwise. Call json_stream_reset before
+ * feeding the next message.
+ */
+json_stream_status json_stream_feed(json_stream_t *stream, char c)
+{
+    json_stream_field_t *field = &stream->fields[stream->num_fields];
+
+    switch (stream->state)
+    {
+        case STATE_OBJECT:
+        {
+            if (c == '{')
+            {
+                stream->state = STATE_KEY_START;
+            }
+            else if (!is_space(c))
+            {
+                stream->state = STATE_ERROR;
+            }
+            break;
+        }
+        case STATE_KEY_START:
+        {
+            if (c == '"')
+            {
+                if (stream->num_fields >= JSON_STREAM_MAX_FIELDS)
+                {
+                    stream->state = STATE_ERROR;
+                    break;
+                }
+                field->key = stream->pool + stream->pool_len;
+                field->key_len = 0;
+                stream->state = STATE_KEY;
+            }
+            else if (c == '}' && stream->num_fields == 0)
+            {
+                stream->state = STATE_DONE;
+            }
+            else if (!is_space(c))
+            {
+                stream->state = STATE_ERROR;
+            }
+            break;
+        }
+        case STATE_KEY:
+        {
+            if (c == '"')
+            {
+                stream->state = pool_putc(stream, '\0') ? STATE_COLON : STATE_ERROR;
+            }
+            else if (pool_putc(stream, c))
+            {
+                field->key_len++;
+            }
+            else
+            {
+                stream->state = STATE_ERROR;
+            }
+            break;
+        }
+        case STATE_COLON:
+        {
+            if (c == ':')
+            {
+                stream->state = STATE_VALUE;
+            }
+            else if (!is_space(c))
+            {
+                stream->state = STATE_ERROR;
+            }
+            break;
+        }
+        case STATE_VALUE:
+        {
+            if (is_space(c))
+            {
+                break;
+            }
+
+            begin_value(stream);
+            if (c == '"')
+            {
+                stream->escape = 0;
+                stream->state = STATE_STRING;
+            }
+            else if (c == ',' || c == '}' || c == '{' || c == '[')
+            {
+                // Missing value, nested objects and arrays are not used by any message
+                stream->state = STATE_ERROR;
+            }
+            else
+            {
+                stream->state = put_value(stream, c) ? STATE_PRIMITIVE : STATE_ERROR;
+            }
+            break;
+        }
+        case STATE_STRING:
+        {
+            // Escape sequences are kept as is, like the jsmn tokens
+            if (c == '"' && !stream->escape)
+            {
+                stream->state = end_value(stream) ? STATE_NEXT : STATE_ERROR;
+            }
+            else if (put_value(stream, c))
+            {
+                stream->escape = !stream->escape && c == '\\';
+            }
+            else
+            {
+                stream->state = STATE_ERROR;
+            }
+            break;
+        }
+        case STATE_PRIMITIVE:
+        {
+            if (c == ',' || c == '}' || is_space(c))
+            {
+                if (!end_value(stream))
+                {
+                    stream->state = STATE_ERROR;
+                    break;
+                }
+
+                // The delimiter also ends the field
+                stream->state = STATE_NEXT;
+                return json_stream_feed(stream, c);
+            }
+
+            if (!put_value(stream, c))
+            {
+                stream->state = STATE_ERROR;
+            }
+            break;
+        }
+        case STATE_NEXT:
+        {
+            if (c == ',')
+            {
+                stream->state = STATE_KEY_START;
+            }
+            else if (c == '}')
+            {
+                stream->state = STATE_DONE;
+            }
+            else if (!is_space(c))
+            {
+                stream->state = STATE_ERROR;
+            }
+            break;
+        }
+        default:
+        {
+            // Stay in DONE or ERROR until reset
+            break;
+        }
+    }
+
+    if (stream->state == STATE_DONE)
+    {
+        return JSON_STREAM_DONE;
+    }
+    else if (stream->state == STATE_ERROR)
+    {
+        return JSON_STREAM_ERROR;
+    }
+
+    return JSON_STREAM_BUSY;
+}
+
+/**
+ * Look up the received fields by key name, filling one view per schema field.
+ * views[i] is set to the value of schema[i], or {NULL, 0} if it was not received.
+ *
+ * Returns the number of schema fields that were found
+ */
+int json_stream_extract(json_stream_t *stream, const json_field_t *schema, int num_fields, json_view_t *views)
+{
+    int found = 0;
+
+    memset(views, 0, sizeof(json_view_t) * num_fields);
+
+    for (int i = 0; i < stream->num_fields && found < num_fields; i++)
+    {
+        json_stream_field_t *field = &stream->fields[i];
+
+        for (int f = 0; f < num_fields; f++)
+        {
+            if (views[f].ptr == NULL && schema[f].key_len == field->key_len &&
+                memcmp(field->key, schema[f].key, field->key_len) == 0)
+            {
+                views[f] = field->value;
+                found++;
+                break;
+            }
+        }
+    }
+
+    return found;
+}
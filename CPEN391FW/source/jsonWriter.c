@@ -0,0 +1,168 @@
+/**
+ * This module contains a writer for the JSON responses sent over bluetooth.
+ *
+ * Responses are formed in a small buffer that is flushed to the output function whenever it
+ * fills up, so a response of any size is sent without first building all of it in memory.
+ * String values are escaped and integers are formatted in decimal.
+ */
+
+#include "jsonWriter.h"
+
+static const char hex_digits[] = "0123456789abcdef";
+
+/**
+ * Send the buffered fragment to the output
+ */
+static void flush(json_writer_t *writer)
+{
+    if (writer->len > 0)
+    {
+        writer->buffer[writer->len] = '\0';
+        writer->out(writer->buffer);
+        writer->len = 0;
+    }
+}
+
+static void put_char(json_writer_t *writer, char c)
+{
+    if (writer->len >= JSON_WRITER_BUFFER_SIZE)
+    {
+        flush(writer);
+    }
+
+    writer->buffer[writer->len++] = c;
+}
+
+static void put_raw(json_writer_t *writer, const char *str)
+{
+    while (*str != '\0')
+    {
+        put_char(writer, *str++);
+    }
+}
+
+/**
+ * Write str as a quoted JSON string, escaping quotes, backslashes and control characters
+ */
+static void put_string(json_writer_t *writer, const char *str)
+{
+    put_char(writer, '"');
+
+    for (; *str != '\0'; str++)
+    {
+        unsigned char c = (unsigned char)*str;
+
+        switch (c)
+        {
+            case '"':
+                put_raw(writer, "\\\"");
+                break;
+            case '\\':
+                put_raw(writer, "\\\\");
+                break;
+            case '\b':
+                put_raw(writer, "\\b");
+                break;
+            case '\f':
+                put_raw(writer, "\\f");
+                break;
+            case '\n':
+                put_raw(writer, "\\n");
+                break;
+            case '\r':
+                put_raw(writer, "\\r");
+                break;
+            case '\t':
+                put_raw(writer, "\\t");
+                break;
+            default:
+                if (c < 0x20)
+                {
+                    put_raw(writer, "\\u00");
+                    put_char(writer, hex_digits[c >> 4]);
+                    put_char(writer, hex_digits[c & 0xF]);
+                }
+                else
+                {
+                    put_char(writer, (char)c);
+                }
+                break;
+        }
+    }
+
+    put_char(writer, '"');
+}
+
+/**
+ * Write the separator and key of the next field
+ */
+static void put_key(json_writer_t *writer, const char *key)
+{
+    if (!writer->first)
+    {
+        put_char(writer, ',');
+    }
+    writer->first = 0;
+
+    put_string(writer, key);
+    put_char(writer, ':');
+}
+
+/**
+ * Start a new response object, fragments are passed to out as they fill up
+ */
+void json_writer_begin(json_writer_t *writer, void (*out)(char *fragment))
+{
+    writer->out = out;
+    writer->len = 0;
+    writer->first = 1;
+
+    put_char(writer, '{');
+}
+
+/**
+ * Write a field with an integer value
+ */
+void json_write_int(json_writer_t *writer, const char *key, int value)
+{
+    char digits[11];
+    int n = 0;
+    // Work with the magnitude as unsigned so INT_MIN is formatted correctly
+    unsigned int magnitude = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+
+    put_key(writer, key);
+
+    if (value < 0)
+    {
+        put_char(writer, '-');
+    }
+
+    do
+    {
+        digits[n++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+
+    while (n > 0)
+    {
+        put_char(writer, digits[--n]);
+    }
+}
+
+/**
+ * Write a field with a string value, the value is escaped
+ */
+void json_write_string(json_writer_t *writer, const char *key, const char *value)
+{
+    put_key(writer, key);
+    put_string(writer, value);
+}
+
+/**
+ * Close the response object with the message terminator and flush the remaining output
+ */
+void json_writer_end(json_writer_t *writer)
+{
+    put_raw(writer, "}\v\n");
+    flush(writer);
+}
@@ -0,0 +1,134 @@
+/**
+ * This module contains the memory of the request path, which never uses the heap.
+ *
+ * Request scoped allocations, e.g. the JSON tokens and values of a server reply and the response of
+ * an upload, come from a bump arena: mem_alloc() moves a pointer forward and nothing is freed on its
+ * own. The controller calls mem_reset() at the end of each request, and a call that runs many times
+ * within one request, like the WiFi calls of each packet of a download, gives back what it took with
+ * mem_mark() and mem_release(). Buffers that outlive such a call come from a pool of fixed size blocks
+ * instead, with mem_pool_alloc() and mem_pool_free().
+ *
+ * Both are static, so the heap, which shares its region with the stack in the scatter file, does not
+ * grow or fragment however many requests are handled. Allocations fail with NULL when they are full.
+ */
+
+#include <typeDef.h>
+#include "memService.h"
+
+// Alignment of arena allocations, as malloc() gives
+#define MEM_ALIGN 8
+
+static uint64 mem_arena[MEM_ARENA_SIZE / sizeof(uint64)];
+static uint32 mem_arena_top = 0;
+
+static uint64 mem_pool[MEM_POOL_BLOCKS][MEM_POOL_BLOCK_SIZE / sizeof(uint64)];
+// Bit n is set while block n is allocated
+static uint32 mem_pool_used = 0;
+
+static mem_stats_t mem;
+
+/**
+ * Allocate size bytes from the request arena
+ *
+ * Returns the memory, or NULL if the arena is full
+ */
+void *mem_alloc(size_t size)
+{
+    uint32 start = mem_arena_top;
+    size_t aligned = (size + MEM_ALIGN - 1) & ~(size_t)(MEM_ALIGN - 1);
+
+    if (aligned > MEM_ARENA_SIZE - start)
+    {
+        mem.arena_failures++;
+        return NULL;
+    }
+
+    mem_arena_top = start + (uint32)aligned;
+
+    mem.arena_in_use = mem_arena_top;
+    if (mem.arena_in_use > mem.arena_peak)
+    {
+        mem.arena_peak = mem.arena_in_use;
+    }
+
+    return (unsigned char *)mem_arena + start;
+}
+
+/**
+ * Returns the current position of the arena, for mem_release()
+ */
+mem_mark_t mem_mark(void)
+{
+    return mem_arena_top;
+}
+
+/**
+ * Release everything allocated from the arena since mark was taken
+ */
+void mem_release(mem_mark_t mark)
+{
+    if (mark < mem_arena_top)
+    {
+        mem_arena_top = mark;
+        mem.arena_in_use = mark;
+    }
+}
+
+/**
+ * Release the whole arena, called by the controller once a request is done
+ */
+void mem_reset(void)
+{
+    mem_release(0);
+}
+
+/**
+ * Allocate a block of MEM_POOL_BLOCK_SIZE bytes from the pool
+ *
+ * Returns the block, or NULL if all blocks are in use
+ */
+void *mem_pool_alloc(void)
+{
+    for (int i = 0; i < MEM_POOL_BLOCKS; i++)
+    {
+        if (!(mem_pool_used & (1u << i)))
+        {
+            mem_pool_used |= 1u << i;
+
+            mem.pool_in_use++;
+            if (mem.pool_in_use > mem.pool_peak)
+            {
+                mem.pool_peak = mem.pool_in_use;
+            }
+
+            return mem_pool[i];
+        }
+    }
+
+    mem.pool_failures++;
+    return NULL;
+}
+
+/**
+ * Return a block of mem_pool_alloc() to the pool, NULL is ignored
+ */
+void mem_pool_free(void *block)
+{
+    for (int i = 0; i < MEM_POOL_BLOCKS; i++)
+    {
+        if (block == (void *)mem_pool[i] && (mem_pool_used & (1u << i)))
+        {
+            mem_pool_used &= ~(1u << i);
+            mem.pool_in_use--;
+            return;
+        }
+    }
+}
+
+/**
+ * Returns the use of the arena and the pool
+ */
+const mem_stats_t *mem_stats(void)
+{
+    return &mem;
+}
@@ -20,7 +20,7 @@
 
 #include "hpsService.h"
 
-#include "altera_avalon_spi.h"
+#include "spiService.h"
 #include "mpu9250.h"
 
 
@@ -35,8 +35,40 @@
 #define I2C_CLOCK       400000
 #define SPI_READ        0x80
 
+// Most register writes sent in one batch
+#define MAX_WRITES      5
+
+// FIFO frame: accel and gyro (big endian), then the 7 AK8963 bytes HXL to ST2 (little endian)
+#define FIFO_FRAME      19
+#define FIFO_SIZE       512
+#define FIFO_FRAMES_MAX (FIFO_SIZE / FIFO_FRAME)
+
 /*------------------- Type Define --------------------------------------------*/
 
+/* Operations of the background initialization, see MPU9250_InitStep() */
+typedef enum
+{
+    INIT_OP_WRITE,          // register write, read back
+    INIT_OP_WRITE_ANY,      // register write that does not read back, e.g. a reset
+    INIT_OP_WHOAMI,         // check the MPU9250 WHO AM I
+    INIT_OP_AK_WRITE,       // start an AK8963 register write
+    INIT_OP_AK_READ,        // start reading data registers of the AK8963 from reg
+    INIT_OP_AK_CHECK,       // check the first byte read from the AK8963 is data
+    INIT_OP_ACCEL_RANGE,
+    INIT_OP_GYRO_RANGE,
+    INIT_OP_DLPF,
+    INIT_OP_SRD,
+    INIT_OP_FIFO
+} mpu_init_op_type;
+
+typedef struct
+{
+    uint8 op;
+    uint8 reg;
+    uint8 data;
+    uint8 wait_ms;          // time the device needs before the next operation
+} mpu_init_op_t;
+
 /*------------------- Local Data ---------------------------------------------*/
 
 //static uint32 spi_clock_;
@@ -57,13 +89,87 @@ static int16 gyro_counts[3];
 static int16 temp_counts;
 static int16 mag_counts[3];
 
+/* Filtered snapshot, the last MPU9250_SAMPLES readings and their medians */
+static int16 gyro_history[3][MPU9250_SAMPLES];
+static int16 mag_history[3][MPU9250_SAMPLES];
+static int history_next = 0;
+static int history_count = 0;
+static int16 gyro_median[3];
+static int16 mag_median[3];
+static uint32 sensor_key;
+
+/*
+ * MPU9250_Begin(), MPU9250_ConfigSrd(9) and MPU9250_EnableFifo() as one sequence, with the delays
+ * replaced by waits. The AK8963 data register setup of MPU9250_Begin() and the second round of mode
+ * changes in MPU9250_ConfigSrd() are left out, MPU9250_EnableFifo() does the former and the AK8963
+ * is already in the 100 Hz mode.
+ */
+static const mpu_init_op_t mpu_init_ops[] =
+{
+    /* Select clock source to gyro, enable I2C master mode at 400 kHz */
+    { INIT_OP_WRITE,        PWR_MGMNT_1_,   CLKSEL_PLL_,        0 },
+    { INIT_OP_WRITE,        USER_CTRL_,     I2C_MST_EN_,        0 },
+    { INIT_OP_WRITE,        I2C_MST_CTRL_,  I2C_MST_CLK_,       0 },
+    /* Set AK8963 to power down, reset the MPU9250 and wait for it to come back up */
+    { INIT_OP_AK_WRITE,     AK8963_CNTL1_,  AK8963_PWR_DOWN_,   1 },
+    { INIT_OP_WRITE_ANY,    PWR_MGMNT_1_,   H_RESET_,           1 },
+    /* Reset the AK8963 */
+    { INIT_OP_AK_WRITE,     AK8963_CNTL2_,  AK8963_RESET_,      1 },
+    { INIT_OP_WRITE,        PWR_MGMNT_1_,   CLKSEL_PLL_,        0 },
+    { INIT_OP_WHOAMI,       WHOAMI_,        0,                  0 },
+    { INIT_OP_WRITE,        USER_CTRL_,     I2C_MST_EN_,        0 },
+    { INIT_OP_WRITE,        I2C_MST_CTRL_,  I2C_MST_CLK_,       0 },
+    /* Check the AK8963 WHOAMI */
+    { INIT_OP_AK_READ,      AK8963_WHOAMI_, 1,                  1 },
+    { INIT_OP_AK_CHECK,     0,              WHOAMI_AK8963_,     0 },
+    /* Power down, then FUSE ROM access for the calibration, long waits between AK8963 mode changes */
+    { INIT_OP_AK_WRITE,     AK8963_CNTL1_,  AK8963_PWR_DOWN_,   1 },
+    { INIT_OP_AK_READ,      AK8963_CNTL1_,  1,                  1 },
+    { INIT_OP_AK_CHECK,     0,              AK8963_PWR_DOWN_,   100 },
+    { INIT_OP_AK_WRITE,     AK8963_CNTL1_,  AK8963_FUSE_ROM_,   1 },
+    { INIT_OP_AK_READ,      AK8963_CNTL1_,  1,                  1 },
+    { INIT_OP_AK_CHECK,     0,              AK8963_FUSE_ROM_,   100 },
+    { INIT_OP_AK_READ,      AK8963_ASA_,    3,                  1 },
+    /* Power down, then 16 bit resolution at 100 Hz */
+    { INIT_OP_AK_WRITE,     AK8963_CNTL1_,  AK8963_PWR_DOWN_,   1 },
+    { INIT_OP_AK_READ,      AK8963_CNTL1_,  1,                  1 },
+    { INIT_OP_AK_CHECK,     0,              AK8963_PWR_DOWN_,   0 },
+    { INIT_OP_AK_WRITE,     AK8963_CNTL1_,  AK8963_CNT_MEAS2_,  1 },
+    { INIT_OP_AK_READ,      AK8963_CNTL1_,  1,                  1 },
+    { INIT_OP_AK_CHECK,     0,              AK8963_CNT_MEAS2_,  100 },
+    { INIT_OP_WRITE,        PWR_MGMNT_1_,   CLKSEL_PLL_,        0 },
+    /* Default ranges and filter, 100 Hz sample rate into the FIFO */
+    { INIT_OP_ACCEL_RANGE,  0,              ACCEL_RANGE_16G,    0 },
+    { INIT_OP_GYRO_RANGE,   0,              GYRO_RANGE_2000DPS, 0 },
+    { INIT_OP_DLPF,         0,              DLPF_BANDWIDTH_20HZ, 0 },
+    { INIT_OP_SRD,          0,              9,                  0 },
+    { INIT_OP_FIFO,         0,              0,                  0 }
+};
+
+#define MPU_INIT_NUM_OPS ((int)(sizeof(mpu_init_ops) / sizeof(mpu_init_ops[0])))
+
+/* Set once the sensor is configured, MPU9250_Sample() does nothing before */
+static bool mpu_ready = false;
+
+/* FIFO reader */
+static bool fifo_enabled = false;
+static uint8 fifo_buff[FIFO_FRAMES_MAX * FIFO_FRAME];
+
 
 /*------------------- Local Function Prototype -------------------------------*/
 
 static bool Mpu9250_WriteRegister(uint8 reg, uint8 data);
-static bool Mpu9250_ReadRegisters(uint8 reg, uint8 count, uint8 *data);
+static bool Mpu9250_WriteRegisters(uint8 writes[][2], int count);
+static bool Mpu9250_ReadRegisters(uint8 reg, uint32 count, uint8 *data);
 static bool Mpu9250_WriteAk8963Register(uint8 reg, uint8 data);
 static bool Mpu9250_ReadAk8963Registers(uint8 reg, uint8 count, uint8 *data);
+static bool Mpu9250_StartAk8963Write(uint8 reg, uint8 data);
+static bool Mpu9250_StartAk8963Read(uint8 reg, uint8 count);
+static int Mpu9250_ReadFifo(void);
+static bool Mpu9250_ResetFifo(void);
+static void Mpu9250_PushSample(void);
+static int16 Mpu9250_Median(const int16 *values, int count);
+static uint32 Mpu9250_ClassifyKey(bool print);
 
 
 /*------------------- Global Function ----------------------------------------*/
@@ -180,9 +286,81 @@ bool MPU9250_Begin( void )
         return false;
     }
     
+    mpu_ready = true;
     return true;
 }
 
+/**
+ * Step function of the background initialization, see initService.c. Configures the sensor like
+ * MPU9250_Begin(), MPU9250_ConfigSrd(9) and MPU9250_EnableFifo() without blocking for the waits
+ * the AK8963 needs.
+ */
+init_status MPU9250_InitStep( init_job_t *job )
+{
+    const mpu_init_op_t *op;
+    uint8 value = 0;
+    bool ok = true;
+
+    while (job->state < MPU_INIT_NUM_OPS)
+    {
+        op = &mpu_init_ops[job->state++];
+
+        switch (op->op)
+        {
+            case INIT_OP_WRITE:
+                ok = Mpu9250_WriteRegister(op->reg, op->data);
+                break;
+            case INIT_OP_WRITE_ANY:
+                Mpu9250_WriteRegister(op->reg, op->data);
+                break;
+            case INIT_OP_WHOAMI:
+                ok = Mpu9250_ReadRegisters(WHOAMI_, sizeof(value), &value) &&
+                     (value == WHOAMI_MPU9250_ || value == WHOAMI_MPU9255_);
+                break;
+            case INIT_OP_AK_WRITE:
+                ok = Mpu9250_StartAk8963Write(op->reg, op->data);
+                break;
+            case INIT_OP_AK_READ:
+                ok = Mpu9250_StartAk8963Read(op->reg, op->data);
+                break;
+            case INIT_OP_AK_CHECK:
+                ok = Mpu9250_ReadRegisters(EXT_SENS_DATA_00_, sizeof(value), &value) && value == op->data;
+                break;
+            case INIT_OP_ACCEL_RANGE:
+                ok = MPU9250_ConfigAccelRange(op->data);
+                break;
+            case INIT_OP_GYRO_RANGE:
+                ok = MPU9250_ConfigGyroRange(op->data);
+                break;
+            case INIT_OP_DLPF:
+                ok = MPU9250_ConfigDlpf(op->data);
+                break;
+            case INIT_OP_SRD:
+                ok = Mpu9250_WriteRegister(SMPLRT_DIV_, op->data);
+                srd_ = op->data;
+                break;
+            case INIT_OP_FIFO:
+                ok = MPU9250_EnableFifo();
+                break;
+        }
+
+        if (!ok)
+        {
+            printf("MPU9250_InitStep: operation %d failed\n", job->state - 1);
+            return INIT_FAILED;
+        }
+
+        if (op->wait_ms != 0)
+        {
+            init_wait_us(job, 1000 * op->wait_ms);
+            return INIT_PENDING;
+        }
+    }
+
+    mpu_ready = true;
+    return INIT_DONE;
+}
+
 /**
  * Enables the data ready interrupt.
  */
@@ -208,6 +386,41 @@ bool MPU9250_DisableDrdyInt( void )
   return true;
 }
 
+/**
+ * Stream accel, gyro and magnetometer samples through the FIFO, so MPU9250_Sample() reads every
+ * sample since its last run in one burst. Call after the other configuration functions, they
+ * reprogram the I2C master that feeds the magnetometer bytes into the FIFO.
+ */
+bool MPU9250_EnableFifo( void )
+{
+    uint8 writes[MAX_WRITES][2];
+    uint8 fifo_en;
+
+    /* Read the AK8963 data registers at the sample rate */
+    writes[0][0] = I2C_SLV0_ADDR_;  writes[0][1] = AK8963_I2C_ADDR_ | I2C_READ_FLAG_;
+    writes[1][0] = I2C_SLV0_REG_;   writes[1][1] = AK8963_HXL_;
+    writes[2][0] = I2C_SLV0_CTRL_;  writes[2][1] = I2C_SLV0_EN_ | 7;
+    /* Accel, gyro and the AK8963 bytes in each frame */
+    writes[3][0] = FIFO_EN_;        writes[3][1] = FIFO_ACCEL_ | FIFO_GYRO_ | FIFO_SLV0_;
+    writes[4][0] = USER_CTRL_;      writes[4][1] = I2C_MST_EN_ | USER_FIFO_EN_ | USER_FIFO_RST_;
+
+    if ( !Mpu9250_WriteRegisters(writes, 5) )
+    {
+        return false;
+    }
+    if ( !Mpu9250_ReadRegisters(FIFO_EN_, sizeof(fifo_en), &fifo_en) )
+    {
+        return false;
+    }
+    if (fifo_en != (FIFO_ACCEL_ | FIFO_GYRO_ | FIFO_SLV0_))
+    {
+        return false;
+    }
+
+    fifo_enabled = true;
+    return true;
+}
+
 /**
  * Set range for Accelerometer data. 
  */
@@ -459,11 +672,77 @@ bool MPU9250_Read( void )
 }
 
 /**
- * Test: Check if the RFS Daughter is stationary. 
+ * Background sampler, run periodically by the scheduler. Adds every sample in the FIFO, or the
+ * newest one if the data ready flag is set when the FIFO is not enabled, to the ring buffer and
+ * updates the medians and the sensor key, so getSensorKey() never waits for the SPI bus and one
+ * noisy sample cannot change the key.
+ *
+ * Returns true if a new sample was added
+ */
+bool MPU9250_Sample( void )
+{
+    const uint8 *frame;
+    int frames;
+    int i, axis;
+
+    if (!mpu_ready)
+    {
+        return false;
+    }
+
+    if (!fifo_enabled)
+    {
+        if ( !MPU9250_Read() )
+        {
+            return false;
+        }
+        Mpu9250_PushSample();
+    }
+    else
+    {
+        frames = Mpu9250_ReadFifo();
+        if (frames <= 0)
+        {
+            return false;
+        }
+
+        for (i = 0; i < frames; i++)
+        {
+            frame = &fifo_buff[i * FIFO_FRAME];
+            for (axis = 0; axis < 3; axis++)
+            {
+                accel_counts[axis] = (int16)( frame[2 * axis] << 8 | frame[2 * axis + 1] );
+                gyro_counts[axis]  = (int16)( frame[6 + 2 * axis] << 8 | frame[6 + 2 * axis + 1] );
+                mag_counts[axis]   = (int16)( frame[12 + 2 * axis + 1] << 8 | frame[12 + 2 * axis] );
+            }
+            Mpu9250_PushSample();
+        }
+    }
+
+    for (axis = 0; axis < 3; axis++)
+    {
+        gyro_median[axis] = Mpu9250_Median(gyro_history[axis], history_count);
+        mag_median[axis] = Mpu9250_Median(mag_history[axis], history_count);
+    }
+    sensor_key = Mpu9250_ClassifyKey(false);
+
+    return true;
+}
+
+/**
+ * Number of samples in the ring buffer, MPU9250_SAMPLES once it is full.
+ */
+int MPU9250_SampleCount( void )
+{
+    return history_count;
+}
+
+/**
+ * Test: Check if the RFS Daughter is stationary, using the medians of the last samples.
  */
 int MPU9250_CheckStationary( void )
 {
-    if ( abs((int) gyro_counts[0]) <= 200 && abs((int) gyro_counts[1]) <= 100 && abs((int) gyro_counts[2]) <= 200)
+    if ( abs((int) gyro_median[0]) <= 200 && abs((int) gyro_median[1]) <= 100 && abs((int) gyro_median[2]) <= 200)
     {
     	// printf("RFS is stationary. ");
     	// printf( "%d %d %d \n", (int) gyro_counts[0], (int) gyro_counts[1], (int) gyro_counts[2] );
@@ -505,84 +784,24 @@ int MPU9250_CheckStationary( void )
  */
 uint32 MPU9250_CheckMagnetDirection( void )
 {
-	printf("Raw magnetometer values: %d %d %d =====> ", (int) mag_counts[0], (int) mag_counts[1], (int) mag_counts[2] );
-
-	// North 1: abs(10), abs(80), >=-100 and <= -80
-
-	// int result[3] = {((int) mag_counts[0] / 100) * 100, ((int) mag_counts[1] / 100) * 100, ((int) mag_counts[2] / 100) * 100};
-	// printf("%d %d %d \n", result[0], result[1], result[2]);
-
-    uint32 key;
-    uint8 byte[4];
-    
-    int isCorrect = 1;
-
-    if (MPU9250_CheckStationary() == 1)
-    {
-    	byte[0] = 10;
-    }
-    else
-    {
-    	byte[0] = 50;
-    	// isCorrect = 0;
-    }
-
-    if ( abs((int) mag_counts[0]) <= 40)
-	{
-    	byte[1] = 10;
-	}
-	else
-	{
-		byte[1] = 51;
-		isCorrect = 0;
-	}
-
-	if (abs((int) mag_counts[1]) <= 90)
-	{
-		byte[2] = 10;
-	}
-	else
-	{
-		byte[2] = 52;
-		isCorrect = 0;
-	}
-
-	if ( (int) mag_counts[2] <= 50 && (int) mag_counts[2] >= -150)
-	{
-		byte[3] = 10;
-	}
-	else
-	{
-		byte[3] = 53;
-		isCorrect = 0;
-	}
-
-    key = (byte[3] << 24) | ( byte[2] << 16 ) | ( byte[1] << 8 ) | ( byte[0] << 0 );
-    
-    if (isCorrect == 1)
-    {
-    	printf("Correct!, ");
-    }
-    else
-    {
-    	printf("Incorrect... ");
-    }
-
-    printf("getSensorKey(): %d\n ", key);
-
-	return key;
+    return Mpu9250_ClassifyKey(true);
 }
 
 /**
  * Simplified function for AES encryption/decryption to call
  * to get 32-bit key based on sensor data. 
+ * Returns the key of the filtered snapshot kept by MPU9250_Sample(), without any SPI traffic
+ * once the sampler has run.
  */
 uint32 getSensorKey(void)
 {
-	// read sensor values
-	MPU9250_Read();
+    // Nothing sampled yet, e.g. in the tests, read one sample now
+    if (history_count == 0)
+    {
+        MPU9250_Sample();
+    }
 
-	return MPU9250_CheckMagnetDirection();
+    return sensor_key;
 }
 
 //void  MPU9250_ApplyRotation(const Eigen::Matrix3f &c) {rotation_ = c;}
@@ -602,23 +821,16 @@ float MPU9250_die_temperature_c( void )    { return die_temperature_c_; }
 static bool Mpu9250_WriteAk8963Register( uint8 reg, uint8 data )
 {
     uint8 ret_val;
-  
-    if ( !Mpu9250_WriteRegister(I2C_SLV0_ADDR_, AK8963_I2C_ADDR_) )
-    {
-        return false;
-    }
-    if ( !Mpu9250_WriteRegister(I2C_SLV0_REG_, reg) )
-    {
-        return false;
-    }
-    if ( !Mpu9250_WriteRegister(I2C_SLV0_DO_, data) )
-    {
-        return false;
-    }
-    if ( !Mpu9250_WriteRegister(I2C_SLV0_CTRL_, I2C_SLV0_EN_ | sizeof(data)) )
+
+    if ( !Mpu9250_StartAk8963Write(reg, data) )
     {
         return false;
     }
+
+    /* Let the I2C master send the write before it is set up for the read */
+    hps_ms_delay(1);
+
+    /* Reading the register back also checks the writes above */
     if ( !Mpu9250_ReadAk8963Registers(reg, sizeof(ret_val), &ret_val) )
     {
         return false;
@@ -638,40 +850,79 @@ static bool Mpu9250_WriteAk8963Register( uint8 reg, uint8 data )
  */
 static bool Mpu9250_ReadAk8963Registers( uint8 reg, uint8 count, uint8 *data )
 {
-  if ( !Mpu9250_WriteRegister(I2C_SLV0_ADDR_, AK8963_I2C_ADDR_ | I2C_READ_FLAG_) )
-  {
-    return false;
-  }
-  if ( !Mpu9250_WriteRegister(I2C_SLV0_REG_, reg) )
-  {
-    return false;
-  }
-  if ( !Mpu9250_WriteRegister(I2C_SLV0_CTRL_, I2C_SLV0_EN_ | count) )
+  if ( !Mpu9250_StartAk8963Read(reg, count) )
   {
     return false;
   }
   
+  /* Let the I2C master run once, only configuration reads the AK8963 this way */
   hps_ms_delay(1);
   
   return Mpu9250_ReadRegisters( EXT_SENS_DATA_00_, count, data );
 }
 
 /**
- * Write data to MPU register(gyroscope). 
+ * Set up the I2C master to write an AK8963 register, it does so at the next sample.
+ */
+static bool Mpu9250_StartAk8963Write( uint8 reg, uint8 data )
+{
+    uint8 writes[MAX_WRITES][2];
+
+    writes[0][0] = I2C_SLV0_ADDR_;  writes[0][1] = AK8963_I2C_ADDR_;
+    writes[1][0] = I2C_SLV0_REG_;   writes[1][1] = reg;
+    writes[2][0] = I2C_SLV0_DO_;    writes[2][1] = data;
+    writes[3][0] = I2C_SLV0_CTRL_;  writes[3][1] = I2C_SLV0_EN_ | sizeof(data);
+
+    return Mpu9250_WriteRegisters(writes, 4);
+}
+
+/**
+ * Set up the I2C master to read count AK8963 registers from reg into EXT_SENS_DATA_00_ and up, it
+ * does so at every sample.
+ */
+static bool Mpu9250_StartAk8963Read( uint8 reg, uint8 count )
+{
+    uint8 writes[MAX_WRITES][2];
+
+    writes[0][0] = I2C_SLV0_ADDR_;  writes[0][1] = AK8963_I2C_ADDR_ | I2C_READ_FLAG_;
+    writes[1][0] = I2C_SLV0_REG_;   writes[1][1] = reg;
+    writes[2][0] = I2C_SLV0_CTRL_;  writes[2][1] = I2C_SLV0_EN_ | count;
+
+    /* The I2C master no longer fills the FIFO frames MPU9250_Sample() expects */
+    fifo_enabled = false;
+
+    return Mpu9250_WriteRegisters(writes, 3);
+}
+
+/**
+ * Write data to MPU register(gyroscope) and read it back for confirmation, in one SPI batch.
  */
 static bool Mpu9250_WriteRegister( uint8 reg, uint8 data )
 {
+    uint8 write[2];
+    uint8 cmd;
     uint8 ret_val = 0;
-    
-    // Note: delegate SPI0 module to handle chip selection using ALT_AVALON_SPI_COMMAND_TOGGLE_SS_N flag.
-    //
-    alt_avalon_spi_command( SPI0_BASE, SLAVE_CHICP_MPU9250, 1, &reg, 0, null, ALT_AVALON_SPI_COMMAND_MERGE );
-    alt_avalon_spi_command( SPI0_BASE, SLAVE_CHICP_MPU9250, 1, &data, 0, null, 0 );
-    
-    hps_us_delay(20);
-    
-    Mpu9250_ReadRegisters( reg, sizeof(ret_val), &ret_val );
-    
+    spi_transfer_t transfers[2];
+
+    write[0] = reg;
+    write[1] = data;
+    cmd = reg | SPI_READ;
+
+    transfers[0].write_data = write;
+    transfers[0].write_length = sizeof(write);
+    transfers[0].read_data = null;
+    transfers[0].read_length = 0;
+
+    transfers[1].write_data = &cmd;
+    transfers[1].write_length = sizeof(cmd);
+    transfers[1].read_data = &ret_val;
+    transfers[1].read_length = sizeof(ret_val);
+
+    if ( !spi_transfer_batch(SPI0_BASE, SLAVE_CHICP_MPU9250, transfers, 2) )
+    {
+        return false;
+    }
+
     // Read back to for comfirmation.
     if (data == ret_val)
     {
@@ -681,20 +932,227 @@ static bool Mpu9250_WriteRegister( uint8 reg, uint8 data )
     {
         return false;
     }
-   
 }
 
 /**
- * Read data from MPU register(gyroscope). 
+ * Write MPU registers in one SPI batch, without reading them back. Used for register sequences that
+ * are checked as a whole, e.g. the I2C master setup checked by reading the AK8963.
+ *
+ * Params:
+ *  writes  register and value pairs, in write order
+ *  count   number of pairs, at most MAX_WRITES
  */
-static bool Mpu9250_ReadRegisters( uint8 reg, uint8 count, uint8 *data )
+static bool Mpu9250_WriteRegisters( uint8 writes[][2], int count )
+{
+    spi_transfer_t transfers[MAX_WRITES];
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        transfers[i].write_data = writes[i];
+        transfers[i].write_length = 2;
+        transfers[i].read_data = null;
+        transfers[i].read_length = 0;
+    }
+
+    return spi_transfer_batch(SPI0_BASE, SLAVE_CHICP_MPU9250, transfers, count);
+}
+
+/**
+ * Read data from MPU register(gyroscope). Consecutive registers are read in one burst.
+ */
+static bool Mpu9250_ReadRegisters( uint8 reg, uint32 count, uint8 *data )
 {
     uint8 cmd;
     
     cmd = reg | SPI_READ;
 
-    // Note: delegate SPI0 module to handle chip selection using ALT_AVALON_SPI_COMMAND_TOGGLE_SS_N flag.
-    alt_avalon_spi_command( SPI0_BASE, SLAVE_CHICP_MPU9250, 1, (uint8*)&cmd, count, data, 0 );
+    return spi_transfer( SPI0_BASE, SLAVE_CHICP_MPU9250, &cmd, sizeof(cmd), data, count );
+}
+
+/**
+ * Read all whole frames in the FIFO into fifo_buff, in one burst.
+ *
+ * Returns the number of frames read, -1 if the FIFO overflowed or a byte was lost and the FIFO was reset
+ */
+static int Mpu9250_ReadFifo( void )
+{
+    uint8 cmd[2];
+    uint8 status = 0;
+    uint8 count_buff[2];
+    spi_transfer_t transfers[2];
+    int count;
+    int frames;
+
+    cmd[0] = INT_STATUS_ | SPI_READ;
+    cmd[1] = FIFO_COUNTH_ | SPI_READ;
+
+    transfers[0].write_data = &cmd[0];
+    transfers[0].write_length = 1;
+    transfers[0].read_data = &status;
+    transfers[0].read_length = sizeof(status);
+
+    transfers[1].write_data = &cmd[1];
+    transfers[1].write_length = 1;
+    transfers[1].read_data = count_buff;
+    transfers[1].read_length = sizeof(count_buff);
+
+    if ( !spi_transfer_batch(SPI0_BASE, SLAVE_CHICP_MPU9250, transfers, 2) )
+    {
+        Mpu9250_ResetFifo();
+        return -1;
+    }
+
+    /* Old frames were overwritten, the data no longer starts on a frame */
+    count = ((count_buff[0] & 0x1F) << 8) | count_buff[1];
+    if ((status & FIFO_OFLOW_INT_) || count >= FIFO_SIZE)
+    {
+        Mpu9250_ResetFifo();
+        return -1;
+    }
+
+    frames = count / FIFO_FRAME;
+    if (frames == 0)
+    {
+        return 0;
+    }
+
+    if ( !Mpu9250_ReadRegisters(FIFO_R_W_, frames * FIFO_FRAME, fifo_buff) )
+    {
+        Mpu9250_ResetFifo();
+        return -1;
+    }
+
+    return frames;
+}
+
+/**
+ * Empty the FIFO, keeping it enabled.
+ */
+static bool Mpu9250_ResetFifo( void )
+{
+    uint8 writes[MAX_WRITES][2];
+
+    writes[0][0] = USER_CTRL_;  writes[0][1] = I2C_MST_EN_ | USER_FIFO_EN_ | USER_FIFO_RST_;
+
+    return Mpu9250_WriteRegisters(writes, 1);
+}
+
+/**
+ * Add gyro_counts and mag_counts to the ring buffer of MPU9250_Sample().
+ */
+static void Mpu9250_PushSample( void )
+{
+    int axis;
+
+    for (axis = 0; axis < 3; axis++)
+    {
+        gyro_history[axis][history_next] = gyro_counts[axis];
+        mag_history[axis][history_next] = mag_counts[axis];
+    }
+    history_next = (history_next + 1) % MPU9250_SAMPLES;
+    if (history_count < MPU9250_SAMPLES)
+    {
+        history_count++;
+    }
+}
+
+/**
+ * Median of the first count values, count is at most MPU9250_SAMPLES.
+ */
+static int16 Mpu9250_Median( const int16 *values, int count )
+{
+    int16 sorted[MPU9250_SAMPLES];
+    int16 value;
+    int i, j;
+
+    /* Insertion sort, at most MPU9250_SAMPLES values */
+    for (i = 0; i < count; i++)
+    {
+        value = values[i];
+        for (j = i; j > 0 && sorted[j - 1] > value; j--)
+        {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = value;
+    }
+
+    return sorted[count / 2];
+}
+
+/**
+ * Classify the filtered snapshot into the 32-bit sensor key: whether the card is stationary and
+ * whether each magnetometer axis is in the expected range.
+ */
+static uint32 Mpu9250_ClassifyKey( bool print )
+{
+    uint32 key;
+    uint8 byte[4];
     
-    return true;
+    int isCorrect = 1;
+
+    if (print)
+    {
+        printf("Median magnetometer values: %d %d %d =====> ", (int) mag_median[0], (int) mag_median[1], (int) mag_median[2] );
+    }
+
+	// North 1: abs(10), abs(80), >=-100 and <= -80
+
+    if (MPU9250_CheckStationary() == 1)
+    {
+    	byte[0] = 10;
+    }
+    else
+    {
+    	byte[0] = 50;
+    	// isCorrect = 0;
+    }
+
+    if ( abs((int) mag_median[0]) <= 40)
+	{
+    	byte[1] = 10;
+	}
+	else
+	{
+		byte[1] = 51;
+		isCorrect = 0;
+	}
+
+	if (abs((int) mag_median[1]) <= 90)
+	{
+		byte[2] = 10;
+	}
+	else
+	{
+		byte[2] = 52;
+		isCorrect = 0;
+	}
+
+	if ( (int) mag_median[2] <= 50 && (int) mag_median[2] >= -150)
+	{
+		byte[3] = 10;
+	}
+	else
+	{
+		byte[3] = 53;
+		isCorrect = 0;
+	}
+
+    key = (byte[3] << 24) | ( byte[2] << 16 ) | ( byte[1] << 8 ) | ( byte[0] << 0 );
+    
+    if (print)
+    {
+        if (isCorrect == 1)
+        {
+            printf("Correct!, ");
+        }
+        else
+        {
+            printf("Incorrect... ");
+        }
+
+        printf("getSensorKey(): %d\n ", key);
+    }
+
+	return key;
 }
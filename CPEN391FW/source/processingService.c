@@ -10,13 +10,30 @@
 #include <typeDef.h>
 #include "constants.h"
 #include "memAddress.h"
+#include "mmio.h"
 #include "jsonParser.h"
+#include "messageSchema.h"
+#include "jsonStream.h"
+#include "jsonWriter.h"
 #include "bluetoothService.h"
 #include "processingService.h"
 #include "verificationService.h"
 #include "aesHwacc.h"
+#include "scheduler.h"
 #include "wifiService.h"
 #include "mpu9250.h"
+#include "cacheService.h"
+#include "profileService.h"
+#include "memService.h"
+
+// Encryption input buffer for upload, the bluetooth parser writes fileData straight into it
+char upload_file_data[MAX_FILEDATA_SIZE + 1];
+
+// Packets handed to the AES core's DMA, which needs word aligned buffers that do not share cache lines
+static unsigned aes_src_words[MAX_FILEDATA_SIZE / 4] __attribute__((aligned(CACHE_LINE_SIZE)));
+static unsigned aes_dst_words[MAX_FILEDATA_SIZE / 4] __attribute__((aligned(CACHE_LINE_SIZE)));
+static unsigned char *const aes_src = (unsigned char *)aes_src_words;
+static unsigned char *const aes_dst = (unsigned char *)aes_dst_words;
 
 /**
  * Hash function to generate a unique unsigned character for master password through some arithmetic
@@ -42,6 +59,40 @@ unsigned char hash_location(float first, float second, float third)
     return hashed;
 }
 
+/**
+ * Hash function to generate the CTR mode nonce of a file from its file ID (64 bit FNV-1a), so every file
+ * encrypted with a key uses different counter blocks
+ */
+void hash_file_id(char *file_id, unsigned char nonce[])
+{
+    unsigned long long hashed = 0xcbf29ce484222325ULL;
+
+    for (int i = 0; file_id[i] != '\0' && i < MAX_FILE_ID_LENGTH; i++)
+    {
+        hashed = (hashed ^ (unsigned char)file_id[i]) * 0x100000001b3ULL;
+    }
+
+    for (int i = 0; i < 8; i++)
+    {
+        nonce[i] = (unsigned char)(hashed >> (8 * (7 - i)));
+    }
+}
+
+/**
+ * Function to form the first CTR counter block of a packet: the file's nonce followed by the big endian
+ * index of the packet's first block, so the packets of a file never reuse a counter
+ */
+void packet_counter_block(char *file_id, int packet_number, unsigned char counter_block[])
+{
+    unsigned counter = (unsigned)(packet_number - 1) * (MAX_FILEDATA_SIZE / 16);
+
+    hash_file_id(file_id, counter_block);
+    for (int i = 0; i < 8; i++)
+    {
+        counter_block[8 + i] = i < 4 ? 0 : (unsigned char)(counter >> (8 * (7 - i)));
+    }
+}
+
 /**
  * Function to generate private key.
  * 32 bits of randomly generated number that should be sent back to frontend application.
@@ -54,6 +105,8 @@ unsigned char hash_location(float first, float second, float third)
  */
 void generate_key(char *location, unsigned char key[])
 {
+    PROF_BEGIN(PROF_GENERATE_KEY);
+
     // Randomly generated 32 bits
     key[0] = (unsigned char)rand() % 256;
     key[1] = (unsigned char)rand() % 256;
@@ -92,8 +145,8 @@ void generate_key(char *location, unsigned char key[])
     key[10] = hash_location(alt_float, lat_float, long_float);
 
     // Get state of switches
-    unsigned char switches = (unsigned char)*SWITCHES;
-    *LEDS = switches;
+    unsigned char switches = (unsigned char)mmio_read32(SWITCHES);
+    mmio_write32(LEDS, switches);
     key[11] = switches;
 
     // Magnetometer values
@@ -102,6 +155,8 @@ void generate_key(char *location, unsigned char key[])
     key[13] = (unsigned char)(sensor_values >> 16);
     key[14] = (unsigned char)(sensor_values >> 8);
     key[15] = (unsigned char)sensor_values;
+
+    PROF_END(PROF_GENERATE_KEY);
 }
 
 /**
@@ -150,8 +205,8 @@ void regenerate_key(char *encryption_component, char *location, unsigned char ke
     key[10] = hash_location(alt_float, lat_float, long_float);
 
     // Get state of switches
-    unsigned char switches = (unsigned char)*SWITCHES;
-    *LEDS = switches;
+    unsigned char switches = (unsigned char)mmio_read32(SWITCHES);
+    mmio_write32(LEDS, switches);
     key[11] = switches;
 
     // Magnetometer values
@@ -164,49 +219,48 @@ void regenerate_key(char *encryption_component, char *location, unsigned char ke
 
 /**
  * Helper function for upload to encrypt fileData.
+ * The packet is encrypted in CTR mode, so the ciphertext is as long as the file data and needs no padding.
  * 
  * Params:
  *  key                 unsigned char array containing the encryption key
+ *  file_id             char array containing the file_id, used for the CTR nonce
+ *  packet_number       int to specify which packet of the file this is
  *  file_data           char array containing bytes of file data to encrypt
- *  keyexp              int to specify whether to perform key expansion
  *  entire_ciphertext   unsigned char array to hold the ciphertext
  */
-void encrypt_helper(unsigned char key[], char *file_data, int keyexp, char *entire_ciphertext)
+void encrypt_helper(unsigned char key[], char *file_id, int packet_number, char *file_data, char *entire_ciphertext)
 {
-    unsigned char plaintext[16], ciphertext[16];
-    int pad = 0, i = 0;
+    unsigned char counter_block[16];
+    int length = 0;
 
-    while (i < MAX_FILEDATA_SIZE)
-    {
-        // Copy file data to plaintext array and pad it with 0 if necessary
-        for (int j = 0; j < 16; j++)
-        {
-            if (file_data[i + j] == '\0')
-            {
-                // Once null terminating byte is encountered, remaining plaintext will be padded with 0
-                pad = 1;
-            }
+    PROF_BEGIN(PROF_ENCRYPT_HELPER);
 
-            if (pad)
-            {
-                plaintext[j] = 0x0;
-            }
-            else
-            {
-                plaintext[j] = file_data[i + j];
-            }
-        }
+    // The key is only expanded when it is not already in one of the AES core's key slots
+    int slot = aes_key_slot(key);
 
-        // Encrypt the plaintext
-        encrypt(key, plaintext, ciphertext, keyexp);
+    // Only the file data is encrypted, a short last packet is not padded
+    while (length < MAX_FILEDATA_SIZE && file_data[length] != '\0')
+    {
+        length++;
+    }
 
-        for (int j = 0; j < 16; j++)
-        {
-            sprintf((char *)(entire_ciphertext + ((i + j) * 2)), "%02X", ciphertext[j]);
-        }
+    memcpy(aes_src, file_data, length);
+    packet_counter_block(file_id, packet_number, counter_block);
 
-        i += 16;
+    // The AES core encrypts the packet by DMA, run idle tasks until it is done
+    aes_ctr_start(slot, counter_block, aes_src, aes_dst, length);
+    while (!aes_dma_done())
+    {
+        sched_idle();
     }
+
+    for (int i = 0; i < length; i++)
+    {
+        sprintf((char *)(entire_ciphertext + (i * 2)), "%02X", aes_dst[i]);
+    }
+    entire_ciphertext[length * 2] = '\0';
+
+    PROF_END(PROF_ENCRYPT_HELPER);
 }
 
 /**
@@ -214,33 +268,44 @@ void encrypt_helper(unsigned char key[], char *file_data, int keyexp, char *enti
  * 
  * Params:
  *  key                 unsigned char array containing the encryption key
+ *  file_id             char array containing the file_id, used for the CTR nonce
+ *  packet_number       int to specify which packet of the file this is
  *  encrypted_data      unsigned char array containing bytes of file data to decrypt
- *  keyexp              int to specify whether to perform key expansion
  *  entire_plaintext    char array to hold the plaintext
  */
-void decrypt_helper(unsigned char key[], char *encrypted_data, int keyexp, char *entire_plaintext)
+void decrypt_helper(unsigned char key[], char *file_id, int packet_number, char *encrypted_data, char *entire_plaintext)
 {
-    unsigned char plaintext[16], ciphertext[16];
-    int i = 0;
+    unsigned char counter_block[16];
+    int length = 0;
 
-    while (i < MAX_FILEDATA_SIZE)
-    {
-        // Copy file data to plaintext array and pad it with 0 if necessary
-        for (int j = 0; j < 16; j++)
-        {
-            sscanf((char *)(encrypted_data + (i + j) * 2), "%2hhx", &ciphertext[j]);
-        }
+    PROF_BEGIN(PROF_DECRYPT_HELPER);
 
-        // Decrypt the ciphertext
-        decrypt(key, ciphertext, plaintext, keyexp);
+    // The key is only expanded when it is not already in one of the AES core's key slots
+    int slot = aes_key_slot(key);
 
-        for (int j = 0; j < 16; j++)
-        {
-            entire_plaintext[i + j] = plaintext[j];
-        }
+    // Two hex digits per byte of the packet
+    while (length < MAX_FILEDATA_SIZE && encrypted_data[length * 2] != '\0' && encrypted_data[length * 2 + 1] != '\0')
+    {
+        length++;
+    }
 
-        i += 16;
+    for (int i = 0; i < length; i++)
+    {
+        sscanf((char *)(encrypted_data + i * 2), "%2hhx", &aes_src[i]);
     }
+    packet_counter_block(file_id, packet_number, counter_block);
+
+    // CTR decryption is the same operation as encryption
+    aes_ctr_start(slot, counter_block, aes_src, aes_dst, length);
+    while (!aes_dma_done())
+    {
+        sched_idle();
+    }
+
+    memcpy(entire_plaintext, aes_dst, length);
+    entire_plaintext[length] = '\0';
+
+    PROF_END(PROF_DECRYPT_HELPER);
 }
 
 /**
@@ -254,30 +319,30 @@ void decrypt_helper(unsigned char key[], char *encrypted_data, int keyexp, char
  *  location                char array containing the latitude, longitude, and altitude of user location
  *  file_data       char array containing bytes of file data to encrypt and send to server. Maximum size is MAX_FILEDATA_SOZE
  *
- * Returns the response data to return to the user. Should contain the status and part of the encryption key
+ * Returns the response data to return to the user. Should contain the status and part of the encryption key.
+ * It is allocated from the request arena, NULL if the arena is full
  */
 char *upload(char *file_id, int packet_number, int total_packets, char *location, char *file_data)
 {
     unsigned char key[16];
     char entire_ciphertext[2 * MAX_FILEDATA_SIZE + 1];
 
+    // Keep a copy of the file ID, the bluetooth message it points into is reused for the next packet
+    char file_id_copy[MAX_FILE_ID_LENGTH + 1];
+    strncpy(file_id_copy, file_id, MAX_FILE_ID_LENGTH);
+    file_id_copy[MAX_FILE_ID_LENGTH] = '\0';
+    file_id = file_id_copy;
+
     // Generate encryption key and then encrypt file data
     generate_key(location, key);
 
-    char *json_str;
-    jsmntok_t *json_tokens;
-    int num_fields = 6;
-    char **all_values;
+    json_stream_t *message;
+    json_view_t values[UPLOAD_NUM_FIELDS];
 
     // Multiple packets of file data to receive
     while (total_packets > packet_number)
     {
-        encrypt_helper(key, file_data, packet_number == 1, entire_ciphertext);
-
-        if (packet_number > 1)
-        {
-            free_json_values_array(all_values, num_fields);
-        }
+        encrypt_helper(key, file_id, packet_number, file_data, entire_ciphertext);
 
         // Upload encrypted file data to server
         upload_data(file_id, packet_number - 1, entire_ciphertext);
@@ -286,28 +351,32 @@ char *upload(char *file_id, int packet_number, int total_packets, char *location
         bluetooth_send_status(1);
 
         // Receive the next packet of fileData to encrypt and upload
-        json_str = bluetooth_wait_for_data();
-        json_tokens = str_to_json(json_str);
-        all_values = get_json_values(json_str, json_tokens, num_fields);
-        packet_number = (int)strtol(all_values[2], NULL, 10);
-        file_data = all_values[5];
-        free(json_tokens);
+        // (file data arrives straight in upload_file_data)
+        message = bluetooth_wait_for_message();
+        if (message == NULL || json_stream_extract(message, upload_schema, UPLOAD_NUM_FIELDS, values) != UPLOAD_NUM_FIELDS)
+        {
+            // Answered with status 0, the packet before it was already uploaded
+            printf("Malformed upload packet\n");
+            return NULL;
+        }
+        packet_number = json_view_to_int(values[UPLOAD_PACKET_NUMBER]);
+        file_data = values[UPLOAD_FILE_DATA].ptr;
     }
 
     // Last packet of fileData to receive
-    encrypt_helper(key, file_data, packet_number == 1, entire_ciphertext);
+    encrypt_helper(key, file_id, packet_number, file_data, entire_ciphertext);
 
     // Upload last packet of encrypted file data to server
     upload_data(file_id, packet_number - 1, entire_ciphertext);
 
-    if (packet_number > 1)
+    // Forming the response message which contains the success status and part of the encryption key,
+    // in the request arena until the controller has sent it
+    char *response_data = (char *)mem_alloc(sizeof(char) * 100);
+    if (response_data == NULL)
     {
-        free_json_values_array(all_values, num_fields);
+        return NULL;
     }
 
-    // Forming the response message which contains the success status and part of the encryption key
-    char *response_data = (char *)malloc(sizeof(char) * 100);
-
     char encryption_component[9];
     for (int i = 0; i < 4; i++)
     {
@@ -333,11 +402,17 @@ void download(char *file_id, char *encryption_component, char *location)
 {
     unsigned char key[16];
 
+    // Keep a copy of the file ID, the bluetooth receive buffer it points into is reused for status replies
+    char file_id_copy[MAX_FILE_ID_LENGTH + 1];
+    strncpy(file_id_copy, file_id, MAX_FILE_ID_LENGTH);
+    file_id_copy[MAX_FILE_ID_LENGTH] = '\0';
+    file_id = file_id_copy;
+
     regenerate_key(encryption_component, location, key);
 
-    char encrypted_data[2 * MAX_FILEDATA_SIZE + 1];
+    char *encrypted_data;
     char entire_plaintext[MAX_FILEDATA_SIZE + 1];
-    char *response_data = (char *)malloc(sizeof(char) * (50 + MAX_FILEDATA_SIZE));
+    json_writer_t writer;
 
     // Generate encryption key and then encrypt file data
     int total_packets = get_file_metadata(file_id);
@@ -348,31 +423,32 @@ void download(char *file_id, char *encryption_component, char *location)
     {
         status = 0;
 
-        // Get a file blob/packet and decrypt it
-        sprintf(encrypted_data, "%s", get_blob(file_id, packet_number - 1));
-
-        decrypt_helper(key, encrypted_data, packet_number == 1, entire_plaintext);
-        entire_plaintext[MAX_FILEDATA_SIZE] = '\0';
+        // Get a file blob/packet and decrypt it, a failed request decrypts as an empty packet
+        encrypted_data = get_blob(file_id, packet_number - 1);
 
-        // Form response data and send to user
-        sprintf(response_data, "{\"packetNumber\":%c,\"totalPackets\":%c,\"fileData\":\"%s\"}\v\n", packet_number + '0', total_packets + '0', entire_plaintext);
+        decrypt_helper(key, file_id, packet_number, encrypted_data != NULL ? encrypted_data : "", entire_plaintext);
+        mem_pool_free(encrypted_data);
 
-        bluetooth_send_message(response_data);
-        // printf("%s\n", response_data);
+        // Form response data and stream it to the user
+        json_writer_begin(&writer, bluetooth_send_message);
+        json_write_int(&writer, "packetNumber", packet_number);
+        json_write_int(&writer, "totalPackets", total_packets);
+        json_write_string(&writer, "fileData", entire_plaintext);
+        json_writer_end(&writer);
 
         // Wait for user to be ready to receive another response
         while (!status && total_packets > packet_number)
         {
-            char *json_str = bluetooth_wait_for_data();
-            jsmntok_t *json_tokens = str_to_json(json_str);
-            char **all_values = get_json_values(json_str, json_tokens, 1);
-            status = (int)strtol(all_values[0], NULL, 10);
-            free(json_tokens);
-            free_json_values_array(all_values, 1);
+            json_stream_t *message = bluetooth_wait_for_message();
+            json_view_t values[STATUS_NUM_FIELDS];
+
+            if (message != NULL)
+            {
+                json_stream_extract(message, status_schema, STATUS_NUM_FIELDS, values);
+                status = json_view_to_int(values[STATUS_STATUS]);
+            }
         }
 
         packet_number++;
     }
-
-    free(response_data);
 }
@@ -0,0 +1,192 @@
+/**
+ * This module contains the profiling probes on the request path.
+ *
+ * A probe is a PROF_BEGIN/PROF_END pair around a piece of code. On the board durations are counted in
+ * CPU cycles by the Cortex-A9 PMU cycle counter, which costs a register read per end of the probe, and
+ * wraps after about 5 s at 800 MHz. On the host, e.g. in the host tests, prof_now() reads
+ * clock_gettime() in ns instead. Each probe keeps a count, the total, min and max and a log2 histogram
+ * of fixed size, printed over the JTAG UART by prof_print_report().
+ *
+ * Probes are compiled out if PROFILING is 0.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <typeDef.h>
+#include "profileService.h"
+
+#ifndef __ARMCC_VERSION
+#include <time.h>
+#endif
+
+// PMCR bits
+#define PMCR_ENABLE 0x1
+#define PMCR_CYCLE_RESET 0x4
+// PMCNTENSET bit of the cycle counter
+#define PMCNTEN_CYCLES 0x80000000
+// The cycle counter counts at the CPU clock
+#define PROF_CYCLES_PER_US 800
+
+static prof_stats_t prof_probes[PROF_PROBES];
+
+static const char *prof_names[PROF_PROBES] = {
+    "request",
+    "str_to_json",
+    "get_json_values",
+    "generate_key",
+    "encrypt_helper",
+    "upload_data",
+    "get_blob",
+    "decrypt_helper",
+    "bluetooth_send",
+    "ready_wait",
+};
+
+/**
+ * Start the cycle counter and clear the probes
+ */
+void prof_init(void)
+{
+#ifdef __ARMCC_VERSION
+    unsigned value;
+
+    __asm { MRC p15, 0, value, c9, c12, 0 }
+    value |= PMCR_ENABLE | PMCR_CYCLE_RESET;
+    __asm { MCR p15, 0, value, c9, c12, 0 }
+
+    value = PMCNTEN_CYCLES;
+    __asm { MCR p15, 0, value, c9, c12, 1 }
+#endif
+
+    prof_reset();
+}
+
+/**
+ * Returns the current time, CPU cycles on the board and ns on the host
+ */
+uint32 prof_now(void)
+{
+#ifdef __ARMCC_VERSION
+    unsigned cycles;
+
+    __asm { MRC p15, 0, cycles, c9, c13, 0 }
+    return cycles;
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32)((uint64)now.tv_sec * 1000000000ULL + now.tv_nsec);
+#endif
+}
+
+/**
+ * Add a duration to a probe, called by PROF_END
+ */
+void prof_record(prof_probe probe, uint32 duration)
+{
+    prof_stats_t *stats = &prof_probes[probe];
+    uint32 value = duration;
+    int bucket = 0;
+
+    while (value >>= 1)
+    {
+        bucket++;
+    }
+
+    if (stats->count == 0 || duration < stats->min)
+    {
+        stats->min = duration;
+    }
+    if (duration > stats->max)
+    {
+        stats->max = duration;
+    }
+
+    stats->count++;
+    stats->total += duration;
+    stats->buckets[bucket]++;
+}
+
+/**
+ * Returns the durations recorded for a probe since the last prof_reset()
+ */
+const prof_stats_t *prof_stats(prof_probe probe)
+{
+    return &prof_probes[probe];
+}
+
+/**
+ * Returns the name of a probe in reports
+ */
+const char *prof_name(prof_probe probe)
+{
+    return prof_names[probe];
+}
+
+/**
+ * Returns the unit of the recorded durations
+ */
+const char *prof_unit(void)
+{
+#ifdef __ARMCC_VERSION
+    return "cycles";
+#else
+    return "ns";
+#endif
+}
+
+/**
+ * Returns a duration of prof_now() in us
+ */
+uint32 prof_to_us(uint64 duration)
+{
+#ifdef __ARMCC_VERSION
+    return (uint32)(duration / PROF_CYCLES_PER_US);
+#else
+    return (uint32)(duration / 1000);
+#endif
+}
+
+/**
+ * Print the probes that ran since the last reset with their histograms, one bucket per power of 2.
+ * Prints nothing if no probe ran.
+ */
+void prof_print_report(void)
+{
+    const prof_stats_t *stats;
+    int header = 0;
+
+    for (int i = 0; i < PROF_PROBES; i++)
+    {
+        stats = &prof_probes[i];
+        if (stats->count == 0)
+        {
+            continue;
+        }
+
+        if (!header)
+        {
+            printf("Profile (%s):\n", prof_unit());
+            header = 1;
+        }
+
+        printf("  %-16s n=%lu mean=%lu min=%lu max=%lu\n   ", prof_names[i], stats->count,
+               (uint32)(stats->total / stats->count), stats->min, stats->max);
+        for (int j = 0; j < PROF_BUCKETS; j++)
+        {
+            if (stats->buckets[j] != 0)
+            {
+                printf(" 2^%d:%lu", j, stats->buckets[j]);
+            }
+        }
+        printf("\n");
+    }
+}
+
+/**
+ * Clear all probes
+ */
+void prof_reset(void)
+{
+    memset(prof_probes, 0, sizeof(prof_probes));
+}
@@ -0,0 +1,292 @@
+/**
+ * This module contains the cooperative scheduler that drives the firmware main loop.
+ *
+ * Periodic tasks are registered with one of the TIME_FLAG_* periods and run when
+ * sched_UpdateTimeFlag raises that flag. Event sources are polled on every pass and their
+ * handler runs when the event has happened (e.g. a complete bluetooth message).
+ * Nothing here blocks, tasks and event sources are expected to return quickly.
+ *
+ * Handlers that still have to wait (the multi-message upload/download exchanges) call
+ * sched_idle while waiting, which keeps the tasks registered with in_idle running.
+ */
+
+#include <stdio.h>
+#include <typeDef.h>
+#include "constants.h"
+#include "hpsService.h"
+#include "scheduler.h"
+
+typedef struct
+{
+    uint32 time_flag;
+    sched_task_fn task;
+    bool in_idle;
+} sched_task_t;
+
+typedef struct
+{
+    sched_poll_fn poll;
+    sched_handler_fn handler;
+} sched_event_t;
+
+static sched_task_t sched_tasks[SCHED_MAX_TASKS];
+static int sched_num_tasks = 0;
+static sched_event_t sched_events[SCHED_MAX_EVENTS];
+static int sched_num_events = 0;
+
+static uint32 sched_u32TimeFlags = 0;
+// Periods that elapsed in sched_idle, kept for the tasks that do not run there
+static uint32 sched_u32DeferredFlags = 0;
+static uint64 sched_next_ms = 0;
+
+// Set while tasks are running, so sched_idle called from a task does nothing
+static int sched_in_tasks = 0;
+
+// Counters since the last sched_print_stats
+static uint32 sched_passes = 0;
+static uint32 sched_idle_passes = 0;
+static uint32 sched_task_runs = 0;
+static uint32 sched_events_handled = 0;
+
+/**
+ * Keep track of how much time has elapsed,
+ * for periodically calling the registered tasks
+ */
+static void sched_UpdateTimeFlag(void)
+{
+    static uint32 Count_ms = 0;
+
+    uint64 now = hps_time_ms();
+
+    if (now >= sched_next_ms)
+    {
+        // Time lost while a handler blocked is not caught up
+        sched_next_ms = now + 1;
+        Count_ms++;
+        sched_u32TimeFlags |= TIME_FLAG_1MS;
+
+        // Update flags
+        if ((Count_ms % 2) == 0)
+        {
+            sched_u32TimeFlags |= TIME_FLAG_2MS;
+        }
+
+        if ((Count_ms % 3) == 0)
+        {
+            sched_u32TimeFlags |= TIME_FLAG_3MS;
+        }
+
+        if ((Count_ms % 4) == 0)
+        {
+            sched_u32TimeFlags |= TIME_FLAG_4MS;
+        }
+
+        if ((Count_ms % 5) == 0)
+        {
+            sched_u32TimeFlags |= TIME_FLAG_5MS;
+        }
+
+        if ((Count_ms % 10) == 0)
+        {
+            sched_u32TimeFlags |= TIME_FLAG_10MS;
+        }
+
+        if ((Count_ms % 20) == 0)
+        {
+            sched_u32TimeFlags |= TIME_FLAG_20MS;
+        }
+
+        if ((Count_ms % 50) == 0)
+        {
+            sched_u32TimeFlags |= TIME_FLAG_50MS;
+        }
+
+        if ((Count_ms % 100) == 0)
+        {
+            sched_u32TimeFlags |= TIME_FLAG_100MS;
+        }
+
+        if ((Count_ms % 200) == 0)
+        {
+            sched_u32TimeFlags |= TIME_FLAG_200MS;
+        }
+
+        if ((Count_ms % 300) == 0)
+        {
+            sched_u32TimeFlags |= TIME_FLAG_300MS;
+        }
+
+        if ((Count_ms % 400) == 0)
+        {
+            sched_u32TimeFlags |= TIME_FLAG_400MS;
+        }
+
+        if ((Count_ms % 500) == 0)
+        {
+            sched_u32TimeFlags |= TIME_FLAG_500MS;
+        }
+
+        if ((Count_ms % 1000) == 0)
+        {
+            sched_u32TimeFlags |= TIME_FLAG_1SEC;
+        }
+    }
+}
+
+/**
+ * Run the tasks whose period has elapsed, then clear the time flags.
+ *
+ * A period that elapses while a handler waits in sched_idle is kept for the tasks without in_idle,
+ * they run once on the next full pass. Several elapsed periods still run them only once.
+ *
+ * Params:
+ *  idle    nonzero to only run the tasks registered with in_idle
+ */
+static void sched_run_tasks(int idle)
+{
+    sched_UpdateTimeFlag();
+
+    if (sched_u32TimeFlags == 0 && (idle || sched_u32DeferredFlags == 0))
+    {
+        return;
+    }
+
+    sched_in_tasks = 1;
+    for (int i = 0; i < sched_num_tasks; i++)
+    {
+        uint32 flags = sched_u32TimeFlags;
+
+        if (!sched_tasks[i].in_idle)
+        {
+            if (idle)
+            {
+                continue;
+            }
+            flags |= sched_u32DeferredFlags;
+        }
+
+        if (flags & sched_tasks[i].time_flag)
+        {
+            sched_tasks[i].task();
+            sched_task_runs++;
+        }
+    }
+    sched_in_tasks = 0;
+
+    // Clear time flags at the end of each pass.
+    if (idle)
+    {
+        sched_u32DeferredFlags |= sched_u32TimeFlags;
+    }
+    else
+    {
+        sched_u32DeferredFlags = 0;
+    }
+    sched_u32TimeFlags = 0;
+}
+
+/**
+ * Register a task to run every time the given TIME_FLAG_* period elapses.
+ *
+ * Params:
+ *  time_flag   one of the TIME_FLAG_* constants
+ *  task        function to run
+ *  in_idle     whether the task also runs while a handler is waiting in sched_idle
+ *
+ * Returns 1 on success, 0 if the task table is full
+ */
+int sched_add_task(uint32 time_flag, sched_task_fn task, bool in_idle)
+{
+    if (sched_num_tasks >= SCHED_MAX_TASKS)
+    {
+        return 0;
+    }
+
+    sched_tasks[sched_num_tasks].time_flag = time_flag;
+    sched_tasks[sched_num_tasks].task = task;
+    sched_tasks[sched_num_tasks].in_idle = in_idle;
+    sched_num_tasks++;
+
+    return 1;
+}
+
+/**
+ * Register an event source, handler is called whenever poll reports the event.
+ *
+ * Returns 1 on success, 0 if the event table is full
+ */
+int sched_add_event(sched_poll_fn poll, sched_handler_fn handler)
+{
+    if (sched_num_events >= SCHED_MAX_EVENTS)
+    {
+        return 0;
+    }
+
+    sched_events[sched_num_events].poll = poll;
+    sched_events[sched_num_events].handler = handler;
+    sched_num_events++;
+
+    return 1;
+}
+
+/**
+ * Called by handlers while they wait, keeps the in_idle tasks running.
+ * The other tasks catch up once the handler returns, see sched_run_tasks.
+ * Event sources are not polled, handlers are never re-entered.
+ */
+void sched_idle(void)
+{
+    if (sched_in_tasks)
+    {
+        return;
+    }
+
+    sched_idle_passes++;
+    sched_run_tasks(1);
+}
+
+/**
+ * One pass of the main loop: the tasks that are due, then every event source. sched_run() repeats it,
+ * a host benchmark calls it directly to stop once it has its numbers.
+ */
+void sched_run_once(void)
+{
+    sched_passes++;
+    sched_run_tasks(0);
+
+    for (int i = 0; i < sched_num_events; i++)
+    {
+        if (sched_events[i].poll())
+        {
+            sched_events[i].handler();
+            sched_events_handled++;
+        }
+    }
+}
+
+/**
+ * Scheduler main loop, never returns
+ */
+void sched_run(void)
+{
+    sched_next_ms = hps_time_ms() + 1;
+
+    while (1)
+    {
+        sched_run_once();
+    }
+}
+
+/**
+ * Print and reset the scheduler counters
+ */
+void sched_print_stats(void)
+{
+    printf("Scheduler: %lu passes, %lu idle passes, %lu task runs, %lu events\n",
+           sched_passes, sched_idle_passes, sched_task_runs, sched_events_handled);
+
+    sched_passes = 0;
+    sched_idle_passes = 0;
+    sched_task_runs = 0;
+    sched_events_handled = 0;
+}
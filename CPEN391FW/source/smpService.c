@@ -0,0 +1,202 @@
+/**
+ * This module contains the boot path of the second Cortex-A9 core and the API for offloading jobs
+ * (AES batches, hex encoding, JSON parsing, ...) to it through the work queue in workQueue.c.
+ *
+ * Core 1 is held in reset by the reset manager until smp_start_core1(). When released it starts at
+ * address 0 with the MMU off, where the scatter file places cpu1_entry(). That reads its C entry point
+ * and stack from a mailbox at the top of on-chip RAM, which is uncached on both cores.
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <typeDef.h>
+#include "memAddress.h"
+#include "mmio.h"
+#include "cacheService.h"
+#include "workQueue.h"
+#include "smpService.h"
+
+// Mailbox words, SMP_MAILBOX must match SMP_MAILBOX_ADDR for the assembly below
+#define SMP_MAILBOX 0xFFFFFF00
+#define MAILBOX_ENTRY 0
+#define MAILBOX_STACK 1
+#define MAILBOX_STATE 2
+#define CPU1_RUNNING 0x52554E31 // "RUN1"
+
+// Reset manager bit holding core 1 in reset
+#define MPUMODRST_CPU1 (1 << 1)
+
+#define CPU1_STACK_SIZE 4096
+// Polls of the mailbox before giving up on core 1
+#define CPU1_START_TIMEOUT 10000000
+
+static work_queue_t jobs;
+static unsigned cpu1_stack[CPU1_STACK_SIZE / 4] __attribute__((aligned(8)));
+static int core1_running = 0;
+
+#ifdef __ARMCC_VERSION
+#pragma arm section code = "cpu1_entry"
+/*
+ * Core 1 starts here at address 0 when it leaves reset. It waits for an entry point in the mailbox,
+ * then jumps to it on the mailbox stack.
+ */
+__asm void cpu1_entry(void)
+{
+    LDR r0, =SMP_MAILBOX
+wait_entry
+    LDR r1, [r0, #MAILBOX_ENTRY * 4]
+    CMP r1, #0
+    WFEEQ
+    BEQ wait_entry
+    LDR sp, [r0, #MAILBOX_STACK * 4]
+    BX r1
+}
+#pragma arm section code
+#endif
+
+/*
+ * C entry point of core 1, runs jobs from the queue forever. Jobs must not use printf or other
+ * library state owned by core 0, and must take a spinlock around peripherals core 0 also uses.
+ */
+static void cpu1_main(void)
+{
+    volatile unsigned *mailbox = SMP_MAILBOX_ADDR;
+    smp_job_t *job;
+
+    cache_init_secondary();
+    mmio_write32(mailbox + MAILBOX_STATE, CPU1_RUNNING);
+
+    for (;;)
+    {
+        job = (smp_job_t *)work_queue_pop(&jobs);
+        if (job == NULL)
+        {
+#ifdef __ARMCC_VERSION
+            // work_queue_push() sends an event
+            __wfe();
+#endif
+            continue;
+        }
+
+        job->function(job->arg);
+#ifdef __ARMCC_VERSION
+        __dmb(0xF);
+#endif
+        job->done = 1;
+    }
+}
+
+/**
+ * Release core 1 from reset and wait until it runs jobs. Must be called after cache_init().
+ *
+ * Returns 1 if core 1 is running, 0 if it did not come up (jobs then run on core 0)
+ */
+int smp_start_core1(void)
+{
+    volatile unsigned *mailbox = SMP_MAILBOX_ADDR;
+    int timeout = CPU1_START_TIMEOUT;
+
+    if (core1_running)
+    {
+        return 1;
+    }
+
+#ifdef __ARMCC_VERSION
+    // The reset entry must be the first thing in the image, see CPEN391FW.scat
+    if ((unsigned)cpu1_entry != 0)
+    {
+        printf("smp_start_core1: cpu1_entry is not at address 0\n");
+        return 0;
+    }
+#endif
+
+    work_queue_init(&jobs);
+
+    mmio_write32(mailbox + MAILBOX_STATE, 0);
+    mmio_write_addr(mailbox + MAILBOX_STACK, &cpu1_stack[CPU1_STACK_SIZE / 4]);
+    mmio_write_addr(mailbox + MAILBOX_ENTRY, (void *)cpu1_main);
+
+    // Core 1 uses its stack before its caches are on, no dirty line of it may be evicted over that later
+    cache_flush_range(cpu1_stack, sizeof(cpu1_stack));
+
+    mmio_write32(RSTMGR_MPUMODRST, mmio_read32(RSTMGR_MPUMODRST) & ~MPUMODRST_CPU1);
+#ifdef __ARMCC_VERSION
+    __dsb(0xF);
+    __sev();
+#endif
+
+    while (mmio_read32(mailbox + MAILBOX_STATE) != CPU1_RUNNING)
+    {
+        if (--timeout == 0)
+        {
+            printf("smp_start_core1: core 1 did not start\n");
+            mmio_write32(RSTMGR_MPUMODRST, mmio_read32(RSTMGR_MPUMODRST) | MPUMODRST_CPU1);
+            return 0;
+        }
+    }
+
+    core1_running = 1;
+    return 1;
+}
+
+/**
+ * Returns 1 once smp_start_core1() has started core 1
+ */
+int smp_core1_running(void)
+{
+    return core1_running;
+}
+
+/**
+ * Hand a job to core 1. Runs it right away on the calling core if core 1 is not running.
+ *
+ * Params:
+ *  job         job structure, must stay valid until smp_job_done() returns 1
+ *  function    function core 1 calls with arg
+ *  arg         argument of function
+ *
+ * Returns 1 if the job was queued or has run, 0 if the queue is full
+ */
+int smp_submit(smp_job_t *job, smp_job_function function, void *arg)
+{
+    job->function = function;
+    job->arg = arg;
+    job->done = 0;
+
+    if (!core1_running)
+    {
+        function(arg);
+        job->done = 1;
+        return 1;
+    }
+
+    return work_queue_push(&jobs, job);
+}
+
+/**
+ * Returns 1 once core 1 has finished the job, its results can then be read
+ */
+int smp_job_done(smp_job_t *job)
+{
+    if (job->done)
+    {
+#ifdef __ARMCC_VERSION
+        // Reads of the results may not pass the read of done
+        __dmb(0xF);
+#endif
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Wait for core 1 to finish a job
+ */
+void smp_wait(smp_job_t *job)
+{
+    while (!smp_job_done(job))
+    {
+        // wait
+    }
+}
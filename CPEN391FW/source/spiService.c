@@ -0,0 +1,154 @@
+/**
+ * This module contains burst transfers on the Avalon SPI master, used instead of alt_avalon_spi_command()
+ * for the MPU9250.
+ *
+ * A batch runs several transfers back to back, each with its own chip select pulse, without the caller
+ * having to come back in between. Bytes are kept two deep: the next byte waits in the transmit holding
+ * register while the current one shifts, so the clock never idles inside a transfer. At 1 MHz a byte
+ * takes 8 us, far longer than this loop needs to empty the receive register, so two bytes in flight
+ * cannot overrun it. If the core ever reports an overrun anyway, transfers drop back to one byte in
+ * flight, the way alt_avalon_spi_command() runs.
+ */
+
+#include <typeDef.h>
+#include "altera_avalon_spi_regs.h"
+#include "spiService.h"
+
+// Bytes in flight, the shift register plus the transmit holding register
+#define SPI_MAX_CREDITS 2
+
+static int credits_max = SPI_MAX_CREDITS;
+
+/*
+ * Clock one transfer with the chip select already asserted.
+ *
+ * Returns true if no byte was lost to a receive overrun
+ */
+static bool spi_run(uint32 base, const spi_transfer_t *transfer)
+{
+    uint32 total = transfer->write_length + transfer->read_length;
+    uint32 sent = 0;
+    uint32 received = 0;
+    int credits = credits_max;
+    uint32 status;
+    uint32 rxdata;
+
+    while (received < total)
+    {
+        status = IORD_ALTERA_AVALON_SPI_STATUS(base);
+
+        // A lost byte never arrives, stop sending
+        if ((status & ALTERA_AVALON_SPI_STATUS_ROE_MSK) != 0)
+        {
+            break;
+        }
+
+        if ((status & ALTERA_AVALON_SPI_STATUS_TRDY_MSK) != 0 && credits > 0 && sent < total)
+        {
+            // Clock out zeros while reading
+            IOWR_ALTERA_AVALON_SPI_TXDATA(base, sent < transfer->write_length ? transfer->write_data[sent] : 0);
+            sent++;
+            credits--;
+        }
+
+        if ((status & ALTERA_AVALON_SPI_STATUS_RRDY_MSK) != 0)
+        {
+            rxdata = IORD_ALTERA_AVALON_SPI_RXDATA(base);
+            if (received >= transfer->write_length && transfer->read_data != null)
+            {
+                transfer->read_data[received - transfer->write_length] = (uint8)rxdata;
+            }
+            received++;
+            credits++;
+        }
+    }
+
+    // Wait until the last byte has left the shift register
+    do
+    {
+        status = IORD_ALTERA_AVALON_SPI_STATUS(base);
+    } while ((status & ALTERA_AVALON_SPI_STATUS_TMT_MSK) == 0);
+
+    if ((status & ALTERA_AVALON_SPI_STATUS_ROE_MSK) != 0)
+    {
+        // Drop the last byte, any write clears the error bits
+        IORD_ALTERA_AVALON_SPI_RXDATA(base);
+        IOWR_ALTERA_AVALON_SPI_STATUS(base, 0);
+        credits_max = 1;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Run one transfer: write write_length bytes, then read read_length bytes, in one chip select pulse.
+ *
+ * Params:
+ *  base            base address of the SPI master
+ *  slave           slave select bit of the device
+ *  write_data      bytes to send, e.g. a register address
+ *  write_length    number of bytes to send
+ *  read_data       buffer for the bytes read after write_data, may be null if read_length is 0
+ *  read_length     number of bytes to read
+ *
+ * Returns true on success, false if a byte was lost
+ */
+bool spi_transfer(uint32 base, uint32 slave, const uint8 *write_data, uint32 write_length,
+                  uint8 *read_data, uint32 read_length)
+{
+    spi_transfer_t transfer;
+
+    transfer.write_data = write_data;
+    transfer.write_length = write_length;
+    transfer.read_data = read_data;
+    transfer.read_length = read_length;
+
+    return spi_transfer_batch(base, slave, &transfer, 1);
+}
+
+/**
+ * Run transfers back to back, releasing the chip select after each one. All transfers are run even
+ * if one of them fails.
+ *
+ * Params:
+ *  base        base address of the SPI master
+ *  slave       slave select bit of the device
+ *  transfers   transfers to run in order
+ *  count       number of transfers
+ *
+ * Returns true on success, false if a byte of any transfer was lost
+ */
+bool spi_transfer_batch(uint32 base, uint32 slave, const spi_transfer_t *transfers, int count)
+{
+    bool ok = true;
+    int i;
+
+    IOWR_ALTERA_AVALON_SPI_SLAVE_SEL(base, 1 << slave);
+
+    for (i = 0; i < count; i++)
+    {
+        // Hold the chip select for the whole transfer
+        IOWR_ALTERA_AVALON_SPI_CONTROL(base, ALTERA_AVALON_SPI_CONTROL_SSO_MSK);
+
+        // Discard stale data left by an interrupted transfer
+        IORD_ALTERA_AVALON_SPI_RXDATA(base);
+
+        if (!spi_run(base, &transfers[i]))
+        {
+            ok = false;
+        }
+
+        IOWR_ALTERA_AVALON_SPI_CONTROL(base, 0);
+    }
+
+    return ok;
+}
+
+/**
+ * Returns the number of bytes transfers keep in flight, 1 after an overrun was seen
+ */
+int spi_credits(void)
+{
+    return credits_max;
+}
@@ -0,0 +1,134 @@
+/**
+ * This module contains the runtime statistics sent in reply to message type 8.
+ *
+ * The counters are kept by the modules that update them, in plain structs only written from the main
+ * loop, so counting on the hot paths is an increment without a lock: bytes and overruns in UART.c,
+ * connections in wifiService.c, blocks in aesHwacc.c and the arena and pool use in memService.c.
+ * stats_send() reads them between requests and streams them as one flat JSON object of integers, e.g.
+ *  {"uptime":1200,"requests":42,"btRx":21504,...,"request_n":42,"request_us":980,"request_max_us":3068}
+ *
+ * The latency of each profiled stage is its count, mean and max in us since boot. task_stats() clears
+ * the probes every STATS_PERIOD_SEC, so they are folded into the totals here first.
+ */
+
+#include <stdio.h>
+#include <typeDef.h>
+#include "UART.h"
+#include "aesHwacc.h"
+#include "bluetoothService.h"
+#include "hpsService.h"
+#include "jsonWriter.h"
+#include "memService.h"
+#include "profileService.h"
+#include "statsService.h"
+#include "wifiService.h"
+
+// Durations of a probe since boot, up to the last stats_fold_profile()
+typedef struct
+{
+    uint32 count;
+    uint64 total;
+    uint32 max;
+} stats_probe_t;
+
+static uint32 stats_requests = 0;
+static stats_probe_t stats_probes[PROF_PROBES];
+
+/**
+ * Count a request handled by the controller
+ */
+void stats_count_request(void)
+{
+    stats_requests++;
+}
+
+/**
+ * Add the durations recorded since the last prof_reset() to the totals, call before resetting the probes
+ */
+void stats_fold_profile(void)
+{
+    for (int i = 0; i < PROF_PROBES; i++)
+    {
+        const prof_stats_t *recorded = prof_stats((prof_probe)i);
+
+        stats_probes[i].count += recorded->count;
+        stats_probes[i].total += recorded->total;
+        if (recorded->max > stats_probes[i].max)
+        {
+            stats_probes[i].max = recorded->max;
+        }
+    }
+}
+
+static void write_uart(json_writer_t *writer, UART_ePORT ePort, const char *rx, const char *tx, const char *overruns)
+{
+    const UART_tSTATS *uart = UART_GetStats(ePort);
+
+    json_write_int(writer, rx, (int)uart->rx_bytes);
+    json_write_int(writer, tx, (int)uart->tx_bytes);
+    json_write_int(writer, overruns, (int)uart->overruns);
+}
+
+/**
+ * Write the count, mean and max of each probe that ran, in us
+ */
+static void write_latency(json_writer_t *writer)
+{
+    char key[32];
+
+    for (int i = 0; i < PROF_PROBES; i++)
+    {
+        const prof_stats_t *recorded = prof_stats((prof_probe)i);
+        uint32 count = stats_probes[i].count + recorded->count;
+        uint64 total = stats_probes[i].total + recorded->total;
+        uint32 max = recorded->max > stats_probes[i].max ? recorded->max : stats_probes[i].max;
+
+        if (count == 0)
+        {
+            continue;
+        }
+
+        snprintf(key, sizeof(key), "%s_n", prof_name((prof_probe)i));
+        json_write_int(writer, key, (int)count);
+        snprintf(key, sizeof(key), "%s_us", prof_name((prof_probe)i));
+        json_write_int(writer, key, (int)prof_to_us(total / count));
+        snprintf(key, sizeof(key), "%s_max_us", prof_name((prof_probe)i));
+        json_write_int(writer, key, (int)prof_to_us(max));
+    }
+}
+
+/**
+ * Send the counter snapshot to the app
+ */
+void stats_send(void)
+{
+    json_writer_t writer;
+    const wifi_stats_t *wifi = wifi_get_stats();
+    const aes_stats_t *aes = aes_get_stats();
+    const mem_stats_t *mem = mem_stats();
+
+    json_writer_begin(&writer, bluetooth_send_message);
+    json_write_int(&writer, "uptime", (int)(hps_time_ms() / 1000));
+    json_write_int(&writer, "requests", (int)stats_requests);
+
+    write_uart(&writer, UART_ePORT_BLUETOOTH, "btRx", "btTx", "btOverruns");
+    write_uart(&writer, UART_ePORT_WIFI, "wifiRx", "wifiTx", "wifiOverruns");
+
+    json_write_int(&writer, "wifiJoins", (int)wifi->joins);
+    json_write_int(&writer, "wifiJoinFails", (int)wifi->join_failures);
+    json_write_int(&writer, "tcpConnects", (int)wifi->tcp_connects);
+    json_write_int(&writer, "tcpFails", (int)wifi->tcp_failures);
+    json_write_int(&writer, "keepaliveFails", (int)wifi->keepalive_failures);
+
+    json_write_int(&writer, "aesBlocks", (int)aes->blocks);
+    json_write_int(&writer, "aesKeyExps", (int)aes->key_expansions);
+
+    json_write_int(&writer, "arenaPeak", (int)mem->arena_peak);
+    json_write_int(&writer, "arenaFails", (int)mem->arena_failures);
+    json_write_int(&writer, "poolInUse", (int)mem->pool_in_use);
+    json_write_int(&writer, "poolPeak", (int)mem->pool_peak);
+    json_write_int(&writer, "poolFails", (int)mem->pool_failures);
+
+    write_latency(&writer);
+    json_writer_end(&writer);
+}
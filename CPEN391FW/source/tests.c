@@ -6,15 +6,25 @@
 #include <stdio.h>
 #include <time.h>
 #include <string.h>
+#include <typeDef.h>
 #include "constants.h"
 #include "memAddress.h"
+#include "mmio.h"
 #include "aesHwacc.h"
+#include "cacheService.h"
+#include "aesVectors.h"
 #include "verificationService.h"
 #include "jsonParser.h"
+#include "messageSchema.h"
+#include "jsonStream.h"
+#include "jsonWriter.h"
 #include "hexService.h"
 #include "bluetoothService.h"
 #include "wifiService.h"
 #include "processingService.h"
+#include "smpService.h"
+#include "hpsService.h"
+#include "mpu9250.h"
 
 /**
  * Test 0 for whether encryption and decryption modules work as expected.
@@ -217,9 +227,484 @@ void aes_test1()
     }
 }
 
+/**
+ * Test for the AES core key slots against the encrypt and decrypt modules
+ */
+void aes_test3()
+{
+    time_t t;
+    srand((unsigned)time(&t));
+    int correct = 1;
+
+    unsigned char keys[AES_KEY_SLOTS + 1][16], plaintext[16], ciphertext[16], ciphertext1[16], plaintext1[16];
+    int slots[AES_KEY_SLOTS + 1];
+
+    for (int i = 0; i < AES_KEY_SLOTS + 1; i++)
+    {
+        for (int j = 0; j < 16; j++)
+        {
+            keys[i][j] = (unsigned char)rand() % 256;
+        }
+    }
+    for (int j = 0; j < 16; j++)
+    {
+        plaintext[j] = (unsigned char)rand() % 256;
+    }
+
+    // Fill every slot, looking a key up again must give the same slot
+    for (int i = 0; i < AES_KEY_SLOTS; i++)
+    {
+        slots[i] = aes_key_slot(keys[i]);
+    }
+    for (int i = 0; i < AES_KEY_SLOTS; i++)
+    {
+        if (aes_key_slot(keys[i]) != slots[i])
+        {
+            correct = 0;
+        }
+    }
+
+    // Switch between keys and directions without expanding them again
+    for (int i = 0; i < AES_KEY_SLOTS && correct; i++)
+    {
+        encrypt(keys[i], plaintext, ciphertext, 1);
+        encrypt_slot(slots[i], plaintext, ciphertext1);
+        decrypt_slot(slots[i], ciphertext, plaintext1);
+
+        if (memcmp(ciphertext, ciphertext1, 16) != 0 || memcmp(plaintext, plaintext1, 16) != 0)
+        {
+            correct = 0;
+        }
+    }
+
+    // One more key replaces the least recently used one, which is the first key
+    slots[AES_KEY_SLOTS] = aes_key_slot(keys[AES_KEY_SLOTS]);
+    decrypt(keys[AES_KEY_SLOTS], plaintext, ciphertext, 1);
+    encrypt_slot(slots[AES_KEY_SLOTS], ciphertext, plaintext1);
+
+    if (slots[AES_KEY_SLOTS] != slots[0] || memcmp(plaintext, plaintext1, 16) != 0)
+    {
+        correct = 0;
+    }
+
+    if (!correct)
+    {
+        printf("Failed AES test 3\n");
+    }
+    else
+    {
+        printf("Passed AES test 3\n");
+    }
+}
+
+/**
+ * Test for encrypting and decrypting blocks with the AES core's DMA
+ */
+void aes_test4()
+{
+    time_t t;
+    srand((unsigned)time(&t));
+    int correct = 1;
+
+    // The DMA needs word aligned buffers that do not share cache lines with the other locals
+    unsigned plaintext_words[64 * 4] __attribute__((aligned(CACHE_LINE_SIZE)));
+    unsigned ciphertext_words[64 * 4] __attribute__((aligned(CACHE_LINE_SIZE)));
+    unsigned decrypted_words[64 * 4] __attribute__((aligned(CACHE_LINE_SIZE)));
+    unsigned char *plaintext = (unsigned char *)plaintext_words;
+    unsigned char *ciphertext = (unsigned char *)ciphertext_words;
+    unsigned char *decrypted = (unsigned char *)decrypted_words;
+    unsigned char key[16], ciphertext1[16];
+
+    for (int j = 0; j < 16; j++)
+    {
+        key[j] = (unsigned char)rand() % 256;
+    }
+    for (int j = 0; j < 64 * 16; j++)
+    {
+        plaintext[j] = (unsigned char)rand() % 256;
+    }
+
+    int slot = aes_key_slot(key);
+
+    aes_dma_start(slot, plaintext, ciphertext, 64, 0);
+    while (!aes_dma_done())
+    {
+        // wait
+    }
+
+    aes_dma_start(slot, ciphertext, decrypted, 64, 1);
+    while (!aes_dma_done())
+    {
+        // wait
+    }
+
+    for (int i = 0; i < 64 && correct; i++)
+    {
+        encrypt_slot(slot, plaintext + 16 * i, ciphertext1);
+
+        if (memcmp(ciphertext + 16 * i, ciphertext1, 16) != 0 || memcmp(decrypted + 16 * i, plaintext + 16 * i, 16) != 0)
+        {
+            correct = 0;
+        }
+    }
+
+    if (!correct)
+    {
+        printf("Failed AES test 4\n");
+    }
+    else
+    {
+        printf("Passed AES test 4\n");
+    }
+}
+
+/**
+ * Test for AES-CTR mode with the AES core's DMA, with a length that ends inside the last block
+ * and a start counter that carries into the upper bytes
+ */
+void aes_test5()
+{
+    time_t t;
+    srand((unsigned)time(&t));
+    int correct = 1;
+    int length = 64 * 16 - 5;
+
+    // The DMA needs word aligned buffers that do not share cache lines with the other locals
+    unsigned plaintext_words[64 * 4] __attribute__((aligned(CACHE_LINE_SIZE)));
+    unsigned ciphertext_words[64 * 4] __attribute__((aligned(CACHE_LINE_SIZE)));
+    unsigned decrypted_words[64 * 4] __attribute__((aligned(CACHE_LINE_SIZE)));
+    unsigned char *plaintext = (unsigned char *)plaintext_words;
+    unsigned char *ciphertext = (unsigned char *)ciphertext_words;
+    unsigned char *decrypted = (unsigned char *)decrypted_words;
+    unsigned char key[16], counter_block[16], keystream[16];
+
+    for (int j = 0; j < 16; j++)
+    {
+        key[j] = (unsigned char)rand() % 256;
+        counter_block[j] = j < 8 ? (unsigned char)rand() % 256 : (j < 12 ? 0 : 0xFF);
+    }
+    for (int j = 0; j < 64 * 16; j++)
+    {
+        plaintext[j] = (unsigned char)rand() % 256;
+    }
+    memset(ciphertext, 0xA5, 64 * 16);
+    memset(decrypted, 0xA5, 64 * 16);
+
+    int slot = aes_key_slot(key);
+
+    aes_ctr_start(slot, counter_block, plaintext, ciphertext, length);
+    while (!aes_dma_done())
+    {
+        // wait
+    }
+
+    aes_ctr_start(slot, counter_block, ciphertext, decrypted, length);
+    while (!aes_dma_done())
+    {
+        // wait
+    }
+
+    for (int i = 0; i < 64 && correct; i++)
+    {
+        encrypt_slot(slot, counter_block, keystream);
+
+        for (int j = 16 * i; j < 16 * i + 16; j++)
+        {
+            // Bytes after the length must not be written
+            unsigned char expected = j < length ? plaintext[j] ^ keystream[j - 16 * i] : 0xA5;
+
+            if (ciphertext[j] != expected || decrypted[j] != (j < length ? plaintext[j] : 0xA5))
+            {
+                correct = 0;
+            }
+        }
+
+        // Big endian increment of the counter in the last 8 bytes
+        for (int j = 15; j >= 8; j--)
+        {
+            if (++counter_block[j] != 0)
+            {
+                break;
+            }
+        }
+    }
+
+    if (!correct)
+    {
+        printf("Failed AES test 5\n");
+    }
+    else
+    {
+        printf("Passed AES test 5\n");
+    }
+}
+
+/**
+ * Test for starting the AES encryption and decryption modules without waiting, counting how many loop
+ * iterations the CPU runs while a block is in progress
+ */
+void aes_test6()
+{
+    time_t t;
+    srand((unsigned)time(&t));
+    int correct = 1;
+    int overlapped = 0;
+
+    unsigned char key[16], plaintext[16], ciphertext[16], ciphertext1[16], decrypted[16];
+
+    for (int j = 0; j < 16; j++)
+    {
+        key[j] = (unsigned char)rand() % 256;
+        plaintext[j] = (unsigned char)rand() % 256;
+    }
+
+    encrypt_start(key, plaintext, 1);
+    while (!encrypt_poll(ciphertext))
+    {
+        overlapped++;
+    }
+
+    decrypt_start(key, ciphertext, 1);
+    while (!decrypt_poll(decrypted))
+    {
+        overlapped++;
+    }
+
+    // The slot based core gives the same ciphertext
+    encrypt_slot(aes_key_slot(key), plaintext, ciphertext1);
+
+    if (memcmp(ciphertext, ciphertext1, 16) != 0 || memcmp(decrypted, plaintext, 16) != 0)
+    {
+        correct = 0;
+    }
+
+    if (!correct)
+    {
+        printf("Failed AES test 6\n");
+    }
+    else
+    {
+        printf("Passed AES test 6, %d polls while the blocks were running\n", overlapped);
+    }
+}
+
+/**
+ * Test 7 for the encryption and decryption modules against the vectors in aesVectors.h
+ * (NIST known answers and random vectors from AES/python_version/gen_vectors.py).
+ * Every vector is run with key expansion, then decrypted again without it.
+ */
+void aes_test7()
+{
+    int failed = 0;
+
+    unsigned char key[16], plaintext[16], ciphertext[16], result[16];
+
+    for (int i = 0; i < AES_NUM_VECTORS; i++)
+    {
+        memcpy(key, aes_vectors[i][0], 16);
+        memcpy(plaintext, aes_vectors[i][1], 16);
+        memcpy(ciphertext, aes_vectors[i][2], 16);
+
+        encrypt(key, plaintext, result, 1);
+        if (memcmp(result, ciphertext, 16) != 0)
+        {
+            failed++;
+            continue;
+        }
+
+        decrypt(key, ciphertext, result, 1);
+        if (memcmp(result, plaintext, 16) != 0)
+        {
+            failed++;
+        }
+    }
+
+    if (failed)
+    {
+        printf("Failed AES test 7, %d of %d vectors\n", failed, AES_NUM_VECTORS);
+    }
+    else
+    {
+        printf("Passed AES test 7, %d vectors\n", AES_NUM_VECTORS);
+    }
+}
+
+// Job for smp_test1, tokenizes a message on core 1
+typedef struct
+{
+    const char *message;
+    jsmntok_t tokens[16];
+    int num_tokens;
+} smp_json_job_t;
+
+static void smp_json_job(void *arg)
+{
+    smp_json_job_t *job = (smp_json_job_t *)arg;
+    job->num_tokens = json_tokenize(job->message, job->tokens, 16);
+}
+
+// Job for smp_test1, sums a slice of numbers on core 1
+typedef struct
+{
+    const unsigned *numbers;
+    int count;
+    unsigned sum;
+} smp_sum_job_t;
+
+static void smp_sum_job(void *arg)
+{
+    smp_sum_job_t *job = (smp_sum_job_t *)arg;
+    job->sum = 0;
+    for (int i = 0; i < job->count; i++)
+    {
+        job->sum += job->numbers[i];
+    }
+}
+
+/**
+ * Test for the second core, offloading jobs to it while core 0 keeps encrypting.
+ * Every job must give the same result as running it on core 0.
+ */
+void smp_test1()
+{
+    static unsigned numbers[4096];
+    smp_job_t jobs[9];
+    smp_sum_job_t sums[8];
+    smp_json_job_t json = {.message = "{\"type\":1,\"fileId\":\"abc\"}"};
+    unsigned char key[16] = {0}, plaintext[16] = {0}, ciphertext[16];
+    unsigned expected = 0;
+    unsigned total = 0;
+    int encrypted = 0;
+    int correct = 1;
+
+    if (!smp_start_core1())
+    {
+        printf("Failed SMP test 1, core 1 did not start\n");
+        return;
+    }
+
+    for (int i = 0; i < 4096; i++)
+    {
+        numbers[i] = (unsigned)i * 2654435761u;
+        expected += numbers[i];
+    }
+
+    for (int i = 0; i < 8; i++)
+    {
+        sums[i].numbers = &numbers[512 * i];
+        sums[i].count = 512;
+        correct &= smp_submit(&jobs[i], smp_sum_job, &sums[i]);
+    }
+    correct &= smp_submit(&jobs[8], smp_json_job, &json);
+
+    // Core 0 is free while core 1 works through the queue
+    while (!smp_job_done(&jobs[8]))
+    {
+        encrypt(key, plaintext, ciphertext, encrypted == 0);
+        encrypted++;
+    }
+
+    for (int i = 0; i < 8; i++)
+    {
+        smp_wait(&jobs[i]);
+        total += sums[i].sum;
+    }
+    if (total != expected || json.num_tokens != 5)
+    {
+        correct = 0;
+    }
+
+    if (!correct)
+    {
+        printf("Failed SMP test 1\n");
+    }
+    else
+    {
+        printf("Passed SMP test 1, %d blocks encrypted on core 0 meanwhile\n", encrypted);
+    }
+}
+
+/**
+ * Test for the background sensor sampler. Once the ring buffer is full getSensorKey() must return
+ * the key of the filtered snapshot without reading the sensor, so it takes well under the time of
+ * one SPI transfer.
+ */
+void sensor_test1()
+{
+    uint32 start, ticks;
+    uint32 key;
+    int correct = 1;
+
+    if (!MPU9250_Begin())
+    {
+        printf("Failed sensor test 1, no MPU9250\n");
+        return;
+    }
+
+    while (MPU9250_SampleCount() < MPU9250_SAMPLES)
+    {
+        MPU9250_Sample();
+        hps_ms_delay(10);
+    }
+
+    // The private timer counts down at 200 MHz
+    start = mmio_read32(PtimerCount);
+    key = getSensorKey();
+    ticks = start - mmio_read32(PtimerCount);
+
+    // 10 us, one SPI byte at 1 MHz takes 8 us
+    if (ticks > 2000 || key != MPU9250_CheckMagnetDirection())
+    {
+        correct = 0;
+    }
+
+    if (!correct)
+    {
+        printf("Failed sensor test 1\n");
+    }
+    else
+    {
+        printf("Passed sensor test 1, getSensorKey() took %u ticks\n", (unsigned)ticks);
+    }
+}
+
 /**
  * Test for getting, setting, and verifying master password
  */
+void delay_test1()
+{
+    static const unsigned delays_us[] = {1, 10, 100, 1000, 10000, 1500000};
+    volatile unsigned *gtimer = GTIMER_ADDR;
+    uint32 start, ticks;
+    int correct = 1;
+
+    hps_init();
+
+    for (int i = 0; i < sizeof(delays_us) / sizeof(delays_us[0]); i++)
+    {
+        // The global timer counts up at 200 MHz, independently of the private timer
+        start = mmio_read32(gtimer);
+        hps_usleep(delays_us[i]);
+        ticks = (mmio_read32(gtimer) - start) / 200;
+
+        // 1% plus 2 us of wakeup latency
+        if (ticks < delays_us[i] || ticks > delays_us[i] + delays_us[i] / 100 + 2)
+        {
+            printf("hps_usleep(%u) took %u us\n", delays_us[i], (unsigned)ticks);
+            correct = 0;
+        }
+    }
+
+    if (!correct)
+    {
+        printf("Failed delay test 1\n");
+    }
+    else
+    {
+        printf("Passed delay test 1\n");
+    }
+}
+
 void password_test()
 {
     int correct = 1;
@@ -309,7 +794,7 @@ void message1_test1() {
  */
 void message2_test1() {
 	set_password("sending rending lending blending");
-	*HEX_ADDR = (unsigned)0x123ABC;
+	mmio_write32(HEX_ADDR, (unsigned)0x123ABC);
     int success = verify("sending rending lending blending", "123ABC");
     if (success)
     {
@@ -327,7 +812,7 @@ void message2_test1() {
  */
 void message2_test2() {
 	set_password("sending lending blending");
-	*HEX_ADDR = (unsigned)0xABC123;
+	mmio_write32(HEX_ADDR, (unsigned)0xABC123);
     int success = verify("sending rending lending blending", "ABC123");
     if (!success)
     {
@@ -345,7 +830,7 @@ void message2_test2() {
  */
 void message2_test3() {
 	set_password("rending lending blending");
-	*HEX_ADDR = (unsigned)0x123ABC;
+	mmio_write32(HEX_ADDR, (unsigned)0x123ABC);
     int success = verify("rending lending blending", "AB12BC");
     if (!success)
     {
@@ -363,7 +848,7 @@ void message2_test3() {
  */
 void message2_test4() {
 	set_password("rending lending blending");
-	*HEX_ADDR = (unsigned)0xAB12BC;
+	mmio_write32(HEX_ADDR, (unsigned)0xAB12BC);
     int success = verify("rending lending blending", "AB12BC");
     if (success)
     {
@@ -381,7 +866,7 @@ void message2_test4() {
  */
 void message2_test5() {
 	set_password("rending blending");
-	*HEX_ADDR = (unsigned)0xEF01234;
+	mmio_write32(HEX_ADDR, (unsigned)0xEF01234);
     int success = verify("rending lending blending", "AB12BC");
     if (!success)
     {
@@ -400,7 +885,7 @@ void message2_test5() {
  */
 void message2_test6() {
 	set_password("1234567890abc");
-	*HEX_ADDR = (unsigned)0xABCDEF;
+	mmio_write32(HEX_ADDR, (unsigned)0xABCDEF);
 	char *json_str = "{\"type\":2,\"password\":\"1234567890abc\",\"hex\":\"ABCDEF\"}";
     jsmntok_t *json_tokens = str_to_json(json_str);
 
@@ -432,7 +917,7 @@ void message2_test6() {
  */
 void message2_test7() {
 	set_password("mosh1prove5zsd");
-	*HEX_ADDR = (unsigned)0xABCDEF;
+	mmio_write32(HEX_ADDR, (unsigned)0xABCDEF);
 	char *json_str = "{\"type\":2,\"password\":\"1234567890abc\",\"hex\":\"ABCDEF\"}";
     jsmntok_t *json_tokens = str_to_json(json_str);
 
@@ -464,7 +949,7 @@ void message2_test7() {
  */
 void message2_test8() {
 	set_password("1234567890abc");
-	*HEX_ADDR = (unsigned)0x012345;
+	mmio_write32(HEX_ADDR, (unsigned)0x012345);
 	char *json_str = "{\"type\":2,\"password\":\"1234567890abc\",\"hex\":\"ABCDEF\"}";
     jsmntok_t *json_tokens = str_to_json(json_str);
 
@@ -496,7 +981,7 @@ void message2_test8() {
  */
 void message2_test9() {
 	set_password("jsonnnon1");
-	*HEX_ADDR = (unsigned)0x987654;
+	mmio_write32(HEX_ADDR, (unsigned)0x987654);
 	char *json_str = "{\"type\":2,\"password\":\"1234567890abc\",\"hex\":\"ABCDEF\"}";
     jsmntok_t *json_tokens = str_to_json(json_str);
 
@@ -785,11 +1270,11 @@ void message7_test1() {
     int success = 1;
     char *cmp_str = "1234567890abc";
     for (int i = 0; i < MAX_PASSWORD_LENGTH; i++) {
-    	if (*(MASTER_PW_ADDR + i) != *(cmp_str)) {
+    	if (mmio_read32(MASTER_PW_ADDR + i) != *(cmp_str)) {
     		success = 0;
     		break;
     	}
-    	if (*(MASTER_PW_ADDR + i) == '\0') break;
+    	if (mmio_read32(MASTER_PW_ADDR + i) == '\0') break;
     }
     if (!success)
     {
@@ -801,14 +1286,159 @@ void message7_test1() {
     }
 }
 
+/**
+ * Schema based field extraction, json_extract()
+ * fields are found by key name even when sent in a different order
+ *
+ */
+void json_extract_test1() {
+
+	char json_str[] = "{\"fileData\":\"abc\",\"totalPackets\":12,\"type\":3,\"location\":\"37.422|-122.084|5.285\",\"packetNumber\":10,\"fileId\":\"d869c9d6\"}";
+	jsmntok_t json_tokens[JSON_MAX_TOKENS];
+	json_view_t values[UPLOAD_NUM_FIELDS];
+	int num_tokens = json_tokenize(json_str, json_tokens, JSON_MAX_TOKENS);
+
+	int success = json_extract(json_str, json_tokens, num_tokens, upload_schema, UPLOAD_NUM_FIELDS, values) == UPLOAD_NUM_FIELDS;
+	success = success && strcmp(values[UPLOAD_FILE_ID].ptr, "d869c9d6") == 0;
+	success = success && json_view_to_int(values[UPLOAD_PACKET_NUMBER]) == 10;
+	success = success && json_view_to_int(values[UPLOAD_TOTAL_PACKETS]) == 12;
+	success = success && strcmp(values[UPLOAD_LOCATION].ptr, "37.422|-122.084|5.285") == 0;
+	success = success && values[UPLOAD_FILE_DATA].len == 3 && strcmp(values[UPLOAD_FILE_DATA].ptr, "abc") == 0;
+
+	// Missing fields are reported as not found
+	char json_str2[] = "{\"type\":2,\"hex\":\"ABCDEF\"}";
+	num_tokens = json_tokenize(json_str2, json_tokens, JSON_MAX_TOKENS);
+	success = success && json_extract(json_str2, json_tokens, num_tokens, verify_schema, VERIFY_NUM_FIELDS, values) == 1;
+	success = success && values[VERIFY_PASSWORD].ptr == NULL;
+
+    if (success)
+    {
+    	printf("Passed json extract test 1\n");
+    }
+    else
+    {
+    	printf("Failed json extract test 1\n");
+    }
+}
+
+/**
+ * Incremental parsing, json_stream_feed()
+ * the message is fed one byte at a time and fileData lands in the sink buffer
+ *
+ */
+void json_stream_test1() {
+
+	const char *json_str = "{\"type\":3, \"fileId\":\"d869c9d6\",\"packetNumber\":10,\"totalPackets\":12,\"location\":\"37.422|-122.084|5.285\",\"fileData\":\"a\\\"bc\"}";
+	static json_stream_t stream;
+	char sink[8];
+	json_view_t values[UPLOAD_NUM_FIELDS];
+	json_stream_status status = JSON_STREAM_BUSY;
+
+	json_stream_init(&stream);
+	json_stream_set_sink(&stream, "fileData", sink, sizeof(sink));
+	for (int i = 0; json_str[i] != '\0' && status == JSON_STREAM_BUSY; i++)
+	{
+		status = json_stream_feed(&stream, json_str[i]);
+	}
+
+	int success = status == JSON_STREAM_DONE && stream.type == 3;
+	success = success && json_stream_extract(&stream, upload_schema, UPLOAD_NUM_FIELDS, values) == UPLOAD_NUM_FIELDS;
+	success = success && strcmp(values[UPLOAD_FILE_ID].ptr, "d869c9d6") == 0;
+	success = success && json_view_to_int(values[UPLOAD_PACKET_NUMBER]) == 10;
+	success = success && json_view_to_int(values[UPLOAD_TOTAL_PACKETS]) == 12;
+	success = success && strcmp(values[UPLOAD_LOCATION].ptr, "37.422|-122.084|5.285") == 0;
+	success = success && values[UPLOAD_FILE_DATA].ptr == sink && strcmp(sink, "a\\\"bc") == 0;
+
+	// Malformed messages are reported as errors
+	json_stream_reset(&stream);
+	status = JSON_STREAM_BUSY;
+	json_str = "{\"type\":,}";
+	for (int i = 0; json_str[i] != '\0' && status == JSON_STREAM_BUSY; i++)
+	{
+		status = json_stream_feed(&stream, json_str[i]);
+	}
+	success = success && status == JSON_STREAM_ERROR;
+
+	// fileData longer than the sink is an error, not truncated
+	json_stream_reset(&stream);
+	status = JSON_STREAM_BUSY;
+	json_str = "{\"type\":3,\"fileData\":\"abcdefgh\"}";
+	for (int i = 0; json_str[i] != '\0' && status == JSON_STREAM_BUSY; i++)
+	{
+		status = json_stream_feed(&stream, json_str[i]);
+	}
+	success = success && status == JSON_STREAM_ERROR;
+
+    if (success)
+    {
+    	printf("Passed json stream test 1\n");
+    }
+    else
+    {
+    	printf("Failed json stream test 1\n");
+    }
+}
+
+// Output of json_writer_test1, collected from the fragments
+static char json_writer_output[256];
+
+static void json_writer_test_out(char *fragment)
+{
+	strcat(json_writer_output, fragment);
+}
+
+/**
+ * Response writer, json_writer_begin()
+ * packet numbers above 9 are formatted in decimal and string values are escaped
+ *
+ */
+void json_writer_test1() {
+
+	json_writer_t writer;
+	char file_data[90];
+
+	// Long enough to be flushed in several fragments
+	memset(file_data, 'x', sizeof(file_data));
+	strcpy(file_data + 80, "a\"b\\c\n\x01");
+
+	json_writer_output[0] = '\0';
+	json_writer_begin(&writer, json_writer_test_out);
+	json_write_int(&writer, "packetNumber", 12);
+	json_write_int(&writer, "totalPackets", -305);
+	json_write_string(&writer, "fileData", file_data);
+	json_writer_end(&writer);
+
+	char expected[256] = "{\"packetNumber\":12,\"totalPackets\":-305,\"fileData\":\"";
+	memset(expected + strlen(expected), 'x', 80);
+	strcat(expected, "a\\\"b\\\\c\\n\\u0001\"}\v\n");
+
+    if (strcmp(json_writer_output, expected) == 0)
+    {
+    	printf("Passed json writer test 1\n");
+    }
+    else
+    {
+    	printf("Failed json writer test 1\n");
+    }
+}
+
 /**
  * Uncomment the following main function and comment out the cloudlockrMain.c main function
  * to run the tests
  */
 //  int main()
 //  {
+//      cache_init();
 //      aes_test0();
 //      aes_test1();
+//      aes_test3();
+//      aes_test4();
+//      aes_test5();
+//      aes_test6();
+//      aes_test7();
+//      smp_test1();
+//      sensor_test1();
+//      delay_test1();
 //      password_test();
 //      //hex_test();
 //      message1_test1();
@@ -824,4 +1454,8 @@ void message7_test1() {
 //      message2_test9();
 
 //      message7_test1();
+
+//      json_extract_test1();
+//      json_stream_test1();
+//      json_writer_test1();
 //  }
@@ -0,0 +1,192 @@
+/**
+ * This module contains a hierarchical timer wheel for the timeouts of the drivers.
+ *
+ * Time advances in 1 ms ticks of hps_time_ms(), driven by timer_task(). Level 0 has a slot per ms for
+ * the next 64 ms, level 1 a slot per 64 ms for the next 4 s, level 2 a slot per 4 s and level 3 a slot
+ * per 4.4 min, about 4.7 h in all. Starting or cancelling a timer is O(1). When the level 0 index wraps,
+ * the due slot of level 1 is spread over level 0, and so on up the levels, so each timer is moved at
+ * most once per level before it expires. Longer timeouts sit in the last slot of level 3 and are
+ * placed again when it is spread.
+ *
+ * Timers run from timer_task(), never from an interrupt, so callbacks may use the drivers.
+ */
+
+#include <typeDef.h>
+#include "hpsService.h"
+#include "timerService.h"
+
+#define TIMER_MASK (TIMER_SLOTS - 1)
+
+static soft_timer_t *timer_wheel[TIMER_LEVELS][TIMER_SLOTS];
+
+// The next tick to run, all timers that expire before it have run
+static uint64 timer_jiffies = 0;
+static int timer_count = 0;
+
+/*
+ * Link the timer into the slot of the level its expiry falls in
+ */
+static void timer_add(soft_timer_t *timer)
+{
+    uint64 expires = timer->expires_ms;
+    uint64 delta;
+    soft_timer_t **slot;
+    int level = 0;
+
+    if (expires < timer_jiffies)
+    {
+        // Already due, runs on the next tick
+        expires = timer_jiffies;
+    }
+
+    delta = expires - timer_jiffies;
+    if (delta >> (TIMER_LEVELS * TIMER_LEVEL_BITS))
+    {
+        // Beyond the wheel, placed again once the last level reaches it
+        delta = ((uint64)1 << (TIMER_LEVELS * TIMER_LEVEL_BITS)) - 1;
+        expires = timer_jiffies + delta;
+    }
+
+    while (delta >> ((level + 1) * TIMER_LEVEL_BITS))
+    {
+        level++;
+    }
+
+    slot = &timer_wheel[level][(expires >> (level * TIMER_LEVEL_BITS)) & TIMER_MASK];
+
+    timer->next = *slot;
+    if (timer->next != null)
+    {
+        timer->next->pprev = &timer->next;
+    }
+    timer->pprev = slot;
+    *slot = timer;
+    timer_count++;
+}
+
+/*
+ * Unlink a pending timer
+ */
+static void timer_remove(soft_timer_t *timer)
+{
+    *timer->pprev = timer->next;
+    if (timer->next != null)
+    {
+        timer->next->pprev = timer->pprev;
+    }
+    timer->next = null;
+    timer->pprev = null;
+    timer_count--;
+}
+
+/*
+ * Move the timers of a slot of an upper level down to the levels below.
+ *
+ * Returns the index of the slot
+ */
+static int timer_cascade(int level)
+{
+    int index = (timer_jiffies >> (level * TIMER_LEVEL_BITS)) & TIMER_MASK;
+    soft_timer_t *timer;
+
+    while ((timer = timer_wheel[level][index]) != null)
+    {
+        timer_remove(timer);
+        timer_add(timer);
+    }
+
+    return index;
+}
+
+/**
+ * Set up a timer before its first use.
+ *
+ * Params:
+ *  timer   timer to set up
+ *  fn      function called when the timer expires
+ *  arg     argument passed to fn
+ */
+void timer_init(soft_timer_t *timer, timer_fn fn, void *arg)
+{
+    timer->next = null;
+    timer->pprev = null;
+    timer->expires_ms = 0;
+    timer->fn = fn;
+    timer->arg = arg;
+}
+
+/**
+ * Start the timer, or restart it if it is pending.
+ *
+ * Params:
+ *  timer       timer set up with timer_init()
+ *  timeout_ms  time from now after which fn is called
+ */
+void timer_start(soft_timer_t *timer, uint32 timeout_ms)
+{
+    if (timer->pprev != null)
+    {
+        timer_remove(timer);
+    }
+
+    timer->expires_ms = hps_time_ms() + timeout_ms;
+    timer_add(timer);
+}
+
+/**
+ * Stop the timer if it is pending, fn is not called.
+ */
+void timer_cancel(soft_timer_t *timer)
+{
+    if (timer->pprev != null)
+    {
+        timer_remove(timer);
+    }
+}
+
+/**
+ * Returns true while the timer is started and has not run yet
+ */
+bool timer_pending(const soft_timer_t *timer)
+{
+    return timer->pprev != null;
+}
+
+/**
+ * Periodic task, runs every timer that expired since the last run
+ */
+void timer_task(void)
+{
+    uint64 now = hps_time_ms();
+    soft_timer_t *timer;
+    int index;
+    int level;
+
+    while (timer_jiffies <= now)
+    {
+        if (timer_count == 0)
+        {
+            // Nothing to move or run
+            timer_jiffies = now + 1;
+            break;
+        }
+
+        index = timer_jiffies & TIMER_MASK;
+
+        // Spread the next slot of each level that wrapped
+        for (level = 1; level < TIMER_LEVELS && index == 0; level++)
+        {
+            index = timer_cascade(level);
+        }
+
+        index = timer_jiffies & TIMER_MASK;
+        timer_jiffies++;
+
+        // Timers started by a callback land in later slots, see timer_add()
+        while ((timer = timer_wheel[0][index]) != null)
+        {
+            timer_remove(timer);
+            timer->fn(timer->arg);
+        }
+    }
+}
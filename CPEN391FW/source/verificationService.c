@@ -11,6 +11,7 @@
 #include <stdlib.h>
 #include "constants.h"
 #include "memAddress.h"
+#include "mmio.h"
 #include "verificationService.h"
 
 /**
@@ -27,11 +28,11 @@ void set_password(char *password)
 
     while (password[i] != '\0' && i < MAX_PASSWORD_LENGTH)
     {
-        *(MASTER_PW_ADDR + i) = password[i];
+        mmio_write32(MASTER_PW_ADDR + i, password[i]);
         i++;
     }
     // Ensure master password is null terminated
-    *(MASTER_PW_ADDR + i) = '\0';
+    mmio_write32(MASTER_PW_ADDR + i, '\0');
 }
 
 /**
@@ -47,7 +48,7 @@ void get_password(char *password)
 
     do
     {
-        master_pw_char = *(MASTER_PW_ADDR + i);
+        master_pw_char = mmio_read32(MASTER_PW_ADDR + i);
         password[i] = master_pw_char;
         i++;
     } while (master_pw_char != '\0' && i < MAX_PASSWORD_LENGTH);
@@ -72,7 +73,7 @@ int verify(char *password, char *hex)
     // Verify master password
     do
     {
-        master_pw_char = *(MASTER_PW_ADDR + i);
+        master_pw_char = mmio_read32(MASTER_PW_ADDR + i);
         pw_char = password[i];
 
         if (master_pw_char != pw_char)
@@ -87,7 +88,7 @@ int verify(char *password, char *hex)
     if (verified)
     {
         unsigned input_hex_code = (unsigned)strtol(hex, NULL, 16);
-        unsigned correct_hex_code = *HEX_ADDR;
+        unsigned correct_hex_code = mmio_read32(HEX_ADDR);
         if (correct_hex_code != input_hex_code)
         {
             verified = 0;
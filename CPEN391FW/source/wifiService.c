@@ -6,7 +6,12 @@
 #include "wifiService.h"
 #include "UART.h"
 #include "hpsService.h"
+#include "initService.h"
+#include "timerService.h"
+#include "scheduler.h"
+#include "profileService.h"
 #include "jsonParser.h"
+#include "memService.h"
 
 /*
  * Flushes the WiFi UART
@@ -31,6 +36,139 @@ static void esp8266_dump_rx(void)
     UART_Flush(UART_ePORT_WIFI);
 }
 
+// Keepalive state, the reply to "AT" is collected by wifi_poll without blocking
+static int wifi_keepalive_pending = 0;
+static int wifi_keepalive_ok = 0;
+static char wifi_keepalive_line[32];
+static size_t wifi_keepalive_len = 0;
+static soft_timer_t wifi_keepalive_timer;
+
+static wifi_stats_t wifi_stats;
+
+/*
+ * Gives up on a keepalive reply that did not arrive in time
+ * */
+static void wifi_keepalive_expired(void *arg)
+{
+    if (wifi_keepalive_pending)
+    {
+        wifi_keepalive_pending = 0;
+        wifi_keepalive_ok = 0;
+        esp8266_dump_rx();
+        wifi_stats.keepalive_failures++;
+        printf("WiFi keepalive timed out\n");
+    }
+}
+
+/*
+ * Starts a keepalive check of the WiFi module, the reply is collected by wifi_poll
+ * */
+void wifi_keepalive_start(void)
+{
+    if (wifi_keepalive_pending)
+    {
+        return;
+    }
+
+    esp8266_dump_rx();
+    wifi_keepalive_len = 0;
+    wifi_keepalive_pending = 1;
+    UART_puts(UART_ePORT_WIFI, "AT\r\n");
+
+    timer_init(&wifi_keepalive_timer, wifi_keepalive_expired, null);
+    timer_start(&wifi_keepalive_timer, WIFI_KEEPALIVE_TIMEOUT_MS);
+}
+
+/*
+ * Reads whatever part of the keepalive reply has arrived, without waiting.
+ * Returns 1 once the reply is complete
+ * */
+int wifi_poll(void)
+{
+    while (wifi_keepalive_pending && UART_TestForReceivedData(UART_ePORT_WIFI))
+    {
+        char c = UART_getchar(UART_ePORT_WIFI);
+
+        if (c != '\n')
+        {
+            if (wifi_keepalive_len < sizeof(wifi_keepalive_line) - 1)
+            {
+                wifi_keepalive_line[wifi_keepalive_len++] = c;
+            }
+            continue;
+        }
+
+        wifi_keepalive_line[wifi_keepalive_len] = '\0';
+        wifi_keepalive_len = 0;
+
+        if (strstr(wifi_keepalive_line, "OK") != NULL)
+        {
+            wifi_keepalive_ok = 1;
+            wifi_keepalive_pending = 0;
+            timer_cancel(&wifi_keepalive_timer);
+            return 1;
+        }
+        else if (strstr(wifi_keepalive_line, "ERROR") != NULL || strstr(wifi_keepalive_line, "FAIL") != NULL)
+        {
+            wifi_keepalive_ok = 0;
+            wifi_keepalive_pending = 0;
+            timer_cancel(&wifi_keepalive_timer);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Handles the end of a keepalive check
+ * */
+void wifi_keepalive_done(void)
+{
+    if (!wifi_keepalive_ok)
+    {
+        wifi_stats.keepalive_failures++;
+        printf("WiFi keepalive failed\n");
+    }
+}
+
+/*
+ * Step function of the background initialization, see initService.c. Probes the WiFi module with
+ * the keepalive "AT" at boot, so a missing module shows up before the app configures the WiFi.
+ * */
+init_status wifi_init_step(init_job_t *job)
+{
+    switch (job->state)
+    {
+    case 0:
+        wifi_keepalive_start();
+        job->state = 1;
+        return INIT_PENDING;
+    default:
+        // The reply may also be collected by the wifi_poll event
+        if (wifi_keepalive_pending && !wifi_poll())
+        {
+            return INIT_PENDING;
+        }
+        return wifi_keepalive_ok ? INIT_DONE : INIT_FAILED;
+    }
+}
+
+/*
+ * Lets an outstanding keepalive reply arrive before a command is sent,
+ * so it cannot be mistaken for the reply to that command
+ * */
+static void wifi_keepalive_finish(void)
+{
+    // A late reply is given up on by wifi_keepalive_expired(). timer_task() is also run here
+    // because sched_idle() does nothing when the command is sent from a task.
+    while (wifi_keepalive_pending && !wifi_poll())
+    {
+        sched_idle();
+        timer_task();
+    }
+}
+
 /*
  * Sends AT commands
  * cmd is the string for the command
@@ -40,6 +178,8 @@ static bool esp8266_send_command(const char *cmd)
     int length = 0;
     char buffer[1000];
 
+    wifi_keepalive_finish();
+
     // Send command to WIFI UART port.
     sprintf(buffer, "%s\r\n", cmd);
     UART_puts(UART_ePORT_WIFI, buffer);
@@ -98,6 +238,16 @@ static bool initiate_tcp(char *domain)
     char cmd_buffer[100];
     sprintf(cmd_buffer, "AT+CIPSTART=\"TCP\",\"%s\",80,7200", domain); // start TCP connection at domain with port 80
     success = esp8266_send_command(cmd_buffer);
+
+    if (success)
+    {
+        wifi_stats.tcp_connects++;
+    }
+    else
+    {
+        wifi_stats.tcp_failures++;
+    }
+
     return success;
 }
 
@@ -114,9 +264,39 @@ static bool close_tcp()
 
 
 /*
- * Uploads contents in file_data to the file specified by file_id and the blob specified by blob_number
+ * Parses the first value of the JSON body of a server reply, e.g. {"numBlobs":3}.
+ * The tokens and the value are allocated from the request arena.
+ * Returns NULL if there is no body or it does not parse
  * */
-int upload_data(char *file_id, int blob_number, char *file_data)
+static char *reply_value(char *body)
+{
+    jsmntok_t *tokens;
+    char **values;
+
+    if (body == NULL)
+    {
+        return NULL;
+    }
+
+    PROF_BEGIN(PROF_STR_TO_JSON);
+    tokens = str_to_json(body);
+    PROF_END(PROF_STR_TO_JSON);
+    if (tokens == NULL)
+    {
+        return NULL;
+    }
+
+    PROF_BEGIN(PROF_GET_JSON_VALUES);
+    values = get_json_values(body, tokens, 1);
+    PROF_END(PROF_GET_JSON_VALUES);
+
+    return values != NULL ? values[0] : NULL;
+}
+
+/*
+ * Sends the request of upload_data and parses the reply
+ * */
+static int upload_data_request(char *file_id, int blob_number, char *file_data)
 {
     char cmd_buffer[100];
     char req_body[2 * MAX_FILEDATA_SIZE + 20];
@@ -153,10 +333,11 @@ int upload_data(char *file_id, int blob_number, char *file_data)
                 char *body = strstr(response, "\r\n\r\n");
                 printf("%s\n", body);
                 close_tcp();
-                jsmntok_t *tokens = str_to_json(body);
-                char **values = get_json_values(body, tokens, 1);
-                free(tokens);
-                return atoi(values[0]);
+                mem_mark_t mark = mem_mark();
+                char *value = reply_value(body);
+                int result = value != NULL ? atoi(value) : -1;
+                mem_release(mark);
+                return result;
             }
             printf("Send data failed\n");
             return -1;
@@ -168,13 +349,27 @@ int upload_data(char *file_id, int blob_number, char *file_data)
     return -1;
 }
 
+/*
+ * Uploads contents in file_data to the file specified by file_id and the blob specified by blob_number
+ * */
+int upload_data(char *file_id, int blob_number, char *file_data)
+{
+    int result;
+
+    PROF_BEGIN(PROF_UPLOAD_DATA);
+    result = upload_data_request(file_id, blob_number, file_data);
+    PROF_END(PROF_UPLOAD_DATA);
+
+    return result;
+}
+
 /*
  * Authenticates the DE1 into the specified WiFi access point
  * */
 int set_wifi_config(char *networkName, char *networkPassword)
 {
     char cmd[200];
-    int mode_set, connected;
+    int mode_set, connected = 0;
 
     for (int i = 0; i < HANDSHAKE; i++)
     {
@@ -196,6 +391,15 @@ int set_wifi_config(char *networkName, char *networkPassword)
         }
     }
 
+    if (connected)
+    {
+        wifi_stats.joins++;
+    }
+    else
+    {
+        wifi_stats.join_failures++;
+    }
+
     return connected;
 }
 
@@ -236,10 +440,11 @@ int get_file_metadata(char *file_id)
                 }
                 char *body = strstr(response, "\r\n\r\n");
                 close_tcp();
-                jsmntok_t *tokens = str_to_json(body);
-                char **values = get_json_values(body, tokens, 1);
-                free(tokens);
-                return atoi(values[0]);
+                mem_mark_t mark = mem_mark();
+                char *value = reply_value(body);
+                int result = value != NULL ? atoi(value) : -1;
+                mem_release(mark);
+                return result;
             }
             printf("Send data failed\n");
             return -1;
@@ -252,9 +457,9 @@ int get_file_metadata(char *file_id)
 }
 
 /*
- * Gets blob for specified file_id and blob_number
+ * Sends the request of get_blob and parses the reply
  * */
-char *get_blob(char *file_id, int blob_number)
+static char *get_blob_request(char *file_id, int blob_number)
 {
     char cmd_buffer[100];
     char request[150];
@@ -288,10 +493,17 @@ char *get_blob(char *file_id, int blob_number)
                 }
                 char *body = strstr(response, "\r\n\r\n");
                 close_tcp();
-                jsmntok_t *tokens = str_to_json(body);
-                char **values = get_json_values(body, tokens, 1);
-                free(tokens);
-                return values[0];
+                // The blob outlives the tokens and values, it is copied to a pool block
+                mem_mark_t mark = mem_mark();
+                char *value = reply_value(body);
+                char *blob = value != NULL ? (char *)mem_pool_alloc() : NULL;
+                if (blob != NULL)
+                {
+                    strncpy(blob, value, MEM_POOL_BLOCK_SIZE - 1);
+                    blob[MEM_POOL_BLOCK_SIZE - 1] = '\0';
+                }
+                mem_release(mark);
+                return blob;
             }
             printf("Send data failed\n");
             return NULL;
@@ -302,3 +514,26 @@ char *get_blob(char *file_id, int blob_number)
     printf("Initiate tcp failed\n");
     return NULL;
 }
+
+/*
+ * Gets blob for specified file_id and blob_number
+ * Returns a block of the memService pool, give it back with mem_pool_free(), or NULL if the request failed
+ * */
+char *get_blob(char *file_id, int blob_number)
+{
+    char *blob;
+
+    PROF_BEGIN(PROF_GET_BLOB);
+    blob = get_blob_request(file_id, blob_number);
+    PROF_END(PROF_GET_BLOB);
+
+    return blob;
+}
+
+/*
+ * Returns the connection counters of the WiFi module since boot
+ * */
+const wifi_stats_t *wifi_get_stats(void)
+{
+    return &wifi_stats;
+}
@@ -0,0 +1,197 @@
+/**
+ * This module contains the spinlocks and the lock-free work queue shared by the two Cortex-A9 cores.
+ * The atomic operations use LDREX/STREX on the target and the GCC atomic builtins on the host,
+ * where host/workQueueTest.c runs the queue with pthreads.
+ */
+
+#include <stddef.h>
+#include "workQueue.h"
+
+#ifdef __ARMCC_VERSION
+#define memory_barrier() __dmb(0xF)
+#define wait_for_event() __wfe()
+#define send_event() __sev()
+#else
+#define memory_barrier() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define wait_for_event()
+#define send_event()
+#endif
+
+/**
+ * Atomically replace the word at addr with desired if it holds expected.
+ *
+ * Returns 1 if the word was replaced, 0 otherwise
+ */
+static int compare_and_swap(volatile unsigned *addr, unsigned expected, unsigned desired)
+{
+#ifdef __ARMCC_VERSION
+    do
+    {
+        if (__ldrex(addr) != expected)
+        {
+            __clrex();
+            return 0;
+        }
+    } while (__strex(desired, addr));
+
+    return 1;
+#else
+    return __atomic_compare_exchange_n(addr, &expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+}
+
+/**
+ * Take a spinlock, waiting for an event from spin_unlock() while another core holds it
+ *
+ * Params:
+ *  lock        spinlock initialized to 0
+ */
+void spin_lock(spinlock_t *lock)
+{
+    while (!compare_and_swap(lock, 0, 1))
+    {
+        wait_for_event();
+    }
+
+    // Nothing inside the lock may be seen before the lock is taken
+    memory_barrier();
+}
+
+/**
+ * Take a spinlock if it is free
+ *
+ * Returns 1 if the lock was taken, 0 if another core holds it
+ */
+int spin_trylock(spinlock_t *lock)
+{
+    if (!compare_and_swap(lock, 0, 1))
+    {
+        return 0;
+    }
+
+    memory_barrier();
+    return 1;
+}
+
+/**
+ * Release a spinlock and wake cores waiting in spin_lock()
+ */
+void spin_unlock(spinlock_t *lock)
+{
+    memory_barrier();
+    *lock = 0;
+    memory_barrier();
+    send_event();
+}
+
+/**
+ * Initialize an empty work queue
+ */
+void work_queue_init(work_queue_t *queue)
+{
+    int i;
+
+    // Cell i is free for the push at position i
+    for (i = 0; i < WORK_QUEUE_SIZE; i++)
+    {
+        queue->cells[i].sequence = i;
+        queue->cells[i].item = NULL;
+    }
+    queue->head = 0;
+    queue->tail = 0;
+    memory_barrier();
+}
+
+/**
+ * Add an item to the tail of the queue.
+ * Each cell carries a sequence number telling whether it is free for the push at a position
+ * (sequence == position) or holds the item for the pop at a position (sequence == position + 1),
+ * so producers and consumers only contend on the tail and head counters.
+ *
+ * Params:
+ *  queue       queue initialized with work_queue_init()
+ *  item        pointer to add, not NULL
+ *
+ * Returns 1 if the item was added, 0 if the queue is full
+ */
+int work_queue_push(work_queue_t *queue, void *item)
+{
+    work_queue_cell_t *cell;
+    unsigned position = queue->tail;
+    int diff;
+
+    for (;;)
+    {
+        cell = &queue->cells[position % WORK_QUEUE_SIZE];
+        memory_barrier();
+        diff = (int)(cell->sequence - position);
+
+        if (diff == 0)
+        {
+            if (compare_and_swap(&queue->tail, position, position + 1))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // The cell still holds the item pushed a lap ago
+            return 0;
+        }
+
+        position = queue->tail;
+    }
+
+    cell->item = item;
+    memory_barrier();
+    cell->sequence = position + 1;
+    send_event();
+
+    return 1;
+}
+
+/**
+ * Remove the item at the head of the queue
+ *
+ * Params:
+ *  queue       queue initialized with work_queue_init()
+ *
+ * Returns the item, or NULL if the queue is empty
+ */
+void *work_queue_pop(work_queue_t *queue)
+{
+    work_queue_cell_t *cell;
+    unsigned position = queue->head;
+    void *item;
+    int diff;
+
+    for (;;)
+    {
+        cell = &queue->cells[position % WORK_QUEUE_SIZE];
+        memory_barrier();
+        diff = (int)(cell->sequence - (position + 1));
+
+        if (diff == 0)
+        {
+            if (compare_and_swap(&queue->head, position, position + 1))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            return NULL;
+        }
+
+        position = queue->head;
+    }
+
+    memory_barrier();
+    item = cell->item;
+    memory_barrier();
+
+    // Free the cell for the push one lap later
+    cell->sequence = position + WORK_QUEUE_SIZE;
+
+    return item;
+}
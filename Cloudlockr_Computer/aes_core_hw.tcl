@@ -0,0 +1,187 @@
+# TCL File Generated by Component Editor 15.0
+# Mon Oct 19 11:02:37 PDT 2026
+# DO NOT MODIFY
+
+
+# 
+# aes_core "aes_core" v1.0
+#  2026.10.19.11:02:37
+# 
+# 
+
+# 
+# request TCL package from ACDS 15.0
+# 
+package require -exact qsys 15.0
+
+
+# 
+# module aes_core
+# 
+set_module_property DESCRIPTION ""
+set_module_property NAME aes_core
+set_module_property VERSION 1.0
+set_module_property INTERNAL false
+set_module_property OPAQUE_ADDRESS_MAP true
+set_module_property AUTHOR ""
+set_module_property DISPLAY_NAME aes_core
+set_module_property INSTANTIATE_IN_SYSTEM_MODULE true
+set_module_property EDITABLE true
+set_module_property REPORT_TO_TALKBACK false
+set_module_property ALLOW_GREYBOX_GENERATION false
+set_module_property REPORT_HIERARCHY false
+
+
+# 
+# file sets
+# 
+add_fileset QUARTUS_SYNTH QUARTUS_SYNTH "" ""
+set_fileset_property QUARTUS_SYNTH TOP_LEVEL aes_core
+set_fileset_property QUARTUS_SYNTH ENABLE_RELATIVE_INCLUDE_PATHS false
+set_fileset_property QUARTUS_SYNTH ENABLE_FILE_OVERWRITE_MODE false
+add_fileset_file aes_core.sv SYSTEM_VERILOG PATH aes_core.sv TOP_LEVEL_FILE
+add_fileset_file aes_sbox.sv SYSTEM_VERILOG PATH aes_sbox.sv
+add_fileset_file aes_inv_sbox.sv SYSTEM_VERILOG PATH aes_inv_sbox.sv
+
+
+# 
+# parameters
+# 
+add_parameter KEY_SLOTS INTEGER 4
+set_parameter_property KEY_SLOTS DEFAULT_VALUE 4
+set_parameter_property KEY_SLOTS DISPLAY_NAME KEY_SLOTS
+set_parameter_property KEY_SLOTS TYPE INTEGER
+set_parameter_property KEY_SLOTS UNITS None
+set_parameter_property KEY_SLOTS HDL_PARAMETER true
+add_parameter SLOT_BITS INTEGER 2
+set_parameter_property SLOT_BITS DEFAULT_VALUE 2
+set_parameter_property SLOT_BITS DISPLAY_NAME SLOT_BITS
+set_parameter_property SLOT_BITS TYPE INTEGER
+set_parameter_property SLOT_BITS UNITS None
+set_parameter_property SLOT_BITS HDL_PARAMETER true
+
+
+# 
+# display items
+# 
+
+
+# 
+# connection point clock
+# 
+add_interface clock clock end
+set_interface_property clock clockRate 0
+set_interface_property clock ENABLED true
+set_interface_property clock EXPORT_OF ""
+set_interface_property clock PORT_NAME_MAP ""
+set_interface_property clock CMSIS_SVD_VARIABLES ""
+set_interface_property clock SVD_ADDRESS_GROUP ""
+
+add_interface_port clock clk clk Input 1
+
+
+# 
+# connection point slave
+# 
+add_interface slave avalon end
+set_interface_property slave addressUnits WORDS
+set_interface_property slave associatedClock clock
+set_interface_property slave associatedReset reset
+set_interface_property slave bitsPerSymbol 8
+set_interface_property slave burstOnBurstBoundariesOnly false
+set_interface_property slave burstcountUnits WORDS
+set_interface_property slave explicitAddressSpan 0
+set_interface_property slave holdTime 0
+set_interface_property slave linewrapBursts false
+set_interface_property slave maximumPendingReadTransactions 0
+set_interface_property slave maximumPendingWriteTransactions 0
+set_interface_property slave readLatency 0
+set_interface_property slave readWaitTime 1
+set_interface_property slave setupTime 0
+set_interface_property slave timingUnits Cycles
+set_interface_property slave writeWaitTime 0
+set_interface_property slave ENABLED true
+set_interface_property slave EXPORT_OF ""
+set_interface_property slave PORT_NAME_MAP ""
+set_interface_property slave CMSIS_SVD_VARIABLES ""
+set_interface_property slave SVD_ADDRESS_GROUP ""
+
+add_interface_port slave slave_waitrequest waitrequest Output 1
+add_interface_port slave slave_address address Input 5
+add_interface_port slave slave_read read Input 1
+add_interface_port slave slave_readdata readdata Output 32
+add_interface_port slave slave_write write Input 1
+add_interface_port slave slave_writedata writedata Input 32
+set_interface_assignment slave embeddedsw.configuration.isFlash 0
+set_interface_assignment slave embeddedsw.configuration.isMemoryDevice 0
+set_interface_assignment slave embeddedsw.configuration.isNonVolatileStorage 0
+set_interface_assignment slave embeddedsw.configuration.isPrintableDevice 0
+
+
+# 
+# connection point reset
+# 
+add_interface reset reset end
+set_interface_property reset associatedClock clock
+set_interface_property reset synchronousEdges DEASSERT
+set_interface_property reset ENABLED true
+set_interface_property reset EXPORT_OF ""
+set_interface_property reset PORT_NAME_MAP ""
+set_interface_property reset CMSIS_SVD_VARIABLES ""
+set_interface_property reset SVD_ADDRESS_GROUP ""
+
+add_interface_port reset rst_n reset_n Input 1
+
+
+# 
+# connection point master
+# 
+add_interface master avalon start
+set_interface_property master addressUnits SYMBOLS
+set_interface_property master associatedClock clock
+set_interface_property master associatedReset reset
+set_interface_property master bitsPerSymbol 8
+set_interface_property master burstOnBurstBoundariesOnly false
+set_interface_property master burstcountUnits WORDS
+set_interface_property master doStreamReads false
+set_interface_property master doStreamWrites false
+set_interface_property master holdTime 0
+set_interface_property master linewrapBursts false
+set_interface_property master maximumPendingReadTransactions 0
+set_interface_property master maximumPendingWriteTransactions 0
+set_interface_property master readLatency 0
+set_interface_property master readWaitTime 1
+set_interface_property master setupTime 0
+set_interface_property master timingUnits Cycles
+set_interface_property master writeWaitTime 0
+set_interface_property master ENABLED true
+set_interface_property master EXPORT_OF ""
+set_interface_property master PORT_NAME_MAP ""
+set_interface_property master CMSIS_SVD_VARIABLES ""
+set_interface_property master SVD_ADDRESS_GROUP ""
+
+add_interface_port master master_address address Output 32
+add_interface_port master master_read read Output 1
+add_interface_port master master_readdata readdata Input 32
+add_interface_port master master_write write Output 1
+add_interface_port master master_writedata writedata Output 32
+add_interface_port master master_byteenable byteenable Output 4
+add_interface_port master master_waitrequest waitrequest Input 1
+
+
+# 
+# connection point irq
+# 
+add_interface irq interrupt end
+set_interface_property irq associatedAddressablePoint slave
+set_interface_property irq associatedClock clock
+set_interface_property irq associatedReset reset
+set_interface_property irq bridgedReceiverOffset ""
+set_interface_property irq bridgesToReceiver ""
+set_interface_property irq ENABLED true
+set_interface_property irq EXPORT_OF ""
+set_interface_property irq PORT_NAME_MAP ""
+set_interface_property irq CMSIS_SVD_VARIABLES ""
+set_interface_property irq SVD_ADDRESS_GROUP ""
+
+add_interface_port irq irq irq Output 1
@@ -40,6 +40,8 @@ set_fileset_property QUARTUS_SYNTH TOP_LEVEL aes_decrypt
 set_fileset_property QUARTUS_SYNTH ENABLE_RELATIVE_INCLUDE_PATHS false
 set_fileset_property QUARTUS_SYNTH ENABLE_FILE_OVERWRITE_MODE false
 add_fileset_file aes_decrypt.sv SYSTEM_VERILOG PATH aes_decrypt.sv TOP_LEVEL_FILE
+add_fileset_file aes_sbox.sv SYSTEM_VERILOG PATH aes_sbox.sv
+add_fileset_file aes_inv_sbox.sv SYSTEM_VERILOG PATH aes_inv_sbox.sv
 
 
 # 
@@ -92,7 +94,6 @@ set_interface_property slave PORT_NAME_MAP ""
 set_interface_property slave CMSIS_SVD_VARIABLES ""
 set_interface_property slave SVD_ADDRESS_GROUP ""
 
-add_interface_port slave slave_waitrequest waitrequest Output 1
 add_interface_port slave slave_address address Input 4
 add_interface_port slave slave_read read Input 1
 add_interface_port slave slave_readdata readdata Output 32
@@ -118,3 +119,20 @@ set_interface_property reset SVD_ADDRESS_GROUP ""
 
 add_interface_port reset rst_n reset_n Input 1
 
+
+# 
+# connection point irq
+# 
+add_interface irq interrupt end
+set_interface_property irq associatedAddressablePoint slave
+set_interface_property irq associatedClock clock
+set_interface_property irq associatedReset reset
+set_interface_property irq bridgedReceiverOffset ""
+set_interface_property irq bridgesToReceiver ""
+set_interface_property irq ENABLED true
+set_interface_property irq EXPORT_OF ""
+set_interface_property irq PORT_NAME_MAP ""
+set_interface_property irq CMSIS_SVD_VARIABLES ""
+set_interface_property irq SVD_ADDRESS_GROUP ""
+
+add_interface_port irq irq irq Output 1